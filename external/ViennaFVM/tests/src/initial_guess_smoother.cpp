@@ -0,0 +1,209 @@
+/* =======================================================================
+   Copyright (c) 2011, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+           ViennaFVM - The Vienna Finite Volume Method Library
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    To be discussed, see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+//
+// The flat-array initial_guess_smoother has to reproduce repeated calls of smooth_initial_guess() on a triangular mesh,
+// for a quantity smoothed by the arithmetic mean and one smoothed by the geometric mean. Both quantities have Dirichlet
+// cells whose boundary values differ from their iterates, and the second one is disabled in a part of the mesh.
+//
+
+// include necessary system headers
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+// ViennaFVM includes:
+#include "viennafvm/forwards.h"
+#include "viennafvm/pde_solver.hpp"
+#include "viennafvm/initial_guess.hpp"
+
+// ViennaGrid includes:
+#include "viennagrid/mesh/mesh.hpp"
+#include "viennagrid/mesh/element_creation.hpp"
+#include <viennagrid/config/default_configs.hpp>
+#include "viennagrid/algorithm/centroid.hpp"
+
+// ViennaData includes:
+#include "viennadata/api.hpp"
+
+// ViennaMath includes:
+#include "viennamath/expression.hpp"
+
+
+typedef double                                                              numeric_type;
+typedef viennagrid::triangular_2d_mesh                                      DomainType;
+typedef viennagrid::result_of::cell_tag<DomainType>::type                   CellTag;
+typedef viennagrid::result_of::element<DomainType, CellTag>::type           CellType;
+typedef viennagrid::result_of::point<DomainType>::type                      PointType;
+typedef viennagrid::result_of::element_range<DomainType, CellTag>::type     CellContainer;
+typedef viennagrid::result_of::iterator<CellContainer>::type                CellIterator;
+typedef viennadata::storage<>                                               StorageType;
+
+typedef viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, numeric_type, CellType>::type  IterateAccessor;
+
+static const long squares_per_side = 12;
+
+
+/** @brief A unit square of squares_per_side^2 squares, each split into two triangles */
+void setup_mesh(DomainType & domain)
+{
+  typedef viennagrid::result_of::vertex_handle<DomainType>::type      VertexHandleType;
+
+  std::vector<VertexHandleType> vertices;
+  for (long j = 0; j <= squares_per_side; ++j)
+    for (long i = 0; i <= squares_per_side; ++i)
+      vertices.push_back(viennagrid::make_vertex(domain, PointType(numeric_type(i) / squares_per_side,
+                                                                   numeric_type(j) / squares_per_side)));
+
+  for (long j = 0; j < squares_per_side; ++j)
+    for (long i = 0; i < squares_per_side; ++i)
+    {
+      long v0 = j * (squares_per_side + 1) + i;
+      long v1 = v0 + 1;
+      long v2 = v0 + squares_per_side + 1;
+      long v3 = v2 + 1;
+      viennagrid::make_triangle(domain, vertices[v0], vertices[v1], vertices[v3]);
+      viennagrid::make_triangle(domain, vertices[v0], vertices[v3], vertices[v2]);
+    }
+}
+
+/**
+ * @brief Rough iterates for both quantities: a potential between -1 and 1 and a density spanning several orders of magnitude.
+ *        The potential has Dirichlet cells at the left edge, the density at the right edge and is disabled for x < 0.25
+ */
+void setup_quantities(DomainType & domain, StorageType & storage, long potential_id, long density_id)
+{
+  long ids[2] = { potential_id, density_id };
+  for (std::size_t q = 0; q < 2; ++q)
+  {
+    viennadata::result_of::accessor<StorageType, viennafvm::disable_quantity_key, bool, CellType>::type disabled =
+        viennadata::make_accessor(storage, viennafvm::disable_quantity_key(ids[q]));
+    viennadata::result_of::accessor<StorageType, viennafvm::boundary_key, bool, CellType>::type boundary =
+        viennadata::make_accessor(storage, viennafvm::boundary_key(ids[q]));
+    viennadata::result_of::accessor<StorageType, viennafvm::boundary_key, numeric_type, CellType>::type boundary_value =
+        viennadata::make_accessor(storage, viennafvm::boundary_key(ids[q]));
+    IterateAccessor iterate = viennadata::make_accessor(storage, viennafvm::current_iterate_key(ids[q]));
+
+    CellContainer cells(domain);
+    for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+    {
+      PointType    c  = viennagrid::centroid(*cit);
+      long         id = cit->id().get();
+      numeric_type h  = 1.0 / squares_per_side;
+
+      disabled(*cit) = (q == 1 && c[0] < 0.25);
+      boundary(*cit) = (q == 0) ? (c[0] < h) : (c[0] > 1.0 - h);
+      if (q == 0)
+      {
+        iterate(*cit) = std::sin(7.0 * id);
+        if (boundary(*cit))
+          boundary_value(*cit) = 0.5 + c[1];
+      }
+      else
+      {
+        iterate(*cit) = std::pow(10.0, 10.0 + 6.0 * std::sin(3.0 * id));
+        if (boundary(*cit))
+          boundary_value(*cit) = 1e16 * (1.0 + c[1]);
+      }
+    }
+  }
+}
+
+/** @brief Smooths the quantities either by smooth_initial_guess() per iteration or by the initial_guess_smoother, returns the iterates per cell ID */
+std::vector<numeric_type> smooth(std::size_t iterations, bool flat, long quantity)
+{
+  DomainType  domain;
+  StorageType storage;
+  setup_mesh(domain);
+
+  viennamath::function_symbol psi(0, viennamath::unknown_tag<>());
+  viennamath::function_symbol n(1, viennamath::unknown_tag<>());
+  setup_quantities(domain, storage, psi.id(), n.id());
+
+  if (flat)
+  {
+    viennafvm::initial_guess_smoother<DomainType, StorageType> smoother(domain, storage);
+    smoother.add(viennafvm::arithmetic_mean_smoother(), psi);
+    smoother.add(viennafvm::geometric_mean_smoother(),  n);
+    smoother(iterations);
+  }
+  else
+  {
+    for (std::size_t k = 0; k < iterations; ++k)
+    {
+      viennafvm::smooth_initial_guess(domain, storage, viennafvm::arithmetic_mean_smoother(), psi);
+      viennafvm::smooth_initial_guess(domain, storage, viennafvm::geometric_mean_smoother(),  n);
+    }
+  }
+
+  IterateAccessor iterate = viennadata::make_accessor(storage, viennafvm::current_iterate_key(quantity == 0 ? psi.id() : n.id()));
+
+  CellContainer cells(domain);
+  std::vector<numeric_type> result(cells.size());
+  for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+    result[cit->id().get()] = iterate(*cit);
+  return result;
+}
+
+numeric_type max_relative_difference(std::vector<numeric_type> const & a, std::vector<numeric_type> const & b)
+{
+  numeric_type scale = 0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    scale = std::max(scale, std::abs(a[i]));
+
+  numeric_type result = 0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    result = std::max(result, std::abs(a[i] - b[i]) / (std::abs(a[i]) > 0 ? std::abs(a[i]) : scale));
+  return result;
+}
+
+
+int check(std::size_t iterations)
+{
+  const char * names[2] = { "arithmetic mean", "geometric mean " };
+  for (long q = 0; q < 2; ++q)
+  {
+    std::vector<numeric_type> initial   = smooth(0, false, q);
+    std::vector<numeric_type> reference = smooth(iterations, false, q);
+    std::vector<numeric_type> flat      = smooth(iterations, true, q);
+
+    numeric_type difference = max_relative_difference(reference, flat);
+    std::cout << "* " << iterations << " iterations, " << names[q] << ": max. relative difference " << difference << std::endl;
+
+    if (difference > 1e-12)
+    {
+      std::cerr << "* The initial_guess_smoother deviates from smooth_initial_guess()!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (max_relative_difference(initial, reference) < 1e-3)
+    {
+      std::cerr << "* The smoothing did not change the iterates!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+
+int main()
+{
+  if (check(1)  != EXIT_SUCCESS)  return EXIT_FAILURE;
+  if (check(5)  != EXIT_SUCCESS)  return EXIT_FAILURE;
+  if (check(20) != EXIT_SUCCESS)  return EXIT_FAILURE;
+
+  std::cout << "******************************************************" << std::endl;
+  std::cout << "* Initial guess smoother test finished successfully! *" << std::endl;
+  std::cout << "******************************************************" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/* =======================================================================
+   Copyright (c) 2011, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+           ViennaFVM - The Vienna Finite Volume Method Library
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    To be discussed, see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+//
+// The drift-diffusion equation div(grad(n) - grad(psi) n) = 0 (in units of the thermal voltage) with a linear potential
+// psi has the solution n = a + b exp(psi), which the Scharfetter-Gummel flux reproduces exactly at the cell centers.
+// A large potential drop uses the exponential branch of the flux, small ones (below 0.01 per cell, of either sign)
+// use its expansion for small exponents, and both have to match the exact solution to the accuracy of the linear solver.
+//
+
+// include necessary system headers
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+// ViennaFVM includes:
+#include "viennafvm/forwards.h"
+#include "viennafvm/pde_solver.hpp"
+#include "viennafvm/linear_solvers/viennacl.hpp"
+
+// ViennaGrid includes:
+#include "viennagrid/mesh/mesh.hpp"
+#include "viennagrid/mesh/element_creation.hpp"
+#include <viennagrid/config/default_configs.hpp>
+
+// ViennaData includes:
+#include "viennadata/api.hpp"
+
+// ViennaMath includes:
+#include "viennamath/expression.hpp"
+
+
+typedef double                                                              numeric_type;
+typedef viennagrid::line_1d_mesh                                            DomainType;
+typedef viennagrid::result_of::cell_tag<DomainType>::type                   CellTag;
+typedef viennagrid::result_of::element<DomainType, CellTag>::type           CellType;
+typedef viennagrid::result_of::element_range<DomainType, CellTag>::type     CellContainer;
+typedef viennagrid::result_of::iterator<CellContainer>::type                CellIterator;
+typedef viennadata::storage<>                                               StorageType;
+
+typedef viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, numeric_type, CellType>::type  IterateAccessor;
+
+static const long cell_count = 100;
+
+
+void setup_mesh(DomainType & domain)
+{
+  typedef viennagrid::result_of::point<DomainType>::type              PointType;
+  typedef viennagrid::result_of::vertex_handle<DomainType>::type      VertexHandleType;
+
+  std::vector<VertexHandleType> vertices;
+  for (long i = 0; i <= cell_count; ++i)
+    vertices.push_back(viennagrid::make_vertex(domain, PointType(numeric_type(i) / cell_count)));
+  for (long i = 0; i < cell_count; ++i)
+    viennagrid::make_line(domain, vertices[i], vertices[i+1]);
+}
+
+/** @brief Dirichlet cells at both ends: the potential is 0 on the left and 'drop' on the right, the density 1 on the left and 2 on the right */
+void setup_boundary(DomainType & domain, StorageType & storage, long potential_id, long density_id, numeric_type drop)
+{
+  viennadata::result_of::accessor<StorageType, viennafvm::boundary_key, bool, CellType>::type psi_boundary =
+      viennadata::make_accessor(storage, viennafvm::boundary_key(potential_id));
+  viennadata::result_of::accessor<StorageType, viennafvm::boundary_key, numeric_type, CellType>::type psi_value =
+      viennadata::make_accessor(storage, viennafvm::boundary_key(potential_id));
+  viennadata::result_of::accessor<StorageType, viennafvm::boundary_key, bool, CellType>::type n_boundary =
+      viennadata::make_accessor(storage, viennafvm::boundary_key(density_id));
+  viennadata::result_of::accessor<StorageType, viennafvm::boundary_key, numeric_type, CellType>::type n_value =
+      viennadata::make_accessor(storage, viennafvm::boundary_key(density_id));
+  IterateAccessor psi = viennadata::make_accessor(storage, viennafvm::current_iterate_key(potential_id));
+  IterateAccessor n   = viennadata::make_accessor(storage, viennafvm::current_iterate_key(density_id));
+
+  CellContainer cells(domain);
+  for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+  {
+    long id = cit->id().get();
+    psi(*cit) = 0.0;
+    n(*cit)   = 1.0;
+    if (id == 0 || id == cell_count - 1)
+    {
+      psi_boundary(*cit) = true;
+      psi_value(*cit)    = (id == 0) ? 0.0 : drop;
+      psi(*cit)          = psi_value(*cit);
+      n_boundary(*cit)   = true;
+      n_value(*cit)      = (id == 0) ? 1.0 : 2.0;
+      n(*cit)            = n_value(*cit);
+    }
+  }
+}
+
+/** @brief Solves the potential and the density equation, returns the maximum relative deviation of the density from the exact solution */
+numeric_type solve(numeric_type drop)
+{
+  DomainType  domain;
+  StorageType storage;
+  setup_mesh(domain);
+
+  viennamath::function_symbol psi(0, viennamath::unknown_tag<>());
+  viennamath::function_symbol n(1, viennamath::unknown_tag<>());
+  setup_boundary(domain, storage, psi.id(), n.id(), drop);
+
+  viennamath::equation poisson_eq = viennamath::make_equation(viennamath::laplace(psi), 0);
+  viennamath::equation density_eq = viennamath::make_equation(viennamath::div(viennamath::grad(n) - viennamath::grad(psi) * n), 0);
+
+  viennafvm::linear_pde_system<> pde_system;
+  pde_system.add_pde(poisson_eq, psi);
+  pde_system.add_pde(density_eq, n);
+
+  viennafvm::linsolv::viennacl linear_solver;
+  viennafvm::pde_solver<>      pde_solver;
+  pde_solver(pde_system, domain, storage, linear_solver);
+
+  // the potential is linear between the Dirichlet cells, n = a + b exp(psi) matches the densities there
+  numeric_type b = 1.0 / (std::exp(drop) - 1.0);
+  numeric_type a = 1.0 - b;
+
+  IterateAccessor n_values = viennadata::make_accessor(storage, viennafvm::current_iterate_key(n.id()));
+
+  numeric_type result = 0;
+  CellContainer cells(domain);
+  for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+  {
+    numeric_type psi_exact = drop * numeric_type(cit->id().get()) / (cell_count - 1);
+    numeric_type n_exact   = a + b * std::exp(psi_exact);
+    result = std::max(result, std::abs(n_values(*cit) - n_exact) / n_exact);
+  }
+  return result;
+}
+
+
+int check(numeric_type drop)
+{
+  numeric_type deviation = solve(drop);
+  std::cout << "* Potential drop " << drop << " (" << drop / (cell_count - 1) << " per cell): max. relative deviation " << deviation << std::endl;
+
+  if (deviation > 1e-8)
+  {
+    std::cerr << "* The Scharfetter-Gummel flux does not reproduce the exact solution!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+
+int main()
+{
+  if (check( 50.0)  != EXIT_SUCCESS)  return EXIT_FAILURE;
+  if (check(-50.0)  != EXIT_SUCCESS)  return EXIT_FAILURE;
+  if (check( 0.5)   != EXIT_SUCCESS)  return EXIT_FAILURE;
+  if (check(-0.5)   != EXIT_SUCCESS)  return EXIT_FAILURE;
+  if (check( 0.98)  != EXIT_SUCCESS)  return EXIT_FAILURE;
+
+  std::cout << "*******************************************************" << std::endl;
+  std::cout << "* Scharfetter-Gummel flux test finished successfully! *" << std::endl;
+  std::cout << "*******************************************************" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,340 @@
+/* =======================================================================
+   Copyright (c) 2011, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+           ViennaFVM - The Vienna Finite Volume Method Library
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    To be discussed, see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+//
+// Decay of the slowest diffusion mode u_t = u_xx on a uniform 1D mesh with homogeneous Dirichlet cells at both ends.
+// The initial state sin(pi (x - x_0) / L) at the cell centers is an eigenvector of the discrete Laplacian,
+// hence the semi-discrete solution decays exactly like exp(-lambda t) with lambda = 4/h^2 sin^2(pi h / (2 L)).
+// This isolates the error of the time integration: backward Euler and BDF2 have to show their orders
+// at fixed steps, and an adaptive run with rejected steps has to start every solve from the last accepted state.
+//
+
+// include necessary system headers
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+// ViennaFVM includes:
+#include "viennafvm/forwards.h"
+#include "viennafvm/pde_solver.hpp"
+#include "viennafvm/transient_solver.hpp"
+#include "viennafvm/linear_solvers/viennacl.hpp"
+
+// ViennaGrid includes:
+#include "viennagrid/mesh/mesh.hpp"
+#include "viennagrid/mesh/element_creation.hpp"
+#include <viennagrid/config/default_configs.hpp>
+#include "viennagrid/algorithm/centroid.hpp"
+
+// ViennaData includes:
+#include "viennadata/api.hpp"
+
+// ViennaMath includes:
+#include "viennamath/expression.hpp"
+
+
+typedef double                                                              numeric_type;
+typedef viennagrid::line_1d_mesh                                            DomainType;
+typedef viennagrid::result_of::cell_tag<DomainType>::type                   CellTag;
+typedef viennagrid::result_of::element<DomainType, CellTag>::type           CellType;
+typedef viennagrid::result_of::element_range<DomainType, CellTag>::type     CellContainer;
+typedef viennagrid::result_of::iterator<CellContainer>::type                CellIterator;
+typedef viennadata::storage<>                                               StorageType;
+
+typedef viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, numeric_type, CellType>::type  IterateAccessor;
+
+static const long         cell_count = 100;
+static const numeric_type pi         = 3.1415926535897932384626433832795;
+
+
+/** @brief Checks that every linear solve starts from the state of the last accepted step. The pde_solver solves
+    a linear PDE with exactly one linear solve, hence each call corresponds to one attempted time step */
+class restore_checking_solver : public viennafvm::linsolv::viennacl
+{
+  public:
+    restore_checking_solver(IterateAccessor iterate, CellType const & probe)
+      : iterate_(iterate), probe_(probe), expected_(iterate(probe)), solves_(0), mismatches_(0) {}
+
+    template <typename MatrixT, typename VectorT>
+    void operator()(MatrixT& A, VectorT& b, VectorT& x)
+    {
+      if (iterate_(probe_) != expected_)
+        ++mismatches_;
+      ++solves_;
+      viennafvm::linsolv::viennacl::operator()(A, b, x);
+    }
+
+    void accept() { expected_ = iterate_(probe_); }
+
+    std::size_t solves()     const { return solves_; }
+    std::size_t mismatches() const { return mismatches_; }
+
+  private:
+    IterateAccessor   iterate_;
+    CellType const &  probe_;
+    numeric_type      expected_;
+    std::size_t       solves_;
+    std::size_t       mismatches_;
+};
+
+/** @brief Records the accepted steps and checks that the reported times are consistent with the step sizes */
+class step_observer : public viennafvm::transient_observer
+{
+  public:
+    explicit step_observer(restore_checking_solver * solver = NULL) : solver_(solver), time_(0), inconsistent_(0) {}
+
+    void accepted(std::size_t /*step*/, numeric_type time, numeric_type step_size)
+    {
+      if (std::abs(time_ + step_size - time) > 1e-14 * time)
+        ++inconsistent_;
+      time_ = time;
+      if (solver_)
+        solver_->accept();
+    }
+
+    std::size_t inconsistent() const { return inconsistent_; }
+
+  private:
+    restore_checking_solver * solver_;
+    numeric_type              time_;
+    std::size_t               inconsistent_;
+};
+
+
+struct diffusion_problem
+{
+  diffusion_problem() : u(0, viennamath::unknown_tag<>())
+  {
+    typedef viennagrid::result_of::point<DomainType>::type              PointType;
+    typedef viennagrid::result_of::vertex_handle<DomainType>::type      VertexHandleType;
+
+    std::vector<VertexHandleType> vertices;
+    for (long i = 0; i <= cell_count; ++i)
+      vertices.push_back(viennagrid::make_vertex(domain, PointType(numeric_type(i) / cell_count)));
+    for (long i = 0; i < cell_count; ++i)
+      viennagrid::make_line(domain, vertices[i], vertices[i+1]);
+
+    // the Dirichlet cells at both ends pin the mode at their centers, i.e. the effective length is 1 - h
+    h      = 1.0 / cell_count;
+    x0     = 0.5 * h;
+    length = 1.0 - h;
+    lambda = 4.0 / (h * h) * std::pow(std::sin(pi * h / (2.0 * length)), 2);
+  }
+
+  /** @brief Writes the initial state and the boundary data to the storage */
+  void reset()
+  {
+    storage = StorageType();
+
+    viennadata::result_of::accessor<StorageType, viennafvm::boundary_key, bool, CellType>::type is_boundary =
+        viennadata::make_accessor(storage, viennafvm::boundary_key(u.id()));
+    viennadata::result_of::accessor<StorageType, viennafvm::boundary_key, numeric_type, CellType>::type boundary_value =
+        viennadata::make_accessor(storage, viennafvm::boundary_key(u.id()));
+    IterateAccessor iterate = viennadata::make_accessor(storage, viennafvm::current_iterate_key(u.id()));
+
+    CellContainer cells(domain);
+    for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+    {
+      long id = cit->id().get();
+      if (id == 0 || id == cell_count - 1)
+      {
+        is_boundary(*cit)    = true;
+        boundary_value(*cit) = 0.0;
+        iterate(*cit)        = 0.0;
+      }
+      else
+        iterate(*cit) = mode(*cit);
+    }
+  }
+
+  numeric_type mode(CellType const & cell) const
+  {
+    return std::sin(pi * (viennagrid::centroid(cell)[0] - x0) / length);
+  }
+
+  /** @brief Maximum deviation from the semi-discrete solution exp(-lambda t) times the initial mode */
+  numeric_type error(numeric_type time)
+  {
+    IterateAccessor iterate = viennadata::make_accessor(storage, viennafvm::current_iterate_key(u.id()));
+
+    numeric_type decay  = std::exp(-lambda * time);
+    numeric_type result = 0;
+    CellContainer cells(domain);
+    for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+      result = std::max(result, std::abs(iterate(*cit) - decay * mode(*cit)));
+    return result;
+  }
+
+  DomainType                      domain;
+  StorageType                     storage;
+  viennamath::function_symbol     u;
+  numeric_type                    h, x0, length, lambda;
+};
+
+
+/** @brief Integrates up to end_time with the given constant step, returns the error at end_time */
+numeric_type fixed_step_error(diffusion_problem & problem, viennafvm::time_integration_scheme scheme,
+                              numeric_type end_time, long steps)
+{
+  problem.reset();
+
+  viennafvm::linsolv::viennacl  linear_solver;
+  viennafvm::pde_solver<>       pde_solver;
+  viennafvm::transient_solver<> transient(pde_solver);
+
+  numeric_type dt = end_time / steps;
+  transient.add_time_derivative(0);
+  transient.set_scheme(scheme);
+  transient.set_initial_step(dt);
+  transient.set_step_limits(dt, dt);
+  transient.set_relative_tolerance(1.0e10);  // never reject
+
+  viennamath::equation diffusion = viennamath::make_equation(viennamath::laplace(problem.u), 0);
+  viennafvm::linear_pde_system<> pde_system = viennafvm::make_linear_pde_system(diffusion, problem.u);
+  if (!transient(pde_system, problem.domain, problem.storage, linear_solver, end_time))
+    return -1;
+  if (transient.statistics().accepted != static_cast<std::size_t>(steps))
+  {
+    std::cerr << "Expected " << steps << " steps, got " << transient.statistics().accepted << std::endl;
+    return -1;
+  }
+  return problem.error(end_time);
+}
+
+int check_order(diffusion_problem & problem, viennafvm::time_integration_scheme scheme, std::string const & name,
+                numeric_type expected_order)
+{
+  numeric_type end_time = 1.0 / 16.0;  // about half a decay time
+  numeric_type e1 = fixed_step_error(problem, scheme, end_time, 16);
+  numeric_type e2 = fixed_step_error(problem, scheme, end_time, 32);
+  numeric_type e3 = fixed_step_error(problem, scheme, end_time, 64);
+  if (e1 < 0 || e2 < 0 || e3 < 0)
+  {
+    std::cerr << "* " << name << ": transient run failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  numeric_type order1 = std::log(e1 / e2) / std::log(2.0);
+  numeric_type order2 = std::log(e2 / e3) / std::log(2.0);
+  std::cout << "* " << name << ": errors " << e1 << ", " << e2 << ", " << e3
+            << ", observed orders " << order1 << ", " << order2 << std::endl;
+
+  if (std::abs(order2 - expected_order) > 0.1 || std::abs(order1 - expected_order) > 0.2)
+  {
+    std::cerr << "* " << name << ": observed order does not match " << expected_order << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+int check_adaptive(diffusion_problem & problem, viennafvm::time_integration_scheme scheme, std::string const & name)
+{
+  problem.reset();
+
+  CellContainer cells(problem.domain);
+  restore_checking_solver linear_solver(viennadata::make_accessor(problem.storage, viennafvm::current_iterate_key(problem.u.id())),
+                                        cells[cell_count / 2]);
+  step_observer observer(&linear_solver);
+
+  viennafvm::pde_solver<>       pde_solver;
+  viennafvm::transient_solver<> transient(pde_solver);
+
+  numeric_type end_time  = 0.25;
+  numeric_type tolerance = 1.0e-4;
+  transient.add_time_derivative(0);
+  transient.set_scheme(scheme);
+  transient.set_initial_step(5.0e-3);  // too large for the tolerance, forces rejected steps
+  transient.set_step_limits(1.0e-10, end_time);
+  transient.set_relative_tolerance(tolerance);
+  transient.set_absolute_tolerance(problem.u.id(), tolerance);
+  transient.set_observer(&observer);
+
+  viennamath::equation diffusion = viennamath::make_equation(viennamath::laplace(problem.u), 0);
+  viennafvm::linear_pde_system<> pde_system = viennafvm::make_linear_pde_system(diffusion, problem.u);
+  bool success = transient(pde_system, problem.domain, problem.storage, linear_solver, end_time);
+
+  viennafvm::transient_statistics const & statistics = transient.statistics();
+  numeric_type error = problem.error(end_time);
+  std::cout << "* " << name << " adaptive: " << statistics.accepted << " accepted, " << statistics.rejected << " rejected steps, "
+            << "steps " << statistics.smallest_step << " .. " << statistics.largest_step << ", error " << error << std::endl;
+
+  if (!success || statistics.time != end_time)
+  {
+    std::cerr << "* " << name << ": adaptive run did not reach the end time" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (statistics.rejected == 0)
+  {
+    std::cerr << "* " << name << ": no rejected steps, the restore is not exercised" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (linear_solver.solves() != statistics.accepted + statistics.rejected || linear_solver.mismatches() > 0)
+  {
+    std::cerr << "* " << name << ": " << linear_solver.mismatches() << " of " << linear_solver.solves()
+              << " solves did not start from the last accepted state" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (observer.inconsistent() > 0)
+  {
+    std::cerr << "* " << name << ": accepted times are inconsistent with the step sizes" << std::endl;
+    return EXIT_FAILURE;
+  }
+  // the local errors are controlled, the global error may accumulate them over the steps
+  if (error > statistics.accepted * tolerance)
+  {
+    std::cerr << "* " << name << ": error " << error << " exceeds the tolerance" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+int check_kernel()
+{
+  std::vector<numeric_type> previous(3, 2.0), previous2(3, 5.0);
+  numeric_type value = 7.0, derivative = 0;
+
+  viennafvm::time_derivative kernel(0);
+  kernel.set(3.0, -4.0, 0.5, &previous, &previous2);
+  numeric_type result = kernel.eval(1, &value, &derivative);
+  if (result != 3.0 * 7.0 - 4.0 * 2.0 + 0.5 * 5.0 || derivative != 3.0)
+  {
+    std::cerr << "* time_derivative: wrong BDF2 value " << result << " or derivative " << derivative << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  kernel.set(2.0, -2.0, 0, &previous, NULL);
+  result = kernel.eval(1, &value, &derivative);
+  if (result != 2.0 * 7.0 - 2.0 * 2.0 || derivative != 2.0)
+  {
+    std::cerr << "* time_derivative: wrong backward Euler value " << result << " or derivative " << derivative << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+
+int main()
+{
+  diffusion_problem problem;
+
+  if (check_kernel() != EXIT_SUCCESS)                                              return EXIT_FAILURE;
+  if (check_order(problem, viennafvm::backward_euler, "backward Euler", 1.0) != EXIT_SUCCESS) return EXIT_FAILURE;
+  if (check_order(problem, viennafvm::bdf2,           "BDF2",           2.0) != EXIT_SUCCESS) return EXIT_FAILURE;
+  if (check_adaptive(problem, viennafvm::backward_euler, "backward Euler") != EXIT_SUCCESS)   return EXIT_FAILURE;
+  if (check_adaptive(problem, viennafvm::bdf2,           "BDF2")           != EXIT_SUCCESS)   return EXIT_FAILURE;
+
+  std::cout << "***************************************************" << std::endl;
+  std::cout << "* Transient diffusion test finished successfully! *" << std::endl;
+  std::cout << "***************************************************" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,40 @@
+#ifndef VIENNAFVM_COEFFICIENT_UPDATER_HPP
+#define VIENNAFVM_COEFFICIENT_UPDATER_HPP
+
+/* =======================================================================
+   Copyright (c) 2011, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+           ViennaFVM - The Vienna Finite Volume Method Library
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+#include <cstddef>
+
+#include "viennafvm/forwards.h"
+
+namespace viennafvm
+{
+  /** @brief Hook of the pde_solver for coefficients which depend on the solution, e.g. field-dependent mobilities.
+   *
+   * update() is called before the assembly of each nonlinear iteration, after the updates of the previous
+   * iteration have been applied to the current iterates. Implementations write the new coefficients
+   * to the storage, from where the ncell_quantity wrappers of the PDE system pick them up.
+   */
+  class coefficient_updater
+  {
+    public:
+      virtual ~coefficient_updater() {}
+
+      virtual void update(std::size_t nonlinear_iteration) = 0;
+  };
+
+} // viennafvm
+
+#endif
@@ -624,7 +624,7 @@ namespace viennafvm
           if ( std::abs(exponent) > 0.01) // Actual tolerance is not critical - this is for stabilization purposes only
             return val_B / (std::exp(exponent) - 1);
           else
-            return val_A / d;  // Note: Can be obtained from tailor expansion of the equation above
+            return val_A / d * (1.0 - exponent / 2.0 + exponent * exponent / 12.0);  // Taylor expansion of the Bernoulli function x / (exp(x) - 1)
         }
 
         // pure diffusion:
@@ -665,7 +665,7 @@ namespace viennafvm
           if ( std::abs(exponent) > 0.01) // Actual tolerance is not critical - this is for stabilization purposes only
             return val_B / (1.0 - std::exp(-exponent));
           else
-            return val_A / d;  // Note: Can be obtained from tailor expansion of the equation above
+            return val_A / d * (1.0 + exponent / 2.0 + exponent * exponent / 12.0);  // Taylor expansion of the Bernoulli function -x / (exp(-x) - 1)
         }
 
         // pure diffusion:
@@ -16,6 +16,7 @@
 ============================================================================ */
 
 #include <cmath>
+#include <vector>
 #include <assert.h>
 
 #include "viennafvm/forwards.h"
@@ -24,6 +25,7 @@
 #include "viennafvm/boundary.hpp"
 
 #include "viennagrid/mesh/mesh.hpp"
+#include "viennagrid/algorithm/csr_adjacency.hpp"
 
 #include "viennadata/api.hpp"
 
@@ -226,6 +228,188 @@ namespace viennafvm
                       viennafvm::current_iterate_key(func_symbol.id()));
     }
 
+  /** @brief Smooths the initial guesses of several quantities at once on flat arrays.
+   *
+   * Equivalent to calling smooth_initial_guess() for each quantity in each iteration, i.e. each enabled, non-Dirichlet cell
+   * takes the mean of its own value and the values of its enabled neighbors (Dirichlet neighbors contribute their boundary value).
+   * The neighbor lists are extracted once from the CSR cell adjacency of the mesh, after which each iteration is a single
+   * Jacobi sweep over contiguous arrays for all quantities, alternating between two buffers. Geometric means are computed as
+   * arithmetic means of the logarithms, so all quantities share the same sweep.
+   * The sweeps run in parallel if VIENNAFVM_WITH_OPENMP is defined.
+   */
+  template <typename DomainSegmentType, typename StorageType>
+  class initial_guess_smoother
+  {
+      typedef typename viennagrid::result_of::cell_tag<DomainSegmentType>::type                     CellTag;
+      typedef typename viennagrid::result_of::element<DomainSegmentType, CellTag>::type             CellType;
+      typedef typename viennagrid::result_of::const_element_range<DomainSegmentType, CellTag>::type CellContainer;
+      typedef typename viennagrid::result_of::iterator<CellContainer>::type                         CellIterator;
+
+      typedef viennagrid::csr_adjacency::index_type                                                 IndexType;
+      typedef std::vector<IndexType>                                                                IndexArrayType;
+
+      typedef typename viennadata::result_of::accessor<StorageType, disable_quantity_key, bool, CellType>::type          DisabledAccessorType;
+      typedef typename viennadata::result_of::accessor<StorageType, boundary_key, bool, CellType>::type                  BoundaryAccessorType;
+      typedef typename viennadata::result_of::accessor<StorageType, boundary_key, numeric_type, CellType>::type          BoundaryValueAccessorType;
+      typedef typename viennadata::result_of::accessor<StorageType, current_iterate_key, numeric_type, CellType>::type   IterateAccessorType;
+
+      struct quantity
+      {
+        DisabledAccessorType      disabled;
+        BoundaryAccessorType      boundary;
+        BoundaryValueAccessorType boundary_value;
+        IterateAccessorType       iterate;
+        bool                      geometric;
+      };
+
+    public:
+      initial_guess_smoother(DomainSegmentType const & domseg, StorageType & storage) : storage_(storage)
+      {
+        viennagrid::csr_adjacency adjacency(domseg);
+        neighbor_offsets_ = adjacency.cell_neighbor_offsets();
+        neighbors_        = adjacency.neighbors();
+
+        // the cells in the order of the adjacency
+        CellContainer cells(domseg);
+        cells_.reserve(cells.size());
+        for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+          cells_.push_back(&(*cit));
+      }
+
+      /** @brief Adds a quantity, smoothed by the arithmetic mean */
+      template <typename InterfaceType>
+      void add(arithmetic_mean_smoother const &, viennamath::rt_function_symbol<InterfaceType> const & func_symbol)
+      {
+        add(func_symbol.id(), false);
+      }
+
+      /** @brief Adds a quantity, smoothed by the geometric mean. The values must not be negative */
+      template <typename InterfaceType>
+      void add(geometric_mean_smoother const &, viennamath::rt_function_symbol<InterfaceType> const & func_symbol)
+      {
+        add(func_symbol.id(), true);
+      }
+
+      /** @brief Runs the given number of smoothing iterations on all quantities and writes the results to the current iterates */
+      void operator()(std::size_t iterations)
+      {
+        if (iterations == 0 || quantities_.empty() || cells_.empty())
+          return;
+
+        IndexType num_quantities = quantities_.size();
+        IndexType num_values     = cells_.size() * num_quantities;
+
+        //
+        // Gather the values and the neighbor lists. Entry i*num_quantities+q refers to quantity q on cell i.
+        // Dirichlet cells hold their boundary value, as seen by their neighbors, and are not updated themselves
+        //
+        std::vector<numeric_type> values(num_values);
+        std::vector<bool>         updated(num_values);
+        for (IndexType i = 0; i < cells_.size(); ++i)
+          for (IndexType q = 0; q < num_quantities; ++q)
+          {
+            quantity const & quan = quantities_[q];
+            bool disabled = quan.disabled(*cells_[i]);
+            bool boundary = quan.boundary(*cells_[i]);
+            numeric_type value = boundary ? quan.boundary_value(*cells_[i]) : quan.iterate(*cells_[i]);
+
+            if (quan.geometric && !disabled)
+            {
+              assert(value >= 0 && bool("Quantity a in geometric smoother negative!"));
+              value = std::log(value);
+            }
+            values[i * num_quantities + q]  = value;
+            updated[i * num_quantities + q] = !disabled && !boundary;
+          }
+
+        offsets_.assign(1, 0);
+        columns_.clear();
+        inverse_counts_.assign(num_values, 0);
+        for (IndexType i = 0; i < cells_.size(); ++i)
+          for (IndexType q = 0; q < num_quantities; ++q)
+          {
+            IndexType row = i * num_quantities + q;
+            if (updated[row])
+            {
+              columns_.push_back(row);
+              for (IndexType j = neighbor_offsets_[i]; j < neighbor_offsets_[i+1]; ++j)
+              {
+                IndexType column = neighbors_[j] * num_quantities + q;
+                if (!quantities_[q].disabled(*cells_[neighbors_[j]]))
+                  columns_.push_back(column);
+              }
+              inverse_counts_[row] = numeric_type(1) / numeric_type(columns_.size() - offsets_.back());
+            }
+            offsets_.push_back(columns_.size());
+          }
+
+        //
+        // Jacobi sweeps, alternating between the two buffers
+        //
+        std::vector<numeric_type> next(values);
+        for (std::size_t k = 0; k < iterations; ++k)
+        {
+          sweep(values, next);
+          values.swap(next);
+        }
+
+        //
+        // Scatter the results
+        //
+        for (IndexType i = 0; i < cells_.size(); ++i)
+          for (IndexType q = 0; q < num_quantities; ++q)
+          {
+            IndexType row = i * num_quantities + q;
+            if (!updated[row])
+              continue;
+
+            numeric_type value = values[row];
+            quantities_[q].iterate(*cells_[i]) = quantities_[q].geometric ? std::exp(value) : value;
+          }
+      }
+
+    private:
+      void add(long id, bool geometric)
+      {
+        quantity quan;
+        quan.disabled       = viennadata::make_accessor<disable_quantity_key, bool, CellType>(storage_, disable_quantity_key(id));
+        quan.boundary       = viennadata::make_accessor<boundary_key, bool, CellType>(storage_, boundary_key(id));
+        quan.boundary_value = viennadata::make_accessor<boundary_key, numeric_type, CellType>(storage_, boundary_key(id));
+        quan.iterate        = viennadata::make_accessor<current_iterate_key, numeric_type, CellType>(storage_, current_iterate_key(id));
+        quan.geometric      = geometric;
+        quantities_.push_back(quan);
+      }
+
+      void sweep(std::vector<numeric_type> const & values, std::vector<numeric_type> & next) const
+      {
+        long num_rows = static_cast<long>(values.size());
+#ifdef VIENNAFVM_WITH_OPENMP
+        #pragma omp parallel for
+#endif
+        for (long row = 0; row < num_rows; ++row)
+        {
+          if (offsets_[row] == offsets_[row+1])
+            continue;
+
+          numeric_type sum = 0;
+          for (IndexType j = offsets_[row]; j < offsets_[row+1]; ++j)
+            sum += values[columns_[j]];
+          next[row] = sum * inverse_counts_[row];
+        }
+      }
+
+      StorageType                     & storage_;
+      std::vector<CellType const *>     cells_;
+      IndexArrayType                    neighbor_offsets_;
+      IndexArrayType                    neighbors_;
+      std::vector<quantity>             quantities_;
+
+      // averaging stencil of each updated entry, including the entry itself
+      IndexArrayType                    offsets_;
+      IndexArrayType                    columns_;
+      std::vector<numeric_type>         inverse_counts_;
+  };
+
 }
 
 #endif
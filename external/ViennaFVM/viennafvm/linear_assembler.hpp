@@ -16,6 +16,10 @@
    license:    To be discussed, see file LICENSE in the ViennaFVM base directory
 ======================================================================= */
 
+// *** system includes
+//
+#include <vector>
+#include <algorithm>
 
 // *** local includes
 //
@@ -26,6 +30,8 @@
 #include "viennafvm/util.hpp"
 #include "viennafvm/flux.hpp"
 #include "viennafvm/ncell_quantity.hpp"
+#include "viennafvm/profiler.hpp"
+#include "viennafvm/volume_kernel.hpp"
 
 #include "viennagrid/forwards.hpp"
 #include "viennagrid/algorithm/voronoi.hpp"
@@ -38,6 +44,8 @@
 
 #include "viennadata/api.hpp"
 
+#include <boost/numeric/ublas/matrix_sparse.hpp>
+
 //#define VIENNAFVMDEBUG
 
 namespace viennafvm
@@ -53,6 +61,31 @@ namespace viennafvm
     facet_value_accessor(facet) = (value_outer - value_inner) / distance;
   }
 
+  namespace detail
+  {
+    /** @brief Empties a system matrix and resizes it for assembly */
+    template <typename MatrixT>
+    void reset_system_matrix(MatrixT & system_matrix, std::size_t size)
+    {
+      system_matrix.clear();
+      system_matrix.resize(size, size, false);
+    }
+
+    /** @brief A compressed matrix which already has the right size keeps its sparsity pattern and only its values are zeroed,
+        so repeated assemblies of the same system (nonlinear iterations, time steps) accumulate into existing entries */
+    template <typename T, typename L, std::size_t IB, typename IA, typename TA>
+    void reset_system_matrix(boost::numeric::ublas::compressed_matrix<T, L, IB, IA, TA> & system_matrix, std::size_t size)
+    {
+      if (system_matrix.size1() == size && system_matrix.size2() == size)
+      {
+        std::fill(system_matrix.value_data().begin(), system_matrix.value_data().end(), T(0));
+        return;
+      }
+      system_matrix.clear();
+      system_matrix.resize(size, size, false);
+    }
+  }
+
 
 
 
@@ -81,8 +114,7 @@ namespace viennafvm
 
         std::size_t map_index = viennafvm::create_mapping(pde_system, segment, storage);
 
-        system_matrix.clear();
-        system_matrix.resize(map_index, map_index, false);
+        detail::reset_system_matrix(system_matrix, map_index);
         load_vector.clear();
         load_vector.resize(map_index);
 
@@ -126,8 +158,7 @@ namespace viennafvm
 
         std::size_t map_index = viennafvm::create_mapping(pde_system, pde_index, segment, storage);
 
-        system_matrix.clear();
-        system_matrix.resize(map_index, map_index, false);
+        detail::reset_system_matrix(system_matrix, map_index);
         load_vector.clear();
         load_vector.resize(map_index);
 
@@ -236,9 +267,31 @@ namespace viennafvm
         typename viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, double, CellType>::type current_iterate_accessor =
             viennadata::make_accessor(storage, viennafvm::current_iterate_key(u.id()));
 
+        // compiled volume sources: accessors to the iterates each kernel depends on, and the position of u among them
+        typedef typename viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, double, CellType>::type  IterateAccessorType;
+
+        std::vector<volume_kernel const *> const & kernels = pde_options.volume_kernels();
+        std::vector< std::vector<IterateAccessorType> > kernel_iterates(kernels.size());
+        std::vector<long> kernel_unknown(kernels.size(), -1);
+        std::size_t kernel_arguments = 1;
+        for (std::size_t k=0; k<kernels.size(); ++k)
+        {
+          std::vector<long> const & quantities = kernels[k]->quantities();
+          for (std::size_t i=0; i<quantities.size(); ++i)
+          {
+            kernel_iterates[k].push_back(viennadata::make_accessor(storage, viennafvm::current_iterate_key(quantities[i])));
+            if (quantities[i] == static_cast<long>(u.id()))
+              kernel_unknown[k] = static_cast<long>(i);
+          }
+          kernel_arguments = std::max(kernel_arguments, quantities.size());
+        }
+        std::vector<numeric_type> kernel_values(kernel_arguments);
+        std::vector<numeric_type> kernel_derivatives(kernel_arguments);
+
         //
         // Actual assembly:
         //
+        std::size_t assembled_cells = 0;
         CellContainer cells(segment);
         for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
         {
@@ -246,6 +299,7 @@ namespace viennafvm
 
           if (row_index < 0)
             continue;
+          ++assembled_cells;
 
           // update ncell quantities in expressions for current cell:
           viennamath::rt_traversal_wrapper<interface_type> cell_updater( new detail::ncell_updater<CellType, interface_type>(*cit) );
@@ -320,8 +374,22 @@ namespace viennafvm
           load_vector(row_index) += viennamath::eval(rhs_omega_integrand, p) * cell_volume;
           //std::cout << "Writing " << viennamath::eval(omega_integrand, p) << " * " << cell_volume << " to rhs at " << row_index << std::endl;
 
+          // Compiled sources on the RHS: residual and the analytic derivative with respect to u
+          for (std::size_t k=0; k<kernels.size(); ++k)
+          {
+            for (std::size_t i=0; i<kernel_iterates[k].size(); ++i)
+              kernel_values[i] = kernel_iterates[k][i](*cit);
+
+            numeric_type source = kernels[k]->eval(cit->id().get(), &(kernel_values[0]), &(kernel_derivatives[0]));
+
+            load_vector(row_index) += source * cell_volume;
+            if (kernel_unknown[k] >= 0)
+              system_matrix(row_index, row_index) -= kernel_derivatives[kernel_unknown[k]] * cell_volume;
+          }
+
         } // for cells
 
+        viennafvm::profiler::counter("cells_assembled", static_cast<double>(assembled_cells));
       } // assemble
 
       template <typename SegmentT, typename StorageType>
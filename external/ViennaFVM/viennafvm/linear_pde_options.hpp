@@ -19,10 +19,12 @@
 // *** system includes
 //
 #include <vector>
+#include <algorithm>
 
 // *** local includes:
 //
 //#include "viennafvm/forwards.h"
+#include "viennafvm/volume_kernel.hpp"
 
 // *** vienna includes:
 //
@@ -50,11 +52,21 @@ namespace viennafvm
       viennamath::expr damping_term() const { return damping_term_; }
       void damping_term(viennamath::expr const & e) { damping_term_ = e; }
 
+      /** @brief Compiled volume sources of the PDE, see volume_kernel. The kernels are not owned and must outlive the assembly */
+      std::vector<volume_kernel const *> const & volume_kernels() const { return volume_kernels_; }
+      void add_volume_kernel(volume_kernel const * kernel) { volume_kernels_.push_back(kernel); }
+      void remove_volume_kernel(volume_kernel const * kernel)
+      {
+        volume_kernels_.erase(std::remove(volume_kernels_.begin(), volume_kernels_.end(), kernel), volume_kernels_.end());
+      }
+      void clear_volume_kernels() { volume_kernels_.clear(); }
+
     private:
       long data_id_;
       bool check_mapping_;
       bool geometric_update_;
       viennamath::expr damping_term_;
+      std::vector<volume_kernel const *> volume_kernels_;
   };
 
   inline linear_pde_options make_linear_pde_options(long data_id, bool existing_mapping = false)
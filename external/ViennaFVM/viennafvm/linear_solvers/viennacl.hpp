@@ -31,6 +31,7 @@
 #include "viennacl/linalg/jacobi_precond.hpp"
 #include "viennacl/linalg/row_scaling.hpp"
 #include "viennafvm/timer.hpp"
+#include "viennafvm/profiler.hpp"
 
 namespace viennafvm {
 
@@ -126,7 +127,9 @@ private:
 //      std::cout << "using pc: none .. " << std::endl;
       last_pc_time_ = 0.0;
       timer.start();
+      viennafvm::profiler::scope krylov_scope("krylov");
       x = ::viennacl::linalg::solve(A, b, linear_solver);
+      krylov_scope.stop();
       last_solver_time_ = timer.get();
     }
     else
@@ -137,11 +140,15 @@ private:
       pc_config.use_level_scheduling(false);
 
       timer.start();
+      viennafvm::profiler::scope preconditioner_scope("preconditioner");
       ::viennacl::linalg::ilu0_precond<MatrixT>    preconditioner(A, pc_config);
+      preconditioner_scope.stop();
       last_pc_time_ = timer.get();
 
       timer.start();
+      viennafvm::profiler::scope krylov_scope("krylov");
       x = ::viennacl::linalg::solve(A, b, linear_solver, preconditioner);
+      krylov_scope.stop();
       last_solver_time_ = timer.get();
     }
     else
@@ -154,11 +161,15 @@ private:
       pc_config.use_level_scheduling(false);
 
       timer.start();
+      viennafvm::profiler::scope preconditioner_scope("preconditioner");
       ::viennacl::linalg::ilut_precond<MatrixT>    preconditioner(A, pc_config);
+      preconditioner_scope.stop();
       last_pc_time_ = timer.get();
 
       timer.start();
+      viennafvm::profiler::scope krylov_scope("krylov");
       x = ::viennacl::linalg::solve(A, b, linear_solver, preconditioner);
+      krylov_scope.stop();
       last_solver_time_ = timer.get();
     }
     else
@@ -169,11 +180,15 @@ private:
       pc_config.use_level_scheduling(false);
 
       timer.start();
+      viennafvm::profiler::scope preconditioner_scope("preconditioner");
       ::viennacl::linalg::block_ilu_precond<MatrixT, ::viennacl::linalg::ilu0_tag>    preconditioner(A, pc_config);
+      preconditioner_scope.stop();
       last_pc_time_ = timer.get();
 
       timer.start();
+      viennafvm::profiler::scope krylov_scope("krylov");
       x = ::viennacl::linalg::solve(A, b, linear_solver, preconditioner);
+      krylov_scope.stop();
       last_solver_time_ = timer.get();
     }
     else
@@ -181,11 +196,15 @@ private:
     {
 //      std::cout << "using pc: jacobi .. " << std::endl;
       timer.start();
+      viennafvm::profiler::scope preconditioner_scope("preconditioner");
       ::viennacl::linalg::jacobi_precond<MatrixT>    preconditioner(A, ::viennacl::linalg::jacobi_tag());
+      preconditioner_scope.stop();
       last_pc_time_ = timer.get();
 
       timer.start();
+      viennafvm::profiler::scope krylov_scope("krylov");
       x = ::viennacl::linalg::solve(A, b, linear_solver, preconditioner);
+      krylov_scope.stop();
       last_solver_time_ = timer.get();
     }
     else
@@ -193,11 +212,15 @@ private:
     {
 //      std::cout << "using pc: row_scaling .. " << std::endl;
       timer.start();
+      viennafvm::profiler::scope preconditioner_scope("preconditioner");
       ::viennacl::linalg::row_scaling<MatrixT>    preconditioner(A, ::viennacl::linalg::row_scaling_tag());
+      preconditioner_scope.stop();
       last_pc_time_ = timer.get();
 
       timer.start();
+      viennafvm::profiler::scope krylov_scope("krylov");
       x = ::viennacl::linalg::solve(A, b, linear_solver, preconditioner);
+      krylov_scope.stop();
       last_solver_time_ = timer.get();
     }
     else
@@ -15,14 +15,19 @@
    license:    see file LICENSE in the ViennaFVM base directory
 ======================================================================= */
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include <boost/numeric/ublas/io.hpp>
 #include <boost/numeric/ublas/matrix_sparse.hpp>
 #include <boost/numeric/ublas/operation.hpp>
 #include <boost/numeric/ublas/operation_sparse.hpp>
 
-#ifdef VIENNAFVM_VERBOSE
 #include "viennafvm/timer.hpp"
-#endif
+#include "viennafvm/solver_monitor.hpp"
+#include "viennafvm/coefficient_updater.hpp"
+#include "viennafvm/profiler.hpp"
 #include "viennafvm/forwards.h"
 #include "viennafvm/linear_assembler.hpp"
 #include "viennafvm/linear_solvers/viennacl.hpp"
@@ -30,95 +35,231 @@
 namespace viennafvm
 {
 
-  template <typename PDESystemType, typename DomainType, typename StorageType, typename VectorType>
-  double apply_update(PDESystemType const & pde_system, std::size_t pde_index,
-                      DomainType const & domain,
-                      StorageType & storage,
-                      VectorType const & update, numeric_type alpha = 0.3)
+  /** @brief The enabled cells of the unknown of one PDE, flattened into contiguous arrays of iterates, boundary values
+   *         and unknown indices, over which the Newton updates are applied.
+   *
+   * Boundary flags, disabled cells and the numbering of the unknowns do not change during a solver run, so the layout is
+   * built once per run. Each update then gathers the iterates, computes the damping term A_n and the update norm in parallel
+   * reductions over the arrays, writes the new values of the unknowns into the solution vector in the same pass, and scatters
+   * the iterates back. The loops run in parallel if VIENNAFVM_WITH_OPENMP is defined.
+   */
+  template <typename DomainType, typename StorageType>
+  class update_layout
   {
-    typedef typename viennagrid::result_of::cell_tag<DomainType>::type CellTag;
+      typedef typename viennagrid::result_of::cell_tag<DomainType>::type                            CellTag;
+      typedef typename viennagrid::result_of::element<DomainType, CellTag>::type                    CellType;
+      typedef typename viennagrid::result_of::const_element_range<DomainType, CellTag>::type        CellContainer;
+      typedef typename viennagrid::result_of::iterator<CellContainer>::type                         CellIterator;
 
-    typedef typename viennagrid::result_of::point<DomainType>::type                  PointType;
-    typedef typename viennagrid::result_of::element<DomainType, CellTag>::type    CellType;
+      typedef typename viennadata::result_of::accessor<StorageType, current_iterate_key, numeric_type, CellType>::type   IterateAccessorType;
 
-    typedef typename viennagrid::result_of::const_element_range<DomainType, CellTag>::type   CellContainer;
-    typedef typename viennagrid::result_of::iterator<CellContainer>::type                       CellIterator;
+    public:
+      update_layout() : geometric_(false), result_offset_(0) {}
+
+      /** @brief Collects the enabled cells of the PDE. The unknowns are numbered in cell order starting from zero, as by create_mapping(),
+       *         result_offset is the index of the first unknown in the solution vector. Returns the number of unknowns
+       */
+      template <typename PDESystemType>
+      long init(PDESystemType const & pde_system, std::size_t pde_index,
+                DomainType const & domain, StorageType & storage, long result_offset)
+      {
+        typedef typename PDESystemType::boundary_key_type  BoundaryKeyType;
 
-    typedef typename PDESystemType::mapping_key_type   MappingKeyType;
-    typedef typename PDESystemType::boundary_key_type  BoundaryKeyType;
+        long unknown_id = pde_system.unknown(pde_index)[0].id();
+        long unknown_size = static_cast<long>(pde_system.unknown(pde_index).size());
 
-    long unknown_id = pde_system.unknown(pde_index)[0].id();
+        typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, bool, CellType>::type boundary_accessor =
+            viennadata::make_accessor(storage, BoundaryKeyType(unknown_id));
 
-    BoundaryKeyType bnd_key(unknown_id);
-    MappingKeyType  map_key(unknown_id);
+        typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, numeric_type, CellType>::type boundary_value_accessor =
+            viennadata::make_accessor(storage, BoundaryKeyType(unknown_id));
 
-    viennamath::function_symbol const & u = pde_system.unknown(pde_index)[0];
-    numeric_type l2_update_norm = 0;
+        typename viennadata::result_of::accessor<StorageType, viennafvm::disable_quantity_key, bool, CellType>::type disable_quantity_accessor =
+            viennadata::make_accessor(storage, viennafvm::disable_quantity_key(unknown_id));
 
+        iterate_       = viennadata::make_accessor(storage, viennafvm::current_iterate_key(unknown_id));
+        geometric_     = pde_system.option(pde_index).geometric_update();
+        result_offset_ = result_offset;
 
-    typename viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, double, CellType>::type current_iterate_accessor =
-        viennadata::make_accessor(storage, viennafvm::current_iterate_key(u.id()));
+        cells_.clear();
+        unknowns_.clear();
+        boundary_values_.clear();
 
-    typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, bool, CellType>::type boundary_accessor =
-        viennadata::make_accessor(storage, bnd_key);
+        long num_unknowns = 0;
+        CellContainer cells(domain);
+        for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+        {
+          if (disable_quantity_accessor(*cit))
+            continue;
 
-    typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, numeric_type, CellType>::type boundary_value_accessor =
-        viennadata::make_accessor(storage, bnd_key);
+          cells_.push_back(&(*cit));
+          if (boundary_accessor(*cit))
+          {
+            unknowns_.push_back(-1);
+            boundary_values_.push_back(boundary_value_accessor(*cit));
+          }
+          else
+          {
+            unknowns_.push_back(num_unknowns);
+            boundary_values_.push_back(0);
+            num_unknowns += unknown_size;
+          }
+        }
+        values_.resize(cells_.size());
 
-    typename viennadata::result_of::accessor<StorageType, viennafvm::mapping_key, long, CellType>::type cell_mapping_accessor =
-        viennadata::make_accessor(storage, map_key);
+        return num_unknowns;
+      }
 
-    typename viennadata::result_of::accessor<StorageType, viennafvm::disable_quantity_key, bool, CellType>::type disable_quantity_accessor =
-        viennadata::make_accessor(storage, viennafvm::disable_quantity_key(unknown_id));
+      /** @brief Writes the current iterates of the unknowns into the solution vector */
+      template <typename ResultVectorType>
+      void transfer(ResultVectorType & result)
+      {
+        for (std::size_t i = 0; i < cells_.size(); ++i)
+          if (unknowns_[i] >= 0)
+            result(result_offset_ + unknowns_[i]) = iterate_(*cells_[i]);
+      }
 
-    CellContainer cells(domain);
+      /** @brief Applies the damped update to the iterates and the solution vector. update(update_offset + i) is the update of the i-th unknown.
+       *         Dirichlet cells are moved towards their boundary values. Returns the l2 norm of the applied update
+       */
+      template <typename VectorType, typename ResultVectorType>
+      numeric_type apply(VectorType const & update, long update_offset, numeric_type alpha, ResultVectorType & result)
+      {
+        return apply_impl(update, update_offset, alpha, &result);
+      }
 
-    // get damping term
-    numeric_type A_n = 0.0;
-    if (pde_system.option(pde_index).geometric_update())
-    {
-      for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+      /** @brief Applies the damped update to the iterates only */
+      template <typename VectorType>
+      numeric_type apply(VectorType const & update, long update_offset, numeric_type alpha)
       {
-        if (!disable_quantity_accessor(*cit))
+        return apply_impl(update, update_offset, alpha, static_cast<VectorType *>(NULL));
+      }
+
+      long result_offset() const { return result_offset_; }
+
+    private:
+      template <typename VectorType, typename ResultVectorType>
+      numeric_type apply_impl(VectorType const & update, long update_offset, numeric_type alpha, ResultVectorType * result)
+      {
+        long num_cells = static_cast<long>(cells_.size());
+
+        for (long i = 0; i < num_cells; ++i)
+          values_[i] = iterate_(*cells_[i]);
+
+        // get damping term
+        numeric_type A_n = 0.0;
+        if (geometric_)
+        {
+#ifdef VIENNAFVM_WITH_OPENMP
+          #pragma omp parallel
+#endif
+          {
+            numeric_type local_A_n = 0.0;
+#ifdef VIENNAFVM_WITH_OPENMP
+            #pragma omp for nowait
+#endif
+            for (long i = 0; i < num_cells; ++i)
+            {
+              numeric_type current_value = values_[i];
+              numeric_type update_value  = update_of(update, update_offset, i);
+              if (current_value != 0)
+                local_A_n = std::max(local_A_n, std::abs(update_value / current_value));
+            }
+#ifdef VIENNAFVM_WITH_OPENMP
+            #pragma omp critical
+#endif
+            A_n = std::max(A_n, local_A_n);
+          }
+        }
+
+        // apply update, accumulate its norm and transfer the unknowns to the solution vector:
+        numeric_type l2_update_norm = 0;
+#ifdef VIENNAFVM_WITH_OPENMP
+        #pragma omp parallel for reduction(+:l2_update_norm)
+#endif
+        for (long i = 0; i < num_cells; ++i)
         {
-          double current_value = current_iterate_accessor(*cit);
-          double update_value = boundary_accessor(*cit)
-                                 ? boundary_value_accessor(*cit) - current_value
-                                 : update(cell_mapping_accessor(*cit));
+          numeric_type current_value = values_[i];
+          numeric_type update_value  = update_of(update, update_offset, i);
+
+          numeric_type new_value = current_value + alpha * update_value;
 
-          if (current_value != 0)
-            A_n = std::max(A_n, std::abs(update_value / current_value));
+          if (geometric_)
+          {
+            if (update_value < 0)
+              new_value = current_value + alpha * ( update_value / (1.0 - A_n * ( update_value / current_value ) ));
+            else if (alpha != 1.0) // the geometric mean of current and full update, otherwise the full update
+            {
+              if (current_value > 0)
+                new_value = current_value * std::pow(1.0 + update_value / current_value, alpha);
+              else
+                new_value = std::pow(current_value, 1.0 - alpha) * std::pow( current_value + update_value, alpha);
+            }
+          }
+
+          l2_update_norm += (new_value - current_value) * (new_value - current_value);
+          values_[i] = new_value;
+          if (result && unknowns_[i] >= 0)
+            (*result)(result_offset_ + unknowns_[i]) = new_value;
         }
+
+        for (long i = 0; i < num_cells; ++i)
+          iterate_(*cells_[i]) = values_[i];
+
+        return std::sqrt(l2_update_norm);
       }
-    }
 
-    // apply update:
-    for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
-    {
-      if (!disable_quantity_accessor(*cit))
+      template <typename VectorType>
+      numeric_type update_of(VectorType const & update, long update_offset, long i) const
       {
-        double current_value = current_iterate_accessor(*cit);
-        double update_value = boundary_accessor(*cit)
-                               ? boundary_value_accessor(*cit) - current_value
-                               : update(cell_mapping_accessor(*cit));
+        return (unknowns_[i] < 0) ? boundary_values_[i] - values_[i]
+                                  : update(update_offset + unknowns_[i]);
+      }
 
-        numeric_type new_value = current_value + alpha * update_value;
+      IterateAccessorType             iterate_;
+      bool                            geometric_;
+      long                            result_offset_;
 
-        if (pde_system.option(pde_index).geometric_update())
-        {
-          if (update_value < 0)
-            new_value = current_value + alpha * ( update_value / (1.0 - A_n * ( update_value / current_value ) ));
-          else
-            new_value = std::pow(current_value, 1.0 - alpha) * std::pow( current_value + update_value, alpha);
-        }
+      std::vector<CellType const *>   cells_;             // enabled cells, in cell order
+      std::vector<long>               unknowns_;          // index of the unknown of each cell, negative for Dirichlet cells
+      std::vector<numeric_type>       boundary_values_;   // Dirichlet value of each cell, zero otherwise
+      std::vector<numeric_type>       values_;            // current iterates
+  };
+
+
+  template <typename PDESystemType, typename DomainType, typename StorageType, typename VectorType>
+  double apply_update(PDESystemType const & pde_system, std::size_t pde_index,
+                      DomainType const & domain,
+                      StorageType & storage,
+                      VectorType const & update, numeric_type alpha = 0.3)
+  {
+    typedef typename viennagrid::result_of::cell_tag<DomainType>::type                            CellTag;
+    typedef typename viennagrid::result_of::element<DomainType, CellTag>::type                    CellType;
+    typedef typename viennagrid::result_of::const_element_range<DomainType, CellTag>::type        CellContainer;
+    typedef typename viennagrid::result_of::iterator<CellContainer>::type                         CellIterator;
+
+    typedef typename PDESystemType::mapping_key_type   MappingKeyType;
+
+    long unknown_id = pde_system.unknown(pde_index)[0].id();
 
-        l2_update_norm += (new_value - current_value) * (new_value - current_value);
-        current_iterate_accessor(*cit) = new_value;
+    typename viennadata::result_of::accessor<StorageType, viennafvm::mapping_key, long, CellType>::type cell_mapping_accessor =
+        viennadata::make_accessor(storage, MappingKeyType(unknown_id));
+
+    // the unknowns are numbered in cell order, so the first mapped cell gives the offset of the PDE in the update vector
+    long update_offset = 0;
+    CellContainer cells(domain);
+    for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+    {
+      if (cell_mapping_accessor(*cit) >= 0)
+      {
+        update_offset = cell_mapping_accessor(*cit);
+        break;
       }
     }
 
-//    std::cout << "* Update norm for quantity " << pde_index << ": " << std::sqrt(l2_update_norm) << std::endl;
-    return std::sqrt(l2_update_norm);
+    update_layout<DomainType, StorageType> layout;
+    layout.init(pde_system, pde_index, domain, storage, 0);
+    return layout.apply(update, update_offset, alpha);
   }
 
 
@@ -175,6 +316,19 @@ namespace viennafvm
   }
 
 
+  /** @brief Accumulated wall clock times of the steps of a pde_solver run, in seconds */
+  struct solver_timings
+  {
+    solver_timings() : coefficients(0), assembly(0), preconditioner(0), linear_solve(0), update(0), transfer(0) {}
+
+    double coefficients;     // updating solution-dependent coefficients
+    double assembly;
+    double preconditioner;   // as reported by the linear solver
+    double linear_solve;
+    double update;
+    double transfer;         // packing the iterates into the result vector
+  };
+
   template<typename MatrixType = boost::numeric::ublas::compressed_matrix<viennafvm::numeric_type>,
            typename VectorType = boost::numeric::ublas::vector<viennafvm::numeric_type> >
   class pde_solver
@@ -188,6 +342,11 @@ namespace viennafvm
         nonlinear_iterations  = 100;
         nonlinear_breaktol    = 1.0e-3;
         damping               = 1.0;
+        monitor_              = NULL;
+        updater_              = NULL;
+        cancelled_            = false;
+        converged_            = false;
+        required_iterations_  = 0;
       }
 
       template<typename PDESystemT, typename DomainT, typename StorageT, typename LinearSolverT>
@@ -197,12 +356,42 @@ namespace viennafvm
         std::streamsize cout_precision = std::cout.precision();
       #endif
 
+        viennafvm::profiler::scope solver_scope("pde_solver");
+
         bool is_linear = pde_system.is_linear(); //TODO: Replace with an automatic detection
 
+        cancelled_ = false;
+        timings_   = solver_timings();
+        viennafvm::Timer run_timer;
+        run_timer.start();
+
+        solver_progress progress;
+        progress.nonlinear_iterations = is_linear ? 1 : nonlinear_iterations;
+        progress.break_pde            = break_pde;
+        progress.nonlinear_breaktol   = nonlinear_breaktol;
+
+        // flatten the unknowns of each PDE once per run. The updates keep the result vector current,
+        // starting from the initial iterates, so it holds the last iterate after cancellation as well
+        viennafvm::Timer transfer_timer;
+        transfer_timer.start();
+        std::vector< update_layout<DomainT, StorageT> > layouts(pde_system.size());
+        long num_unknowns = 0;
+        for (std::size_t pde_index = 0; pde_index < pde_system.size(); ++pde_index)
+          num_unknowns += layouts[pde_index].init(pde_system, pde_index, domain, storage, num_unknowns);
+        result_.resize(num_unknowns, false);
+        for (std::size_t pde_index = 0; pde_index < pde_system.size(); ++pde_index)
+          layouts[pde_index].transfer(result_);
+        timings_.transfer = transfer_timer.get();
+
         if (is_linear)
         {
+          update_coefficients(0);
           for (std::size_t pde_index = 0; pde_index < pde_system.size(); ++pde_index)
           {
+            if (cancel_requested()) break;
+            progress.pde_index = pde_index;
+            notify(progress, phase_assembly, run_timer);
+
           #ifdef VIENNAFVM_VERBOSE
             viennafvm::Timer timer;
             timer.start();
@@ -210,34 +399,44 @@ namespace viennafvm
             std::cout << " ------------------------------------------" << std::endl;
           #endif
 
-            MatrixType system_matrix;
+            MatrixType & system_matrix = system_matrix_of(pde_index);
             VectorType load_vector;
 
-          #ifdef VIENNAFVM_VERBOSE
             viennafvm::Timer subtimer;
             subtimer.start();
-          #endif
+            viennafvm::profiler::scope assembly_scope("assembly");
             viennafvm::linear_assembler fvm_assembler;
             fvm_assembler(pde_system, domain, storage, system_matrix, load_vector);
+            timings_.assembly += subtimer.get();
+            assembly_scope.stop();
+            viennafvm::profiler::counter("nnz", static_cast<double>(system_matrix.nnz()));
+            viennafvm::profiler::counter("allocated_bytes", static_cast<double>(system_bytes(system_matrix, load_vector)));
           #ifdef VIENNAFVM_VERBOSE
             std::cout.precision(3);
             subtimer.get();
             std::cout << "   Assembly time : " << std::fixed << subtimer.get() << " s" << std::endl;
           #endif
 
+            notify(progress, phase_linear_solve, run_timer);
             VectorType update;
+            viennafvm::profiler::scope solve_scope("linear_solve");
             linear_solver(system_matrix, load_vector, update);
+            solve_scope.stop();
+            viennafvm::profiler::counter("krylov_iterations", static_cast<double>(linear_solver.last_iterations()));
+            timings_.preconditioner += linear_solver.last_pc_time();
+            timings_.linear_solve   += linear_solver.last_solver_time();
           #ifdef VIENNAFVM_VERBOSE
             std::cout << "   Precond time  : " << std::fixed << linear_solver.last_pc_time() << " s" << std::endl;
             std::cout << "   Solver time   : " << std::fixed << linear_solver.last_solver_time() << " s" << std::endl;
           #endif
 
-          #ifdef VIENNAFVM_VERBOSE
             subtimer.start();
-            numeric_type update_norm = apply_update(pde_system, pde_index, domain, storage, update, damping);
-          #else
-            apply_update(pde_system, pde_index, domain, storage, update, damping);
-          #endif
+            viennafvm::profiler::scope update_scope("update");
+            numeric_type update_norm = layouts[pde_index].apply(update, layouts[pde_index].result_offset(), damping, result_);
+            update_scope.stop();
+            timings_.update += subtimer.get();
+            progress.update_norm = update_norm;
+            notify(progress, phase_update, run_timer);
 
           #ifdef VIENNAFVM_VERBOSE
             subtimer.get();
@@ -263,10 +462,17 @@ namespace viennafvm
             std::cout << std::endl;
           #endif
           }
-          std::size_t map_index = create_mapping(pde_system, domain, storage);
-          result_.resize(map_index);
+          progress.converged = !cancelled_;
+          notify(progress, cancelled_ ? phase_cancelled : phase_finished, run_timer);
+
+          converged_           = !cancelled_;
+          required_iterations_ = 1;
 
-          transfer_to_solution_vector(pde_system, domain, storage, result_);
+          // the result vector is already filled by the updates, only the mapping for reading it back is needed
+          transfer_timer.start();
+          viennafvm::profiler::scope transfer_scope("transfer");
+          create_mapping(pde_system, domain, storage);
+          timings_.transfer += transfer_timer.get();
         }
         else // nonlinear
         {
@@ -280,14 +486,22 @@ namespace viennafvm
           std::size_t required_nonlinear_iterations = 0;
           for (std::size_t iter=0; iter < nonlinear_iterations; ++iter)
           {
+            viennafvm::profiler::scope iteration_scope("nonlinear_iteration");
             required_nonlinear_iterations++;
+            progress.nonlinear_iteration = iter;
           #ifdef VIENNAFVM_VERBOSE
             std::cout << " --- Nonlinear iteration " << iter << " --- " << std::endl;
           #endif
+            if (!cancel_requested())
+              update_coefficients(iter);
             if (picard_iteration_)
             {
               for (std::size_t pde_index = 0; pde_index < pde_system.size(); ++pde_index)
               {
+                if (cancel_requested()) break;
+                progress.pde_index = pde_index;
+                notify(progress, phase_assembly, run_timer);
+
               #ifdef VIENNAFVM_VERBOSE
                 viennafvm::Timer timer;
                 timer.start();
@@ -296,33 +510,45 @@ namespace viennafvm
               #endif
 
 
-                MatrixType system_matrix;
+                MatrixType & system_matrix = system_matrix_of(pde_index);
                 VectorType load_vector;
 
-              #ifdef VIENNAFVM_VERBOSE
                 viennafvm::Timer subtimer;
                 subtimer.start();
-              #endif
+                viennafvm::profiler::scope assembly_scope("assembly");
                 // assemble linearized systems
                 viennafvm::linear_assembler fvm_assembler;
                 fvm_assembler(pde_system, pde_index, domain, storage, system_matrix, load_vector);
+                timings_.assembly += subtimer.get();
+                assembly_scope.stop();
+                viennafvm::profiler::counter("nnz", static_cast<double>(system_matrix.nnz()));
+                viennafvm::profiler::counter("allocated_bytes", static_cast<double>(system_bytes(system_matrix, load_vector)));
               #ifdef VIENNAFVM_VERBOSE
                 std::cout.precision(3);
                 subtimer.get();
                 std::cout << "   Assembly time : " << std::fixed << subtimer.get() << " s" << std::endl;
               #endif
 
+                notify(progress, phase_linear_solve, run_timer);
                 VectorType update;
+                viennafvm::profiler::scope solve_scope("linear_solve");
                 linear_solver(system_matrix, load_vector, update);
+                solve_scope.stop();
+                viennafvm::profiler::counter("krylov_iterations", static_cast<double>(linear_solver.last_iterations()));
+                timings_.preconditioner += linear_solver.last_pc_time();
+                timings_.linear_solve   += linear_solver.last_solver_time();
               #ifdef VIENNAFVM_VERBOSE
                 std::cout << "   Precond time  : " << std::fixed << linear_solver.last_pc_time() << " s" << std::endl;
                 std::cout << "   Solver time   : " << std::fixed << linear_solver.last_solver_time() << " s" << std::endl;
               #endif
 
-              #ifdef VIENNAFVM_VERBOSE
                 subtimer.start();
-              #endif
-                numeric_type update_norm = apply_update(pde_system, pde_index, domain, storage, update, damping);
+                viennafvm::profiler::scope update_scope("update");
+                numeric_type update_norm = layouts[pde_index].apply(update, 0, damping, result_);
+                update_scope.stop();
+                timings_.update += subtimer.get();
+                progress.update_norm = update_norm;
+                notify(progress, phase_update, run_timer);
               #ifdef VIENNAFVM_VERBOSE
                 subtimer.get();
                 std::cout << "   Update time   : " << std::fixed << subtimer.get() << " s" << std::endl;
@@ -382,11 +608,25 @@ namespace viennafvm
           #ifdef VIENNAFVM_VERBOSE
             std::cout << std::endl;
           #endif
-            if(converged) break; // .. the nonlinear for-loop
+            if(converged || cancelled_) break; // .. the nonlinear for-loop
 
           } // nonlinear for-loop
 
+          progress.converged = converged;
+          notify(progress, cancelled_ ? phase_cancelled : phase_finished, run_timer);
+
+          converged_           = converged;
+          required_iterations_ = required_nonlinear_iterations;
+
         #ifdef VIENNAFVM_VERBOSE
+          if(cancelled_)
+          {
+              std::cout << std::endl;
+              std::cout << "--------" << std::endl;
+              std::cout << "Warning: Simulation cancelled in nonlinear iteration " << required_nonlinear_iterations-1 << "!" << std::endl;
+              std::cout << "--------" << std::endl;
+          }
+          else
           if(converged)
           {
               std::cout << std::endl;
@@ -407,10 +647,11 @@ namespace viennafvm
           }
         #endif
 
-          // need to pack all approximations into a single vector:
-          std::size_t map_index = create_mapping(pde_system, domain, storage);
-          result_.resize(map_index);
-          transfer_to_solution_vector(pde_system, domain, storage, result_);
+          // the result vector is already filled by the updates, only the global mapping for reading it back is needed
+          transfer_timer.start();
+          viennafvm::profiler::scope transfer_scope("transfer");
+          create_mapping(pde_system, domain, storage);
+          timings_.transfer += transfer_timer.get();
         }
 
       }
@@ -426,12 +667,77 @@ namespace viennafvm
       numeric_type get_damping() { return damping; }
       void set_damping(numeric_type value) { damping = value; }
 
+      /** @brief Sets an observer which receives progress reports and may stop the solver between linear solves. Pass NULL to detach. */
+      void set_monitor(solver_monitor * monitor) { monitor_ = monitor; }
+
+      /** @brief Sets a hook which updates solution-dependent coefficients before each nonlinear iteration. Pass NULL to detach. */
+      void set_coefficient_updater(coefficient_updater * updater) { updater_ = updater; }
+
+      /** @brief Returns true if the last run was stopped by the monitor. The result then holds the last iterate */
+      bool cancelled() const { return cancelled_; }
+
+      /** @brief Returns true if the last run reached the break tolerance (always true for linear systems, unless cancelled) */
+      bool converged() const { return converged_; }
+
+      /** @brief Returns the number of nonlinear iterations of the last run */
+      std::size_t get_required_nonlinear_iterations() const { return required_iterations_; }
+
+      /** @brief Returns the accumulated times of the solver steps of the last run */
+      solver_timings const & timings() const { return timings_; }
+
     private:
+      /** @brief Estimates the memory allocated for a compressed system matrix and its load vector */
+      static std::size_t system_bytes(MatrixType const & system_matrix, VectorType const & load_vector)
+      {
+        return system_matrix.nnz() * (sizeof(numeric_type) + sizeof(std::size_t))
+             + (system_matrix.size1() + 1) * sizeof(std::size_t)
+             + load_vector.size() * sizeof(numeric_type);
+      }
+
+      /** @brief The system matrix of a PDE is kept between runs, so that the assembly reuses its sparsity pattern */
+      MatrixType & system_matrix_of(std::size_t pde_index)
+      {
+        if (system_matrices_.size() <= pde_index)
+          system_matrices_.resize(pde_index + 1);
+        return system_matrices_[pde_index];
+      }
+
+      void update_coefficients(std::size_t iter)
+      {
+        if (!updater_) return;
+        viennafvm::Timer timer;
+        timer.start();
+        viennafvm::profiler::scope scope("coefficient_update");
+        updater_->update(iter);
+        timings_.coefficients += timer.get();
+      }
+
+      bool cancel_requested()
+      {
+        cancelled_ = cancelled_ || (monitor_ && monitor_->cancelled());
+        return cancelled_;
+      }
+
+      void notify(solver_progress & progress, solver_phase phase, viennafvm::Timer const & timer)
+      {
+        if (!monitor_) return;
+        progress.phase   = phase;
+        progress.elapsed = timer.get();
+        monitor_->notify(progress);
+      }
+
       VectorType result_;
+      std::vector<MatrixType> system_matrices_;
       bool picard_iteration_;
       std::size_t     nonlinear_iterations;
       numeric_type    nonlinear_breaktol;
       numeric_type    damping;
+      solver_monitor* monitor_;
+      coefficient_updater* updater_;
+      bool            cancelled_;
+      bool            converged_;
+      std::size_t     required_iterations_;
+      solver_timings  timings_;
   };
 
 }
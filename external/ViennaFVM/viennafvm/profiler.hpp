@@ -0,0 +1,347 @@
+#ifndef VIENNAFVM_PROFILER_HPP
+#define VIENNAFVM_PROFILER_HPP
+
+/* =======================================================================
+   Copyright (c) 2011, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+           ViennaFVM - The Vienna Finite Volume Method Library
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/** @file profiler.hpp
+    @brief Lightweight instrumentation with nested scoped timers and counters.
+
+    The profiler is always compiled in and switched on at runtime via profiler::enable().
+    While disabled, a scope costs a single branch. Events are recorded into per-thread
+    buffers and exported after the instrumented run, either as Chrome trace JSON
+    (chrome://tracing, Perfetto) or as folded stacks for flame graph tools.
+
+    Event and counter names must be string literals (or otherwise outlive the export).
+*/
+
+#include <cstddef>
+#include <vector>
+#include <map>
+#include <string>
+#include <ostream>
+#include <fstream>
+
+#include "viennafvm/timer.hpp"
+
+#ifdef _WIN32
+  #include <windows.h>
+  #define VIENNAFVM_THREAD_LOCAL __declspec(thread)
+#else
+  #include <pthread.h>
+  #define VIENNAFVM_THREAD_LOCAL __thread
+#endif
+
+namespace viennafvm
+{
+  namespace profiler
+  {
+    /** @brief A recorded event: 'B' begins a scope, 'E' ends the innermost scope, 'C' is a counter sample */
+    struct event
+    {
+      event(const char * n, char p, double t, double v) : name(n), phase(p), timestamp(t), value(v) {}
+
+      const char *  name;
+      char          phase;
+      double        timestamp;   // microseconds since the profiler has been enabled for the first time
+      double        value;       // counter value
+    };
+
+    namespace detail
+    {
+      class mutex
+      {
+        public:
+        #ifdef _WIN32
+          mutex()       { InitializeCriticalSection(&cs_); }
+          ~mutex()      { DeleteCriticalSection(&cs_); }
+          void lock()   { EnterCriticalSection(&cs_); }
+          void unlock() { LeaveCriticalSection(&cs_); }
+        private:
+          CRITICAL_SECTION cs_;
+        #else
+          mutex()       { pthread_mutex_init(&m_, NULL); }
+          ~mutex()      { pthread_mutex_destroy(&m_); }
+          void lock()   { pthread_mutex_lock(&m_); }
+          void unlock() { pthread_mutex_unlock(&m_); }
+        private:
+          pthread_mutex_t m_;
+        #endif
+          mutex(mutex const &);
+          mutex & operator=(mutex const &);
+      };
+
+      /** @brief A flag which may be written by one thread while others read it. Reading costs a plain load
+          on the common platforms, the write is published with release semantics */
+      class atomic_flag
+      {
+        public:
+          atomic_flag() : value_(0) {}
+        #ifdef _WIN32
+          bool load() const   { return InterlockedCompareExchange(&value_, 0, 0) != 0; }
+          void store(bool v)  { InterlockedExchange(&value_, v ? 1 : 0); }
+        private:
+          mutable volatile LONG value_;
+        #else
+          bool load() const   { return __atomic_load_n(&value_, __ATOMIC_ACQUIRE) != 0; }
+          void store(bool v)  { __atomic_store_n(&value_, v ? 1 : 0, __ATOMIC_RELEASE); }
+        private:
+          int value_;
+        #endif
+          atomic_flag(atomic_flag const &);
+          atomic_flag & operator=(atomic_flag const &);
+      };
+
+      struct thread_buffer
+      {
+        explicit thread_buffer(std::size_t id) : thread_id(id) { events.reserve(4096); }
+
+        std::size_t         thread_id;
+        std::vector<event>  events;
+      };
+
+      /** @brief Owns the buffers of all threads which have recorded events. Only registering a new thread locks */
+      struct registry
+      {
+        registry() { clock.start(); }
+
+        ~registry()
+        {
+          for (std::size_t i = 0; i < buffers.size(); ++i)
+            delete buffers[i];
+        }
+
+        mutex                         lock;
+        std::vector<thread_buffer *>  buffers;
+        viennafvm::Timer              clock;
+      };
+
+      inline registry & get_registry()
+      {
+        static registry instance;
+        return instance;
+      }
+
+      inline atomic_flag & enabled_flag()
+      {
+        static atomic_flag flag;
+        return flag;
+      }
+
+      inline thread_buffer & local_buffer()
+      {
+        static VIENNAFVM_THREAD_LOCAL thread_buffer * buffer = NULL;
+        if (!buffer)
+        {
+          registry & reg = get_registry();
+          reg.lock.lock();
+          buffer = new thread_buffer(reg.buffers.size());
+          reg.buffers.push_back(buffer);
+          reg.lock.unlock();
+        }
+        return *buffer;
+      }
+
+      inline double now()
+      {
+        return get_registry().clock.get() * 1.0e6;
+      }
+
+      inline void record(const char * name, char phase, double value)
+      {
+        local_buffer().events.push_back(event(name, phase, now(), value));
+      }
+    } // detail
+
+    /** @brief Returns true if events are recorded */
+    inline bool enabled() { return detail::enabled_flag().load(); }
+
+    /** @brief Starts recording. May be called while instrumented code is running in other threads,
+        their scopes opened before are then not recorded. The clock starts with the first call and is
+        not reset by later ones, so the timestamps of all recordings share the same origin */
+    inline void enable()
+    {
+      detail::get_registry();
+      detail::enabled_flag().store(true);
+    }
+
+    /** @brief Stops recording, the recorded events are kept for the export. Scopes which are open
+        meanwhile still record their end */
+    inline void disable() { detail::enabled_flag().store(false); }
+
+    /** @brief Drops all recorded events. Must not be called while instrumented code is running */
+    inline void clear()
+    {
+      detail::registry & reg = detail::get_registry();
+      reg.lock.lock();
+      for (std::size_t i = 0; i < reg.buffers.size(); ++i)
+        reg.buffers[i]->events.clear();
+      reg.lock.unlock();
+    }
+
+    /** @brief Opens a scope on the calling thread, prefer the scope class */
+    inline void begin(const char * name)
+    {
+      if (enabled()) detail::record(name, 'B', 0);
+    }
+
+    /** @brief Closes the innermost scope opened with begin() on the calling thread */
+    inline void end(const char * name)
+    {
+      if (enabled()) detail::record(name, 'E', 0);
+    }
+
+    /** @brief Records a sample of a counter, e.g. the number of assembled cells or Krylov iterations */
+    inline void counter(const char * name, double value)
+    {
+      if (enabled()) detail::record(name, 'C', value);
+    }
+
+    /** @brief Times the enclosing block. stop() ends the scope early, e.g. if objects created
+        inside the timed section must outlive it */
+    class scope
+    {
+      public:
+        explicit scope(const char * name) : name_(name), active_(enabled())
+        {
+          if (active_) detail::record(name_, 'B', 0);
+        }
+
+        ~scope() { stop(); }
+
+        void stop()
+        {
+          if (active_) detail::record(name_, 'E', 0); // also if the profiler has been disabled meanwhile
+          active_ = false;
+        }
+
+      private:
+        scope(scope const &);
+        scope & operator=(scope const &);
+
+        const char *  name_;
+        bool          active_;
+    };
+
+    namespace detail
+    {
+      inline void write_json_string(std::ostream & stream, const char * str)
+      {
+        stream << '"';
+        for (; *str; ++str)
+        {
+          if (*str == '"' || *str == '\\') stream << '\\';
+          stream << *str;
+        }
+        stream << '"';
+      }
+    }
+
+    /** @brief Writes all recorded events in the Chrome trace event format */
+    inline void write_chrome_trace(std::ostream & stream)
+    {
+      detail::registry & reg = detail::get_registry();
+      reg.lock.lock();
+
+      std::streamsize precision = stream.precision(15);
+      stream << "{\"traceEvents\":[";
+      bool first = true;
+      for (std::size_t i = 0; i < reg.buffers.size(); ++i)
+      {
+        std::vector<event> const & events = reg.buffers[i]->events;
+        for (std::size_t j = 0; j < events.size(); ++j)
+        {
+          stream << (first ? "\n" : ",\n");
+          first = false;
+
+          stream << "{\"name\":";
+          detail::write_json_string(stream, events[j].name);
+          stream << ",\"ph\":\"" << events[j].phase << "\",\"ts\":" << events[j].timestamp
+                 << ",\"pid\":1,\"tid\":" << reg.buffers[i]->thread_id;
+          if (events[j].phase == 'C')
+          {
+            stream << ",\"args\":{";
+            detail::write_json_string(stream, events[j].name);
+            stream << ":" << events[j].value << "}";
+          }
+          stream << "}";
+        }
+      }
+      stream << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+      stream.precision(precision);
+
+      reg.lock.unlock();
+    }
+
+    /** @brief Writes the self time of each call stack in microseconds as 'outer;inner;innermost <time>',
+        the input format of flamegraph.pl and speedscope. Counters are not part of the output */
+    inline void write_folded_stacks(std::ostream & stream)
+    {
+      detail::registry & reg = detail::get_registry();
+      reg.lock.lock();
+
+      std::map<std::string, double> self_times;
+      for (std::size_t i = 0; i < reg.buffers.size(); ++i)
+      {
+        std::vector<event> const & events = reg.buffers[i]->events;
+
+        std::vector<std::string>  paths;       // the stack of open scopes
+        std::vector<double>       starts;
+        std::vector<double>       child_times;
+        for (std::size_t j = 0; j < events.size(); ++j)
+        {
+          if (events[j].phase == 'B')
+          {
+            paths.push_back(paths.empty() ? std::string(events[j].name) : paths.back() + ";" + events[j].name);
+            starts.push_back(events[j].timestamp);
+            child_times.push_back(0);
+          }
+          else
+          if (events[j].phase == 'E' && !paths.empty())
+          {
+            double duration = events[j].timestamp - starts.back();
+            self_times[paths.back()] += duration - child_times.back();
+
+            paths.pop_back();
+            starts.pop_back();
+            child_times.pop_back();
+            if (!child_times.empty())
+              child_times.back() += duration;
+          }
+        }
+      }
+
+      for (std::map<std::string, double>::const_iterator it = self_times.begin(); it != self_times.end(); ++it)
+        stream << it->first << " " << static_cast<long>(it->second + 0.5) << "\n";
+      stream.flush();
+
+      reg.lock.unlock();
+    }
+
+    /** @brief Writes both export formats, to '<basename>.json' and '<basename>.folded' */
+    inline bool write_files(std::string const & basename)
+    {
+      std::ofstream trace((basename + ".json").c_str());
+      std::ofstream folded((basename + ".folded").c_str());
+      if (!trace || !folded) return false;
+
+      write_chrome_trace(trace);
+      write_folded_stacks(folded);
+      return trace.good() && folded.good();
+    }
+
+  } // profiler
+} // viennafvm
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef VIENNAFVM_SOLVER_MONITOR_HPP
+#define VIENNAFVM_SOLVER_MONITOR_HPP
+
+/* =======================================================================
+   Copyright (c) 2011, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+           ViennaFVM - The Vienna Finite Volume Method Library
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+#include <cstddef>
+
+#include "viennafvm/forwards.h"
+
+namespace viennafvm
+{
+  /** @brief The steps of the pde_solver reported to a solver_monitor */
+  enum solver_phase
+  {
+    phase_assembly,
+    phase_linear_solve,
+    phase_update,
+    phase_finished,
+    phase_cancelled
+  };
+
+  /** @brief Snapshot of the pde_solver state passed to solver_monitor::notify() */
+  struct solver_progress
+  {
+    solver_progress() : phase(phase_assembly), nonlinear_iteration(0), nonlinear_iterations(0), pde_index(0),
+                        break_pde(0), update_norm(0), nonlinear_breaktol(0), elapsed(0), converged(false) {}
+
+    solver_phase   phase;
+    std::size_t    nonlinear_iteration;    // current iteration, 0 for linear systems
+    std::size_t    nonlinear_iterations;   // maximum number of iterations
+    std::size_t    pde_index;
+    std::size_t    break_pde;              // the pde whose update norm decides on convergence
+    numeric_type   update_norm;            // valid for phase_update only
+    numeric_type   nonlinear_breaktol;
+    double         elapsed;                // seconds since the start of the solver
+    bool           converged;
+  };
+
+  /** @brief Observer interface of the pde_solver.
+   *
+   * notify() is called from the thread running the solver, hence implementations must not block.
+   * cancelled() is polled before each linear solve, returning true stops the solver cooperatively.
+   */
+  class solver_monitor
+  {
+    public:
+      virtual ~solver_monitor() {}
+
+      virtual void notify(solver_progress const &) {}
+      virtual bool cancelled() const { return false; }
+  };
+
+} // viennafvm
+
+#endif
@@ -0,0 +1,393 @@
+#ifndef VIENNAFVM_TRANSIENT_SOLVER_HPP
+#define VIENNAFVM_TRANSIENT_SOLVER_HPP
+
+/* =======================================================================
+   Copyright (c) 2011, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+           ViennaFVM - The Vienna Finite Volume Method Library
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/** @file transient_solver.hpp
+    @brief Time integration of PDE systems with du/dt terms on top of the stationary pde_solver.
+
+    A PDE marked as time dependent reads div(...) = ... + du/dt. The time derivative is discretized
+    by backward Euler or by the variable step BDF2 formula and enters the assembly as a volume kernel,
+    i.e. as a mass term on the diagonal and history terms on the right hand side.
+    Each time step is a nonlinear solve of the pde_solver, starting from the solution of the previous step.
+    The step size is controlled by the local truncation error, estimated from the difference
+    between the solution and an explicit polynomial predictor through the previous steps (Milne's device).
+*/
+
+#include <cmath>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "viennafvm/forwards.h"
+#include "viennafvm/volume_kernel.hpp"
+#include "viennafvm/pde_solver.hpp"
+#include "viennafvm/profiler.hpp"
+
+namespace viennafvm
+{
+
+  enum time_integration_scheme
+  {
+    backward_euler,
+    bdf2
+  };
+
+  /** @brief Receives the accepted steps of a transient run. During the call, the storage and the result vector of the
+      stationary solver hold the solution at the given time */
+  class transient_observer
+  {
+    public:
+      virtual ~transient_observer() {}
+
+      virtual void accepted(std::size_t step, numeric_type time, numeric_type step_size) = 0;
+  };
+
+  /** @brief The discrete time derivative a0 u + a1 u_{n} + a2 u_{n-1} of one quantity, with the previous solutions indexed by cell ID */
+  class time_derivative : public volume_kernel
+  {
+    public:
+      explicit time_derivative(long quantity_id) : a0_(0), a1_(0), a2_(0), previous_(NULL), previous2_(NULL)
+      {
+        quantities_.push_back(quantity_id);
+      }
+
+      void set(numeric_type a0, numeric_type a1, numeric_type a2,
+               std::vector<numeric_type> const * previous, std::vector<numeric_type> const * previous2)
+      {
+        a0_ = a0; a1_ = a1; a2_ = a2;
+        previous_  = previous;
+        previous2_ = previous2;
+      }
+
+      numeric_type eval(long cell_id, numeric_type const * values, numeric_type * derivatives) const
+      {
+        derivatives[0] = a0_;
+        numeric_type result = a0_ * values[0] + a1_ * (*previous_)[cell_id];
+        if (a2_ != 0)
+          result += a2_ * (*previous2_)[cell_id];
+        return result;
+      }
+
+    private:
+      numeric_type a0_, a1_, a2_;
+      std::vector<numeric_type> const * previous_;
+      std::vector<numeric_type> const * previous2_;
+  };
+
+  /** @brief Statistics of the last transient run */
+  struct transient_statistics
+  {
+    transient_statistics() : accepted(0), rejected(0), failed_solves(0), time(0), smallest_step(0), largest_step(0) {}
+
+    std::size_t   accepted;
+    std::size_t   rejected;        // by the error estimate
+    std::size_t   failed_solves;   // nonlinear solves without convergence, retried with a smaller step
+    numeric_type  time;            // time of the last accepted step
+    numeric_type  smallest_step;
+    numeric_type  largest_step;
+  };
+
+  template<typename MatrixType = boost::numeric::ublas::compressed_matrix<viennafvm::numeric_type>,
+           typename VectorType = boost::numeric::ublas::vector<viennafvm::numeric_type> >
+  class transient_solver
+  {
+    public:
+      typedef viennafvm::numeric_type                       numeric_type;
+      typedef viennafvm::pde_solver<MatrixType, VectorType> stationary_solver_type;
+
+      explicit transient_solver(stationary_solver_type & solver) : solver_(solver), scheme_(bdf2),
+        initial_step_(1.0e-12), min_step_(1.0e-18), max_step_(1.0), relative_tolerance_(1.0e-3), max_steps_(10000), observer_(NULL) {}
+
+      /** @brief Marks a PDE of the system as time dependent, i.e. du/dt is added to its right hand side */
+      void add_time_derivative(std::size_t pde_index) { transient_pdes_.push_back(pde_index); }
+      void clear_time_derivatives() { transient_pdes_.clear(); }
+
+      void set_scheme(time_integration_scheme scheme) { scheme_ = scheme; }
+      time_integration_scheme get_scheme() const { return scheme_; }
+
+      void set_initial_step(numeric_type dt) { initial_step_ = dt; }
+      void set_step_limits(numeric_type min_dt, numeric_type max_dt) { min_step_ = min_dt; max_step_ = max_dt; }
+      void set_max_steps(std::size_t steps) { max_steps_ = steps; }
+
+      /** @brief The local error of a quantity is accepted below absolute + relative * |u| */
+      void set_relative_tolerance(numeric_type tol) { relative_tolerance_ = tol; }
+      void set_absolute_tolerance(long quantity_id, numeric_type tol) { absolute_tolerances_[quantity_id] = tol; }
+
+      /** @brief Sets an observer which is notified about each accepted step. Pass NULL to detach. */
+      void set_observer(transient_observer * observer) { observer_ = observer; }
+
+      transient_statistics const & statistics() const { return statistics_; }
+
+      /** @brief Integrates from the state in the storage at time zero up to end_time.
+          Returns false if the run has been cancelled or the step size fell below the minimum */
+      template<typename PDESystemT, typename DomainT, typename StorageT, typename LinearSolverT>
+      bool operator()(PDESystemT & pde_system, DomainT const & domain, StorageT & storage, LinearSolverT & linear_solver,
+                      numeric_type end_time, std::size_t break_pde = 0)
+      {
+        viennafvm::profiler::scope transient_scope("transient");
+
+        statistics_ = transient_statistics();
+        std::size_t cells = max_cell_id(domain) + 1;
+
+        // the states of all quantities at the last accepted step, for rejected steps
+        std::vector< std::vector<numeric_type> > state(pde_system.size());
+        for (std::size_t i = 0; i < pde_system.size(); ++i)
+          store(domain, storage, pde_system.unknown(i)[0].id(), state[i], cells);
+
+        // per time dependent PDE: the solutions of the last three accepted steps, newest first
+        std::size_t transient_count = transient_pdes_.size();
+        std::vector< std::vector< std::vector<numeric_type> > > history(transient_count, std::vector< std::vector<numeric_type> >(3));
+        std::vector<time_derivative> derivatives;
+        for (std::size_t k = 0; k < transient_count; ++k)
+        {
+          history[k][0] = state[transient_pdes_[k]];
+          derivatives.push_back(time_derivative(pde_system.unknown(transient_pdes_[k])[0].id()));
+        }
+        for (std::size_t k = 0; k < transient_count; ++k)
+          pde_system.option(transient_pdes_[k]).add_volume_kernel(&derivatives[k]);
+
+        numeric_type time    = 0;
+        numeric_type dt      = std::min(initial_step_, max_step_);
+        numeric_type dt_prev = 0, dt_prev2 = 0;   // sizes of the last two accepted steps
+        bool success = true;
+
+        while (time < end_time && statistics_.accepted < max_steps_)
+        {
+          viennafvm::profiler::scope step_scope("time_step");
+
+          dt = std::min(dt, end_time - time);
+          std::size_t order = (scheme_ == bdf2 && statistics_.accepted > 0) ? 2 : 1;
+
+          for (std::size_t k = 0; k < transient_count; ++k)
+          {
+            if (order == 1)
+              derivatives[k].set(1.0 / dt, -1.0 / dt, 0, &history[k][0], NULL);
+            else
+            {
+              numeric_type w = dt / dt_prev;
+              derivatives[k].set((1.0 + 2.0 * w) / ((1.0 + w) * dt), -(1.0 + w) / dt, w * w / ((1.0 + w) * dt),
+                                 &history[k][0], &history[k][1]);
+            }
+          }
+
+          solver_(pde_system, domain, storage, linear_solver, break_pde);
+          if (solver_.cancelled())
+          {
+            success = false;
+            break;
+          }
+
+          numeric_type error = 0;
+          bool acceptable = solver_.converged();
+          if (!acceptable)
+            statistics_.failed_solves++;
+          else
+          if (statistics_.accepted >= order) // enough previous steps for the predictor
+          {
+            error = local_error(pde_system, domain, storage, history, order, dt, dt_prev, dt_prev2);
+            acceptable = (error <= 1.0);
+            if (!acceptable)
+              statistics_.rejected++;
+          }
+
+          if (!acceptable)
+          {
+            for (std::size_t i = 0; i < pde_system.size(); ++i)
+              restore(domain, storage, pde_system.unknown(i)[0].id(), state[i]);
+
+            dt *= solver_.converged() ? std::max(0.2, 0.9 * std::pow(error, -1.0 / (order + 1))) : 0.25;
+            if (dt < min_step_)
+            {
+              success = false;
+              break;
+            }
+            continue;
+          }
+
+          // accept the step
+          time += dt;
+          for (std::size_t i = 0; i < pde_system.size(); ++i)
+            store(domain, storage, pde_system.unknown(i)[0].id(), state[i], cells);
+          for (std::size_t k = 0; k < transient_count; ++k)
+          {
+            history[k][2].swap(history[k][1]);
+            history[k][1].swap(history[k][0]);
+            history[k][0] = state[transient_pdes_[k]];
+          }
+
+          statistics_.time          = time;
+          statistics_.smallest_step = (statistics_.accepted == 0) ? dt : std::min(statistics_.smallest_step, dt);
+          statistics_.largest_step  = std::max(statistics_.largest_step, dt);
+          statistics_.accepted++;
+          viennafvm::profiler::counter("time_step_size", dt);
+
+          if (observer_)
+            observer_->accepted(statistics_.accepted, time, dt);
+
+          dt_prev2 = dt_prev;
+          dt_prev  = dt;
+          numeric_type factor = (error > 0) ? 0.9 * std::pow(error, -1.0 / (order + 1)) : 2.0;
+          dt = std::max(min_step_, std::min(max_step_, dt * std::min(2.0, std::max(0.2, factor))));
+        }
+
+        for (std::size_t k = 0; k < transient_count; ++k)
+          pde_system.option(transient_pdes_[k]).remove_volume_kernel(&derivatives[k]);
+
+        return success;
+      }
+
+    private:
+      template<typename DomainT>
+      static std::size_t max_cell_id(DomainT const & domain)
+      {
+        typedef typename viennagrid::result_of::cell_tag<DomainT>::type                           CellTag;
+        typedef typename viennagrid::result_of::const_element_range<DomainT, CellTag>::type       CellContainer;
+        typedef typename viennagrid::result_of::iterator<CellContainer>::type                     CellIterator;
+
+        std::size_t result = 0;
+        CellContainer cells(domain);
+        for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+          result = std::max(result, static_cast<std::size_t>(cit->id().get()));
+        return result;
+      }
+
+      /** @brief Copies the current iterate of a quantity to an array indexed by cell ID */
+      template<typename DomainT, typename StorageT>
+      static void store(DomainT const & domain, StorageT & storage, long quantity_id, std::vector<numeric_type> & values, std::size_t size)
+      {
+        typedef typename viennagrid::result_of::cell_tag<DomainT>::type                           CellTag;
+        typedef typename viennagrid::result_of::element<DomainT, CellTag>::type                   CellType;
+        typedef typename viennagrid::result_of::const_element_range<DomainT, CellTag>::type       CellContainer;
+        typedef typename viennagrid::result_of::iterator<CellContainer>::type                     CellIterator;
+
+        typename viennadata::result_of::accessor<StorageT, viennafvm::current_iterate_key, numeric_type, CellType>::type iterate =
+            viennadata::make_accessor(storage, viennafvm::current_iterate_key(quantity_id));
+
+        values.resize(size);
+        CellContainer cells(domain);
+        for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+          values[cit->id().get()] = iterate(*cit);
+      }
+
+      template<typename DomainT, typename StorageT>
+      static void restore(DomainT const & domain, StorageT & storage, long quantity_id, std::vector<numeric_type> const & values)
+      {
+        typedef typename viennagrid::result_of::cell_tag<DomainT>::type                           CellTag;
+        typedef typename viennagrid::result_of::element<DomainT, CellTag>::type                   CellType;
+        typedef typename viennagrid::result_of::const_element_range<DomainT, CellTag>::type       CellContainer;
+        typedef typename viennagrid::result_of::iterator<CellContainer>::type                     CellIterator;
+
+        typename viennadata::result_of::accessor<StorageT, viennafvm::current_iterate_key, numeric_type, CellType>::type iterate =
+            viennadata::make_accessor(storage, viennafvm::current_iterate_key(quantity_id));
+
+        CellContainer cells(domain);
+        for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+          iterate(*cit) = values[cit->id().get()];
+      }
+
+      /** @brief Weighted RMS norm of the estimated local truncation error, maximized over the time dependent quantities.
+          The step is acceptable if the result does not exceed one */
+      template<typename PDESystemT, typename DomainT, typename StorageT>
+      numeric_type local_error(PDESystemT const & pde_system, DomainT const & domain, StorageT & storage,
+                               std::vector< std::vector< std::vector<numeric_type> > > const & history,
+                               std::size_t order, numeric_type dt, numeric_type dt_prev, numeric_type dt_prev2) const
+      {
+        typedef typename viennagrid::result_of::cell_tag<DomainT>::type                           CellTag;
+        typedef typename viennagrid::result_of::element<DomainT, CellTag>::type                   CellType;
+        typedef typename viennagrid::result_of::const_element_range<DomainT, CellTag>::type       CellContainer;
+        typedef typename viennagrid::result_of::iterator<CellContainer>::type                     CellIterator;
+
+        // the predictor interpolates the previous solutions at t_n = 0, t_{n-1} = -h1, t_{n-2} = -h1-h2 and is evaluated at dt.
+        // Milne's device: with the local errors E_c = C u^(p+1) of the corrector and E_p = -P u^(p+1) of the predictor,
+        // the local error is E_c = C / (C + P) * (u_c - u_p). Backward Euler: C = dt^2/2, P = dt (dt+h1)/2,
+        // BDF2: C = dt^2 (dt+h1)^2 / (6 (2dt+h1)), P = dt (dt+h1) (dt+h1+h2)/6, i.e. 1/3 and 2/11 at constant steps
+        numeric_type h1 = dt_prev, h2 = dt_prev2;
+        numeric_type c0, c1, c2, scaling;
+        if (order == 1)
+        {
+          c0 = 1.0 + dt / h1;
+          c1 = -dt / h1;
+          c2 = 0;
+          scaling = dt / (2.0 * dt + h1);
+        }
+        else
+        {
+          c0 = (dt + h1) * (dt + h1 + h2) / (h1 * (h1 + h2));
+          c1 = -dt * (dt + h1 + h2) / (h1 * h2);
+          c2 = dt * (dt + h1) / (h2 * (h1 + h2));
+          scaling = dt * (dt + h1) / (dt * (dt + h1) + (2.0 * dt + h1) * (dt + h1 + h2));
+        }
+
+        numeric_type result = 0;
+        CellContainer cells(domain);
+        for (std::size_t k = 0; k < transient_pdes_.size(); ++k)
+        {
+          long quantity_id = pde_system.unknown(transient_pdes_[k])[0].id();
+
+          typename viennadata::result_of::accessor<StorageT, viennafvm::current_iterate_key, numeric_type, CellType>::type iterate =
+              viennadata::make_accessor(storage, viennafvm::current_iterate_key(quantity_id));
+          typename viennadata::result_of::accessor<StorageT, viennafvm::boundary_key, bool, CellType>::type boundary =
+              viennadata::make_accessor(storage, viennafvm::boundary_key(quantity_id));
+          typename viennadata::result_of::accessor<StorageT, viennafvm::disable_quantity_key, bool, CellType>::type disabled =
+              viennadata::make_accessor(storage, viennafvm::disable_quantity_key(quantity_id));
+
+          std::map<long, numeric_type>::const_iterator atol = absolute_tolerances_.find(quantity_id);
+          numeric_type absolute = (atol == absolute_tolerances_.end()) ? 0 : atol->second;
+
+          std::vector<numeric_type> const & u0 = history[k][0];
+          std::vector<numeric_type> const & u1 = history[k][1];
+          std::vector<numeric_type> const & u2 = history[k][2];
+
+          numeric_type sum = 0;
+          std::size_t  count = 0;
+          for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+          {
+            if (boundary(*cit) || disabled(*cit))
+              continue;
+
+            std::size_t id = cit->id().get();
+            numeric_type value     = iterate(*cit);
+            numeric_type predicted = c0 * u0[id] + c1 * u1[id] + ((order == 1) ? 0 : c2 * u2[id]);
+            numeric_type weight    = absolute + relative_tolerance_ * std::max(std::abs(value), std::abs(u0[id]));
+            if (weight <= 0)
+              continue;
+
+            numeric_type e = scaling * (value - predicted) / weight;
+            sum += e * e;
+            ++count;
+          }
+          if (count > 0)
+            result = std::max(result, std::sqrt(sum / count));
+        }
+        return result;
+      }
+
+      stationary_solver_type &      solver_;
+      time_integration_scheme       scheme_;
+      std::vector<std::size_t>      transient_pdes_;
+      numeric_type                  initial_step_;
+      numeric_type                  min_step_;
+      numeric_type                  max_step_;
+      numeric_type                  relative_tolerance_;
+      std::map<long, numeric_type>  absolute_tolerances_;
+      std::size_t                   max_steps_;
+      transient_observer *          observer_;
+      transient_statistics          statistics_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef VIENNAFVM_VOLUME_KERNEL_HPP
+#define VIENNAFVM_VOLUME_KERNEL_HPP
+
+/* =======================================================================
+   Copyright (c) 2011, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+           ViennaFVM - The Vienna Finite Volume Method Library
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/** @file volume_kernel.hpp
+    @brief Interface for compiled volume source terms of a PDE.
+
+    A volume kernel adds a source f(u_0, ..., u_k) per unit volume to the right hand side of a PDE,
+    i.e. div(...) = ... + f. Unlike symbolic right hand sides, the kernel is evaluated natively per cell
+    and supplies its partial derivatives analytically, so no expression tree is traversed or differentiated
+    during assembly. Kernels are attached to a PDE via linear_pde_options::add_volume_kernel().
+*/
+
+#include <vector>
+
+#include "viennafvm/forwards.h"
+
+namespace viennafvm
+{
+
+  class volume_kernel
+  {
+    public:
+      virtual ~volume_kernel() {}
+
+      /** @brief The IDs of the quantities the kernel depends on. Their current iterates are passed to eval() in this order */
+      std::vector<long> const & quantities() const { return quantities_; }
+
+      /** @brief Returns the source per unit volume in the cell with the given ID and writes the partial derivatives
+          with respect to each of the quantities to 'derivatives'
+
+          @param cell_id      ID of the cell, allows kernels to look up cell-wise parameters
+          @param values       Current iterates of the quantities in the cell
+          @param derivatives  Receives quantities().size() partial derivatives
+      */
+      virtual numeric_type eval(long cell_id, numeric_type const * values, numeric_type * derivatives) const = 0;
+
+    protected:
+      std::vector<long> quantities_;
+  };
+
+}
+
+#endif
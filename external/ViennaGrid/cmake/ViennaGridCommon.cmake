@@ -36,6 +36,8 @@ option(BUILD_EXAMPLES "Build example programs" ON)
 
 option(ENABLE_VIENNADATA "Enable ViennaData for advanced accessors" OFF)
 
+option(ENABLE_OPENMP "Use OpenMP acceleration" OFF)
+
 mark_as_advanced(ENABLE_PEDANTIC_FLAGS)
 
 include_directories(${PROJECT_SOURCE_DIR})
@@ -50,6 +52,12 @@ if(ENABLE_VIENNADATA)
   set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DVIENNAGRID_WITH_VIENNADATA")
 endif()
 
+if(ENABLE_OPENMP)
+  find_package(OpenMP REQUIRED)
+  set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS} -DVIENNAGRID_WITH_OPENMP")
+  set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} ${OpenMP_EXE_LINKER_FLAGS}")
+endif()
+
 
 # Export
 ########
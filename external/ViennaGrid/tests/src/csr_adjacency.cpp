@@ -0,0 +1,192 @@
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                     ViennaGrid - The Vienna Grid Library
+                            -----------------
+
+   License:      MIT (X11), see file LICENSE in the base directory
+======================================================================= */
+
+#ifdef _MSC_VER
+  #pragma warning( disable : 4503 )     //truncated name decoration
+#endif
+
+#include "viennagrid/forwards.hpp"
+#include "viennagrid/config/default_configs.hpp"
+#include "viennagrid/mesh/element_creation.hpp"
+#include "viennagrid/mesh/coboundary_iteration.hpp"
+#include "viennagrid/algorithm/csr_adjacency.hpp"
+
+
+/** @brief Checks the CSR arrays against the handle-based coboundary iteration */
+template <typename MeshType>
+int check(MeshType const & mesh)
+{
+  typedef typename viennagrid::result_of::cell_tag<MeshType>::type                    CellTag;
+  typedef typename viennagrid::result_of::facet_tag<CellTag>::type                    FacetTag;
+  typedef typename viennagrid::result_of::cell<MeshType>::type                        CellType;
+
+  typedef typename viennagrid::result_of::const_element_range<MeshType, CellTag>::type    CellRange;
+  typedef typename viennagrid::result_of::iterator<CellRange>::type                       CellIterator;
+  typedef typename viennagrid::result_of::const_element_range<CellType, FacetTag>::type   FacetOnCellRange;
+  typedef typename viennagrid::result_of::iterator<FacetOnCellRange>::type                FacetOnCellIterator;
+
+  typedef typename viennagrid::result_of::const_coboundary_range<MeshType, FacetTag, CellTag>::type   CellOnFacetRange;
+
+  viennagrid::csr_adjacency adj(mesh);
+
+  if (adj.cell_count() != viennagrid::cells(mesh).size())
+  {
+    std::cerr << "Wrong number of cells: " << adj.cell_count() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (adj.facet_count() != viennagrid::elements<FacetTag>(mesh).size())
+  {
+    std::cerr << "Wrong number of facets: " << adj.facet_count() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::size_t i = 0;
+  CellRange cells(mesh);
+  for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit, ++i)
+  {
+    if (adj.cell_ids()[i] != static_cast<std::size_t>(cit->id().get()))
+    {
+      std::cerr << "Cell order does not match cell range!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::size_t j = adj.cell_facet_offsets()[i];
+    FacetOnCellRange facets_on_cell(*cit);
+    for (FacetOnCellIterator focit = facets_on_cell.begin(); focit != facets_on_cell.end(); ++focit, ++j)
+    {
+      std::size_t facet_index = adj.cell_facets()[j];
+      if (adj.facet_ids()[facet_index] != static_cast<std::size_t>(focit->id().get()))
+      {
+        std::cerr << "Cell-to-facet adjacency wrong for cell " << i << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      CellOnFacetRange cells_on_facet = viennagrid::coboundary_elements<FacetTag, CellTag>(mesh, viennagrid::handle(mesh, *focit));
+      std::size_t num_cells = adj.facet_cell_offsets()[facet_index + 1] - adj.facet_cell_offsets()[facet_index];
+      if (num_cells != cells_on_facet.size())
+      {
+        std::cerr << "Facet-to-cell adjacency wrong for facet " << facet_index << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      std::size_t other = adj.other_cell(facet_index, i);
+      if ( (num_cells == 1) != (other == viennagrid::csr_adjacency::invalid_index()) )
+      {
+        std::cerr << "other_cell() wrong for facet " << facet_index << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    if (j != adj.cell_facet_offsets()[i+1])
+    {
+      std::cerr << "Wrong number of facets for cell " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // neighbor relation must be symmetric:
+    for (std::size_t k = adj.cell_neighbor_offsets()[i]; k < adj.cell_neighbor_offsets()[i+1]; ++k)
+    {
+      std::size_t other = adj.neighbors()[k];
+      bool found = false;
+      for (std::size_t l = adj.cell_neighbor_offsets()[other]; l < adj.cell_neighbor_offsets()[other+1]; ++l)
+        if (adj.neighbors()[l] == i && adj.neighbor_facets()[l] == adj.neighbor_facets()[k])
+          found = true;
+
+      if (!found)
+      {
+        std::cerr << "Neighbor relation not symmetric for cells " << i << " and " << other << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  std::cout << "Cells: " << adj.cell_count() << ", facets: " << adj.facet_count()
+            << ", neighbor entries: " << adj.neighbors().size() << std::endl;
+  return EXIT_SUCCESS;
+}
+
+
+int test(viennagrid::triangular_2d_mesh)
+{
+  typedef viennagrid::triangular_2d_mesh                              MeshType;
+  typedef viennagrid::result_of::point<MeshType>::type                PointType;
+  typedef viennagrid::result_of::vertex_handle<MeshType>::type        VertexHandleType;
+
+  MeshType mesh;
+
+  std::size_t n = 4;
+  std::vector<VertexHandleType> vertices;
+  for (std::size_t y=0; y<=n; ++y)
+    for (std::size_t x=0; x<=n; ++x)
+      vertices.push_back( viennagrid::make_vertex(mesh, PointType(double(x), double(y))) );
+
+  for (std::size_t y=0; y<n; ++y)
+    for (std::size_t x=0; x<n; ++x)
+    {
+      std::size_t v0 = y * (n+1) + x;
+      viennagrid::make_triangle(mesh, vertices[v0], vertices[v0+1],   vertices[v0+n+2]);
+      viennagrid::make_triangle(mesh, vertices[v0], vertices[v0+n+2], vertices[v0+n+1]);
+    }
+
+  // 2*n*n triangles, 3*n*n + 2*n edges, 3*n*n - n interior edges:
+  viennagrid::csr_adjacency adj(mesh);
+  if (adj.neighbors().size() != 2 * (3*n*n - 2*n))
+  {
+    std::cerr << "Wrong number of neighbor entries!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return check(mesh);
+}
+
+
+int test(viennagrid::tetrahedral_3d_mesh)
+{
+  typedef viennagrid::tetrahedral_3d_mesh                             MeshType;
+  typedef viennagrid::result_of::point<MeshType>::type                PointType;
+  typedef viennagrid::result_of::vertex_handle<MeshType>::type        VertexHandleType;
+
+  MeshType mesh;
+
+  VertexHandleType v0 = viennagrid::make_vertex(mesh, PointType(0.0, 0.0, 0.0));
+  VertexHandleType v1 = viennagrid::make_vertex(mesh, PointType(1.0, 0.0, 0.0));
+  VertexHandleType v2 = viennagrid::make_vertex(mesh, PointType(0.0, 1.0, 0.0));
+  VertexHandleType v3 = viennagrid::make_vertex(mesh, PointType(0.0, 0.0, 1.0));
+  VertexHandleType v4 = viennagrid::make_vertex(mesh, PointType(1.0, 1.0, 1.0));
+  VertexHandleType v5 = viennagrid::make_vertex(mesh, PointType(-1.0, -1.0, -1.0));
+
+  viennagrid::make_tetrahedron(mesh, v0, v1, v2, v3);
+  viennagrid::make_tetrahedron(mesh, v1, v2, v3, v4);
+  viennagrid::make_tetrahedron(mesh, v0, v1, v2, v5);
+
+  return check(mesh);
+}
+
+
+int main()
+{
+  std::cout << "*****************" << std::endl;
+  std::cout << "* Test started! *" << std::endl;
+  std::cout << "*****************" << std::endl;
+
+  if (test(viennagrid::triangular_2d_mesh()) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  if (test(viennagrid::tetrahedral_3d_mesh()) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  std::cout << "*******************************" << std::endl;
+  std::cout << "* Test finished successfully! *" << std::endl;
+  std::cout << "*******************************" << std::endl;
+
+  return EXIT_SUCCESS;
+}
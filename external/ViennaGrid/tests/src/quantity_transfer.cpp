@@ -0,0 +1,213 @@
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                     ViennaGrid - The Vienna Grid Library
+                            -----------------
+
+   License:      MIT (X11), see file LICENSE in the base directory
+======================================================================= */
+
+#ifdef _MSC_VER
+  #pragma warning( disable : 4503 )     //truncated name decoration
+#endif
+
+#include <cmath>
+#include <numeric>
+
+#include "viennagrid/forwards.hpp"
+#include "viennagrid/config/default_configs.hpp"
+#include "viennagrid/mesh/element_creation.hpp"
+#include "viennagrid/algorithm/centroid.hpp"
+#include "viennagrid/algorithm/volume.hpp"
+#include "viennagrid/algorithm/quantity_transfer.hpp"
+
+
+typedef viennagrid::triangular_2d_mesh                                  MeshType;
+typedef viennagrid::result_of::point<MeshType>::type                   PointType;
+typedef viennagrid::result_of::vertex<MeshType>::type                  VertexType;
+typedef viennagrid::result_of::vertex_handle<MeshType>::type           VertexHandleType;
+typedef viennagrid::result_of::cell<MeshType>::type                    CellType;
+
+typedef viennagrid::result_of::accessor< std::vector<double>, CellType >::type     CellAccessorType;
+typedef viennagrid::result_of::accessor< std::vector<double>, VertexType >::type   VertexAccessorType;
+
+
+/** @brief A trivial filter, all objects are accepted */
+struct any_filter
+{
+  template <typename T>
+  bool operator()(T const &) const { return true; }
+};
+
+/** @brief Accepts all vertices with x-coordinate less than 'x_max' */
+struct x_filter
+{
+  x_filter(double x_max) : x_max_(x_max) {}
+
+  bool operator()(VertexType const & vertex) const { return viennagrid::point(vertex)[0] < x_max_; }
+
+  double x_max_;
+};
+
+/** @brief Arithmetic mean of all values in the container */
+struct arithmetic_averager
+{
+  template <typename ContainerT>
+  double operator()(ContainerT const & values) const { return std::accumulate(values.begin(), values.end(), 0.0) / values.size(); }
+};
+
+/** @brief Writes the value to a vertex accessor and records the vertex as visited */
+struct vertex_setter
+{
+  vertex_setter(VertexAccessorType & acc, std::vector<bool> & visited) : acc_(acc), visited_(visited) {}
+
+  void operator()(VertexType const & vertex, double value) const
+  {
+    acc_(vertex) = value;
+    visited_[vertex.id().get()] = true;
+  }
+
+  VertexAccessorType & acc_;
+  std::vector<bool> & visited_;
+};
+
+
+int main()
+{
+  std::cout << "*****************" << std::endl;
+  std::cout << "* Test started! *" << std::endl;
+  std::cout << "*****************" << std::endl;
+
+  //
+  // n x n triangle mesh with graded spacing in x, such that the cell volumes differ:
+  //
+  MeshType mesh;
+
+  std::size_t n = 6;
+  std::vector<VertexHandleType> vertices;
+  for (std::size_t y=0; y<=n; ++y)
+    for (std::size_t x=0; x<=n; ++x)
+      vertices.push_back( viennagrid::make_vertex(mesh, PointType(double(x*x), double(y))) );
+
+  for (std::size_t y=0; y<n; ++y)
+    for (std::size_t x=0; x<n; ++x)
+    {
+      std::size_t v0 = y * (n+1) + x;
+      viennagrid::make_triangle(mesh, vertices[v0], vertices[v0+1],   vertices[v0+n+2]);
+      viennagrid::make_triangle(mesh, vertices[v0], vertices[v0+n+2], vertices[v0+n+1]);
+    }
+
+  // three cell fields:
+  std::size_t num_fields = 3;
+  std::vector< std::vector<double> > cell_data(num_fields);
+  std::vector<CellAccessorType> cell_accessors;
+  for (std::size_t k=0; k<num_fields; ++k)
+    cell_accessors.push_back( CellAccessorType(cell_data[k]) );
+
+  viennagrid::result_of::cell_range<MeshType>::type cells(mesh);
+  for (viennagrid::result_of::iterator< viennagrid::result_of::cell_range<MeshType>::type >::type cit = cells.begin(); cit != cells.end(); ++cit)
+  {
+    PointType centroid = viennagrid::centroid(*cit);
+    cell_accessors[0](*cit) = 1.0;
+    cell_accessors[1](*cit) = centroid[0] + 2.0 * centroid[1];
+    cell_accessors[2](*cit) = std::sin(centroid[0]) * centroid[1];
+  }
+
+  //
+  // Arithmetic averaging must reproduce quantity_transfer() for all fields, including filtering of destination elements.
+  // sum_j (1/n) x_j and (sum_j x_j) / n round differently, hence the values are compared with a relative tolerance:
+  //
+  x_filter filter_dest(10.0);
+  viennagrid::quantity_transfer_weights<MeshType, CellType, VertexType> weights(mesh, viennagrid::arithmetic_averaging_tag(), any_filter(), filter_dest);
+
+  std::vector<double> src;
+  for (std::size_t k=0; k<num_fields; ++k)
+    weights.gather(cell_accessors[k], k, num_fields, src);
+
+  std::vector<double> dest;
+  weights.apply(src, num_fields, dest);
+
+  for (std::size_t k=0; k<num_fields; ++k)
+  {
+    std::vector<double> reference_data;
+    VertexAccessorType reference_accessor(reference_data);
+    std::vector<bool> reference_visited(viennagrid::vertices(mesh).size());
+    vertex_setter reference_setter(reference_accessor, reference_visited);
+
+    viennagrid::quantity_transfer<CellType, VertexType>(mesh, cell_accessors[k], reference_setter,
+                                                        arithmetic_averager(), any_filter(), filter_dest);
+
+    std::vector<double> batched_data;
+    VertexAccessorType batched_accessor(batched_data);
+    std::vector<bool> batched_visited(viennagrid::vertices(mesh).size());
+    vertex_setter batched_setter(batched_accessor, batched_visited);
+
+    weights.scatter(dest, k, num_fields, batched_setter);
+
+    if (batched_visited != reference_visited)
+    {
+      std::cerr << "Set of destination vertices differs from quantity_transfer() for field " << k << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    for (std::size_t i=0; i<weights.destination_count(); ++i)
+    {
+      VertexType const & vertex = *weights.destination_elements()[i];
+      if (std::fabs(batched_accessor(vertex) - reference_accessor(vertex)) > 1e-12 * (1.0 + std::fabs(reference_accessor(vertex))))
+      {
+        std::cerr << "Value mismatch with quantity_transfer() for field " << k << " at vertex " << vertex << ": "
+                  << batched_accessor(vertex) << " vs. " << reference_accessor(vertex) << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  //
+  // Volume weighting: weights of each vertex are proportional to the volumes of the adjacent cells, constant fields are preserved
+  //
+  viennagrid::quantity_transfer_weights<MeshType, CellType, VertexType> volume_weights(mesh, viennagrid::volume_averaging_tag(), any_filter(), any_filter());
+
+  if (volume_weights.destination_count() != viennagrid::vertices(mesh).size() || volume_weights.source_count() != viennagrid::cells(mesh).size())
+  {
+    std::cerr << "Wrong number of source or destination elements!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (std::size_t i=0; i<volume_weights.destination_count(); ++i)
+  {
+    double volume_sum = 0;
+    for (std::size_t j=volume_weights.row_offsets()[i]; j<volume_weights.row_offsets()[i+1]; ++j)
+      volume_sum += viennagrid::volume( *volume_weights.source_elements()[volume_weights.columns()[j]] );
+
+    for (std::size_t j=volume_weights.row_offsets()[i]; j<volume_weights.row_offsets()[i+1]; ++j)
+    {
+      double expected = viennagrid::volume( *volume_weights.source_elements()[volume_weights.columns()[j]] ) / volume_sum;
+      if (std::fabs(volume_weights.weights()[j] - expected) > 1e-12)
+      {
+        std::cerr << "Wrong volume weight for vertex " << *volume_weights.destination_elements()[i] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  src.clear();
+  volume_weights.gather(cell_accessors[0], 0, 1, src);
+  volume_weights.apply(src, 1, dest);
+  for (std::size_t i=0; i<dest.size(); ++i)
+  {
+    if (std::fabs(dest[i] - 1.0) > 1e-12)
+    {
+      std::cerr << "Volume-weighted transfer does not preserve constant field!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "*******************************" << std::endl;
+  std::cout << "* Test finished successfully! *" << std::endl;
+  std::cout << "*******************************" << std::endl;
+
+  return EXIT_SUCCESS;
+}
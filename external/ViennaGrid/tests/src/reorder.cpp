@@ -0,0 +1,165 @@
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                     ViennaGrid - The Vienna Grid Library
+                            -----------------
+
+   License:      MIT (X11), see file LICENSE in the base directory
+======================================================================= */
+
+#ifdef _MSC_VER
+  #pragma warning( disable : 4503 )     //truncated name decoration
+#endif
+
+#include <cmath>
+
+#include "viennagrid/forwards.hpp"
+#include "viennagrid/config/default_configs.hpp"
+#include "viennagrid/mesh/element_creation.hpp"
+#include "viennagrid/algorithm/volume.hpp"
+#include "viennagrid/algorithm/reorder.hpp"
+
+
+typedef viennagrid::triangular_2d_mesh                                   MeshType;
+typedef viennagrid::result_of::segmentation<MeshType>::type             SegmentationType;
+typedef viennagrid::result_of::segment_handle<SegmentationType>::type   SegmentHandleType;
+typedef viennagrid::result_of::point<MeshType>::type                    PointType;
+typedef viennagrid::result_of::vertex_handle<MeshType>::type            VertexHandleType;
+typedef viennagrid::result_of::cell_tag<MeshType>::type                 CellTag;
+
+
+/** @brief Creates a structured n x n triangle mesh with deliberately scrambled cell and vertex numbering. Left half is segment 0, right half is segment 1. */
+void setup(MeshType & mesh, SegmentationType & segmentation, std::size_t n)
+{
+  // scrambled vertex numbering:
+  std::vector<VertexHandleType> vertices((n+1) * (n+1));
+  for (std::size_t k=0; k<vertices.size(); ++k)
+  {
+    std::size_t i = (k * 7919) % vertices.size();   // 7919 is prime, hence coprime with the number of vertices unless n+1 is a multiple of it
+    vertices[i] = viennagrid::make_vertex(mesh, PointType(double(i % (n+1)), double(i / (n+1))));
+  }
+
+  // scrambled cell numbering:
+  std::size_t num_quads = n * n;
+  for (std::size_t k=0; k<num_quads; ++k)
+  {
+    std::size_t q = (k * 7907) % num_quads;
+    std::size_t x = q % n;
+    std::size_t y = q / n;
+
+    SegmentHandleType & seg = segmentation( (x < n/2) ? 0 : 1 );
+
+    std::size_t v0 = y * (n+1) + x;
+    std::size_t v1 = v0 + 1;
+    std::size_t v2 = v0 + n + 1;
+    std::size_t v3 = v2 + 1;
+
+    viennagrid::make_triangle(seg, vertices[v0], vertices[v1], vertices[v3]);
+    viennagrid::make_triangle(seg, vertices[v0], vertices[v3], vertices[v2]);
+  }
+}
+
+
+template <typename MeshOrSegmentT>
+double total_volume(MeshOrSegmentT const & mesh_or_segment)
+{
+  typedef typename viennagrid::result_of::const_element_range<MeshOrSegmentT, CellTag>::type   CellRange;
+  typedef typename viennagrid::result_of::iterator<CellRange>::type                          CellIterator;
+
+  double vol = 0;
+  CellRange cells(mesh_or_segment);
+  for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+    vol += viennagrid::volume(*cit);
+  return vol;
+}
+
+
+template <typename OrderingTagT>
+int test(std::string const & name)
+{
+  std::size_t n = 20;
+
+  MeshType mesh;
+  SegmentationType segmentation(mesh);
+  setup(mesh, segmentation, n);
+
+  MeshType mesh_out;
+  SegmentationType segmentation_out(mesh_out);
+
+  viennagrid::reordering_statistics stats = viennagrid::reorder<OrderingTagT>(mesh, segmentation, mesh_out, segmentation_out);
+
+  std::cout << name << ": bandwidth " << stats.bandwidth_before << " -> " << stats.bandwidth_after
+                    << ", profile "   << stats.profile_before   << " -> " << stats.profile_after << std::endl;
+
+  //
+  // The renumbered mesh must be the same mesh:
+  //
+  if (viennagrid::cells(mesh_out).size() != viennagrid::cells(mesh).size()
+      || viennagrid::vertices(mesh_out).size() != viennagrid::vertices(mesh).size())
+  {
+    std::cerr << "Number of elements changed!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (segmentation_out.size() != segmentation.size())
+  {
+    std::cerr << "Number of segments changed!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (SegmentationType::const_iterator sit = segmentation.begin(); sit != segmentation.end(); ++sit)
+  {
+    SegmentHandleType const & seg_out = segmentation_out(sit->id());
+    if (viennagrid::cells(seg_out).size() != viennagrid::cells(*sit).size()
+        || std::fabs(total_volume(seg_out) - total_volume(*sit)) > 1e-8)
+    {
+      std::cerr << "Segment " << sit->id() << " not preserved!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  //
+  // Statistics must match the renumbered mesh and the numbering must be better than the scrambled one:
+  //
+  std::pair<std::size_t, std::size_t> before = viennagrid::cell_bandwidth_and_profile(mesh);
+  std::pair<std::size_t, std::size_t> after  = viennagrid::cell_bandwidth_and_profile(mesh_out);
+
+  if (before.first != stats.bandwidth_before || before.second != stats.profile_before
+      || after.first != stats.bandwidth_after || after.second != stats.profile_after)
+  {
+    std::cerr << "Reported bandwidth/profile do not match renumbered mesh!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (stats.bandwidth_after >= stats.bandwidth_before || stats.profile_after >= stats.profile_before)
+  {
+    std::cerr << "Renumbering did not reduce bandwidth and profile!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "[PASSED]" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+
+int main()
+{
+  std::cout << "*****************" << std::endl;
+  std::cout << "* Test started! *" << std::endl;
+  std::cout << "*****************" << std::endl;
+
+  if (test<viennagrid::reverse_cuthill_mckee_tag>("reverse Cuthill-McKee") != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  if (test<viennagrid::morton_tag>("Morton") != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  std::cout << "*******************************" << std::endl;
+  std::cout << "* Test finished successfully! *" << std::endl;
+  std::cout << "*******************************" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                     ViennaGrid - The Vienna Grid Library
+                            -----------------
+
+   License:      MIT (X11), see file LICENSE in the base directory
+======================================================================= */
+
+#ifdef _MSC_VER
+  #pragma warning( disable : 4503 )     //truncated name decoration
+#endif
+
+#include "viennagrid/forwards.hpp"
+#include "viennagrid/config/default_configs.hpp"
+#include "viennagrid/mesh/element_creation.hpp"
+#include "viennagrid/algorithm/interface.hpp"
+#include "viennagrid/algorithm/segment_interface_map.hpp"
+
+
+int main()
+{
+  std::cout << "*****************" << std::endl;
+  std::cout << "* Test started! *" << std::endl;
+  std::cout << "*****************" << std::endl;
+
+  typedef viennagrid::triangular_2d_mesh                                   MeshType;
+  typedef viennagrid::result_of::segmentation<MeshType>::type             SegmentationType;
+  typedef viennagrid::result_of::segment_handle<SegmentationType>::type   SegmentHandleType;
+  typedef viennagrid::result_of::point<MeshType>::type                    PointType;
+  typedef viennagrid::result_of::vertex_handle<MeshType>::type            VertexHandleType;
+  typedef viennagrid::result_of::facet<MeshType>::type                    FacetType;
+  typedef viennagrid::result_of::facet_range<MeshType>::type              FacetRange;
+  typedef viennagrid::result_of::iterator<FacetRange>::type               FacetIterator;
+
+  MeshType mesh;
+  SegmentationType segmentation(mesh);
+
+  //
+  // 6 x 2 quads split into triangles; columns 0-1 -> segment 0, columns 2-3 -> segment 1, columns 4-5 -> segment 3. Segment 2 is empty.
+  //
+  std::size_t nx = 6;
+  std::size_t ny = 2;
+  std::vector<VertexHandleType> vertices;
+  for (std::size_t y=0; y<=ny; ++y)
+    for (std::size_t x=0; x<=nx; ++x)
+      vertices.push_back( viennagrid::make_vertex(mesh, PointType(double(x), double(y))) );
+
+  segmentation(2);
+  for (std::size_t y=0; y<ny; ++y)
+    for (std::size_t x=0; x<nx; ++x)
+    {
+      int segment_id = (x < 2) ? 0 : ((x < 4) ? 1 : 3);
+      SegmentHandleType & seg = segmentation(segment_id);
+
+      std::size_t v0 = y * (nx+1) + x;
+      viennagrid::make_triangle(seg, vertices[v0], vertices[v0+1],    vertices[v0+nx+2]);
+      viennagrid::make_triangle(seg, vertices[v0], vertices[v0+nx+2], vertices[v0+nx+1]);
+    }
+
+  viennagrid::segment_interface_map<SegmentationType> interfaces(segmentation);
+
+  //
+  // Adjacency of segments:
+  //
+  if (interfaces.adjacent_segments(0).size() != 1 || interfaces.adjacent_segments(0)[0] != 1
+   || interfaces.adjacent_segments(1).size() != 2 || interfaces.adjacent_segments(1)[0] != 0 || interfaces.adjacent_segments(1)[1] != 3
+   || interfaces.adjacent_segments(2).size() != 0
+   || interfaces.adjacent_segments(3).size() != 1 || interfaces.adjacent_segments(3)[0] != 1
+   || interfaces.adjacent_segments(42).size() != 0)
+  {
+    std::cerr << "Wrong segment adjacency!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!interfaces.is_interface(0, 1) || !interfaces.is_interface(3, 1) || interfaces.is_interface(0, 3) || interfaces.is_interface(0, 2))
+  {
+    std::cerr << "Wrong segment interfaces!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (interfaces.interface_facets(0, 1).size() != ny || interfaces.interface_facets(1, 3).size() != ny || interfaces.interface_facets(0, 3).size() != 0)
+  {
+    std::cerr << "Wrong number of interface facets!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Facet-wise comparison with viennagrid::is_interface():
+  //
+  FacetRange facets(mesh);
+  for (FacetIterator fit = facets.begin(); fit != facets.end(); ++fit)
+  {
+    for (SegmentationType::iterator sit0 = segmentation.begin(); sit0 != segmentation.end(); ++sit0)
+    {
+      for (SegmentationType::iterator sit1 = segmentation.begin(); sit1 != segmentation.end(); ++sit1)
+      {
+        if (sit0->id() == sit1->id())
+          continue;
+
+        FacetType const & facet = *fit;
+        if (viennagrid::is_interface(*sit0, *sit1, facet) != interfaces.is_interface(sit0->id(), sit1->id(), facet))
+        {
+          std::cerr << "Mismatch with is_interface() for segments " << sit0->id() << " and " << sit1->id() << " at facet " << facet << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  std::cout << "*******************************" << std::endl;
+  std::cout << "* Test finished successfully! *" << std::endl;
+  std::cout << "*******************************" << std::endl;
+
+  return EXIT_SUCCESS;
+}
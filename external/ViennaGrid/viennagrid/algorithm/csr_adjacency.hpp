@@ -0,0 +1,197 @@
+#ifndef VIENNAGRID_ALGORITHM_CSR_ADJACENCY_HPP
+#define VIENNAGRID_ALGORITHM_CSR_ADJACENCY_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                     ViennaGrid - The Vienna Grid Library
+                            -----------------
+
+   License:      MIT (X11), see file LICENSE in the base directory
+======================================================================= */
+
+#include <vector>
+#include <limits>
+
+#include "viennagrid/forwards.hpp"
+#include "viennagrid/mesh/mesh.hpp"
+
+/** @file viennagrid/algorithm/csr_adjacency.hpp
+    @brief Provides a static compressed sparse row (CSR) export of the cell-facet-cell adjacency of a mesh or segment
+*/
+
+namespace viennagrid
+{
+
+  /** @brief Immutable CSR representation of the cell-to-facet, facet-to-cell and cell-to-neighbor-cell adjacency of a mesh or segment.
+   *
+   * Cells are indexed by their position in the cell range of the mesh/segment, i.e. in the same order as viennafvm::create_mapping() visits them.
+   * Facets are indexed in the order in which they are first encountered while iterating over the cells.
+   * The facets of cell i are facets[ cell_facet_offsets[i] ... cell_facet_offsets[i+1] ), listed in the local facet order of the cell.
+   * The neighbor cells of cell i are neighbors[ cell_neighbor_offsets[i] ... cell_neighbor_offsets[i+1] ), with neighbor_facets holding the shared facet for each entry.
+   * Once constructed, the adjacency does not track changes of the mesh.
+   */
+  class csr_adjacency
+  {
+  public:
+    typedef std::size_t                   index_type;
+    typedef std::vector<index_type>       index_array_type;
+
+    /** @brief Marker for 'no such element' */
+    static index_type invalid_index() { return std::numeric_limits<index_type>::max(); }
+
+    csr_adjacency() {}
+
+    /** @brief Builds the adjacency arrays in a single pass over the cells of the mesh or segment.
+     *
+     * @param mesh_or_segment     The mesh or segment from which the adjacency is extracted
+     */
+    template <typename MeshOrSegmentHandleT>
+    explicit csr_adjacency(MeshOrSegmentHandleT const & mesh_or_segment)
+    {
+      typedef typename viennagrid::result_of::cell_tag<MeshOrSegmentHandleT>::type               CellTag;
+      typedef typename viennagrid::result_of::facet_tag<CellTag>::type                            FacetTag;
+      typedef typename viennagrid::result_of::cell<MeshOrSegmentHandleT>::type                    CellType;
+
+      typedef typename viennagrid::result_of::const_element_range<MeshOrSegmentHandleT, CellTag>::type  CellRange;
+      typedef typename viennagrid::result_of::iterator<CellRange>::type                                 CellIterator;
+      typedef typename viennagrid::result_of::const_element_range<CellType, FacetTag>::type             FacetOnCellRange;
+      typedef typename viennagrid::result_of::iterator<FacetOnCellRange>::type                          FacetOnCellIterator;
+
+      CellRange cells(mesh_or_segment);
+
+      cell_ids_.reserve(cells.size());
+      cell_facet_offsets_.reserve(cells.size() + 1);
+      cell_facet_offsets_.push_back(0);
+      cell_facets_.reserve(cells.size() * boundary_elements<CellTag, FacetTag>::num);
+
+      // Facet ID -> facet index, and up to two cells per facet:
+      index_array_type facet_index_of_id;
+      index_array_type facet_cell_pairs;
+
+      //
+      // Single pass over the mesh: cell -> facets
+      //
+      for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+      {
+        index_type cell_index = cell_ids_.size();
+        cell_ids_.push_back( static_cast<index_type>(cit->id().get()) );
+
+        FacetOnCellRange facets_on_cell(*cit);
+        for (FacetOnCellIterator focit = facets_on_cell.begin(); focit != facets_on_cell.end(); ++focit)
+        {
+          index_type facet_id = static_cast<index_type>(focit->id().get());
+          if (facet_id >= facet_index_of_id.size())
+            facet_index_of_id.resize(2 * facet_id + 1, invalid_index());
+
+          index_type facet_index = facet_index_of_id[facet_id];
+          if (facet_index == invalid_index())
+          {
+            facet_index = facet_ids_.size();
+            facet_index_of_id[facet_id] = facet_index;
+            facet_ids_.push_back(facet_id);
+            facet_cell_pairs.push_back(cell_index);
+            facet_cell_pairs.push_back(invalid_index());
+          }
+          else
+            facet_cell_pairs[2*facet_index + 1] = cell_index;
+
+          cell_facets_.push_back(facet_index);
+        }
+
+        cell_facet_offsets_.push_back(cell_facets_.size());
+      }
+
+      //
+      // facet -> cells
+      //
+      facet_cell_offsets_.reserve(facet_ids_.size() + 1);
+      facet_cell_offsets_.push_back(0);
+      facet_cells_.reserve(facet_cell_pairs.size());
+      for (index_type i=0; i<facet_ids_.size(); ++i)
+      {
+        facet_cells_.push_back(facet_cell_pairs[2*i]);
+        if (facet_cell_pairs[2*i+1] != invalid_index())
+          facet_cells_.push_back(facet_cell_pairs[2*i+1]);
+        facet_cell_offsets_.push_back(facet_cells_.size());
+      }
+
+      //
+      // cell -> neighbor cells, derived from the two arrays above by index arithmetic only
+      //
+      cell_neighbor_offsets_.reserve(cell_ids_.size() + 1);
+      cell_neighbor_offsets_.push_back(0);
+      neighbors_.reserve(cell_facets_.size());
+      neighbor_facets_.reserve(cell_facets_.size());
+      for (index_type i=0; i<cell_ids_.size(); ++i)
+      {
+        for (index_type j=cell_facet_offsets_[i]; j<cell_facet_offsets_[i+1]; ++j)
+        {
+          index_type other = other_cell(cell_facets_[j], i);
+          if (other != invalid_index())
+          {
+            neighbors_.push_back(other);
+            neighbor_facets_.push_back(cell_facets_[j]);
+          }
+        }
+        cell_neighbor_offsets_.push_back(neighbors_.size());
+      }
+    }
+
+    /** @brief Number of cells */
+    index_type cell_count() const { return cell_ids_.size(); }
+    /** @brief Number of facets */
+    index_type facet_count() const { return facet_ids_.size(); }
+
+    /** @brief Returns the cell on the other side of the facet, or invalid_index() if the facet is on the boundary */
+    index_type other_cell(index_type facet_index, index_type cell_index) const
+    {
+      index_type begin = facet_cell_offsets_[facet_index];
+      if (facet_cell_offsets_[facet_index + 1] - begin < 2)
+        return invalid_index();
+      return (facet_cells_[begin] == cell_index) ? facet_cells_[begin + 1] : facet_cells_[begin];
+    }
+
+    /** @brief Element IDs of the cells, indexed by cell index */
+    index_array_type const & cell_ids()  const { return cell_ids_; }
+    /** @brief Element IDs of the facets, indexed by facet index */
+    index_array_type const & facet_ids() const { return facet_ids_; }
+
+    /** @brief CSR row offsets of the cell-to-facet adjacency (size cell_count()+1) */
+    index_array_type const & cell_facet_offsets() const { return cell_facet_offsets_; }
+    /** @brief CSR column indices of the cell-to-facet adjacency */
+    index_array_type const & cell_facets()        const { return cell_facets_; }
+
+    /** @brief CSR row offsets of the facet-to-cell adjacency (size facet_count()+1) */
+    index_array_type const & facet_cell_offsets() const { return facet_cell_offsets_; }
+    /** @brief CSR column indices of the facet-to-cell adjacency. Boundary facets have one cell, interior facets two. */
+    index_array_type const & facet_cells()        const { return facet_cells_; }
+
+    /** @brief CSR row offsets of the cell-to-neighbor-cell adjacency (size cell_count()+1) */
+    index_array_type const & cell_neighbor_offsets() const { return cell_neighbor_offsets_; }
+    /** @brief CSR column indices of the cell-to-neighbor-cell adjacency */
+    index_array_type const & neighbors()             const { return neighbors_; }
+    /** @brief Facet shared with the respective entry in neighbors() */
+    index_array_type const & neighbor_facets()       const { return neighbor_facets_; }
+
+  private:
+    index_array_type cell_ids_;
+    index_array_type facet_ids_;
+
+    index_array_type cell_facet_offsets_;
+    index_array_type cell_facets_;
+
+    index_array_type facet_cell_offsets_;
+    index_array_type facet_cells_;
+
+    index_array_type cell_neighbor_offsets_;
+    index_array_type neighbors_;
+    index_array_type neighbor_facets_;
+  };
+
+}
+
+#endif
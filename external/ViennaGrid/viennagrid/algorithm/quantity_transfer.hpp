@@ -14,8 +14,10 @@
 ======================================================================= */
 
 #include <vector>
+#include <limits>
 #include "viennagrid/forwards.hpp"
 #include "viennagrid/mesh/mesh.hpp"
+#include "viennagrid/algorithm/volume.hpp"
 
 /** @file viennagrid/algorithm/quantity_transfer.hpp
     @brief Provides routines for transferring quantities defined for elements of one topological dimensions to elements of other topological dimension.
@@ -175,6 +177,241 @@ namespace viennagrid
                                                  typename detail::quantity_transfer_dispatcher<SourceTag, DestinationTag>::type());
   }
 
+
+
+  /** @brief Tag for quantity_transfer_weights: all adjacent source elements contribute with the same weight */
+  struct arithmetic_averaging_tag {};
+
+  /** @brief Tag for quantity_transfer_weights: adjacent source elements contribute proportionally to their volume */
+  struct volume_averaging_tag {};
+
+  namespace detail
+  {
+    /** @brief For internal use only */
+    template <typename ElementT>
+    double transfer_weight(ElementT const &, arithmetic_averaging_tag) { return 1.0; }
+
+    /** @brief For internal use only */
+    template <typename ElementT>
+    double transfer_weight(ElementT const & element, volume_averaging_tag) { return viennagrid::volume(element); }
+  }
+
+  /** @brief Precomputed averaging weights for transferring quantities from elements of higher to elements of lower topological dimension, e.g. from cells to vertices.
+   *
+   * The weights are computed once in a single pass over the source elements and stored as a sparse matrix in compressed row format (one row per destination element).
+   * Afterwards, any number of fields can be transferred with apply(), which only operates on contiguous arrays and runs in parallel if VIENNAGRID_WITH_OPENMP is defined.
+   * Source and destination elements are indexed by their position in source_elements() and destination_elements(); use gather() and scatter() to move data between accessors and the flat arrays.
+   * Once constructed, the weights do not track changes of the mesh.
+   *
+   * @tparam MeshOrSegmentT         The mesh or segment type in which the source and destination elements reside
+   * @tparam SourceTypeOrTag        The source element type or tag, e.g. the cell type
+   * @tparam DestinationTypeOrTag   The destination element type or tag, e.g. the vertex type
+   * @tparam NumericT               The floating point type of the weights and values
+   */
+  template <typename MeshOrSegmentT, typename SourceTypeOrTag, typename DestinationTypeOrTag, typename NumericT = double>
+  class quantity_transfer_weights
+  {
+    typedef typename viennagrid::result_of::element_tag<SourceTypeOrTag>::type       SourceTag;
+    typedef typename viennagrid::result_of::element_tag<DestinationTypeOrTag>::type  DestinationTag;
+
+    typedef typename viennagrid::result_of::const_element_range<MeshOrSegmentT, SourceTag>::type  SourceContainer;
+    typedef typename viennagrid::result_of::iterator<SourceContainer>::type                       SourceIterator;
+
+  public:
+    typedef NumericT                                                                              value_type;
+    typedef std::size_t                                                                           index_type;
+    typedef std::vector<index_type>                                                               index_array_type;
+
+    typedef typename viennagrid::result_of::element<MeshOrSegmentT, SourceTag>::type              source_element_type;
+    typedef typename viennagrid::result_of::element<MeshOrSegmentT, DestinationTag>::type         destination_element_type;
+
+  private:
+    typedef typename viennagrid::result_of::const_element_range<source_element_type, DestinationTag>::type  DestOnSrcContainer;
+    typedef typename viennagrid::result_of::iterator<DestOnSrcContainer>::type                              DestOnSrcIterator;
+
+  public:
+    /** @brief Computes the averaging weights.
+     *
+     * @param mesh_or_segment    A mesh or segment, in which the source and destination elements reside
+     * @param tag                Either arithmetic_averaging_tag or volume_averaging_tag
+     * @param filter_src         A functor which returns true for all source elements considered for the transfer, false otherwise
+     * @param filter_dest        A functor which returns true for all destination elements considered for the transfer, false otherwise
+     */
+    template <typename AveragingTagT, typename SourceFilterT, typename DestinationFilterT>
+    quantity_transfer_weights(MeshOrSegmentT const & mesh_or_segment, AveragingTagT tag,
+                              SourceFilterT const & filter_src, DestinationFilterT const & filter_dest)
+    {
+      SourceContainer source_cells(mesh_or_segment);
+
+      // Destination ID -> destination index, and the (destination, source, weight) triplets in the order of the source elements:
+      index_array_type             dest_index_of_id;
+      index_array_type             triplet_dest;
+      index_array_type             triplet_src;
+      std::vector<NumericT>        triplet_weights;
+
+      //
+      // Step 1: Push the weights of all source elements to their destination boundary (boundary iteration only, as in quantity_transfer())
+      //
+      source_elements_.reserve(source_cells.size());
+      for (SourceIterator sit = source_cells.begin(); sit != source_cells.end(); ++sit)
+      {
+        if ( !filter_src(*sit) )
+          continue;
+
+        index_type src_index = source_elements_.size();
+        source_elements_.push_back( &(*sit) );
+        NumericT weight = static_cast<NumericT>(detail::transfer_weight(*sit, tag));
+
+        DestOnSrcContainer dest_on_src(*sit);
+        for (DestOnSrcIterator dosit = dest_on_src.begin(); dosit != dest_on_src.end(); ++dosit)
+        {
+          if ( !filter_dest(*dosit) )
+            continue;
+
+          index_type dest_id = static_cast<index_type>(dosit->id().get());
+          if (dest_id >= dest_index_of_id.size())
+            dest_index_of_id.resize(2 * dest_id + 1, invalid_index());
+
+          index_type dest_index = dest_index_of_id[dest_id];
+          if (dest_index == invalid_index())
+          {
+            dest_index = destination_elements_.size();
+            dest_index_of_id[dest_id] = dest_index;
+            destination_elements_.push_back( &(*dosit) );
+          }
+
+          triplet_dest.push_back(dest_index);
+          triplet_src.push_back(src_index);
+          triplet_weights.push_back(weight);
+        }
+      }
+
+      //
+      // Step 2: Sort the triplets by destination (counting sort, stable with respect to the source order)
+      //
+      row_offsets_.assign(destination_elements_.size() + 1, 0);
+      for (index_type i=0; i<triplet_dest.size(); ++i)
+        ++row_offsets_[triplet_dest[i] + 1];
+      for (index_type i=0; i<destination_elements_.size(); ++i)
+        row_offsets_[i+1] += row_offsets_[i];
+
+      index_array_type row_fill(row_offsets_.begin(), row_offsets_.end() - 1);
+      columns_.resize(triplet_dest.size());
+      weights_.resize(triplet_dest.size());
+      for (index_type i=0; i<triplet_dest.size(); ++i)
+      {
+        index_type pos = row_fill[triplet_dest[i]]++;
+        columns_[pos] = triplet_src[i];
+        weights_[pos] = triplet_weights[i];
+      }
+
+      //
+      // Step 3: Normalize each row such that the weights sum up to one
+      //
+      for (index_type i=0; i<destination_elements_.size(); ++i)
+      {
+        NumericT row_sum = 0;
+        for (index_type j=row_offsets_[i]; j<row_offsets_[i+1]; ++j)
+          row_sum += weights_[j];
+
+        if (row_sum > 0)
+          for (index_type j=row_offsets_[i]; j<row_offsets_[i+1]; ++j)
+            weights_[j] /= row_sum;
+      }
+    }
+
+    /** @brief Number of source elements taking part in the transfer */
+    index_type source_count()      const { return source_elements_.size(); }
+    /** @brief Number of destination elements receiving a value */
+    index_type destination_count() const { return destination_elements_.size(); }
+
+    /** @brief Source elements, indexed by source index */
+    std::vector<source_element_type const *>      const & source_elements()      const { return source_elements_; }
+    /** @brief Destination elements, indexed by destination index */
+    std::vector<destination_element_type const *> const & destination_elements() const { return destination_elements_; }
+
+    /** @brief CSR row offsets of the weight matrix (size destination_count()+1) */
+    index_array_type      const & row_offsets() const { return row_offsets_; }
+    /** @brief CSR column indices of the weight matrix, i.e. source indices */
+    index_array_type      const & columns()     const { return columns_; }
+    /** @brief Weights of the entries in columns(). The weights of each row sum up to one. */
+    std::vector<NumericT> const & weights()     const { return weights_; }
+
+    /** @brief Reads the values of one field from an accessor into an interleaved source array.
+     *
+     * @param accessor_src       An accessor functor for retrieving the data defined on each source element
+     * @param field              The index of the field within the interleaved array
+     * @param num_fields         The total number of fields stored in the interleaved array
+     * @param src                The interleaved array of size source_count() * num_fields. Resized if necessary.
+     */
+    template <typename SourceAccessorT>
+    void gather(SourceAccessorT const & accessor_src, index_type field, index_type num_fields, std::vector<NumericT> & src) const
+    {
+      src.resize(source_count() * num_fields);
+      for (index_type i=0; i<source_count(); ++i)
+        src[i * num_fields + field] = accessor_src(*source_elements_[i]);
+    }
+
+    /** @brief Transfers 'num_fields' fields at once: dest[i*num_fields + k] = sum_j w_ij * src[j*num_fields + k]
+     *
+     * The weights are normalized beforehand, hence the results agree with quantity_transfer(), which divides the sum of the
+     * values by the sum of the weights, only up to rounding (a few ulps), not bit for bit.
+     *
+     * @param src                The interleaved source values of size source_count() * num_fields
+     * @param num_fields         The number of interleaved fields
+     * @param dest               The interleaved destination values of size destination_count() * num_fields. Resized if necessary.
+     */
+    void apply(std::vector<NumericT> const & src, index_type num_fields, std::vector<NumericT> & dest) const
+    {
+      dest.resize(destination_count() * num_fields);
+      if (num_fields == 0)
+        return;
+
+      long num_rows = static_cast<long>(destination_count());
+#ifdef VIENNAGRID_WITH_OPENMP
+      #pragma omp parallel for
+#endif
+      for (long i = 0; i < num_rows; ++i)
+      {
+        NumericT * dest_row = &dest[static_cast<index_type>(i) * num_fields];
+        for (index_type k=0; k<num_fields; ++k)
+          dest_row[k] = 0;
+
+        for (index_type j=row_offsets_[i]; j<row_offsets_[i+1]; ++j)
+        {
+          NumericT         weight  = weights_[j];
+          NumericT const * src_row = &src[columns_[j] * num_fields];
+          for (index_type k=0; k<num_fields; ++k)
+            dest_row[k] += weight * src_row[k];
+        }
+      }
+    }
+
+    /** @brief Writes the values of one field from an interleaved destination array to a setter.
+     *
+     * @param dest               The interleaved destination values as computed by apply()
+     * @param field              The index of the field within the interleaved array
+     * @param num_fields         The total number of fields stored in the interleaved array
+     * @param setter_dest        A setter for storing the data on each destination element (first argument is the destination n-cell, second argument is the value)
+     */
+    template <typename DestinationSetterT>
+    void scatter(std::vector<NumericT> const & dest, index_type field, index_type num_fields, DestinationSetterT & setter_dest) const
+    {
+      for (index_type i=0; i<destination_count(); ++i)
+        setter_dest(*destination_elements_[i], dest[i * num_fields + field]);
+    }
+
+  private:
+    static index_type invalid_index() { return std::numeric_limits<index_type>::max(); }
+
+    std::vector<source_element_type const *>        source_elements_;
+    std::vector<destination_element_type const *>   destination_elements_;
+
+    index_array_type        row_offsets_;
+    index_array_type        columns_;
+    std::vector<NumericT>   weights_;
+  };
+
 }
 
 #endif
@@ -0,0 +1,613 @@
+#ifndef VIENNAGRID_ALGORITHM_REORDER_HPP
+#define VIENNAGRID_ALGORITHM_REORDER_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                     ViennaGrid - The Vienna Grid Library
+                            -----------------
+
+   License:      MIT (X11), see file LICENSE in the base directory
+======================================================================= */
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include "viennagrid/forwards.hpp"
+#include "viennagrid/algorithm/centroid.hpp"
+#include "viennagrid/algorithm/csr_adjacency.hpp"
+
+#include "viennagrid/mesh/element_creation.hpp"
+
+/** @file viennagrid/algorithm/reorder.hpp
+    @brief Provides the routines for a cache-friendly renumbering of the cells and vertices of a mesh
+*/
+
+namespace viennagrid
+{
+  /** @brief Tag selecting the reverse Cuthill-McKee ordering of the cell adjacency graph */
+  struct reverse_cuthill_mckee_tag {};
+
+  /** @brief Tag selecting a Morton (Z-order) space-filling curve on the cell centroids */
+  struct morton_tag {};
+
+
+  /** @brief Bandwidth and profile of the cell adjacency matrix before and after a reordering */
+  struct reordering_statistics
+  {
+    reordering_statistics() : bandwidth_before(0), profile_before(0), bandwidth_after(0), profile_after(0) {}
+
+    std::size_t bandwidth_before;
+    std::size_t profile_before;
+    std::size_t bandwidth_after;
+    std::size_t profile_after;
+  };
+
+
+  namespace detail
+  {
+    /** @brief For internal use only */
+    typedef std::vector< std::vector<std::size_t> >   cell_adjacency_type;
+
+    /** @brief For internal use only. Builds the facet-based cell adjacency graph. Cells are indexed by their position in the cell range of the mesh. */
+    template <typename MeshT>
+    void cell_adjacency(MeshT const & mesh_in, cell_adjacency_type & neighbors)
+    {
+      csr_adjacency adjacency(mesh_in);
+
+      csr_adjacency::index_array_type const & offsets = adjacency.cell_neighbor_offsets();
+
+      neighbors.clear();
+      neighbors.resize(adjacency.cell_count());
+      for (std::size_t i=0; i<neighbors.size(); ++i)
+      {
+        neighbors[i].assign(adjacency.neighbors().begin() + offsets[i], adjacency.neighbors().begin() + offsets[i+1]);
+        std::sort(neighbors[i].begin(), neighbors[i].end());
+      }
+    }
+
+
+    /** @brief For internal use only. Functor ordering graph nodes by ascending degree, ties broken by index. */
+    struct degree_less
+    {
+      degree_less(cell_adjacency_type const & neighbors) : neighbors_(neighbors) {}
+
+      bool operator()(std::size_t a, std::size_t b) const
+      {
+        if (neighbors_[a].size() != neighbors_[b].size())
+          return neighbors_[a].size() < neighbors_[b].size();
+        return a < b;
+      }
+
+      cell_adjacency_type const & neighbors_;
+    };
+
+
+    /** @brief For internal use only. Breadth-first level structure rooted at 'root'. Returns the eccentricity of 'root', the last level is written to 'last_level'.
+      *
+      * 'level' has to be filled with 'invalid' on entry and is restored on exit, so that the costs are linear in the size of the connected component only.
+      */
+    inline std::size_t level_structure(cell_adjacency_type const & neighbors,
+                                       std::size_t root,
+                                       std::vector<std::size_t> & level,
+                                       std::vector<std::size_t> & queue,
+                                       std::vector<std::size_t> & last_level)
+    {
+      std::size_t const invalid = std::numeric_limits<std::size_t>::max();
+
+      queue.clear();
+      queue.push_back(root);
+      level[root] = 0;
+
+      std::size_t depth = 0;
+      last_level.clear();
+      for (std::size_t head = 0; head < queue.size(); ++head)
+      {
+        std::size_t node = queue[head];
+
+        if (level[node] > depth)
+        {
+          depth = level[node];
+          last_level.clear();
+        }
+        last_level.push_back(node);
+
+        for (std::size_t i=0; i<neighbors[node].size(); ++i)
+        {
+          std::size_t other = neighbors[node][i];
+          if (level[other] == invalid)
+          {
+            level[other] = level[node] + 1;
+            queue.push_back(other);
+          }
+        }
+      }
+
+      for (std::size_t i=0; i<queue.size(); ++i)
+        level[queue[i]] = invalid;
+
+      return depth;
+    }
+
+
+    /** @brief For internal use only. George-Liu search for a pseudo-peripheral node in the connected component of 'start'. */
+    inline std::size_t pseudo_peripheral_node(cell_adjacency_type const & neighbors, std::size_t start,
+                                              std::vector<std::size_t> & level, std::vector<std::size_t> & queue)
+    {
+      std::vector<std::size_t> last_level;
+
+      std::size_t root = start;
+      std::size_t eccentricity = level_structure(neighbors, root, level, queue, last_level);
+
+      while (true)
+      {
+        std::size_t candidate = *std::min_element(last_level.begin(), last_level.end(), degree_less(neighbors));
+        std::size_t candidate_eccentricity = level_structure(neighbors, candidate, level, queue, last_level);
+
+        if (candidate_eccentricity <= eccentricity)
+          break;
+
+        root = candidate;
+        eccentricity = candidate_eccentricity;
+      }
+
+      return root;
+    }
+
+
+    /** @brief For internal use only. Reverse Cuthill-McKee ordering. ordering[new_index] = old_index */
+    inline void reverse_cuthill_mckee(cell_adjacency_type const & neighbors, std::vector<std::size_t> & ordering)
+    {
+      std::size_t num_nodes = neighbors.size();
+
+      ordering.clear();
+      ordering.reserve(num_nodes);
+
+      std::vector<bool> visited(num_nodes, false);
+      std::vector<std::size_t> candidates;
+
+      std::vector<std::size_t> level(num_nodes, std::numeric_limits<std::size_t>::max());
+      std::vector<std::size_t> queue;
+
+      for (std::size_t i=0; i<num_nodes; ++i)
+      {
+        if (visited[i])
+          continue;
+
+        // one connected component per pass:
+        std::size_t root = pseudo_peripheral_node(neighbors, i, level, queue);
+        std::size_t head = ordering.size();
+
+        ordering.push_back(root);
+        visited[root] = true;
+
+        while (head < ordering.size())
+        {
+          std::size_t node = ordering[head++];
+
+          candidates.clear();
+          for (std::size_t j=0; j<neighbors[node].size(); ++j)
+          {
+            std::size_t other = neighbors[node][j];
+            if (!visited[other])
+            {
+              visited[other] = true;
+              candidates.push_back(other);
+            }
+          }
+
+          std::sort(candidates.begin(), candidates.end(), degree_less(neighbors));
+          ordering.insert(ordering.end(), candidates.begin(), candidates.end());
+        }
+      }
+
+      std::reverse(ordering.begin(), ordering.end());
+    }
+
+
+    /** @brief For internal use only. Morton ordering of cell centroids. ordering[new_index] = old_index */
+    template <typename MeshT, typename PointAccessorT>
+    void morton_ordering(MeshT const & mesh_in, PointAccessorT const point_accessor_in, std::vector<std::size_t> & ordering)
+    {
+      typedef typename viennagrid::result_of::cell_tag<MeshT>::type                         CellTag;
+      typedef typename viennagrid::result_of::point<MeshT>::type                            PointType;
+      typedef typename viennagrid::result_of::coord<PointType>::type                        CoordType;
+
+      typedef typename viennagrid::result_of::const_element_range<MeshT, CellTag>::type    CellRange;
+      typedef typename viennagrid::result_of::iterator<CellRange>::type                    CellIterator;
+
+      // bits per coordinate direction; 3 * 10 bits fit into any unsigned long
+      static const unsigned int bits = 10;
+
+      CellRange cells(mesh_in);
+
+      std::vector<PointType> centroids;
+      centroids.reserve(cells.size());
+      for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+        centroids.push_back( viennagrid::centroid(point_accessor_in, *cit) );
+
+      ordering.clear();
+      if (centroids.empty())
+        return;
+
+      std::size_t dim = centroids[0].size();
+
+      // bounding box of the centroids:
+      PointType lower = centroids[0];
+      PointType upper = centroids[0];
+      for (std::size_t i=1; i<centroids.size(); ++i)
+      {
+        for (std::size_t d=0; d<dim; ++d)
+        {
+          lower[d] = std::min(lower[d], centroids[i][d]);
+          upper[d] = std::max(upper[d], centroids[i][d]);
+        }
+      }
+
+      std::vector< std::pair<unsigned long, std::size_t> > keys(centroids.size());
+      for (std::size_t i=0; i<centroids.size(); ++i)
+      {
+        std::vector<unsigned long> q(dim);
+        for (std::size_t d=0; d<dim; ++d)
+        {
+          CoordType extent = upper[d] - lower[d];
+          if (extent > 0)
+            q[d] = static_cast<unsigned long>( (centroids[i][d] - lower[d]) / extent * ((1ul << bits) - 1) );
+          else
+            q[d] = 0;
+        }
+
+        unsigned long key = 0;
+        for (unsigned int b=bits; b > 0; --b)
+          for (std::size_t d=0; d<dim; ++d)
+            key = (key << 1) | ((q[d] >> (b-1)) & 1ul);
+
+        keys[i] = std::make_pair(key, i);
+      }
+
+      std::sort(keys.begin(), keys.end());
+
+      ordering.resize(keys.size());
+      for (std::size_t i=0; i<keys.size(); ++i)
+        ordering[i] = keys[i].second;
+    }
+
+
+    /** @brief For internal use only */
+    template <typename MeshT, typename PointAccessorT>
+    void cell_ordering(cell_adjacency_type const & neighbors, MeshT const &, PointAccessorT const, reverse_cuthill_mckee_tag, std::vector<std::size_t> & ordering)
+    {
+      reverse_cuthill_mckee(neighbors, ordering);
+    }
+
+    /** @brief For internal use only */
+    template <typename MeshT, typename PointAccessorT>
+    void cell_ordering(cell_adjacency_type const &, MeshT const & mesh_in, PointAccessorT const point_accessor_in, morton_tag, std::vector<std::size_t> & ordering)
+    {
+      morton_ordering(mesh_in, point_accessor_in, ordering);
+    }
+
+
+    /** @brief For internal use only. Returns bandwidth and profile of the adjacency graph with respect to the numbering 'ordering' (ordering[new_index] = old_index) */
+    inline std::pair<std::size_t, std::size_t> bandwidth_and_profile(cell_adjacency_type const & neighbors, std::vector<std::size_t> const & ordering)
+    {
+      std::vector<std::size_t> new_index(ordering.size());
+      for (std::size_t i=0; i<ordering.size(); ++i)
+        new_index[ordering[i]] = i;
+
+      std::size_t bandwidth = 0;
+      std::size_t profile   = 0;
+      for (std::size_t i=0; i<ordering.size(); ++i)
+      {
+        std::size_t first = i;  // leftmost nonzero column in row i of the lower triangle
+        std::vector<std::size_t> const & row = neighbors[ordering[i]];
+        for (std::size_t j=0; j<row.size(); ++j)
+        {
+          std::size_t col = new_index[row[j]];
+          bandwidth = std::max(bandwidth, (col > i) ? col - i : i - col);
+          first = std::min(first, col);
+        }
+        profile += i - first;
+      }
+
+      return std::make_pair(bandwidth, profile);
+    }
+
+
+    /** @brief For internal use only. Computes the new cell ordering and the bandwidth and profile of the cell adjacency before and after. */
+    template <typename MeshT, typename PointAccessorT, typename OrderingTagT>
+    reordering_statistics compute_ordering(MeshT const & mesh_in, PointAccessorT const point_accessor_in, OrderingTagT tag, std::vector<std::size_t> & ordering)
+    {
+      cell_adjacency_type neighbors;
+      cell_adjacency(mesh_in, neighbors);
+
+      std::vector<std::size_t> identity(neighbors.size());
+      for (std::size_t i=0; i<identity.size(); ++i)
+        identity[i] = i;
+
+      cell_ordering(neighbors, mesh_in, point_accessor_in, tag, ordering);
+
+      std::pair<std::size_t, std::size_t> before = bandwidth_and_profile(neighbors, identity);
+      std::pair<std::size_t, std::size_t> after  = bandwidth_and_profile(neighbors, ordering);
+
+      reordering_statistics stats;
+      stats.bandwidth_before = before.first;  stats.profile_before = before.second;
+      stats.bandwidth_after  = after.first;   stats.profile_after  = after.second;
+      return stats;
+    }
+
+
+    /** @brief For internal use only */
+    template <typename WrappedMeshConfigInT, typename WrappedMeshConfigOutT, typename PointAccessorT,
+              typename SegmentIDContainerT, typename SegmentCreatorT>
+    void reorder_impl(mesh<WrappedMeshConfigInT> const & mesh_in,
+                      mesh<WrappedMeshConfigOutT> & mesh_out,
+                      PointAccessorT const point_accessor_in,
+                      std::vector<std::size_t> const & ordering,
+                      SegmentIDContainerT const & cell_segments,
+                      SegmentCreatorT & segment_creator)
+    {
+      typedef mesh<WrappedMeshConfigInT>      MeshInType;
+      typedef mesh<WrappedMeshConfigOutT>     MeshOutType;
+
+      typedef typename viennagrid::result_of::cell_tag<MeshInType>::type                     CellTag;
+      typedef typename viennagrid::result_of::cell<MeshInType>::type                         CellType;
+      typedef typename viennagrid::result_of::vertex<MeshInType>::type                       VertexType;
+
+      typedef typename viennagrid::result_of::const_element_range<MeshInType, CellTag>::type     CellRange;
+      typedef typename viennagrid::result_of::iterator<CellRange>::type                          CellIterator;
+      typedef typename viennagrid::result_of::const_element_range<CellType, vertex_tag>::type    VertexOnCellRange;
+      typedef typename viennagrid::result_of::iterator<VertexOnCellRange>::type                  VertexOnCellIterator;
+
+      typedef typename viennagrid::result_of::vertex_handle<MeshOutType>::type               VertexHandleType;
+
+      CellRange cells(mesh_in);
+
+      std::vector<CellType const *> cells_in;
+      cells_in.reserve(cells.size());
+      for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+        cells_in.push_back( &(*cit) );
+
+      // vertices are numbered in the order they are first touched by the renumbered cells:
+      std::vector<VertexHandleType> vertex_handles( viennagrid::id_upper_bound<VertexType>(mesh_in).get() );
+      std::vector<bool>             vertex_created( vertex_handles.size(), false );
+
+      for (std::size_t i=0; i<ordering.size(); ++i)
+      {
+        CellType const & cell = *cells_in[ordering[i]];
+
+        static_array<VertexHandleType, boundary_elements<CellTag, vertex_tag>::num> cell_vertex_handles;
+
+        std::size_t local_index = 0;
+        VertexOnCellRange vertices_on_cell(cell);
+        for (VertexOnCellIterator vocit = vertices_on_cell.begin(); vocit != vertices_on_cell.end(); ++vocit, ++local_index)
+        {
+          std::size_t vertex_id = static_cast<std::size_t>(vocit->id().get());
+          if (!vertex_created[vertex_id])
+          {
+            vertex_handles[vertex_id] = viennagrid::make_vertex( mesh_out, point_accessor_in(*vocit) );
+            vertex_created[vertex_id] = true;
+          }
+          cell_vertex_handles[local_index] = vertex_handles[vertex_id];
+        }
+
+        segment_creator(mesh_out, cell_vertex_handles, cell_segments[ordering[i]]);
+      }
+    }
+
+
+    /** @brief For internal use only. Creates a cell in the mesh only. */
+    struct reorder_mesh_cell_creator
+    {
+      template <typename MeshOutT, typename VertexHandleContainerT, typename SegmentIDsT>
+      void operator()(MeshOutT & mesh_out, VertexHandleContainerT const & vertex_handles, SegmentIDsT const &)
+      {
+        typedef typename viennagrid::result_of::cell_tag<MeshOutT>::type  CellTag;
+        viennagrid::make_element<CellTag>( mesh_out, vertex_handles.begin(), vertex_handles.end() );
+      }
+    };
+
+    /** @brief For internal use only. Creates a cell in the first segment it belongs to and adds it to all further segments. */
+    template <typename SegmentationOutT>
+    struct reorder_segmentation_cell_creator
+    {
+      reorder_segmentation_cell_creator(SegmentationOutT & segmentation_out) : segmentation_out_(segmentation_out) {}
+
+      template <typename MeshOutT, typename VertexHandleContainerT, typename SegmentIDsT>
+      void operator()(MeshOutT & mesh_out, VertexHandleContainerT const & vertex_handles, SegmentIDsT const & segment_ids)
+      {
+        typedef typename viennagrid::result_of::cell_tag<MeshOutT>::type  CellTag;
+
+        if (segment_ids.empty())
+        {
+          viennagrid::make_element<CellTag>( mesh_out, vertex_handles.begin(), vertex_handles.end() );
+          return;
+        }
+
+        typename viennagrid::result_of::cell_handle<MeshOutT>::type cell_handle
+          = viennagrid::make_element<CellTag>( segmentation_out_(segment_ids[0]), vertex_handles.begin(), vertex_handles.end() );
+
+        for (std::size_t i=1; i<segment_ids.size(); ++i)
+          viennagrid::add( segmentation_out_(segment_ids[i]), viennagrid::dereference_handle(mesh_out, cell_handle) );
+      }
+
+      SegmentationOutT & segmentation_out_;
+    };
+
+  } //namespace detail
+
+
+
+  /** @brief Returns the bandwidth and the profile of the facet-based cell adjacency matrix of a mesh for the current cell numbering.
+   *
+   * The adjacency matrix has the same sparsity pattern as a finite volume system matrix with one unknown per cell.
+   *
+   * @param mesh_in                           Input mesh
+   * @return                                  Pair (bandwidth, profile)
+   */
+  template <typename WrappedMeshConfigInT>
+  std::pair<std::size_t, std::size_t> cell_bandwidth_and_profile(mesh<WrappedMeshConfigInT> const & mesh_in)
+  {
+    detail::cell_adjacency_type neighbors;
+    detail::cell_adjacency(mesh_in, neighbors);
+
+    std::vector<std::size_t> identity(neighbors.size());
+    for (std::size_t i=0; i<identity.size(); ++i)
+      identity[i] = i;
+
+    return detail::bandwidth_and_profile(neighbors, identity);
+  }
+
+
+  /** @brief Computes a new numbering of the cells of a mesh without modifying the mesh.
+   *
+   * @tparam OrderingTagT                     Either reverse_cuthill_mckee_tag or morton_tag
+   * @param mesh_in                           Input mesh
+   * @param point_accessor_in                 Point accessor for input points
+   * @param ordering                          Output: ordering[new_index] is the position of the cell in the cell range of mesh_in
+   */
+  template <typename OrderingTagT, typename WrappedMeshConfigInT, typename PointAccessorT>
+  void cell_ordering(mesh<WrappedMeshConfigInT> const & mesh_in, PointAccessorT const point_accessor_in, std::vector<std::size_t> & ordering)
+  {
+    detail::compute_ordering(mesh_in, point_accessor_in, OrderingTagT(), ordering);
+  }
+
+  /** @brief Computes a new numbering of the cells of a mesh without modifying the mesh.
+   *
+   * @tparam OrderingTagT                     Either reverse_cuthill_mckee_tag or morton_tag
+   * @param mesh_in                           Input mesh
+   * @param ordering                          Output: ordering[new_index] is the position of the cell in the cell range of mesh_in
+   */
+  template <typename OrderingTagT, typename WrappedMeshConfigInT>
+  void cell_ordering(mesh<WrappedMeshConfigInT> const & mesh_in, std::vector<std::size_t> & ordering)
+  {
+    cell_ordering<OrderingTagT>(mesh_in, default_point_accessor(mesh_in), ordering);
+  }
+
+
+
+  /** @brief Public interface for renumbering a mesh with explicit point accessor. Cells are written to mesh_out in the new order, vertices are numbered in the order they are first referenced by the renumbered cells.
+   *
+   * @tparam OrderingTagT                     Either reverse_cuthill_mckee_tag or morton_tag
+   * @param mesh_in                           Input mesh
+   * @param mesh_out                          Output renumbered mesh
+   * @param point_accessor_in                 Point accessor for input points
+   * @return                                  Bandwidth and profile of the cell adjacency matrix before and after renumbering
+   */
+  template <typename OrderingTagT, typename WrappedMeshConfigInT, typename WrappedMeshConfigOutT, typename PointAccessorT>
+  reordering_statistics reorder(mesh<WrappedMeshConfigInT> const & mesh_in,
+                                mesh<WrappedMeshConfigOutT> & mesh_out,
+                                PointAccessorT const point_accessor_in)
+  {
+    std::vector<std::size_t> ordering;
+    reordering_statistics stats = detail::compute_ordering(mesh_in, point_accessor_in, OrderingTagT(), ordering);
+
+    std::vector< std::vector<int> > no_segments(ordering.size());
+    detail::reorder_mesh_cell_creator creator;
+    detail::reorder_impl(mesh_in, mesh_out, point_accessor_in, ordering, no_segments, creator);
+
+    return stats;
+  }
+
+  /** @brief Public interface for renumbering a mesh.
+   *
+   * @tparam OrderingTagT                     Either reverse_cuthill_mckee_tag or morton_tag
+   * @param mesh_in                           Input mesh
+   * @param mesh_out                          Output renumbered mesh
+   * @return                                  Bandwidth and profile of the cell adjacency matrix before and after renumbering
+   */
+  template <typename OrderingTagT, typename WrappedMeshConfigInT, typename WrappedMeshConfigOutT>
+  reordering_statistics reorder(mesh<WrappedMeshConfigInT> const & mesh_in,
+                                mesh<WrappedMeshConfigOutT> & mesh_out)
+  {
+    return reorder<OrderingTagT>(mesh_in, mesh_out, default_point_accessor(mesh_in));
+  }
+
+
+
+  /** @brief Public interface for renumbering a mesh with segmentation providing explicit point accessor. Segment IDs and segment membership of the cells are preserved.
+   *
+   * @tparam OrderingTagT                     Either reverse_cuthill_mckee_tag or morton_tag
+   * @param mesh_in                           Input mesh
+   * @param segmentation_in                   Input segmentation
+   * @param mesh_out                          Output renumbered mesh
+   * @param segmentation_out                  Output renumbered segmentation
+   * @param point_accessor_in                 Point accessor for input points
+   * @return                                  Bandwidth and profile of the cell adjacency matrix before and after renumbering
+   */
+  template <typename OrderingTagT,
+            typename WrappedMeshConfigInT,  typename WrappedSegmentationConfigInT,
+            typename WrappedMeshConfigOutT, typename WrappedSegmentationConfigOutT,
+            typename PointAccessorT>
+  reordering_statistics reorder(mesh<WrappedMeshConfigInT> const & mesh_in,  segmentation<WrappedSegmentationConfigInT> const & segmentation_in,
+                                mesh<WrappedMeshConfigOutT> & mesh_out,      segmentation<WrappedSegmentationConfigOutT> & segmentation_out,
+                                PointAccessorT const point_accessor_in)
+  {
+    typedef mesh<WrappedMeshConfigInT>                                MeshInType;
+    typedef segmentation<WrappedSegmentationConfigInT>                SegmentationInType;
+    typedef segmentation<WrappedSegmentationConfigOutT>               SegmentationOutType;
+
+    typedef typename viennagrid::result_of::cell_tag<MeshInType>::type                     CellTag;
+    typedef typename viennagrid::result_of::cell<MeshInType>::type                         CellType;
+    typedef typename viennagrid::result_of::segment_handle<SegmentationInType>::type       SegmentHandleInType;
+    typedef typename viennagrid::result_of::segment_id<SegmentationInType>::type           SegmentIDType;
+
+    typedef typename viennagrid::result_of::const_element_range<MeshInType, CellTag>::type             CellRange;
+    typedef typename viennagrid::result_of::iterator<CellRange>::type                                  CellIterator;
+    typedef typename viennagrid::result_of::const_element_range<SegmentHandleInType, CellTag>::type    SegmentCellRange;
+    typedef typename viennagrid::result_of::iterator<SegmentCellRange>::type                           SegmentCellIterator;
+
+    std::vector<std::size_t> ordering;
+    reordering_statistics stats = detail::compute_ordering(mesh_in, point_accessor_in, OrderingTagT(), ordering);
+
+    //
+    // Collect segment membership, indexed by position in the cell range of mesh_in:
+    //
+    std::vector<std::size_t> cell_index( viennagrid::id_upper_bound<CellType>(mesh_in).get() );
+    CellRange cells(mesh_in);
+    std::size_t index = 0;
+    for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit, ++index)
+      cell_index[static_cast<std::size_t>(cit->id().get())] = index;
+
+    std::vector< std::vector<SegmentIDType> > cell_segments(ordering.size());
+    for (typename SegmentationInType::const_iterator sit = segmentation_in.begin(); sit != segmentation_in.end(); ++sit)
+    {
+      // create all segments up front, so that segment IDs and the order of segments are preserved even for empty segments
+      segmentation_out( sit->id() );
+
+      SegmentCellRange segment_cells(*sit);
+      for (SegmentCellIterator scit = segment_cells.begin(); scit != segment_cells.end(); ++scit)
+        cell_segments[ cell_index[static_cast<std::size_t>(scit->id().get())] ].push_back(sit->id());
+    }
+
+    detail::reorder_segmentation_cell_creator<SegmentationOutType> creator(segmentation_out);
+    detail::reorder_impl(mesh_in, mesh_out, point_accessor_in, ordering, cell_segments, creator);
+
+    return stats;
+  }
+
+  /** @brief Public interface for renumbering a mesh with segmentation. Segment IDs and segment membership of the cells are preserved.
+   *
+   * @tparam OrderingTagT                     Either reverse_cuthill_mckee_tag or morton_tag
+   * @param mesh_in                           Input mesh
+   * @param segmentation_in                   Input segmentation
+   * @param mesh_out                          Output renumbered mesh
+   * @param segmentation_out                  Output renumbered segmentation
+   * @return                                  Bandwidth and profile of the cell adjacency matrix before and after renumbering
+   */
+  template <typename OrderingTagT,
+            typename WrappedMeshConfigInT,  typename WrappedSegmentationConfigInT,
+            typename WrappedMeshConfigOutT, typename WrappedSegmentationConfigOutT>
+  reordering_statistics reorder(mesh<WrappedMeshConfigInT> const & mesh_in,  segmentation<WrappedSegmentationConfigInT> const & segmentation_in,
+                                mesh<WrappedMeshConfigOutT> & mesh_out,      segmentation<WrappedSegmentationConfigOutT> & segmentation_out)
+  {
+    return reorder<OrderingTagT>(mesh_in, segmentation_in, mesh_out, segmentation_out, default_point_accessor(mesh_in));
+  }
+
+}
+
+#endif
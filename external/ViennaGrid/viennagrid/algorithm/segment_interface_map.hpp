@@ -0,0 +1,195 @@
+#ifndef VIENNAGRID_ALGORITHM_SEGMENT_INTERFACE_MAP_HPP
+#define VIENNAGRID_ALGORITHM_SEGMENT_INTERFACE_MAP_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                     ViennaGrid - The Vienna Grid Library
+                            -----------------
+
+   License:      MIT (X11), see file LICENSE in the base directory
+======================================================================= */
+
+#include <vector>
+#include <algorithm>
+
+#include "viennagrid/forwards.hpp"
+#include "viennagrid/mesh/segmentation.hpp"
+
+/** @file viennagrid/algorithm/segment_interface_map.hpp
+    @brief Provides a one-pass detection of all interfaces between the segments of a segmentation.
+*/
+
+namespace viennagrid
+{
+
+  /** @brief Static map of all segment interfaces of a segmentation.
+   *
+   * Each facet is labelled with the IDs of the segments its adjacent cells belong to, using flat arrays over the facet IDs.
+   * The map is built in a single pass over the cells of all segments and answers the queries
+   * 'which segments touch segment X' and 'which facets form the interface of X and Y' in constant time.
+   * In contrast to is_interface(), the map does not track changes of the mesh or the segmentation after construction.
+   *
+   * @tparam SegmentationT     The segmentation type
+   */
+  template <typename SegmentationT>
+  class segment_interface_map
+  {
+    typedef typename viennagrid::result_of::segment_handle<SegmentationT>::type          SegmentHandleType;
+    typedef typename viennagrid::result_of::cell_tag<SegmentHandleType>::type            CellTag;
+    typedef typename viennagrid::result_of::facet_tag<CellTag>::type                     FacetTag;
+    typedef typename viennagrid::result_of::cell<SegmentHandleType>::type                CellType;
+
+    typedef typename viennagrid::result_of::const_element_range<SegmentHandleType, CellTag>::type   CellRange;
+    typedef typename viennagrid::result_of::iterator<CellRange>::type                                CellIterator;
+    typedef typename viennagrid::result_of::const_element_range<CellType, FacetTag>::type           FacetOnCellRange;
+    typedef typename viennagrid::result_of::iterator<FacetOnCellRange>::type                        FacetOnCellIterator;
+
+  public:
+    typedef typename viennagrid::result_of::segment_id<SegmentationT>::type    segment_id_type;
+    typedef std::vector<segment_id_type>                                       segment_id_container_type;
+    typedef std::vector<std::size_t>                                           facet_id_container_type;
+
+    /** @brief Builds the interface map.
+     *
+     * @param segmentation     The segmentation for which all interfaces are detected
+     */
+    segment_interface_map(SegmentationT const & segmentation) : num_segment_ids_(0)
+    {
+      //
+      // Step 1: Collect (facet ID, segment ID) pairs in one pass over all cells of all segments
+      //
+      std::vector< std::pair<std::size_t, segment_id_type> > facet_segment_pairs;
+      for (typename SegmentationT::const_iterator sit = segmentation.begin(); sit != segmentation.end(); ++sit)
+      {
+        num_segment_ids_ = std::max(num_segment_ids_, static_cast<std::size_t>(sit->id()) + 1);
+
+        CellRange cells(*sit);
+        for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+        {
+          FacetOnCellRange facets_on_cell(*cit);
+          for (FacetOnCellIterator focit = facets_on_cell.begin(); focit != facets_on_cell.end(); ++focit)
+            facet_segment_pairs.push_back( std::make_pair(static_cast<std::size_t>(focit->id().get()), sit->id()) );
+        }
+      }
+
+      std::sort(facet_segment_pairs.begin(), facet_segment_pairs.end());
+      facet_segment_pairs.erase( std::unique(facet_segment_pairs.begin(), facet_segment_pairs.end()), facet_segment_pairs.end() );
+
+      //
+      // Step 2: Flat facet ID -> segment IDs labelling (CSR)
+      //
+      std::size_t num_facet_ids = facet_segment_pairs.empty() ? 0 : facet_segment_pairs.back().first + 1;
+      facet_segment_offsets_.assign(num_facet_ids + 1, 0);
+      facet_segments_.reserve(facet_segment_pairs.size());
+      for (std::size_t i=0; i<facet_segment_pairs.size(); ++i)
+      {
+        ++facet_segment_offsets_[facet_segment_pairs[i].first + 1];
+        facet_segments_.push_back(facet_segment_pairs[i].second);
+      }
+      for (std::size_t i=0; i<num_facet_ids; ++i)
+        facet_segment_offsets_[i+1] += facet_segment_offsets_[i];
+
+      //
+      // Step 3: Facets labelled with more than one segment form interfaces. Dense segment-pair table for constant-time lookup.
+      //
+      pair_index_.assign(num_segment_ids_ * num_segment_ids_, invalid_index());
+      adjacent_segments_.resize(num_segment_ids_);
+      for (std::size_t facet_id=0; facet_id<num_facet_ids; ++facet_id)
+      {
+        for (std::size_t i=facet_segment_offsets_[facet_id]; i<facet_segment_offsets_[facet_id+1]; ++i)
+        {
+          for (std::size_t j=i+1; j<facet_segment_offsets_[facet_id+1]; ++j)
+          {
+            std::size_t seg0 = static_cast<std::size_t>(facet_segments_[i]);
+            std::size_t seg1 = static_cast<std::size_t>(facet_segments_[j]);
+
+            std::size_t & index = pair_index_[seg0 * num_segment_ids_ + seg1];
+            if (index == invalid_index())
+            {
+              index = interface_facets_.size();
+              pair_index_[seg1 * num_segment_ids_ + seg0] = index;
+              interface_facets_.push_back( facet_id_container_type() );
+
+              adjacent_segments_[seg0].push_back(facet_segments_[j]);
+              adjacent_segments_[seg1].push_back(facet_segments_[i]);
+            }
+            interface_facets_[index].push_back(facet_id);
+          }
+        }
+      }
+
+      for (std::size_t i=0; i<adjacent_segments_.size(); ++i)
+        std::sort(adjacent_segments_[i].begin(), adjacent_segments_[i].end());
+    }
+
+    /** @brief Returns the IDs of all segments sharing at least one facet with the segment 'seg' (sorted ascending) */
+    segment_id_container_type const & adjacent_segments(segment_id_type seg) const
+    {
+      if (static_cast<std::size_t>(seg) >= num_segment_ids_)
+        return empty_segments_;
+      return adjacent_segments_[static_cast<std::size_t>(seg)];
+    }
+
+    /** @brief Returns the IDs of all facets at the interface of the segments 'seg0' and 'seg1' */
+    facet_id_container_type const & interface_facets(segment_id_type seg0, segment_id_type seg1) const
+    {
+      std::size_t index = lookup(seg0, seg1);
+      if (index == invalid_index())
+        return empty_facets_;
+      return interface_facets_[index];
+    }
+
+    /** @brief Returns true if the segments 'seg0' and 'seg1' share at least one facet */
+    bool is_interface(segment_id_type seg0, segment_id_type seg1) const
+    {
+      return lookup(seg0, seg1) != invalid_index();
+    }
+
+    /** @brief Returns true if the facet is located at the interface of the segments 'seg0' and 'seg1' */
+    template <typename FacetT>
+    bool is_interface(segment_id_type seg0, segment_id_type seg1, FacetT const & facet) const
+    {
+      std::size_t facet_id = static_cast<std::size_t>(facet.id().get());
+      if (facet_id + 1 >= facet_segment_offsets_.size())
+        return false;
+
+      bool found0 = false;
+      bool found1 = false;
+      for (std::size_t i=facet_segment_offsets_[facet_id]; i<facet_segment_offsets_[facet_id+1]; ++i)
+      {
+        found0 = found0 || (facet_segments_[i] == seg0);
+        found1 = found1 || (facet_segments_[i] == seg1);
+      }
+      return found0 && found1 && (seg0 != seg1);
+    }
+
+  private:
+    static std::size_t invalid_index() { return static_cast<std::size_t>(-1); }
+
+    std::size_t lookup(segment_id_type seg0, segment_id_type seg1) const
+    {
+      if (static_cast<std::size_t>(seg0) >= num_segment_ids_ || static_cast<std::size_t>(seg1) >= num_segment_ids_)
+        return invalid_index();
+      return pair_index_[static_cast<std::size_t>(seg0) * num_segment_ids_ + static_cast<std::size_t>(seg1)];
+    }
+
+    std::size_t                               num_segment_ids_;
+
+    std::vector<std::size_t>                  facet_segment_offsets_;
+    segment_id_container_type                 facet_segments_;
+
+    std::vector<std::size_t>                  pair_index_;
+    std::vector<facet_id_container_type>      interface_facets_;
+    std::vector<segment_id_container_type>    adjacent_segments_;
+
+    segment_id_container_type                 empty_segments_;
+    facet_id_container_type                   empty_facets_;
+  };
+
+}
+
+#endif
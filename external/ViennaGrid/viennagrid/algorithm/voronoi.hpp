@@ -17,6 +17,8 @@
 #include <sstream>
 #include <string>
 #include <stdexcept>
+#include <vector>
+#include <algorithm>
 
 #include "viennagrid/forwards.hpp"
 #include "viennagrid/mesh/coboundary_iteration.hpp"
@@ -580,6 +582,9 @@ namespace viennagrid
      *          total_interface_volume = sum_over_cells(interface_volume_per_cell).
      *        As a consequence, the same holds true for volume contributions.
      *
+     *  The geometric work (circumcenters, interface polygons and their areas) is carried out in parallel if VIENNAGRID_WITH_OPENMP is defined.
+     *  All results are collected in flat arrays first and then written to the accessors sequentially in the order of the edge range,
+     *  hence the output does not depend on the number of threads.
      */
     template <typename CellTag,
               typename MeshT,
@@ -604,9 +609,7 @@ namespace viennagrid
       typedef typename viennagrid::result_of::point<MeshT>::type                           PointType;
       typedef typename viennagrid::result_of::element<MeshT, vertex_tag>::type             VertexType;
       typedef typename viennagrid::result_of::element<MeshT, line_tag>::type               EdgeType;
-      typedef typename viennagrid::result_of::const_handle<MeshT, line_tag>::type          ConstEdgeHandleType;
       typedef typename viennagrid::result_of::element<MeshT, triangle_tag>::type           FacetType;
-      typedef typename viennagrid::result_of::const_handle<MeshT, triangle_tag>::type      ConstFacetHandleType;
 
       typedef typename viennagrid::result_of::const_element_range<MeshT, CellTag>::type    CellRange;
       typedef typename viennagrid::result_of::iterator<CellRange>::type                       CellIterator;
@@ -626,161 +629,248 @@ namespace viennagrid
       typedef typename viennagrid::result_of::const_element_range<EdgeType, vertex_tag>::type                   VertexOnEdgeRange;
       typedef typename viennagrid::result_of::iterator<VertexOnEdgeRange>::type                                 VertexOnEdgeIterator;
 
-      typedef std::pair<PointType, ConstCellHandleType>             PointWithCellInfo;
-      typedef std::pair<std::pair<PointType, PointType>,
-                        ConstCellHandleType>                        EdgePointsWithCellInfo;
-      typedef std::vector< PointWithCellInfo >                      CircumcenterContainer;
+      typedef std::pair<PointType, PointType>                       EdgePoints;
 
+      static const std::size_t edges_per_facet = boundary_elements<triangle_tag, line_tag>::num;
+      std::size_t const invalid = static_cast<std::size_t>(-1);
 
       //
-      // Step one: Write circumcenters to facets
+      // Step zero: Flat, index-based views on cells, facets and edges
       //
+      CellRange cells = viennagrid::elements<CellType>(mesh_obj);
+      std::vector<CellType const *>     cell_ptrs;     cell_ptrs.reserve(cells.size());
+      std::vector<ConstCellHandleType>  cell_handles;  cell_handles.reserve(cells.size());
+      for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+      {
+        cell_ptrs.push_back( &(*cit) );
+        cell_handles.push_back( cit.handle() );
+      }
 
-      viennagrid::detail::dereference_handle_comparator<MeshT> comp(mesh_obj);
+      FacetRange facets = viennagrid::elements<FacetType>(mesh_obj);
+      std::vector<FacetType const *> facet_ptrs;  facet_ptrs.reserve(facets.size());
+      for (FacetIterator fit = facets.begin(); fit != facets.end(); ++fit)
+        facet_ptrs.push_back( &(*fit) );
 
-      std::map< ConstFacetHandleType, CircumcenterContainer, viennagrid::detail::dereference_handle_comparator<MeshT> >
-                                                               circumcenters_on_facets( comp );
-      //std::map< EdgeType const *,
-      std::map< ConstEdgeHandleType,
-                std::vector< EdgePointsWithCellInfo >,
-                viennagrid::detail::dereference_handle_comparator<MeshT>
-              >                                                interface_boundaries_on_edges(comp);
+      EdgeRange edges = viennagrid::elements<EdgeType>(mesh_obj);
+      std::vector<EdgeType const *> edge_ptrs;    edge_ptrs.reserve(edges.size());
+      std::vector<std::size_t>      edge_index_of_id( static_cast<std::size_t>(viennagrid::id_upper_bound<EdgeType>(mesh_obj).get()), invalid );
+      for (EdgeIterator eit = edges.begin(); eit != edges.end(); ++eit)
+      {
+        edge_index_of_id[ static_cast<std::size_t>((*eit).id().get()) ] = edge_ptrs.size();
+        edge_ptrs.push_back( &(*eit) );
+      }
 
+      long num_cells  = static_cast<long>(cell_ptrs.size());
+      long num_facets = static_cast<long>(facet_ptrs.size());
+      long num_edges  = static_cast<long>(edge_ptrs.size());
 
-      CellRange cells = viennagrid::elements<CellType>(mesh_obj);
-      for (CellIterator cit  = cells.begin();
-                        cit != cells.end();
-                      ++cit)
-      {
-        const CellType & cell = *cit;
-        PointType circ_center = circumcenter(cell);
+      //
+      // Step one: Compute circumcenters of cells (parallel) and attach them to facets in cell order (sequential)
+      //
+      std::vector<PointType> cell_circumcenters(cell_ptrs.size());
+#ifdef VIENNAGRID_WITH_OPENMP
+      #pragma omp parallel for
+#endif
+      for (long i = 0; i < num_cells; ++i)
+        cell_circumcenters[i] = circumcenter(*cell_ptrs[i]);
 
-        FacetOnCellRange facets_on_cell = viennagrid::elements<FacetType>(cell);
+      std::size_t facet_id_bound = static_cast<std::size_t>(viennagrid::id_upper_bound<FacetType>(mesh_obj).get());
+      std::vector<std::size_t> cells_on_facet(2 * facet_id_bound, invalid);
+      std::vector<std::size_t> num_cells_on_facet(facet_id_bound, 0);
+      for (std::size_t i = 0; i < cell_ptrs.size(); ++i)
+      {
+        FacetOnCellRange facets_on_cell = viennagrid::elements<FacetType>(*cell_ptrs[i]);
         for (FacetOnCellIterator focit  = facets_on_cell.begin();
                                  focit != facets_on_cell.end();
-                                 ++focit)
+                               ++focit)
         {
-          circumcenters_on_facets[focit.handle()].push_back( PointWithCellInfo(circ_center, cit.handle()) );
-        } //for edges on cells
+          std::size_t facet_id = static_cast<std::size_t>(focit->id().get());
+          if (num_cells_on_facet[facet_id] < 2)
+            cells_on_facet[2*facet_id + num_cells_on_facet[facet_id]] = i;
+          ++num_cells_on_facet[facet_id];
+        } //for facets on cells
       } //for cells
 
 
       //
-      // Step two: Write lines connecting circumcenters to edges
+      // Step two: Lines connecting circumcenters, two per edge of each facet (parallel over facets)
       //
-      FacetRange facets = viennagrid::elements<FacetType>(mesh_obj);
-      for (FacetIterator fit  = facets.begin();
-                         fit != facets.end();
-                       ++fit)
+      std::vector<EdgePoints>  facet_edge_points(facet_ptrs.size() * edges_per_facet * 2);
+      std::vector<std::size_t> facet_edge_cells(facet_ptrs.size() * edges_per_facet * 2);
+      std::vector<std::size_t> facet_edges(facet_ptrs.size() * edges_per_facet);
+      long first_invalid_facet = num_facets;
+
+#ifdef VIENNAGRID_WITH_OPENMP
+      #pragma omp parallel for
+#endif
+      for (long f = 0; f < num_facets; ++f)
       {
-        CircumcenterContainer & circ_centers = circumcenters_on_facets[fit.handle()];
-        const FacetType & facet = *fit;
+        const FacetType & facet = *facet_ptrs[f];
+        std::size_t facet_id = static_cast<std::size_t>(facet.id().get());
+        std::size_t num_circ_centers = num_cells_on_facet[facet_id];
 
+        if (num_circ_centers != 1 && num_circ_centers != 2)
+        {
+#ifdef VIENNAGRID_WITH_OPENMP
+          #pragma omp critical
+#endif
+          first_invalid_facet = std::min(first_invalid_facet, f);
+          continue;
+        }
+
+        std::size_t cell0 = cells_on_facet[2*facet_id];
+        std::size_t cell1 = cells_on_facet[2*facet_id + 1];
+
+        std::size_t k = 0;
         EdgeOnFacetRange edges_on_facet = viennagrid::elements<EdgeType>( facet );
         for (EdgeOnFacetIterator eofit  = edges_on_facet.begin();
                                  eofit != edges_on_facet.end();
-                              ++eofit)
+                               ++eofit, ++k)
         {
           const EdgeType & edge = *eofit;
+          std::size_t slot = f * edges_per_facet + k;
+
+          facet_edges[slot] = edge_index_of_id[ static_cast<std::size_t>(edge.id().get()) ];
 
-          if (circ_centers.size() == 1)
+          if (num_circ_centers == 1)
           {
-            interface_boundaries_on_edges[eofit.handle()].push_back(std::make_pair( std::make_pair(circ_centers[0].first, circumcenter(facet)),
-                                                                               circ_centers[0].second)
-                                                              );
-            interface_boundaries_on_edges[eofit.handle()].push_back(std::make_pair( std::make_pair(circumcenter(edge), circumcenter(facet)),
-                                                                               circ_centers[0].second)
-                                                              );
+            facet_edge_points[2*slot]     = EdgePoints(cell_circumcenters[cell0], circumcenter(facet));
+            facet_edge_cells[2*slot]      = cell0;
+            facet_edge_points[2*slot + 1] = EdgePoints(circumcenter(edge), circumcenter(facet));
+            facet_edge_cells[2*slot + 1]  = cell0;
           }
-          else if (circ_centers.size() == 2)
+          else
           {
-            PointType edge_mid = circ_centers[0].first + circ_centers[1].first;
+            PointType edge_mid = cell_circumcenters[cell0] + cell_circumcenters[cell1];
             edge_mid /= 2.0;
 
-            interface_boundaries_on_edges[eofit.handle()].push_back(std::make_pair( std::make_pair(circ_centers[0].first, edge_mid),
-                                                                               circ_centers[0].second)
-                                                              );
-            interface_boundaries_on_edges[eofit.handle()].push_back(std::make_pair( std::make_pair(edge_mid, circ_centers[1].first),
-                                                                               circ_centers[1].second)
-                                                              );
-          }
-          else
-          {
-            std::cerr << "circ_centers.size() = " << circ_centers.size() << std::endl;
-            std::cerr << "*fit: " << facet << std::endl;
-            throw "More than two circumcenters for a facet in three dimensions!";
+            facet_edge_points[2*slot]     = EdgePoints(cell_circumcenters[cell0], edge_mid);
+            facet_edge_cells[2*slot]      = cell0;
+            facet_edge_points[2*slot + 1] = EdgePoints(edge_mid, cell_circumcenters[cell1]);
+            facet_edge_cells[2*slot + 1]  = cell1;
           }
+        } //for edges on facet
+      }
 
-        } //for edges on cells
+      if (first_invalid_facet < num_facets)
+      {
+        std::cerr << "circ_centers.size() = " << num_cells_on_facet[ static_cast<std::size_t>(facet_ptrs[first_invalid_facet]->id().get()) ] << std::endl;
+        std::cerr << "*fit: " << *facet_ptrs[first_invalid_facet] << std::endl;
+        throw "More than two circumcenters for a facet in three dimensions!";
+      }
+
+      //
+      // Deterministic reduction: interface segments of each edge in CSR format, ordered by facet
+      //
+      std::vector<std::size_t> edge_segment_offsets(edge_ptrs.size() + 1, 0);
+      for (std::size_t slot = 0; slot < facet_edges.size(); ++slot)
+        edge_segment_offsets[facet_edges[slot] + 1] += 2;
+      for (std::size_t e = 0; e < edge_ptrs.size(); ++e)
+        edge_segment_offsets[e+1] += edge_segment_offsets[e];
+
+      std::vector<std::size_t> edge_segments(edge_segment_offsets.back());
+      {
+        std::vector<std::size_t> fill_position(edge_segment_offsets.begin(), edge_segment_offsets.end() - 1);
+        for (std::size_t slot = 0; slot < facet_edges.size(); ++slot)
+        {
+          std::size_t & pos = fill_position[facet_edges[slot]];
+          edge_segments[pos++] = 2*slot;
+          edge_segments[pos++] = 2*slot + 1;
+        }
       }
 
 
       //
-      // Step three: Compute Voronoi information:
+      // Step three: Compute Voronoi information (parallel over edges):
       //
-      EdgeRange edges = viennagrid::elements<EdgeType>(mesh_obj);
-      for (EdgeIterator eit  = edges.begin();
-                        eit != edges.end();
-                        ++eit)
+      std::vector<double> edge_lengths(edge_ptrs.size());
+      std::vector<double> interface_areas(edge_ptrs.size());
+      std::vector<double> segment_contributions(edge_segments.size());
+
+#ifdef VIENNAGRID_WITH_OPENMP
+      #pragma omp parallel for
+#endif
+      for (long e = 0; e < num_edges; ++e)
       {
-        const EdgeType & edge = *eit;
+        const EdgeType & edge = *edge_ptrs[e];
 
         //get vertices of edge:
         VertexOnEdgeRange vertices_on_edge = viennagrid::elements<VertexType>(edge);
         VertexOnEdgeIterator voeit = vertices_on_edge.begin();
 
-
-
         VertexType const & v0 = *voeit;
         ++voeit;
         VertexType const & v1 = *voeit;
 
-        double edge_length = spanned_volume( viennagrid::point(mesh_obj, v0), viennagrid::point(mesh_obj, v1));
+        edge_lengths[e] = spanned_volume( viennagrid::point(mesh_obj, v0), viennagrid::point(mesh_obj, v1));
 
-        std::vector< EdgePointsWithCellInfo > & interface_segments = interface_boundaries_on_edges[eit.handle()];
+        std::size_t seg_begin = edge_segment_offsets[e];
+        std::size_t seg_end   = edge_segment_offsets[e+1];
 
         //
         // determine inner point of convex interface polygon:
         //
-        PointType inner_point = (interface_segments[0].first.first + interface_segments[0].first.second) / 2.0;
-        for (std::size_t i=1; i<interface_segments.size(); ++i)
+        PointType inner_point = (facet_edge_points[edge_segments[seg_begin]].first + facet_edge_points[edge_segments[seg_begin]].second) / 2.0;
+        for (std::size_t i=seg_begin+1; i<seg_end; ++i)
         {
-          inner_point += (interface_segments[i].first.first + interface_segments[i].first.second) / 2.0;
+          inner_point += (facet_edge_points[edge_segments[i]].first + facet_edge_points[edge_segments[i]].second) / 2.0;
         }
-        inner_point /= interface_segments.size();
+        inner_point /= (seg_end - seg_begin);
 
         //
         // compute interface area
         //
         double interface_area = 0.0;
-        for (std::size_t i=0; i<interface_segments.size(); ++i)
+        for (std::size_t i=seg_begin; i<seg_end; ++i)
         {
-          // interface area:
-          double interface_contribution = spanned_volume(interface_segments[i].first.first, interface_segments[i].first.second, inner_point);
+          double interface_contribution = spanned_volume(facet_edge_points[edge_segments[i]].first, facet_edge_points[edge_segments[i]].second, inner_point);
+          segment_contributions[i] = interface_contribution;
+          if (interface_contribution > 0)
+            interface_area += interface_contribution;
+        }
+        interface_areas[e] = interface_area;
+      } //for edges
+
+
+      //
+      // Write Voronoi info (sequential, in the order of the edge range):
+      //
+      for (std::size_t e = 0; e < edge_ptrs.size(); ++e)
+      {
+        const EdgeType & edge = *edge_ptrs[e];
+
+        VertexOnEdgeRange vertices_on_edge = viennagrid::elements<VertexType>(edge);
+        VertexOnEdgeIterator voeit = vertices_on_edge.begin();
+
+        VertexType const & v0 = *voeit;
+        ++voeit;
+        VertexType const & v1 = *voeit;
+
+        double edge_length = edge_lengths[e];
+
+        for (std::size_t i=edge_segment_offsets[e]; i<edge_segment_offsets[e+1]; ++i)
+        {
+          double interface_contribution = segment_contributions[i];
           if (interface_contribution > 0)
           {
+            ConstCellHandleType const & cell_handle = cell_handles[ facet_edge_cells[edge_segments[i]] ];
+
             voronoi_unique_quantity_update(interface_area_cell_contribution_accessor( edge ),
-                                           std::make_pair(interface_segments[i].second, interface_contribution) );
-            interface_area += interface_contribution;
+                                           std::make_pair(cell_handle, interface_contribution) );
 
             // box volume:
             double volume_contribution = interface_contribution * edge_length / 6.0;
             voronoi_unique_quantity_update(edge_box_volume_cell_contribution_accessor( edge ),
-                                           std::make_pair(interface_segments[i].second, 2.0 * volume_contribution) ); //volume contribution of both box volumes associated with the edge
+                                           std::make_pair(cell_handle, 2.0 * volume_contribution) ); //volume contribution of both box volumes associated with the edge
             voronoi_unique_quantity_update(vertex_box_volume_cell_contribution_accessor(v0),
-                                           std::make_pair( interface_segments[i].second, volume_contribution) );
+                                           std::make_pair(cell_handle, volume_contribution) );
             voronoi_unique_quantity_update(vertex_box_volume_cell_contribution_accessor(v1),
-                                           std::make_pair( interface_segments[i].second, volume_contribution) );
+                                           std::make_pair(cell_handle, volume_contribution) );
           }
         }
 
-        //
-        // Write Voronoi info:
-        //
-
-        //std::cout << "Interface area: " << interface_area << std::endl;
-        interface_area_accessor( edge ) = interface_area;
-        double volume_contribution = interface_area * edge_length / 6.0;
+        interface_area_accessor( edge ) = interface_areas[e];
+        double volume_contribution = interface_areas[e] * edge_length / 6.0;
         edge_box_volume_accessor(edge) = 2.0 * volume_contribution; //volume contribution of both box volumes associated with the edge
         vertex_box_volume_accessor(v0) += volume_contribution;
         vertex_box_volume_accessor(v1) += volume_contribution;
@@ -14,6 +14,11 @@
    license:    see file LICENSE in the base directory
 ============================================================================= */
 
+#include <vector>
+#include <limits>
+
+#include "boost/unordered_map.hpp"
+
 #include "viennautils/xml.hpp"
 #include "viennautils/file.hpp"
 
@@ -42,44 +47,32 @@ struct PugiXML
   typedef bool                                                        Boolean;
   typedef std::string                                                 String;
 
-  PugiXML()
+  /** @brief A parameter of a material, as compiled from the loaded database */
+  struct ParameterRecord
   {
-    // setup variables used as placeholdes in the precompiled queries
-    vars.add(vmat::key::id.c_str(),         pugi::xpath_type_string);
-    vars.add(vmat::key::category.c_str(),   pugi::xpath_type_string);
-    vars.add(vmat::key::parameter.c_str(),  pugi::xpath_type_string);
-
-    // precompile the various query strings - use placeholders for run-time parameters
-    std::string material_query_string = "/materials/material[id = string($"+vmat::key::id+")]";
-    query_material = new pugi::xpath_query(material_query_string.c_str(), &vars);
-    
-    std::string category_query_string = "/materials/material[category = string($"+vmat::key::category+")]";
-    query_category = new pugi::xpath_query(category_query_string.c_str(), &vars);
-
-    std::string parameter_query_string = "/materials/material[id = string($"+vmat::key::id+")]/parameters/parameter[name = string($"+vmat::key::parameter+")]";
-    query_parameter = new pugi::xpath_query(parameter_query_string.c_str(), &vars);    
+    ParameterRecord() : value(0), occurrences(0) {}
 
-    std::string parameter_value_query_string = "/materials/material[id = string($"+vmat::key::id+")]/parameters/parameter[name = string($"+vmat::key::parameter+")]/value";
-    query_parameter_value = new pugi::xpath_query(parameter_value_query_string.c_str(), &vars);    
+    Numeric       value;
+    String        unit;
+    String        note;
+    Entry         entry;
+    std::size_t   occurrences;  // more than one means the parameter is not unique
+  };
 
-    std::string parameter_unit_query_string = "/materials/material[id = string($"+vmat::key::id+")]/parameters/parameter[name = string($"+vmat::key::parameter+")]/unit";
-    query_parameter_unit = new pugi::xpath_query(parameter_unit_query_string.c_str(), &vars);    
-    
-    std::string parameter_note_query_string = "/materials/material[id = string($"+vmat::key::id+")]/parameters/parameter[name = string($"+vmat::key::parameter+")]/note";
-    query_parameter_note = new pugi::xpath_query(parameter_note_query_string.c_str(), &vars);      
-  }
-  
-  ~PugiXML()
+  typedef boost::unordered_map<std::string, ParameterRecord>   ParameterTable;
+
+  /** @brief A material and its parameters, as compiled from the loaded database */
+  struct MaterialRecord
   {
-    // the xpath queries are due to pugixml's impelmentation required to be allocated
-    // on the heap ..
-    delete query_material;
-    delete query_category;
-    delete query_parameter;
-    delete query_parameter_value;
-    delete query_parameter_unit;
-    delete query_parameter_note;  
-  }
+    MaterialRecord() : occurrences(0) {}
+
+    Entry           entry;
+    std::size_t     occurrences;  // more than one means the material is not unique
+    ParameterTable  parameters;
+  };
+
+  typedef boost::unordered_map<std::string, MaterialRecord>               MaterialTable;
+  typedef boost::unordered_map<std::string, std::vector<pugi::xpath_node> > CategoryTable;
 
   bool load(std::string const& filename)
   {
@@ -99,6 +92,7 @@ struct PugiXML
     if(viennautils::file_extension(filename) == "xml")  // native
     {
       mdb.read(filename);
+      this->freeze();
       return true;
     }
 #ifdef HAVE_VIENNAIPD    
@@ -118,6 +112,7 @@ struct PugiXML
   bool load(std::stringstream & stream)
   {
     mdb.read(stream);
+    this->freeze();
     return true;
   }
   
@@ -131,6 +126,9 @@ struct PugiXML
     mdb.dump(stream);
   }
 
+  // ad-hoc XPath queries on the database. the accessors below don't use XPath,
+  // they look up the tables compiled by load()
+  //
   Entries query(std::string const& expr)
   {
     return mdb.query_raw(expr);
@@ -141,169 +139,172 @@ struct PugiXML
     return mdb.query_raw(expr);
   }
 
-  Entries getSemiconductors()
+  Entries getSemiconductors() const
   {
-    vars.set(vmat::key::category.c_str(), vmat::key::semiconductor.c_str());
-    return query_category->evaluate_node_set(mdb.xml);
+    return this->getMaterialsOfCategory(vmat::key::semiconductor);
   }
-  
-//  Entries getSemiconductors() const
-//  {
-//    vars.set(vmat::key::category.c_str(), vmat::key::semiconductor.c_str());
-//    return query_category->evaluate_node_set(mdb.xml);
-//  }
 
-  bool hasSemiconductors()
+  bool hasSemiconductors() const
   {
-    return !(this->getSemiconductors().empty());
+    return this->hasMaterialsOfCategory(vmat::key::semiconductor);
   }  
 
-//  bool hasSemiconductors() const
-//  {
-//    return !(this->getSemiconductors().empty());
-//  } 
-
-  Entries getMetals()
+  Entries getMetals() const
   {
-    vars.set(vmat::key::category.c_str(), vmat::key::metal.c_str());
-    return query_category->evaluate_node_set(mdb.xml);
+    return this->getMaterialsOfCategory(vmat::key::metal);
   }
 
-//  Entries getMetals() const
-//  {
-//    vars.set(vmat::key::category.c_str(), vmat::key::metal.c_str());
-//    return query_category->evaluate_node_set(mdb.xml);
-//  }
-
-  bool hasMetals()
+  bool hasMetals() const
   {
-    return !(this->getMetals().empty());
+    return this->hasMaterialsOfCategory(vmat::key::metal);
   }  
 
-  Entries getOxides()
+  Entries getOxides() const
   {
-    vars.set(vmat::key::category.c_str(), vmat::key::oxide.c_str());
-    return query_category->evaluate_node_set(mdb.xml);
+    return this->getMaterialsOfCategory(vmat::key::oxide);
   }
   
-  bool hasOxides()
+  bool hasOxides() const
   {
-    return !(this->getOxides().empty());
+    return this->hasMaterialsOfCategory(vmat::key::oxide);
   }  
 
-  Entries getMaterialsOfCategory(std::string const& category_id)
+  Entries getMaterialsOfCategory(std::string const& category_id) const
   {
-    vars.set(vmat::key::category.c_str(), category_id.c_str());
-    return query_category->evaluate_node_set(mdb.xml);
+    CategoryTable::const_iterator iter = categories.find(category_id);
+    if(iter == categories.end() || iter->second.empty()) return Entries();
+    std::vector<pugi::xpath_node> const& nodes = iter->second;
+    return Entries(&nodes[0], &nodes[0] + nodes.size(), Entries::type_sorted);
   }
   
-  bool hasMaterialsOfCategory(std::string const& category_id)
+  bool hasMaterialsOfCategory(std::string const& category_id) const
   {
-    return !(this->getMaterialsOfCategory(category_id).empty());
+    CategoryTable::const_iterator iter = categories.find(category_id);
+    return (iter != categories.end()) && !iter->second.empty();
   }  
 
   // -- Material Accessors -----------------------------------------------------
 private:  
-  Entries queryMaterial(std::string const& material_id)
+  MaterialRecord const* findMaterial(std::string const& material_id) const
   {
-    vars.set(vmat::key::id.c_str(), material_id.c_str());
-    return query_material->evaluate_node_set(mdb.xml);
+    MaterialTable::const_iterator iter = materials.find(material_id);
+    if(iter == materials.end()) return NULL;
+    if(iter->second.occurrences > 1) // there must be only one material with this id
+      throw vmat::NonUniqueMaterialException(material_id);
+    return &(iter->second);
   }
 public:
-  Entry getMaterial(std::string const& material_id)
+  Entry getMaterial(std::string const& material_id) const
   {
-    pugi::xpath_node_set const& result = this->queryMaterial(material_id);
-    if(result.size() > 1) // there must be only one material with this id
-    {
-      throw vmat::NonUniqueMaterialException(material_id);
-      return Entry();
-    }
-    else if (result.size() == 0) return Entry();
-    else return result.first(); // if success, return only a single xpath_node
+    MaterialRecord const* material = this->findMaterial(material_id);
+    return material ? material->entry : Entry();
   }
   
-  bool hasMaterial(std::string const& material_id)
+  bool hasMaterial(std::string const& material_id) const
   {
-    pugi::xpath_node_set const& result = this->queryMaterial(material_id);
-    if(result.size() > 1) // there must be only one material with this id
-    {
-      throw vmat::NonUniqueMaterialException(material_id);
-      return false;
-    }
-    else if (result.size() == 0) return false;
-    else return true;
+    return this->findMaterial(material_id) != NULL;
   }  
   // ---------------------------------------------------------------------------
 
   // -- Parameter Accessors ----------------------------------------------------
 private:
-  Entries queryParameter(std::string const& material_id, std::string const& parameter_id)
+  ParameterRecord const* findParameter(std::string const& material_id, std::string const& parameter_id) const
   {
-    vars.set(vmat::key::id.c_str(),        material_id.c_str());  
-    vars.set(vmat::key::parameter.c_str(), parameter_id.c_str());
-    return query_parameter->evaluate_node_set(mdb.xml);
+    MaterialTable::const_iterator material = materials.find(material_id);
+    if(material == materials.end()) return NULL;
+
+    ParameterTable::const_iterator iter = material->second.parameters.find(parameter_id);
+    if(iter == material->second.parameters.end()) return NULL;
+    return &(iter->second);
   }
 public:
-  Entry getParameter(std::string const& material_id, std::string const& parameter_id)
+  Entry getParameter(std::string const& material_id, std::string const& parameter_id) const
   {
-    pugi::xpath_node_set const& result = this->queryParameter(material_id, parameter_id);
-    if(result.size() > 1) // there must be only one parameter with this id
-    {
+    ParameterRecord const* parameter = this->findParameter(material_id, parameter_id);
+    if(parameter && parameter->occurrences > 1) // there must be only one parameter with this id
       throw vmat::NonUniqueParameterException(parameter_id);
-      return Entry();
-    }
-    else if (result.size() == 0) return Entry();
-    else return result.first(); // if success, return only a single xpath_node
+    return parameter ? parameter->entry : Entry();
   }
 
-  bool hasParameter(std::string const& material_id, std::string const& parameter_id)
+  bool hasParameter(std::string const& material_id, std::string const& parameter_id) const
   {
-    pugi::xpath_node_set const& result = this->queryParameter(material_id, parameter_id);
-    if(result.size() > 1) // there must be only one material with this id
-    {
+    ParameterRecord const* parameter = this->findParameter(material_id, parameter_id);
+    if(parameter && parameter->occurrences > 1) // there must be only one parameter with this id
       throw vmat::NonUniqueParameterException(parameter_id);
-      return false;
-    }
-    else if (result.size() == 0) return false;
-    else return true;
+    return parameter != NULL;
   }  
 
-  Numeric getParameterValue(std::string const& material_id, std::string const& parameter_id)
+  /** @brief Returns NaN if the parameter does not exist */
+  Numeric getParameterValue(std::string const& material_id, std::string const& parameter_id) const
   {
-    vars.set(vmat::key::id.c_str(),        material_id.c_str());  
-    vars.set(vmat::key::parameter.c_str(), parameter_id.c_str());
-    return query_parameter_value->evaluate_number(mdb.xml);
+    ParameterRecord const* parameter = this->findParameter(material_id, parameter_id);
+    return parameter ? parameter->value : std::numeric_limits<Numeric>::quiet_NaN();
   }
 
-  String getParameterUnit(std::string const& material_id, std::string const& parameter_id)
+  String getParameterUnit(std::string const& material_id, std::string const& parameter_id) const
   {
-    vars.set(vmat::key::id.c_str(),        material_id.c_str());  
-    vars.set(vmat::key::parameter.c_str(), parameter_id.c_str());
-    return query_parameter_unit->evaluate_string(mdb.xml);
+    ParameterRecord const* parameter = this->findParameter(material_id, parameter_id);
+    return parameter ? parameter->unit : String();
   }
 
-  String getParameterNote(std::string const& material_id, std::string const& parameter_id)
+  String getParameterNote(std::string const& material_id, std::string const& parameter_id) const
   {
-    vars.set(vmat::key::id.c_str(),        material_id.c_str());  
-    vars.set(vmat::key::parameter.c_str(), parameter_id.c_str());
-    return query_parameter_note->evaluate_string(mdb.xml);
+    ParameterRecord const* parameter = this->findParameter(material_id, parameter_id);
+    return parameter ? parameter->note : String();
   }
 
   // ---------------------------------------------------------------------------
   
 private:
 
+  // compiles the loaded database into the lookup tables, which are never modified
+  // afterwards. hence, apart from load(), all accessors may be used concurrently
+  //
+  void freeze()
+  {
+    materials.clear();
+    categories.clear();
+
+    pugi::xpath_query string_query("string(.)");
+    pugi::xpath_query id_query("id");
+    pugi::xpath_query name_query("name");
+    pugi::xpath_query value_query("value");
+    pugi::xpath_query unit_query("unit");
+    pugi::xpath_query note_query("note");
+
+    Entries material_entries = mdb.query_raw("/materials/material");
+    for(std::size_t mi = 0; mi < material_entries.size(); mi++)
+    {
+      Entry const& material_entry = material_entries[mi];
+
+      Entries category_entries = material_entry.node().select_nodes("category");
+      for(std::size_t ci = 0; ci < category_entries.size(); ci++)
+        categories[string_query.evaluate_string(category_entries[ci])].push_back(material_entry);
+
+      // for non-unique ids, keep the first material in document order
+      MaterialRecord& material = materials[id_query.evaluate_string(material_entry)];
+      if(material.occurrences++ > 0) continue;
+      material.entry = material_entry;
+
+      Entries parameter_entries = material_entry.node().select_nodes("parameters/parameter");
+      for(std::size_t pi = 0; pi < parameter_entries.size(); pi++)
+      {
+        Entry const& parameter_entry = parameter_entries[pi];
+
+        ParameterRecord& parameter = material.parameters[name_query.evaluate_string(parameter_entry)];
+        if(parameter.occurrences++ > 0) continue;
+        parameter.entry = parameter_entry;
+        parameter.value = value_query.evaluate_number(parameter_entry);
+        parameter.unit  = unit_query.evaluate_string(parameter_entry);
+        parameter.note  = note_query.evaluate_string(parameter_entry);
+      }
+    }
+  }
+
   MaterialDatabase mdb;
-  
-  pugi::xpath_variable_set    vars;
-  
-  pugi::xpath_query *query_material;
-  pugi::xpath_query *query_category;
-  pugi::xpath_query *query_parameter;  
-  pugi::xpath_query *query_parameter_value;
-  pugi::xpath_query *query_parameter_unit;
-  pugi::xpath_query *query_parameter_note;  
 
+  MaterialTable    materials;
+  CategoryTable    categories;
 };
 
 
@@ -28,6 +28,18 @@ config::config()
   damping_                             = 1.0;
   initial_guess_smoothing_iterations_  = 0;
   model_drift_diffusion_state_         = true;
+  model_recombination_srh_state_       = false;
+  model_recombination_auger_state_     = false;
+  transient_state_                     = false;
+  time_integration_                    = time_bdf2;
+  end_time_                            = 1.E-9;
+  initial_time_step_                   = 1.E-12;
+  time_step_tolerance_                 = 1.E-2;
+  mobility_model_                      = mobility_constant;
+  mobility_field_tolerance_            = 0.05;
+  refinement_steps_                    = 0;
+  refinement_fraction_                 = 0.2;
+  refinement_tolerance_                = 1.E-3;
 }
 
 
@@ -66,6 +78,31 @@ config::IndexType&    config::initial_guess_smoothing_iterations()
   return initial_guess_smoothing_iterations_;
 }
 
+mobility_model_type& config::mobility_model()
+{
+  return mobility_model_;
+}
+
+config::NumericType&  config::mobility_field_tolerance()
+{
+  return mobility_field_tolerance_;
+}
+
+config::IndexType&    config::refinement_steps()
+{
+  return refinement_steps_;
+}
+
+config::NumericType&  config::refinement_fraction()
+{
+  return refinement_fraction_;
+}
+
+config::NumericType&  config::refinement_tolerance()
+{
+  return refinement_tolerance_;
+}
+
 void config::assign_contact(std::size_t segment_index, config::NumericType value, config::NumericType workfunction)
 {
   segment_contact_values_       [segment_index] = value;
@@ -87,5 +124,60 @@ bool& config::drift_diffusion_state()
   return model_drift_diffusion_state_;
 }
 
+bool& config::recombination_srh_state()
+{
+  return model_recombination_srh_state_;
+}
+
+bool& config::recombination_auger_state()
+{
+  return model_recombination_auger_state_;
+}
+
+bool& config::transient_state()
+{
+  return transient_state_;
+}
+
+time_integration_type& config::time_integration()
+{
+  return time_integration_;
+}
+
+config::NumericType&  config::end_time()
+{
+  return end_time_;
+}
+
+config::NumericType&  config::initial_time_step()
+{
+  return initial_time_step_;
+}
+
+config::NumericType&  config::time_step_tolerance()
+{
+  return time_step_tolerance_;
+}
+
+void config::assign_contact_switch(std::size_t segment_index, config::NumericType value)
+{
+  segment_switched_contact_values_[segment_index] = value;
+}
+
+bool config::has_contact_switch(std::size_t segment_index) const
+{
+  return segment_switched_contact_values_.find(segment_index) != segment_switched_contact_values_.end();
+}
+
+config::NumericType& config::switched_contact_value(std::size_t segment_index)
+{
+  return segment_switched_contact_values_[segment_index];
+}
+
+void config::clear_contact_switches()
+{
+  segment_switched_contact_values_.clear();
+}
+
 } // viennamini
 
@@ -65,6 +65,13 @@ void device<MeshT,SegmentationT,StorageT>::assign_semiconductor(std::size_t segm
   segment_acceptors_[segment_index] = NA;
 }
 
+template<typename MeshT, typename SegmentationT, typename StorageT>
+void device<MeshT,SegmentationT,StorageT>::assign_doping_profiles(std::size_t segment_index, doping_profile const* ND, doping_profile const* NA)
+{
+  segment_donator_profiles_[segment_index]  = ND;
+  segment_acceptor_profiles_[segment_index] = NA;
+}
+
 template<typename MeshT, typename SegmentationT, typename StorageT>
 typename device<MeshT,SegmentationT,StorageT>::IndexKeysType&     device<MeshT,SegmentationT,StorageT>::segment_names()          { return segment_names_; }
 
@@ -86,6 +93,20 @@ typename device<MeshT,SegmentationT,StorageT>::NumericType&       device<MeshT,S
 template<typename MeshT, typename SegmentationT, typename StorageT>
 typename device<MeshT,SegmentationT,StorageT>::NumericType&       device<MeshT,SegmentationT,StorageT>::acceptor(std::size_t segment_index)  { return segment_acceptors_[segment_index]; }
 
+template<typename MeshT, typename SegmentationT, typename StorageT>
+doping_profile const* device<MeshT,SegmentationT,StorageT>::donator_profile(std::size_t segment_index) const
+{
+  typename IndexProfilesType::const_iterator iter = segment_donator_profiles_.find(segment_index);
+  return (iter == segment_donator_profiles_.end()) ? NULL : iter->second;
+}
+
+template<typename MeshT, typename SegmentationT, typename StorageT>
+doping_profile const* device<MeshT,SegmentationT,StorageT>::acceptor_profile(std::size_t segment_index) const
+{
+  typename IndexProfilesType::const_iterator iter = segment_acceptor_profiles_.find(segment_index);
+  return (iter == segment_acceptor_profiles_.end()) ? NULL : iter->second;
+}
+
 template<typename MeshT, typename SegmentationT, typename StorageT>
 typename device<MeshT,SegmentationT,StorageT>::MeshType&          device<MeshT,SegmentationT,StorageT>::mesh()                  { return mesh_;   }
 
@@ -21,7 +21,8 @@ namespace viennamini
 
 template <typename DeviceT, typename MatlibT>
 simulator<DeviceT, MatlibT>::simulator(DeviceT& device, MatlibT& matlib, viennamini::config& config) :
-          device_(device), matlib_(matlib), config_(config), notfound_(-1)
+          device_(device), matlib_(matlib), config_(config), transient_solver_(pde_solver_),
+          transient_completed_(true), initial_guess_provider_(NULL), doping_(&own_doping_), notfound_(-1)
 {
   eps_.wrap_constant ( device_.storage(), eps_key_  );
   mu_n_.wrap_constant( device_.storage(), mu_n_key_ );
@@ -33,23 +34,45 @@ simulator<DeviceT, MatlibT>::simulator(DeviceT& device, MatlibT& matlib, viennam
 template <typename DeviceT, typename MatlibT>
 void simulator<DeviceT, MatlibT>::operator()()
 {
+  timings_ = simulator_timings();
+  viennafvm::Timer timer;
+  viennafvm::profiler::scope simulator_scope("simulator");
+
   // detect contact-semiconductor and contact-oxide interfaces
   //
-  this->detect_interfaces();
+  timer.start();
+  {
+    viennafvm::profiler::scope profile("interface_detection");
+    this->detect_interfaces();
+  }
+  timings_.interface_detection = timer.get();
 
   // finalize the device setup
   //
-  this->prepare();
+  timer.start();
+  {
+    viennafvm::profiler::scope profile("prepare");
+    this->prepare();
+  }
+  timings_.prepare = timer.get();
 
   // write doping and initial guesses (including boundary conditions) to
   // vtk files for analysis
   //
-  this->write_device_doping();
-  this->write_device_initial_guesses();
+  timer.start();
+  {
+    viennafvm::profiler::scope profile("diagnostics_write");
+    this->write_device_doping();
+    this->write_device_initial_guesses();
+  }
+  timings_.diagnostics = timer.get();
 
   // run the simulation
   //
+  timer.start();
   this->run();
+  timings_.solve  = timer.get();
+  timings_.solver = pde_solver_.timings();
 }
 
 template <typename DeviceT, typename MatlibT>
@@ -98,6 +121,8 @@ void simulator<DeviceT, MatlibT>::write_device_initial_guesses()
 template <typename DeviceT, typename MatlibT>
 void simulator<DeviceT, MatlibT>::write_result(std::string filename)
 {
+  viennafvm::profiler::scope profile("result_write");
+
   // Writing all solution variables back to domain.
   //
   std::vector<long> result_ids(3); //TODO: Better way to make potential, electron_density and hole_density accessible
@@ -115,6 +140,10 @@ void simulator<DeviceT, MatlibT>::detect_interfaces()
   IndicesType& oxide_segments         = device_.oxide_segments();
   IndicesType& semiconductor_segments = device_.semiconductor_segments();
 
+  // label all facets with their adjacent segments in a single pass
+  //
+  InterfaceMapType interfaces(device_.segments());
+
   // traverse only contact segments
   // for each contact segment, determine whether it shares an interface with an oxide or a semiconductor
   //
@@ -122,16 +151,14 @@ void simulator<DeviceT, MatlibT>::detect_interfaces()
     cs_it != contact_segments.end(); cs_it++)
   {
     //std::cout << "  * contact-segment " << *cs_it << " : looking for interfaces .." << std::endl;
-    SegmentType& current_contact_segment = device_.segment(*cs_it);
-
-    int adjacent_semiconduct_segment_id = find_adjacent_segment(current_contact_segment, semiconductor_segments);
+    int adjacent_semiconduct_segment_id = find_adjacent_segment(interfaces, *cs_it, semiconductor_segments);
     if(adjacent_semiconduct_segment_id != notfound_)
     {
       //std::cout << "Found neighbour Semiconductor segment #" << adjacent_semiconduct_segment_id << " for contact segment #" << *cs_it << std::endl;
       contactSemiconductorInterfaces_[*cs_it] = adjacent_semiconduct_segment_id;
     }
     // if it's not a contact-semiconductor interface -> try a contact-insulator interface
-    int adjacent_oxide_segment_id = find_adjacent_segment(current_contact_segment, oxide_segments);
+    int adjacent_oxide_segment_id = find_adjacent_segment(interfaces, *cs_it, oxide_segments);
     if(adjacent_oxide_segment_id != notfound_)
     {
       //std::cout << "Found neighbour Oxide segment #" << adjacent_oxide_segment_id << " for contact segment #" << *cs_it << std::endl;
@@ -141,26 +168,16 @@ void simulator<DeviceT, MatlibT>::detect_interfaces()
 }
 
 template <typename DeviceT, typename MatlibT>
-int simulator<DeviceT, MatlibT>::find_adjacent_segment(SegmentType & current_contact_segment, IndicesType & segments_under_test)
+int simulator<DeviceT, MatlibT>::find_adjacent_segment(InterfaceMapType const & interfaces, std::size_t contact_segment_index, IndicesType & segments_under_test)
 {
-  typedef typename viennagrid::result_of::const_facet_range<SegmentType>::type            ConstFacetSegmentRangeType;
-  typedef typename viennagrid::result_of::iterator<ConstFacetSegmentRangeType>::type      ConstFacetSegmentIteratorType;
-
-  ConstFacetSegmentRangeType const& facets = viennagrid::elements<FacetType>(current_contact_segment);
-
   // segments under test: these are either all oxide or semiconductor segments
   //
   for(typename IndicesType::iterator sit = segments_under_test.begin();
       sit != segments_under_test.end(); sit++)
   {
-    SegmentType& current_segment = device_.segment(*sit);
-
-    for (ConstFacetSegmentIteratorType fit = facets.begin(); fit != facets.end(); ++fit)
+    if (interfaces.is_interface(contact_segment_index, *sit))
     {
-      if (viennagrid::is_interface(current_contact_segment, current_segment, *fit))
-      {
-        return *sit;
-      }
+      return *sit;
     }
   }
   return notfound_;
@@ -175,6 +192,14 @@ void simulator<DeviceT, MatlibT>::prepare()
 
   StorageType & storage = device_.storage();
 
+  // evaluate the doping profiles at the cells of the semiconductors and their contacts,
+  // unless the values of an earlier run on this mesh are still valid
+  //
+  doping_->update(device_, contactSemiconductorInterfaces_);
+
+  typedef typename viennagrid::result_of::const_element_range<SegmentType, CellTagType>::type   SegmentCellRangeType;
+  typedef typename viennagrid::result_of::iterator<SegmentCellRangeType>::type                  SegmentCellIteratorType;
+
   //
   // CONTACTS
   //
@@ -199,12 +224,7 @@ void simulator<DeviceT, MatlibT>::prepare()
       // [NOTE] as there is no adjacent semiconductor segment, we must not set a electron/hole BC at
       // this contact
       //
-      viennafvm::set_dirichlet_boundary(
-          device_.segment(*iter),
-          storage,
-          quantity_potential(),
-          config_.contact_value(*iter) + config_.workfunction(*iter)
-          );
+      this->assign_contact_potential(*iter, config_.contact_value(*iter));
 
       std::size_t adjacent_oxide_segment = contactOxideInterfaces_[*iter];
 
@@ -234,12 +254,8 @@ void simulator<DeviceT, MatlibT>::prepare()
       std::cout << "  * segment " << *iter << " : contact-to-semiconductor interface" << std::endl;
     #endif
 
-      // retrieve the doping values of the adjacent semiconductor segment and
-      // compute the initial guess
+      // the contact cells take the doping of the adjacent semiconductor segment at their positions
       std::size_t adjacent_semiconductor_segment = contactSemiconductorInterfaces_[*iter];
-      NumericType ND_value = device_.donator(adjacent_semiconductor_segment);
-      NumericType NA_value = device_.acceptor(adjacent_semiconductor_segment);
-      NumericType builtin_pot = viennamini::built_in_potential(config_.temperature(), ND_value, NA_value);
 
       // a contact segment needs the permittivity as well. we use the
       // permittivity from the adjacent segment
@@ -252,34 +268,33 @@ void simulator<DeviceT, MatlibT>::prepare()
 
 //                  std::cout << "contact segment " << *iter << " interfaces with semiconductor segment " << adjacent_semiconductor_segment
 //                            << " :: contact potential: " << config.get_contact_value(*iter) <<
-//                               " workfunction: " << config.get_workfunction(*iter) <<
-//                               " builtin-pot: " << builtin_pot << " ND: " << ND << " NA: " << NA << std::endl;
+//                               " workfunction: " << config.get_workfunction(*iter) << std::endl;
 
       // aside of the contact potential, add the builtin-pot and the workfunction (0 by default ..)
       //
-      viennafvm::set_dirichlet_boundary(
-              device_.segment(*iter),  // segment
-              storage,
-              quantity_potential(),
-              config_.contact_value(*iter) + config_.workfunction(*iter) + builtin_pot // BC value
-              );
+      this->assign_contact_potential(*iter, config_.contact_value(*iter));
 
       // as this contact is a contact-semiconductor interface, we have to
-      // provide BCs for the electrons and holes as well
+      // provide BCs for the electrons and holes as well, i.e. the doping of each cell
       //
-      viennafvm::set_dirichlet_boundary(
-              device_.segment(*iter), // segment
-              storage,
-              quantity_electron_density(),
-              ND_value // BC value
-              );
-
-      viennafvm::set_dirichlet_boundary(
-              device_.segment(*iter), // segment
-              storage,
-              quantity_hole_density(),
-              NA_value // BC value
-              );
+      typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, bool, CellType>::type n_boundary =
+          viennadata::make_accessor(storage, BoundaryKeyType(quantity_electron_density().id()));
+      typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, NumericType, CellType>::type n_boundary_value =
+          viennadata::make_accessor(storage, BoundaryKeyType(quantity_electron_density().id()));
+      typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, bool, CellType>::type p_boundary =
+          viennadata::make_accessor(storage, BoundaryKeyType(quantity_hole_density().id()));
+      typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, NumericType, CellType>::type p_boundary_value =
+          viennadata::make_accessor(storage, BoundaryKeyType(quantity_hole_density().id()));
+
+      SegmentCellRangeType cells(device_.segment(*iter));
+      for(SegmentCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+      {
+        std::size_t id = static_cast<std::size_t>(cit->id().get());
+        n_boundary(*cit)       = true;
+        n_boundary_value(*cit) = doping_->donator(id);
+        p_boundary(*cit)       = true;
+        p_boundary_value(*cit) = doping_->acceptor(id);
+      }
 
       // for a contact, the following quantities don't make any sense
       //
@@ -330,30 +345,43 @@ void simulator<DeviceT, MatlibT>::prepare()
                                    matlib_.getParameterValue(
                                      device_.segment_materials()[*iter], "permittivity") * viennamini::eps0::val());
 
+    // the mobility values are written by the mobility model, once the doping is known
+    //
     viennafvm::set_quantity_region(device_.segment(*iter), storage, mu_n_key_, true);
-    viennafvm::set_quantity_value (device_.segment(*iter), storage, mu_n_key_, 0.1430);// TODO
-
     viennafvm::set_quantity_region(device_.segment(*iter), storage, mu_p_key_, true);
-    viennafvm::set_quantity_value (device_.segment(*iter), storage, mu_p_key_, 0.046);// TODO
 
     viennafvm::set_quantity_region(device_.segment(*iter), storage, ND_key_, true);
-    viennafvm::set_quantity_value (device_.segment(*iter), storage, ND_key_, device_.donator(*iter));
-
     viennafvm::set_quantity_region(device_.segment(*iter), storage, NA_key_, true);
-    viennafvm::set_quantity_value (device_.segment(*iter), storage, NA_key_, device_.acceptor(*iter));
-
 
     // within the semiconductor segments, we have to prepare an initial guess quantity for the potential distribution
     // we shall use the builtin-pot here ..
     // [NOTE] I have pimped the builtin-pot implementation, with respect to UT
     //
-    NumericType builtin_potential_value = viennamini::built_in_potential(
-            config_.temperature(), device_.donator(*iter), device_.acceptor(*iter));
-
     viennafvm::set_quantity_region(device_.segment(*iter), storage, builtin_key_, true);
-    viennafvm::set_quantity_value(device_.segment(*iter), storage, builtin_key_, builtin_potential_value);
+
+    // the doping and the builtin-pot of each cell
+    //
+    typename viennadata::result_of::accessor<StorageType, viennamini::donator_doping_key, NumericType, CellType>::type    ND =
+        viennadata::make_accessor(storage, ND_key_);
+    typename viennadata::result_of::accessor<StorageType, viennamini::acceptor_doping_key, NumericType, CellType>::type   NA =
+        viennadata::make_accessor(storage, NA_key_);
+    typename viennadata::result_of::accessor<StorageType, viennamini::builtin_potential_key, NumericType, CellType>::type builtin =
+        viennadata::make_accessor(storage, builtin_key_);
+
+    SegmentCellRangeType cells(device_.segment(*iter));
+    for(SegmentCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+    {
+      std::size_t id = static_cast<std::size_t>(cit->id().get());
+      ND(*cit)      = doping_->donator(id);
+      NA(*cit)      = doping_->acceptor(id);
+      builtin(*cit) = viennamini::built_in_potential(config_.temperature(), doping_->donator(id), doping_->acceptor(id));
+    }
   }
 
+  // evaluate the low-field mobilities of all semiconductor cells
+  //
+  mobility_.setup(device_, matlib_, config_, quantity_potential().id());
+
 #ifdef VIENNAMINI_DEBUG
   std::cout << "* setting initial conditions .." << std::endl;
 #endif
@@ -365,6 +393,18 @@ void simulator<DeviceT, MatlibT>::prepare()
   viennafvm::set_initial_guess(device_.mesh(), storage, quantity_electron_density(), viennamini::donator_doping_key());
   viennafvm::set_initial_guess(device_.mesh(), storage, quantity_hole_density(),     viennamini::acceptor_doping_key());
 
+  // a provider, e.g. the solution of a previous run, replaces the cold start from the doping.
+  // the doping based guesses above remain in place if it can't provide a guess for this device
+  //
+  if(initial_guess_provider_ && (*initial_guess_provider_)(device_, quantity_potential().id(),
+                                                           quantity_electron_density().id(), quantity_hole_density().id()))
+  {
+#ifdef VIENNAMINI_DEBUG
+    std::cout << "* initial conditions taken from the initial guess provider" << std::endl;
+#endif
+    return;
+  }
+
 #ifdef VIENNAMINI_DEBUG
   std::cout << "* smoothing initial conditions " << config_.initial_guess_smoothing_iterations() << " times " << std::endl;
 #endif
@@ -372,17 +412,11 @@ void simulator<DeviceT, MatlibT>::prepare()
   // smooth the initial guesses
   // we can set the number of smoothing iterations via the config object
   //
-  for(int i = 0; i < config_.initial_guess_smoothing_iterations(); i++)
-  {
-    viennafvm::smooth_initial_guess(device_.mesh(), storage,
-                                    viennafvm::arithmetic_mean_smoother(), quantity_potential());
-
-    viennafvm::smooth_initial_guess(device_.mesh(), storage,
-                                    viennafvm::geometric_mean_smoother(), quantity_electron_density());
-
-    viennafvm::smooth_initial_guess(device_.mesh(), storage,
-                                    viennafvm::geometric_mean_smoother(), quantity_hole_density());
-  }
+  viennafvm::initial_guess_smoother<MeshType, StorageType> smoother(device_.mesh(), storage);
+  smoother.add(viennafvm::arithmetic_mean_smoother(), quantity_potential());
+  smoother.add(viennafvm::geometric_mean_smoother(),  quantity_electron_density());
+  smoother.add(viennafvm::geometric_mean_smoother(),  quantity_hole_density());
+  smoother(static_cast<std::size_t>(std::max(0, config_.initial_guess_smoothing_iterations())));
 }
 
 template <typename DeviceT, typename MatlibT>
@@ -391,6 +425,33 @@ bool simulator<DeviceT, MatlibT>::isContactInsulatorInterface(std::size_t contac
   return !(contactOxideInterfaces_.find(contact_segment_index) == contactOxideInterfaces_.end());
 }
 
+template <typename DeviceT, typename MatlibT>
+void simulator<DeviceT, MatlibT>::assign_contact_potential(std::size_t contact_segment, NumericType contact_value)
+{
+  typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, bool, CellType>::type boundary =
+      viennadata::make_accessor(device_.storage(), BoundaryKeyType(quantity_potential().id()));
+  typename viennadata::result_of::accessor<StorageType, BoundaryKeyType, NumericType, CellType>::type boundary_value =
+      viennadata::make_accessor(device_.storage(), BoundaryKeyType(quantity_potential().id()));
+
+  // as in prepare(), a contact to an insulator has no built-in potential, even if it touches a semiconductor as well
+  bool semiconductor = !isContactInsulatorInterface(contact_segment) && isContactSemiconductorInterface(contact_segment);
+
+  typedef typename viennagrid::result_of::const_element_range<SegmentType, CellTagType>::type   SegmentCellRangeType;
+  typedef typename viennagrid::result_of::iterator<SegmentCellRangeType>::type                  SegmentCellIteratorType;
+
+  SegmentCellRangeType cells(device_.segment(contact_segment));
+  for(SegmentCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+  {
+    std::size_t id = static_cast<std::size_t>(cit->id().get());
+    NumericType offset = config_.workfunction(contact_segment);
+    if(semiconductor)
+      offset += viennamini::built_in_potential(config_.temperature(), doping_->donator(id), doping_->acceptor(id));
+
+    boundary(*cit)       = true;
+    boundary_value(*cit) = contact_value + offset;
+  }
+}
+
 template <typename DeviceT, typename MatlibT>
 bool simulator<DeviceT, MatlibT>::isContactSemiconductorInterface(std::size_t contact_segment_index)
 {
@@ -426,6 +487,13 @@ void simulator<DeviceT, MatlibT>::add_drift_diffusion()
   pde_system_.option(1).geometric_update(true);
   pde_system_.option(2).geometric_update(true);
 
+  // the net recombination rate is the volume source of both continuity equations
+  if(recombination_.setup(device_, matlib_, config_, n.id(), p.id()))
+  {
+    pde_system_.option(1).add_volume_kernel(&recombination_);
+    pde_system_.option(2).add_volume_kernel(&recombination_);
+  }
+
   pde_system_.is_linear(false); // temporary solution up until automatic nonlinearity detection is running
 }
 
@@ -446,6 +514,9 @@ void simulator<DeviceT, MatlibT>::run()
   pde_solver_.set_nonlinear_iterations(config_.nonlinear_iterations());
   pde_solver_.set_nonlinear_breaktol(config_.nonlinear_breaktol());
 
+  // field-dependent mobilities are reevaluated before each nonlinear iteration
+  pde_solver_.set_coefficient_updater(config_.mobility_model() == mobility_field_dependent ? &mobility_ : NULL);
+
 //            std::cout << "starting simulatoin " << std::endl;
 
 #ifdef VIENNAMINI_DEBUG
@@ -453,6 +524,42 @@ void simulator<DeviceT, MatlibT>::run()
 #endif
   // run the simulation
   pde_solver_(pde_system_, device_.mesh(), device_.storage(), linear_solver_);
+
+  transient_completed_ = true;
+  if(config_.transient_state() && config_.drift_diffusion_state() && pde_solver_.converged())
+    run_transient();
+}
+
+template <typename DeviceT, typename MatlibT>
+void simulator<DeviceT, MatlibT>::run_transient()
+{
+  // switch the contacts, the stationary solution is the state at t=0
+  //
+  IndicesType& contact_segments = device_.contact_segments();
+  for(typename IndicesType::iterator iter = contact_segments.begin();
+      iter != contact_segments.end(); iter++)
+  {
+    if(!config_.has_contact_switch(*iter)) continue;
+
+    this->assign_contact_potential(*iter, config_.switched_contact_value(*iter));
+  }
+
+  // the continuity equations read div(J_n/q) = R + dn/dt and -div(J_p/q) = R + dp/dt
+  //
+  transient_solver_.clear_time_derivatives();
+  transient_solver_.add_time_derivative(1);
+  transient_solver_.add_time_derivative(2);
+
+  transient_solver_.set_scheme(config_.time_integration() == time_backward_euler ? viennafvm::backward_euler : viennafvm::bdf2);
+  transient_solver_.set_initial_step(config_.initial_time_step());
+  transient_solver_.set_step_limits(config_.initial_time_step() * 1.0e-6, config_.end_time() / 10.0);
+  transient_solver_.set_relative_tolerance(config_.time_step_tolerance());
+
+  // carrier densities far below the intrinsic density do not limit the step size
+  transient_solver_.set_absolute_tolerance(quantity_electron_density().id(), 1.0e12);
+  transient_solver_.set_absolute_tolerance(quantity_hole_density().id(),     1.0e12);
+
+  transient_completed_ = transient_solver_(pde_system_, device_.mesh(), device_.storage(), linear_solver_, config_.end_time());
 }
 
 template <typename DeviceT, typename MatlibT>
@@ -479,5 +586,66 @@ typename simulator<DeviceT, MatlibT>::VectorType const& simulator<DeviceT, Matli
   return pde_solver_.result();
 }
 
+template <typename DeviceT, typename MatlibT>
+void simulator<DeviceT, MatlibT>::set_monitor(viennafvm::solver_monitor* monitor)
+{
+  pde_solver_.set_monitor(monitor);
+}
+
+template <typename DeviceT, typename MatlibT>
+void simulator<DeviceT, MatlibT>::set_transient_observer(viennafvm::transient_observer* observer)
+{
+  transient_solver_.set_observer(observer);
+}
+
+template <typename DeviceT, typename MatlibT>
+void simulator<DeviceT, MatlibT>::set_initial_guess_provider(InitialGuessProviderType* provider)
+{
+  initial_guess_provider_ = provider;
+}
+
+template <typename DeviceT, typename MatlibT>
+void simulator<DeviceT, MatlibT>::set_doping_cache(DopingCacheType* cache)
+{
+  doping_ = cache ? cache : &own_doping_;
+}
+
+template <typename DeviceT, typename MatlibT>
+void simulator<DeviceT, MatlibT>::capture_solution(solution_snapshot& snapshot)
+{
+  viennamini::capture_solution(device_, quantity_potential().id(), quantity_electron_density().id(),
+                               quantity_hole_density().id(), snapshot);
+}
+
+template <typename DeviceT, typename MatlibT>
+viennafvm::transient_statistics const& simulator<DeviceT, MatlibT>::transient_statistics() const
+{
+  return transient_solver_.statistics();
+}
+
+template <typename DeviceT, typename MatlibT>
+bool simulator<DeviceT, MatlibT>::cancelled() const
+{
+  return pde_solver_.cancelled();
+}
+
+template <typename DeviceT, typename MatlibT>
+bool simulator<DeviceT, MatlibT>::converged() const
+{
+  return pde_solver_.converged() && transient_completed_;
+}
+
+template <typename DeviceT, typename MatlibT>
+std::size_t simulator<DeviceT, MatlibT>::required_nonlinear_iterations() const
+{
+  return pde_solver_.get_required_nonlinear_iterations();
+}
+
+template <typename DeviceT, typename MatlibT>
+simulator_timings const& simulator<DeviceT, MatlibT>::timings() const
+{
+  return timings_;
+}
+
 } // viennamini
 
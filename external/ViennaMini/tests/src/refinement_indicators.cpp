@@ -0,0 +1,197 @@
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+//
+// The error indicators of refinement_indicators() have to vanish for a solution which is linear in the potential and in
+// the logarithms of the carrier densities, and have to single out the cells around a kink of the potential, which are
+// then the only ones marked for refinement.
+//
+
+// include necessary system headers
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+// ViennaMini includes:
+#include "viennamini/simulator.hpp"
+
+// ViennaGrid includes:
+#include "viennagrid/mesh/element_creation.hpp"
+
+
+typedef viennamini::MeshTriangular2DType                                          MeshType;
+typedef viennamini::SegmentationTriangular2DType                                  SegmentationType;
+typedef viennamini::DeviceTriangular2DType                                        DeviceType;
+typedef viennagrid::result_of::segment_handle<SegmentationType>::type             SegmentHandleType;
+typedef viennagrid::result_of::point<MeshType>::type                              PointType;
+typedef viennagrid::result_of::vertex_handle<MeshType>::type                      VertexHandleType;
+
+static const long   squares_per_side = 12;
+static const double h                = 1.0 / squares_per_side;
+static const double thermal_voltage  = 0.0258;
+
+
+/** @brief A unit square of squares_per_side^2 squares, each split into two triangles, in a single segment */
+void setup_mesh(MeshType & mesh, SegmentationType & segments)
+{
+  std::vector<VertexHandleType> vertices;
+  for (long j = 0; j <= squares_per_side; ++j)
+    for (long i = 0; i <= squares_per_side; ++i)
+      vertices.push_back(viennagrid::make_vertex(mesh, PointType(i * h, j * h)));
+
+  SegmentHandleType & segment = segments(0);
+  for (long j = 0; j < squares_per_side; ++j)
+    for (long i = 0; i < squares_per_side; ++i)
+    {
+      long v0 = j * (squares_per_side + 1) + i;
+      long v1 = v0 + 1;
+      long v2 = v0 + squares_per_side + 1;
+      long v3 = v2 + 1;
+      viennagrid::make_triangle(segment, vertices[v0], vertices[v1], vertices[v3]);
+      viennagrid::make_triangle(segment, vertices[v0], vertices[v3], vertices[v2]);
+    }
+}
+
+/** @brief A linear potential and carrier densities whose logarithms are linear */
+struct linear_solution
+{
+  double operator()(double x, double y, std::size_t q) const
+  {
+    if (q == viennamini::solution_snapshot::potential)
+      return 0.3 + 0.2 * x - 0.1 * y;
+    if (q == viennamini::solution_snapshot::electron_density)
+      return 1e20 * std::exp((0.5 * x + 0.2 * y) / thermal_voltage);
+    return 1e12 * std::exp(-(0.5 * x + 0.2 * y) / thermal_voltage);
+  }
+};
+
+/** @brief A potential with a kink at x = 0.5, constant carrier densities */
+struct kinked_solution
+{
+  double operator()(double x, double, std::size_t q) const
+  {
+    if (q == viennamini::solution_snapshot::potential)
+      return 0.5 * std::abs(x - 0.5);
+    return 1e16;
+  }
+};
+
+/** @brief A snapshot on the mesh of the device with the values of the given solution at the cell centroids */
+template <typename SolutionT>
+viennamini::solution_snapshot make_snapshot(DeviceType & device, SolutionT const & solution)
+{
+  viennamini::solution_snapshot snapshot;
+  snapshot.dimension = 2;
+  std::size_t id_count = viennamini::detail::cell_centroids(device.mesh(), snapshot.centroids);
+  snapshot.mesh = viennamini::detail::fingerprint_of(device.mesh(), snapshot.centroids);
+  for (std::size_t q = 0; q < viennamini::solution_snapshot::quantity_count; ++q)
+  {
+    snapshot.values[q].resize(id_count);
+    snapshot.enabled[q].assign(id_count, true);
+    for (std::size_t id = 0; id < id_count; ++id)
+      snapshot.values[q][id] = solution(snapshot.centroids[2 * id], snapshot.centroids[2 * id + 1], q);
+  }
+  return snapshot;
+}
+
+
+int main()
+{
+  MeshType                mesh;
+  SegmentationType        segments(mesh);
+  viennamini::StorageType storage;
+  setup_mesh(mesh, segments);
+
+  DeviceType device(mesh, segments, storage);
+  device.assign_name         (0, "silicon");
+  device.assign_material     (0, "Si");
+  device.assign_semiconductor(0, 1e22, 1e10);
+
+  std::vector<double> indicators;
+
+  //
+  // A snapshot of another mesh is rejected
+  //
+  if (viennamini::refinement_indicators(device, viennamini::solution_snapshot(), thermal_voltage, indicators))
+  {
+    std::cerr << "* Indicators computed for a snapshot of another mesh!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Linear solution: all indicators vanish
+  //
+  viennamini::solution_snapshot linear = make_snapshot(device, linear_solution());
+  if (!viennamini::refinement_indicators(device, linear, thermal_voltage, indicators) || indicators.size() != linear.cell_count())
+  {
+    std::cerr << "* No indicators for the linear solution!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double largest = *std::max_element(indicators.begin(), indicators.end());
+  std::cout << "* linear solution: largest indicator " << largest << " V" << std::endl;
+  if (largest > 1e-10)
+  {
+    std::cerr << "* The indicators of the linear solution don't vanish!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Kinked potential: only the cells within two columns of the kink have indicators, and only they are marked
+  //
+  viennamini::solution_snapshot kinked = make_snapshot(device, kinked_solution());
+  if (!viennamini::refinement_indicators(device, kinked, thermal_voltage, indicators))
+  {
+    std::cerr << "* No indicators for the kinked solution!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  double largest_near = 0;
+  double largest_far  = 0;
+  for (std::size_t id = 0; id < indicators.size(); ++id)
+  {
+    double distance = std::abs(kinked.centroids[2 * id] - 0.5);
+    if (distance < h)
+      largest_near = std::max(largest_near, indicators[id]);
+    else
+    if (distance > 2.1 * h)
+      largest_far = std::max(largest_far, indicators[id]);
+  }
+  std::cout << "* kinked solution: largest indicator " << largest_near << " V at the kink, " << largest_far << " V away from it" << std::endl;
+  if (largest_near < 1e-3 || largest_far > 1e-10)
+  {
+    std::cerr << "* The indicators don't single out the kink!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<bool> marks;
+  std::size_t marked = viennamini::mark_for_refinement(indicators, 0.25, 1e-6, marks);
+  std::cout << "* kinked solution: " << marked << " of " << marks.size() << " cells marked" << std::endl;
+  if (marked == 0)
+  {
+    std::cerr << "* No cell marked at the kink!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (std::size_t id = 0; id < marks.size(); ++id)
+    if (marks[id] && std::abs(kinked.centroids[2 * id] - 0.5) > 2.1 * h)
+    {
+      std::cerr << "* Cell " << id << " away from the kink is marked!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  std::cout << "*****************************************************" << std::endl;
+  std::cout << "* Refinement indicators test finished successfully! *" << std::endl;
+  std::cout << "*****************************************************" << std::endl;
+  return EXIT_SUCCESS;
+}
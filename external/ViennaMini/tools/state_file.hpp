@@ -0,0 +1,384 @@
+#ifndef VIENNAMINI_TOOLS_STATE_FILE_HPP
+#define VIENNAMINI_TOOLS_STATE_FILE_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/* Reading of the state files written by the ViennaMOS ViennaMini module,
+   shared by the command line tools */
+
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <map>
+#include <vector>
+#include <string>
+
+#ifdef _WIN32
+  #include <direct.h>
+#else
+  #include <unistd.h>
+  #include <sys/stat.h>
+  #include <sys/types.h>
+#endif
+
+#include "viennamini/config.hpp"
+#include "viennamini/doping.hpp"
+
+namespace viennamini
+{
+namespace tools
+{
+
+//
+// ------------------------------------------------------------------------------------------------
+// State files: the QSettings ini format written by ViennaMiniForm::saveState
+// ------------------------------------------------------------------------------------------------
+//
+
+typedef std::map<std::string, std::string>   IniSectionType;   // 'segment0\name' -> 'LeftContact'
+typedef std::map<std::string, IniSectionType> IniFileType;      // 'general', 'device'
+
+inline std::string trim(std::string const& str)
+{
+  std::size_t first = str.find_first_not_of(" \t\r\n");
+  if(first == std::string::npos) return std::string();
+  std::size_t last  = str.find_last_not_of(" \t\r\n");
+  return str.substr(first, last - first + 1);
+}
+
+inline std::string to_lower(std::string str)
+{
+  for(std::size_t i = 0; i < str.size(); i++)
+    str[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(str[i])));
+  return str;
+}
+
+inline bool read_ini(std::string const& filename, IniFileType& ini)
+{
+  std::ifstream file(filename.c_str());
+  if(!file) return false;
+
+  std::string section;
+  std::string line;
+  while(std::getline(file, line))
+  {
+    line = trim(line);
+    if(line.empty() || line[0] == ';' || line[0] == '#') continue;
+
+    if(line[0] == '[' && line[line.size()-1] == ']')
+    {
+      // QSettings stores the group 'general' as '[%General]'
+      section = to_lower(line.substr(1, line.size()-2));
+      if(!section.empty() && section[0] == '%') section.erase(0, 1);
+      continue;
+    }
+
+    std::size_t pos = line.find('=');
+    if(pos == std::string::npos) continue;
+
+    std::string key   = trim(line.substr(0, pos));
+    std::string value = trim(line.substr(pos+1));
+    if(value.size() >= 2 && value[0] == '"' && value[value.size()-1] == '"')
+      value = value.substr(1, value.size()-2);
+    ini[section][key] = value;
+  }
+  return true;
+}
+
+template<typename T>
+T get(IniFileType& ini, std::string const& section, std::string const& key, T const& default_value)
+{
+  IniSectionType& values = ini[section];
+  IniSectionType::const_iterator iter = values.find(key);
+  if(iter == values.end()) return default_value;
+
+  T value;
+  std::istringstream stream(iter->second);
+  if(!(stream >> value)) return default_value;
+  return value;
+}
+
+template<>
+inline bool get<bool>(IniFileType& ini, std::string const& section, std::string const& key, bool const& default_value)
+{
+  IniSectionType& values = ini[section];
+  IniSectionType::const_iterator iter = values.find(key);
+  if(iter == values.end()) return default_value;
+  return to_lower(iter->second) == "true";
+}
+
+template<>
+inline std::string get<std::string>(IniFileType& ini, std::string const& section, std::string const& key, std::string const& default_value)
+{
+  IniSectionType& values = ini[section];
+  IniSectionType::const_iterator iter = values.find(key);
+  if(iter == values.end()) return default_value;
+  return iter->second;
+}
+
+struct segment_state
+{
+  int           id;
+  std::string   name;
+  std::string   material;
+  bool          is_contact;
+  bool          is_oxide;
+  bool          is_semiconductor;
+  double        contact;
+  bool          is_contact_range;   // transient runs switch the contact from 'contact_from' to 'contact_to' at t=0
+  double        contact_from;
+  double        contact_to;
+  double        workfunction;
+  double        donors;
+  double        acceptors;
+  std::string   donors_file;        // doping tables replacing the constants, see read_doping_table()
+  std::string   acceptors_file;
+};
+
+struct state
+{
+  std::string                   meshfile;
+  double                        scaling;
+  int                           meshtype;   // index of the ViennaMOS mesh type selection: 0 .. 2D triangular, 1 .. 3D tetrahedral
+  viennamini::config            config;
+  std::vector<segment_state>    segments;
+
+  // the doping tables of the segments, read along with the state
+  std::map<int, viennamini::tabulated_doping>  donor_tables;
+  std::map<int, viennamini::tabulated_doping>  acceptor_tables;
+};
+
+inline bool file_exists(std::string const& filename)
+{
+  std::ifstream file(filename.c_str());
+  return file.good();
+}
+
+inline bool is_absolute(std::string const& path)
+{
+#ifdef _WIN32
+  return (path.size() > 1 && path[1] == ':') || (!path.empty() && (path[0] == '\\' || path[0] == '/'));
+#else
+  return !path.empty() && path[0] == '/';
+#endif
+}
+
+inline std::string directory_of(std::string const& filename)
+{
+  std::size_t pos = filename.find_last_of("/\\");
+  return (pos == std::string::npos) ? std::string(".") : filename.substr(0, pos);
+}
+
+inline std::string basename_of(std::string const& filename)
+{
+  std::size_t pos = filename.find_last_of("/\\");
+  std::string name = (pos == std::string::npos) ? filename : filename.substr(pos+1);
+  std::size_t dot = name.find_last_of('.');
+  return (dot == std::string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+inline std::string absolute_path(std::string const& path)
+{
+  if(is_absolute(path)) return path;
+  char buffer[4096];
+#ifdef _WIN32
+  if(!_getcwd(buffer, sizeof(buffer))) return path;
+#else
+  if(!getcwd(buffer, sizeof(buffer))) return path;
+#endif
+  return std::string(buffer) + "/" + path;
+}
+
+/** @brief The mesh path of a state file is relative to the working directory of ViennaMOS.
+    If it can't be found from here, it is looked up relative to the state file */
+inline std::string resolve_meshfile(std::string const& meshfile, std::string const& statefile)
+{
+  if(is_absolute(meshfile) || file_exists(meshfile))
+    return absolute_path(meshfile);
+
+  std::string state_dir = directory_of(statefile);
+  std::string candidate = state_dir + "/" + meshfile;
+  if(file_exists(candidate)) return absolute_path(candidate);
+
+  std::size_t pos = meshfile.find_last_of("/\\");
+  candidate = state_dir + "/" + ((pos == std::string::npos) ? meshfile : meshfile.substr(pos+1));
+  if(file_exists(candidate)) return absolute_path(candidate);
+
+  return meshfile;
+}
+
+/** @brief Reads the doping table of a segment, if any. The path is resolved like the mesh path */
+inline bool read_doping_tables(std::string const& tablefile, std::string const& statefile, int segment_id,
+                               state const& st, std::map<int, viennamini::tabulated_doping>& tables)
+{
+  if(tablefile.empty()) return true;
+
+  std::size_t dimension = (st.meshtype == 1) ? 3 : 2;
+  std::string path = resolve_meshfile(tablefile, statefile);
+  if(!viennamini::read_doping_table(path, dimension, st.scaling, tables[segment_id]) || tables[segment_id].empty())
+  {
+    std::cerr << "Error: Could not read doping table " << path << " of segment " << segment_id << std::endl;
+    return false;
+  }
+  return true;
+}
+
+inline bool read_state(std::string const& filename, state& st)
+{
+  IniFileType ini;
+  if(!read_ini(filename, ini))
+  {
+    std::cerr << "Error: Could not read state file " << filename << std::endl;
+    return false;
+  }
+
+  st.meshfile = resolve_meshfile(get<std::string>(ini, "general", "meshfile", ""), filename);
+  st.scaling  = get<double>(ini, "general", "meshscaling", 1.0);
+  st.meshtype = get<int>   (ini, "general", "meshtype", 0);
+
+  st.config.temperature()          = get<double>(ini, "general", "temperature",         st.config.temperature());
+  st.config.linear_iterations()    = get<int>   (ini, "general", "linsolve_iter",       st.config.linear_iterations());
+  st.config.linear_breaktol()      = get<double>(ini, "general", "linsolve_tol",        st.config.linear_breaktol());
+  st.config.nonlinear_iterations() = get<int>   (ini, "general", "nonlinsolve_iter",    st.config.nonlinear_iterations());
+  st.config.nonlinear_breaktol()   = get<double>(ini, "general", "nonlinsolve_tol",     st.config.nonlinear_breaktol());
+  st.config.damping()              = get<double>(ini, "general", "nonlinsolve_damping", st.config.damping());
+  st.config.mobility_field_tolerance() = get<double>(ini, "general", "mobility_field_tol", st.config.mobility_field_tolerance());
+  st.config.recombination_srh_state()   = get<bool>  (ini, "general", "recombination_srh",   st.config.recombination_srh_state());
+  st.config.recombination_auger_state() = get<bool>  (ini, "general", "recombination_auger", st.config.recombination_auger_state());
+  st.config.transient_state()           = get<bool>  (ini, "general", "transient",           st.config.transient_state());
+  st.config.end_time()                  = get<double>(ini, "general", "end_time",            st.config.end_time());
+  st.config.initial_time_step()         = get<double>(ini, "general", "time_step",           st.config.initial_time_step());
+  st.config.time_step_tolerance()       = get<double>(ini, "general", "time_tol",            st.config.time_step_tolerance());
+  st.config.refinement_steps()          = get<int>   (ini, "general", "refinement_steps",    st.config.refinement_steps());
+  st.config.refinement_fraction()       = get<double>(ini, "general", "refinement_fraction", st.config.refinement_fraction());
+  st.config.refinement_tolerance()      = get<double>(ini, "general", "refinement_tol",      st.config.refinement_tolerance());
+
+  std::string time_integration = to_lower(get<std::string>(ini, "general", "time_integration", "bdf2"));
+  if(time_integration == "euler")   st.config.time_integration() = viennamini::time_backward_euler;
+  else
+  if(time_integration == "bdf2")    st.config.time_integration() = viennamini::time_bdf2;
+  else
+  {
+    std::cerr << "Error: Unknown time integration \"" << time_integration << "\" in " << filename
+              << ", expected euler or bdf2" << std::endl;
+    return false;
+  }
+
+  std::string mobility_model = to_lower(get<std::string>(ini, "general", "mobility_model", "constant"));
+  if(mobility_model == "constant")  st.config.mobility_model() = viennamini::mobility_constant;
+  else
+  if(mobility_model == "doping")    st.config.mobility_model() = viennamini::mobility_doping_dependent;
+  else
+  if(mobility_model == "field")     st.config.mobility_model() = viennamini::mobility_field_dependent;
+  else
+  {
+    std::cerr << "Error: Unknown mobility model \"" << mobility_model << "\" in " << filename
+              << ", expected constant, doping or field" << std::endl;
+    return false;
+  }
+
+  int segment_size = get<int>(ini, "device", "segmentsize", 0);
+  for(int si = 0; si < segment_size; si++)
+  {
+    std::ostringstream prefix;
+    prefix << "segment" << si << "\\";
+
+    segment_state seg;
+    seg.id               = get<int>        (ini, "device", prefix.str()+"id",              si);
+    seg.name             = get<std::string>(ini, "device", prefix.str()+"name",            "");
+    seg.material         = get<std::string>(ini, "device", prefix.str()+"material",        "");
+    seg.is_contact       = get<bool>       (ini, "device", prefix.str()+"iscontact",       false);
+    seg.is_oxide         = get<bool>       (ini, "device", prefix.str()+"isoxide",         false);
+    seg.is_semiconductor = get<bool>       (ini, "device", prefix.str()+"issemiconductor", false);
+    seg.contact          = get<double>     (ini, "device", prefix.str()+"contact",         0.0);
+    seg.is_contact_range = get<bool>       (ini, "device", prefix.str()+"iscontactrange",  false);
+    seg.contact_from     = get<double>     (ini, "device", prefix.str()+"contactfrom",     0.0);
+    seg.contact_to       = get<double>     (ini, "device", prefix.str()+"contactto",       0.0);
+    seg.workfunction     = get<double>     (ini, "device", prefix.str()+"workfunction",    0.0);
+    seg.donors           = get<double>     (ini, "device", prefix.str()+"donors",          0.0);
+    seg.acceptors        = get<double>     (ini, "device", prefix.str()+"acceptors",       0.0);
+    seg.donors_file      = get<std::string>(ini, "device", prefix.str()+"donorsfile",      "");
+    seg.acceptors_file   = get<std::string>(ini, "device", prefix.str()+"acceptorsfile",   "");
+    st.segments.push_back(seg);
+
+    // the table coordinates are given in the units of the mesh file
+    if(!read_doping_tables(seg.donors_file,    filename, seg.id, st, st.donor_tables))    return false;
+    if(!read_doping_tables(seg.acceptors_file, filename, seg.id, st, st.acceptor_tables)) return false;
+  }
+  return true;
+}
+
+/** @brief Creates a directory, an existing directory is not an error */
+inline void make_directory(std::string const& path)
+{
+#ifdef _WIN32
+  _mkdir(path.c_str());
+#else
+  mkdir(path.c_str(), 0755);
+#endif
+}
+
+inline bool change_directory(std::string const& path)
+{
+#ifdef _WIN32
+  return _chdir(path.c_str()) == 0;
+#else
+  return chdir(path.c_str()) == 0;
+#endif
+}
+
+/** @brief Applies the segment setup of a state to a device and its contacts to the config,
+    the same way the ViennaMOS ViennaMini worker does */
+template<typename DeviceT>
+void setup_device(DeviceT& device, state& st)
+{
+  for(std::vector<segment_state>::const_iterator iter = st.segments.begin(); iter != st.segments.end(); iter++)
+  {
+    device.assign_name(iter->id, iter->name);
+    device.assign_material(iter->id, iter->material);
+
+    if(iter->is_contact)
+    {
+      device.assign_contact(iter->id);
+      if(st.config.transient_state() && iter->is_contact_range)
+      {
+        st.config.assign_contact(iter->id, iter->contact_from, iter->workfunction);
+        st.config.assign_contact_switch(iter->id, iter->contact_to);
+      }
+      else
+        st.config.assign_contact(iter->id, iter->contact, iter->workfunction);
+    }
+    else
+    if(iter->is_oxide)
+      device.assign_oxide(iter->id);
+    else
+    if(iter->is_semiconductor)
+    {
+      device.assign_semiconductor(iter->id, iter->donors, iter->acceptors);
+
+      std::map<int, viennamini::tabulated_doping>::const_iterator donors    = st.donor_tables.find(iter->id);
+      std::map<int, viennamini::tabulated_doping>::const_iterator acceptors = st.acceptor_tables.find(iter->id);
+      if(donors != st.donor_tables.end() || acceptors != st.acceptor_tables.end())
+        device.assign_doping_profiles(iter->id,
+                                      (donors    != st.donor_tables.end())    ? &donors->second    : NULL,
+                                      (acceptors != st.acceptor_tables.end()) ? &acceptors->second : NULL);
+    }
+  }
+}
+
+} // tools
+} // viennamini
+
+#endif
@@ -0,0 +1,556 @@
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/* Headless batch runner: runs ViennaMini on state files written by the ViennaMOS
+   ViennaMini module ('Save' button), without any Qt or VTK dependency.
+
+   usage: viennamini_batch [options] <state.ini> [<state.ini> ...]
+
+   Each state file is a job. A native result of an earlier run on the same mesh can serve as
+   the initial guess of all jobs (-g), e.g. to continue from a run with slightly different parameters. The results of a job are written to <output>/<job>/,
+   where <job> is the base name of the state file. Transient jobs additionally write
+   each accepted time step as result_<step>. Stationary jobs with refinement steps
+   (general/refinement_steps) solve again on adaptively refined meshes, and write the
+   result on the last one (native results along with that mesh as mesh_refined.vtu). The exit code is
+     0  all jobs converged
+     1  at least one job did not converge
+     2  at least one job failed (e.g. unreadable state, mesh or material file)
+*/
+
+// include necessary system headers
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdio>
+#include <map>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+
+#ifndef _WIN32
+  #include <unistd.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+#endif
+
+// ViennaMini main include:
+#include "viennamini/simulator.hpp"
+
+// Vienna Includes
+#include "viennamaterials/library.hpp"
+#include "viennamaterials/kernels/pugixml.hpp"
+
+#include "state_file.hpp"
+
+using namespace viennamini::tools;
+
+
+enum job_status
+{
+  status_converged     = 0,
+  status_not_converged = 1,
+  status_failed        = 2
+};
+
+struct options
+{
+  options() : jobs(1), output("."), format("vmr"), profile(false) {}
+
+  std::string               materials;
+  std::string               initial_guess;  // native result file of an earlier run on the same mesh
+  int                       jobs;
+  std::string               output;
+  std::string               format;   // 'vmr' (native binary) or 'vtu'
+  bool                      profile;  // write a trace of the run to profile.json and profile.folded
+  std::vector<std::string>  states;
+};
+
+//
+// ------------------------------------------------------------------------------------------------
+// Native binary result format (*.vmr), host byte order:
+//   char[8]   magic "VMRES02"
+//   uint64    number of cells N
+//   uint64    number of quantities Q
+//   uint64    number of vertices     } fingerprint of the mesh, see viennamini::mesh_fingerprint
+//   uint64    hash of the centroids  }
+//   uint64[N] cell IDs
+//   Q times:  uint64 length of the name, the name, double[N] values in the order of the cell IDs
+// ------------------------------------------------------------------------------------------------
+//
+
+template<typename DeviceT, typename SimulatorT>
+bool write_native(std::string const& filename, DeviceT& device, SimulatorT& sim)
+{
+  typedef typename DeviceT::mesh_type                                           MeshType;
+  typedef typename DeviceT::storage_type                                        StorageType;
+  typedef typename viennagrid::result_of::cell<MeshType>::type                  CellType;
+  typedef typename viennagrid::result_of::cell_range<MeshType>::type            CellRangeType;
+  typedef typename viennagrid::result_of::iterator<CellRangeType>::type         CellIteratorType;
+  typedef typename SimulatorT::VectorType                                       VectorType;
+  typedef viennamini::result_accessor<CellType, StorageType, VectorType>        ResultAccessorType;
+
+  viennafvm::profiler::scope profile("result_write");
+
+  std::ofstream file(filename.c_str(), std::ios::binary);
+  if(!file) return false;
+
+  CellRangeType cells(device.mesh());
+
+  viennamini::mesh_fingerprint fingerprint = viennamini::make_fingerprint(device.mesh());
+
+  const char magic[8] = "VMRES02";
+  boost::uint64_t num_cells      = cells.size();
+  boost::uint64_t num_quantities = 3;
+  file.write(magic, sizeof(magic));
+  file.write(reinterpret_cast<const char*>(&num_cells),      sizeof(num_cells));
+  file.write(reinterpret_cast<const char*>(&num_quantities), sizeof(num_quantities));
+  file.write(reinterpret_cast<const char*>(&fingerprint.vertex_count),  sizeof(fingerprint.vertex_count));
+  file.write(reinterpret_cast<const char*>(&fingerprint.centroid_hash), sizeof(fingerprint.centroid_hash));
+
+  std::vector<boost::uint64_t> ids;
+  ids.reserve(cells.size());
+  for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+    ids.push_back(static_cast<boost::uint64_t>(cit->id().get()));
+  if(!ids.empty())
+    file.write(reinterpret_cast<const char*>(&ids[0]), ids.size() * sizeof(boost::uint64_t));
+
+  const char* names[3] = { "potential", "electron_concentration", "hole_concentration" };
+  std::size_t quantity_ids[3] = { static_cast<std::size_t>(sim.quantity_potential().id()),
+                                  static_cast<std::size_t>(sim.quantity_electron_density().id()),
+                                  static_cast<std::size_t>(sim.quantity_hole_density().id()) };
+
+  std::vector<double> values(cells.size());
+  for(std::size_t q = 0; q < 3; q++)
+  {
+    ResultAccessorType accessor(device.storage(), sim.result(), quantity_ids[q]);
+    std::size_t i = 0;
+    for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit, ++i)
+      values[i] = accessor(*cit);
+
+    std::string name(names[q]);
+    boost::uint64_t name_length = name.size();
+    file.write(reinterpret_cast<const char*>(&name_length), sizeof(name_length));
+    file.write(name.c_str(), name.size());
+    if(!values.empty())
+      file.write(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(double));
+  }
+  return file.good();
+}
+
+/** @brief Reads a native result file into a snapshot, which has the mesh fingerprint but no cell centroids.
+    Returns false on a missing or malformed file */
+bool read_native(std::string const& filename, viennamini::solution_snapshot& snapshot)
+{
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  if(!file) return false;
+
+  char magic[8];
+  boost::uint64_t num_cells = 0, num_quantities = 0;
+  viennamini::mesh_fingerprint fingerprint;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(&num_cells),      sizeof(num_cells));
+  file.read(reinterpret_cast<char*>(&num_quantities), sizeof(num_quantities));
+  file.read(reinterpret_cast<char*>(&fingerprint.vertex_count),  sizeof(fingerprint.vertex_count));
+  file.read(reinterpret_cast<char*>(&fingerprint.centroid_hash), sizeof(fingerprint.centroid_hash));
+  if(!file || std::string(magic, sizeof(magic)).compare(0, 7, "VMRES02") != 0) return false;
+  fingerprint.cell_count = num_cells;
+
+  std::vector<boost::uint64_t> ids(num_cells);
+  if(num_cells > 0)
+    file.read(reinterpret_cast<char*>(&ids[0]), ids.size() * sizeof(boost::uint64_t));
+
+  std::size_t id_count = 0;
+  for(std::size_t i = 0; i < ids.size(); i++)
+    id_count = std::max(id_count, static_cast<std::size_t>(ids[i]) + 1);
+
+  const char* names[3] = { "potential", "electron_concentration", "hole_concentration" };
+  snapshot = viennamini::solution_snapshot();
+  snapshot.mesh = fingerprint;
+  std::vector<double> values(num_cells);
+  for(boost::uint64_t q = 0; q < num_quantities; q++)
+  {
+    boost::uint64_t name_length = 0;
+    file.read(reinterpret_cast<char*>(&name_length), sizeof(name_length));
+    if(!file || name_length > 256) return false;
+    std::string name(name_length, ' ');
+    if(name_length > 0)
+      file.read(&name[0], name_length);
+    if(num_cells > 0)
+      file.read(reinterpret_cast<char*>(&values[0]), values.size() * sizeof(double));
+    if(!file) return false;
+
+    for(std::size_t k = 0; k < 3; k++)
+    {
+      if(name != names[k]) continue;
+      snapshot.values[k].assign(id_count, 0);
+      snapshot.enabled[k].assign(id_count, false);
+      for(std::size_t i = 0; i < ids.size(); i++)
+      {
+        snapshot.values[k][ids[i]]  = values[i];
+        snapshot.enabled[k][ids[i]] = true;
+      }
+    }
+  }
+
+  for(std::size_t k = 0; k < 3; k++)
+    if(snapshot.values[k].size() != id_count) return false;
+  return true;
+}
+
+//
+// ------------------------------------------------------------------------------------------------
+// Jobs
+// ------------------------------------------------------------------------------------------------
+//
+
+/** @brief Writes each accepted step of a transient run as result_<step> in the requested format */
+template<typename DeviceT, typename SimulatorT>
+class step_writer : public viennafvm::transient_observer
+{
+public:
+  step_writer(DeviceT& device, SimulatorT& sim, std::string const& format) : device_(device), sim_(sim), format_(format), failed_(false) {}
+
+  void accepted(std::size_t step, double time, double step_size)
+  {
+    std::ostringstream name;
+    name << "result_" << std::setw(5) << std::setfill('0') << step;
+
+    if(format_ == "vtu")
+      sim_.write_result(name.str());
+    else
+    if(!write_native(name.str() + ".vmr", device_, sim_))
+      failed_ = true;
+
+    std::cout << "* step " << step << ": t = " << time << " s, dt = " << step_size << " s" << std::endl;
+  }
+
+  bool failed() const { return failed_; }
+
+private:
+  DeviceT&          device_;
+  SimulatorT&       sim_;
+  std::string       format_;
+  bool              failed_;
+};
+
+template<typename MeshT, typename SegmentationT, typename DeviceT, typename SimulatorT>
+job_status run_simulation(state& st, options const& opt)
+{
+  MeshT                       mesh;
+  SegmentationT               segments(mesh);
+  viennamini::StorageType     storage;
+
+  try
+  {
+    viennafvm::profiler::scope profile("mesh_read");
+    viennagrid::io::netgen_reader reader;
+    reader(mesh, segments, st.meshfile);
+  }
+  catch(std::exception& e)
+  {
+    std::cerr << "Error: Could not read mesh file " << st.meshfile << ": " << e.what() << std::endl;
+    return status_failed;
+  }
+  viennagrid::scale(mesh, st.scaling);
+
+  viennamini::MatLibPugixmlType matlib;
+  if(!matlib.load(opt.materials))
+  {
+    std::cerr << "Error: Could not load material database " << opt.materials << std::endl;
+    return status_failed;
+  }
+
+  DeviceT device(mesh, segments, storage);
+  setup_device(device, st);
+
+  SimulatorT sim(device, matlib, st.config);
+
+  viennamini::solution_snapshot snapshot;
+  if(!opt.initial_guess.empty() && !read_native(opt.initial_guess, snapshot))
+  {
+    std::cerr << "Error: Could not read initial guess " << opt.initial_guess << std::endl;
+    return status_failed;
+  }
+  viennamini::previous_solution_guess<DeviceT> guess(snapshot);
+  if(!snapshot.empty())
+  {
+    if(viennamini::detail::same_mesh(device, snapshot))
+      sim.set_initial_guess_provider(&guess);
+    else
+      std::cout << "Warning: The initial guess " << opt.initial_guess << " is not a result on this mesh and is ignored" << std::endl;
+  }
+
+  step_writer<DeviceT, SimulatorT> steps(device, sim, opt.format);
+  if(st.config.transient_state())
+    sim.set_transient_observer(&steps);
+  sim();
+
+  if(steps.failed())
+  {
+    std::cerr << "Error: Could not write the result file of a time step" << std::endl;
+    return status_failed;
+  }
+
+  // adaptive refinement: each step refines the cells with the largest error indicators of the last
+  // solution and solves again
+  //
+  viennamini::adaptive_run<DeviceT, SimulatorT> adaptive(device, sim, matlib, st.config);
+  if(st.config.transient_state() && st.config.refinement_steps() > 0)
+    std::cout << "Warning: Transient runs are not refined, the refinement steps are ignored" << std::endl;
+  adaptive();
+
+  DeviceT*    result_device = &adaptive.device();
+  SimulatorT* result_sim    = &adaptive.simulator();
+
+  // native results hold no mesh, hence the refined one is written along
+  if(adaptive.steps() > 0 && opt.format != "vtu")
+  {
+    viennagrid::io::vtk_writer<MeshT> writer;
+    writer(result_device->mesh(), result_device->segments(), "mesh_refined");
+  }
+
+  if(opt.format == "vtu")
+    result_sim->write_result("result");
+  else
+  if(!write_native("result.vmr", *result_device, *result_sim))
+  {
+    std::cerr << "Error: Could not write result file" << std::endl;
+    return status_failed;
+  }
+
+  return result_sim->converged() ? status_converged : status_not_converged;
+}
+
+/** @brief Runs a single job in its own output directory, which also takes the
+    diagnostic files of the simulator and, for parallel runs, the log */
+job_status run_job(std::string const& statefile, options const& opt, bool redirect_log)
+{
+  state st;
+  if(!read_state(statefile, st)) return status_failed;
+
+  std::string job_dir = opt.output + "/" + basename_of(statefile);
+  make_directory(opt.output);
+  make_directory(job_dir);
+  if(!change_directory(job_dir))
+  {
+    std::cerr << "Error: Could not enter output directory " << job_dir << std::endl;
+    return status_failed;
+  }
+
+  if(redirect_log)
+  {
+    if(!std::freopen("log.txt", "w", stdout) || !std::freopen("log.txt", "a", stderr))
+      return status_failed;
+  }
+
+  if(opt.profile)
+  {
+    viennafvm::profiler::clear();
+    viennafvm::profiler::enable();
+  }
+
+  job_status status;
+  if(st.meshtype == 0)
+    status = run_simulation<viennamini::MeshTriangular2DType,  viennamini::SegmentationTriangular2DType,
+                            viennamini::DeviceTriangular2DType, viennamini::SimulatorTriangular2DType>(st, opt);
+  else
+  if(st.meshtype == 1)
+    status = run_simulation<viennamini::MeshTetrahedral3DType,  viennamini::SegmentationTetrahedral3DType,
+                            viennamini::DeviceTetrahedral3DType, viennamini::SimulatorTetrahedral3DType>(st, opt);
+  else
+  {
+    std::cerr << "Error: Mesh type " << st.meshtype << " is not supported" << std::endl;
+    status = status_failed;
+  }
+
+  if(opt.profile && !viennafvm::profiler::write_files("profile"))
+    std::cerr << "Error: Could not write the profile" << std::endl;
+
+  std::cout.flush();
+  std::cerr.flush();
+  return status;
+}
+
+const char* status_string(int status)
+{
+  switch(status)
+  {
+    case status_converged:     return "converged";
+    case status_not_converged: return "not converged";
+    default:                   return "failed";
+  }
+}
+
+void print_usage()
+{
+  std::cout << "usage: viennamini_batch [options] <state.ini> [<state.ini> ...]" << std::endl;
+  std::cout << "  -m, --materials <file>  material database (default: $VIENNAMINI_MATERIALS)" << std::endl;
+  std::cout << "  -l, --job-list <file>   read additional state files from a list, one per line" << std::endl;
+  std::cout << "  -j, --jobs <n>          number of simultaneous runs (default: 1)" << std::endl;
+  std::cout << "  -o, --output <dir>      output directory (default: .)" << std::endl;
+  std::cout << "  -f, --format <vmr|vtu>  result format: native binary or VTK (default: vmr)" << std::endl;
+  std::cout << "  -g, --initial-guess <file>  start from a native result (.vmr) of an earlier run on the same mesh" << std::endl;
+  std::cout << "  -p, --profile           write a Chrome trace (profile.json) and folded stacks (profile.folded) of each job" << std::endl;
+}
+
+bool read_job_list(std::string const& filename, std::vector<std::string>& states)
+{
+  std::ifstream file(filename.c_str());
+  if(!file) return false;
+
+  std::string line;
+  while(std::getline(file, line))
+  {
+    line = trim(line);
+    if(line.empty() || line[0] == '#') continue;
+    states.push_back(line);
+  }
+  return true;
+}
+
+bool parse_options(int argc, char** argv, options& opt)
+{
+  if(const char* materials = std::getenv("VIENNAMINI_MATERIALS"))
+    opt.materials = materials;
+
+  for(int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    bool has_value = (i+1 < argc);
+
+    if((arg == "-h") || (arg == "--help")) return false;
+    else
+    if((arg == "-p") || (arg == "--profile"))                   opt.profile = true;
+    else
+    if(((arg == "-m") || (arg == "--materials")) && has_value)  opt.materials = argv[++i];
+    else
+    if(((arg == "-j") || (arg == "--jobs")) && has_value)       opt.jobs = std::max(1, std::atoi(argv[++i]));
+    else
+    if(((arg == "-o") || (arg == "--output")) && has_value)     opt.output = argv[++i];
+    else
+    if(((arg == "-f") || (arg == "--format")) && has_value)     opt.format = argv[++i];
+    else
+    if(((arg == "-g") || (arg == "--initial-guess")) && has_value) opt.initial_guess = argv[++i];
+    else
+    if(((arg == "-l") || (arg == "--job-list")) && has_value)
+    {
+      if(!read_job_list(argv[++i], opt.states))
+      {
+        std::cerr << "Error: Could not read job list " << argv[i] << std::endl;
+        return false;
+      }
+    }
+    else
+    if(!arg.empty() && arg[0] == '-')
+    {
+      std::cerr << "Error: Unknown or incomplete option " << arg << std::endl;
+      return false;
+    }
+    else opt.states.push_back(arg);
+  }
+
+  if(opt.format != "vmr" && opt.format != "vtu")
+  {
+    std::cerr << "Error: Unknown result format " << opt.format << std::endl;
+    return false;
+  }
+  if(opt.materials.empty())
+  {
+    std::cerr << "Error: No material database given" << std::endl;
+    return false;
+  }
+  return !opt.states.empty();
+}
+
+int main(int argc, char** argv)
+{
+  options opt;
+  if(!parse_options(argc, argv, opt))
+  {
+    print_usage();
+    return status_failed;
+  }
+
+  // jobs change into their output directories, hence all paths are made absolute beforehand
+  //
+  opt.materials = absolute_path(opt.materials);
+  opt.output    = absolute_path(opt.output);
+  if(!opt.initial_guess.empty())
+    opt.initial_guess = absolute_path(opt.initial_guess);
+  for(std::size_t i = 0; i < opt.states.size(); i++)
+    opt.states[i] = absolute_path(opt.states[i]);
+
+  std::vector<int> status(opt.states.size(), status_failed);
+  bool redirect_log = opt.states.size() > 1;
+
+#ifdef _WIN32
+  for(std::size_t i = 0; i < opt.states.size(); i++)
+  {
+    status[i] = run_job(opt.states[i], opt, redirect_log);
+    std::cout << "[" << status_string(status[i]) << "] " << opt.states[i] << std::endl;
+  }
+#else
+  // the simulator is not designed for concurrent use within a process (e.g. global
+  // material library state), hence parallel jobs run in separate processes
+  //
+  std::map<pid_t, std::size_t> running;
+  std::size_t next = 0;
+  while(next < opt.states.size() || !running.empty())
+  {
+    while(next < opt.states.size() && int(running.size()) < opt.jobs)
+    {
+      std::cout.flush();
+      pid_t pid = fork();
+      if(pid == 0)
+        std::exit(run_job(opt.states[next], opt, redirect_log));
+      else
+      if(pid < 0)
+      {
+        std::cerr << "Error: Could not start job " << opt.states[next] << std::endl;
+        next++;
+      }
+      else
+        running[pid] = next++;
+    }
+
+    if(running.empty()) continue;
+
+    int child_status = 0;
+    pid_t pid = waitpid(-1, &child_status, 0);
+    if(pid < 0) break;
+
+    std::map<pid_t, std::size_t>::iterator iter = running.find(pid);
+    if(iter == running.end()) continue;
+
+    std::size_t job = iter->second;
+    running.erase(iter);
+    status[job] = (WIFEXITED(child_status) && WEXITSTATUS(child_status) <= status_failed) ? WEXITSTATUS(child_status) : int(status_failed);
+    std::cout << "[" << status_string(status[job]) << "] " << opt.states[job] << std::endl;
+  }
+#endif
+
+  int result = status_converged;
+  for(std::size_t i = 0; i < status.size(); i++)
+    result = std::max(result, status[i]);
+
+  std::cout << std::endl;
+  std::cout << "--------" << std::endl;
+  std::cout << "Batch finished: " << status.size() << " job(s), overall status: " << status_string(result) << std::endl;
+  std::cout << "--------" << std::endl;
+  return result;
+}
@@ -0,0 +1,814 @@
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/* Performance benchmark: runs ViennaMini on ViennaMOS state files (e.g. the shipped
+   example decks) and on synthetic n-i-n devices of increasing size, and reports the
+   time spent in each phase of the simulation as well as the memory high-water marks.
+
+   usage: viennamini_benchmark [options] [<state.ini> ...]
+
+   The report is written as JSON. If a baseline report is given, each phase is compared
+   against it and slowdowns beyond the tolerance are reported. The exit code is
+     0  no regression
+     1  at least one regression with respect to the baseline
+     2  at least one case failed
+*/
+
+// include necessary system headers
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+#include <map>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#ifndef _WIN32
+  #include <unistd.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+  #include <sys/resource.h>
+#endif
+
+// ViennaMini main include:
+#include "viennamini/simulator.hpp"
+
+// Vienna Includes
+#include "viennamaterials/library.hpp"
+#include "viennamaterials/kernels/pugixml.hpp"
+
+#include "state_file.hpp"
+
+using namespace viennamini::tools;
+
+
+enum bench_status
+{
+  status_ok         = 0,
+  status_regression = 1,
+  status_failed     = 2
+};
+
+struct options
+{
+  options() : repetitions(1), output("benchmark.json"), workdir("benchmark_work"), tolerance(0.15), min_time(0.05), profile(false) {}
+
+  std::string               materials;
+  int                       repetitions;
+  std::string               output;
+  std::string               baseline;
+  std::string               workdir;
+  double                    tolerance;   // allowed relative slowdown
+  double                    min_time;    // phases faster than this (in seconds) are too noisy to compare
+  bool                      profile;     // write a trace of each run to the work directory
+};
+
+/** @brief A benchmark case: either a state file or a synthetic device */
+struct bench_case
+{
+  bench_case() : nx(0), ny(0) {}
+
+  std::string   name;
+  std::string   statefile;    // empty for synthetic cases
+  std::size_t   nx, ny;       // grid of the synthetic device
+};
+
+typedef std::vector<std::pair<std::string, double> >  MeasurementsType;
+
+struct case_result
+{
+  case_result() : failed(true), converged(false), cells(0), iterations(0) {}
+
+  void add_phase(std::string const& name, double seconds) { phases.push_back(std::make_pair(name, seconds)); }
+  void add_memory(std::string const& name, double kb)     { memory.push_back(std::make_pair(name, kb)); }
+
+  bool              failed;
+  bool              converged;
+  std::size_t       cells;
+  std::size_t       iterations;
+  MeasurementsType  phases;   // seconds, in execution order
+  MeasurementsType  memory;   // high-water mark in kB at the end of the phase
+};
+
+/** @brief Peak resident set size of the process in kB, 0 if not available */
+double memory_high_water_mark()
+{
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  #ifdef __APPLE__
+  return usage.ru_maxrss / 1024.0;  // bytes on Mac OS
+  #else
+  return usage.ru_maxrss;
+  #endif
+#endif
+}
+
+//
+// ------------------------------------------------------------------------------------------------
+// Synthetic devices: the geometry of the nin2d deck (155nm x 50nm, contact | n+ | intrinsic | n+ | contact
+// along x), meshed with a structured grid of nx*ny rectangles split into two triangles each
+// ------------------------------------------------------------------------------------------------
+//
+
+template<typename MeshT, typename SegmentationT>
+void make_synthetic_mesh(MeshT& mesh, SegmentationT& segments, std::size_t nx, std::size_t ny)
+{
+  typedef typename viennagrid::result_of::point<MeshT>::type          PointType;
+  typedef typename viennagrid::result_of::vertex_handle<MeshT>::type  VertexHandleType;
+
+  const double length = 155.0;
+  const double height = 50.0;
+  const double hx = length / nx;
+  const double hy = height / ny;
+
+  std::vector<VertexHandleType> vertices;
+  vertices.reserve((nx+1) * (ny+1));
+  for(std::size_t y = 0; y <= ny; ++y)
+    for(std::size_t x = 0; x <= nx; ++x)
+      vertices.push_back(viennagrid::make_vertex(mesh, PointType(x * hx, y * hy)));
+
+  for(std::size_t x = 0; x < nx; ++x)
+  {
+    double center = (x + 0.5) * hx;
+    int segment_id;
+    if(center < 5.0)        segment_id = 1;
+    else if(center < 50.0)  segment_id = 2;
+    else if(center < 100.0) segment_id = 3;
+    else if(center < 150.0) segment_id = 4;
+    else                    segment_id = 5;
+
+    for(std::size_t y = 0; y < ny; ++y)
+    {
+      std::size_t v0 = y * (nx+1) + x;
+      viennagrid::make_triangle(segments[segment_id], vertices[v0], vertices[v0+1],    vertices[v0+nx+2]);
+      viennagrid::make_triangle(segments[segment_id], vertices[v0], vertices[v0+nx+2], vertices[v0+nx+1]);
+    }
+  }
+}
+
+void make_synthetic_state(state& st)
+{
+  st.scaling  = 1.0e-9;
+  st.meshtype = 0;
+  st.config.linear_iterations()    = 700;
+  st.config.linear_breaktol()      = 1.0e-14;
+  st.config.nonlinear_iterations() = 100;
+  st.config.nonlinear_breaktol()   = 1.0e-3;
+  st.config.damping()              = 1.0;
+
+  const char*  names[5]     = { "LeftContact", "LeftN", "Intrinsic", "RightN", "RightContact" };
+  const double donors[5]    = { 0.0, 1.0e24, 1.0e21, 1.0e24, 0.0 };
+  const double acceptors[5] = { 0.0, 1.0e8,  1.0e11, 1.0e8,  0.0 };
+
+  for(int si = 0; si < 5; si++)
+  {
+    segment_state seg;
+    seg.id               = si+1;
+    seg.name             = names[si];
+    seg.is_contact       = (si == 0) || (si == 4);
+    seg.is_oxide         = false;
+    seg.is_semiconductor = !seg.is_contact;
+    seg.material         = seg.is_contact ? "Cu" : "Si";
+    seg.contact          = (si == 4) ? 0.5 : 0.0;
+    seg.workfunction     = 0.0;
+    seg.donors           = donors[si];
+    seg.acceptors        = acceptors[si];
+    st.segments.push_back(seg);
+  }
+}
+
+//
+// ------------------------------------------------------------------------------------------------
+// Measurement of a single case
+// ------------------------------------------------------------------------------------------------
+//
+
+template<typename MeshT, typename SegmentationT, typename DeviceT, typename SimulatorT>
+void measure(bench_case const& bc, state& st, options const& opt, case_result& result)
+{
+  MeshT                       mesh;
+  SegmentationT               segments(mesh);
+  viennamini::StorageType     storage;
+  viennafvm::Timer            timer;
+  viennafvm::Timer            total_timer;
+
+  total_timer.start();
+
+  timer.start();
+  if(bc.statefile.empty())
+  {
+    viennafvm::profiler::scope profile("mesh_generate");
+    make_synthetic_mesh(mesh, segments, bc.nx, bc.ny);
+  }
+  else
+  {
+    try
+    {
+      viennafvm::profiler::scope profile("mesh_read");
+      viennagrid::io::netgen_reader reader;
+      reader(mesh, segments, st.meshfile);
+    }
+    catch(std::exception& e)
+    {
+      std::cerr << "Error: Could not read mesh file " << st.meshfile << ": " << e.what() << std::endl;
+      return;
+    }
+  }
+  viennagrid::scale(mesh, st.scaling);
+  result.add_phase("mesh_read", timer.get());
+  result.add_memory("mesh_read", memory_high_water_mark());
+  result.cells = viennagrid::cells(mesh).size();
+
+  timer.start();
+  viennamini::MatLibPugixmlType matlib;
+  if(!matlib.load(opt.materials))
+  {
+    std::cerr << "Error: Could not load material database " << opt.materials << std::endl;
+    return;
+  }
+  result.add_phase("material_load", timer.get());
+
+  DeviceT device(mesh, segments, storage);
+  setup_device(device, st);
+
+  SimulatorT sim(device, matlib, st.config);
+  sim();
+
+  viennamini::simulator_timings const& timings = sim.timings();
+  result.add_phase("interface_detection", timings.interface_detection);
+  result.add_phase("prepare",             timings.prepare);
+  result.add_phase("diagnostics_write",   timings.diagnostics);
+  result.add_phase("coefficients",        timings.solver.coefficients);
+  result.add_phase("assembly",            timings.solver.assembly);
+  result.add_phase("preconditioner",      timings.solver.preconditioner);
+  result.add_phase("linear_solve",        timings.solver.linear_solve);
+  result.add_phase("update",              timings.solver.update);
+  result.add_phase("result_transfer",     timings.solver.transfer);
+  result.add_memory("simulation", memory_high_water_mark());
+
+  timer.start();
+  sim.write_result("result");
+  result.add_phase("vtk_write", timer.get());
+  result.add_memory("vtk_write", memory_high_water_mark());
+
+  result.add_phase("total", total_timer.get());
+
+  result.failed     = false;
+  result.converged  = sim.converged();
+  result.iterations = sim.required_nonlinear_iterations();
+}
+
+/** @brief Runs a case in its own work directory, which takes the vtk files and the log */
+case_result run_case(bench_case const& bc, options const& opt)
+{
+  case_result result;
+
+  state st;
+  if(bc.statefile.empty())
+    make_synthetic_state(st);
+  else
+  if(!read_state(bc.statefile, st))
+    return result;
+
+  std::string case_dir = opt.workdir + "/" + bc.name;
+  make_directory(opt.workdir);
+  make_directory(case_dir);
+  if(!change_directory(case_dir))
+  {
+    std::cerr << "Error: Could not enter work directory " << case_dir << std::endl;
+    return result;
+  }
+  if(!std::freopen("log.txt", "w", stdout) || !std::freopen("log.txt", "a", stderr))
+    return result;
+
+  // repetitions overwrite the trace, the last one is kept
+  if(opt.profile)
+  {
+    viennafvm::profiler::clear();
+    viennafvm::profiler::enable();
+  }
+
+  if(st.meshtype == 0)
+    measure<viennamini::MeshTriangular2DType,  viennamini::SegmentationTriangular2DType,
+            viennamini::DeviceTriangular2DType, viennamini::SimulatorTriangular2DType>(bc, st, opt, result);
+  else
+  if(st.meshtype == 1)
+    measure<viennamini::MeshTetrahedral3DType,  viennamini::SegmentationTetrahedral3DType,
+            viennamini::DeviceTetrahedral3DType, viennamini::SimulatorTetrahedral3DType>(bc, st, opt, result);
+  else
+    std::cerr << "Error: Mesh type " << st.meshtype << " is not supported" << std::endl;
+
+  if(opt.profile && !viennafvm::profiler::write_files("profile"))
+    std::cerr << "Error: Could not write the profile" << std::endl;
+
+  std::cout.flush();
+  std::cerr.flush();
+  return result;
+}
+
+//
+// ------------------------------------------------------------------------------------------------
+// Process isolation: each run is measured in a child process, hence the memory high-water
+// marks are not polluted by previous runs. The child reports its result as text lines
+//   failed|converged|cells|iterations <value>,  phase|memory <name> <value>
+// ------------------------------------------------------------------------------------------------
+//
+
+std::string serialize(case_result const& result)
+{
+  std::ostringstream stream;
+  stream << std::setprecision(17);
+  stream << "failed "     << result.failed     << "\n";
+  stream << "converged "  << result.converged  << "\n";
+  stream << "cells "      << result.cells      << "\n";
+  stream << "iterations " << result.iterations << "\n";
+  for(MeasurementsType::const_iterator iter = result.phases.begin(); iter != result.phases.end(); iter++)
+    stream << "phase " << iter->first << " " << iter->second << "\n";
+  for(MeasurementsType::const_iterator iter = result.memory.begin(); iter != result.memory.end(); iter++)
+    stream << "memory " << iter->first << " " << iter->second << "\n";
+  return stream.str();
+}
+
+case_result deserialize(std::string const& text)
+{
+  case_result result;
+  std::istringstream stream(text);
+  std::string line;
+  while(std::getline(stream, line))
+  {
+    std::istringstream fields(line);
+    std::string key;
+    fields >> key;
+    if(key == "failed")     fields >> result.failed;
+    else
+    if(key == "converged")  fields >> result.converged;
+    else
+    if(key == "cells")      fields >> result.cells;
+    else
+    if(key == "iterations") fields >> result.iterations;
+    else
+    if(key == "phase" || key == "memory")
+    {
+      std::string name;
+      double value = 0;
+      fields >> name >> value;
+      if(key == "phase") result.add_phase(name, value);
+      else               result.add_memory(name, value);
+    }
+  }
+  return result;
+}
+
+case_result run_isolated(bench_case const& bc, options const& opt)
+{
+#ifdef _WIN32
+  return run_case(bc, opt);
+#else
+  int fds[2];
+  if(pipe(fds) != 0) return case_result();
+
+  std::cout.flush();
+  pid_t pid = fork();
+  if(pid < 0)
+  {
+    close(fds[0]);
+    close(fds[1]);
+    return case_result();
+  }
+  if(pid == 0)
+  {
+    close(fds[0]);
+    std::string text = serialize(run_case(bc, opt));
+    std::size_t written = 0;
+    while(written < text.size())
+    {
+      ssize_t count = write(fds[1], text.c_str() + written, text.size() - written);
+      if(count <= 0) break;
+      written += count;
+    }
+    close(fds[1]);
+    std::exit(0);
+  }
+
+  close(fds[1]);
+  std::string text;
+  char buffer[4096];
+  ssize_t count;
+  while((count = read(fds[0], buffer, sizeof(buffer))) > 0)
+    text.append(buffer, count);
+  close(fds[0]);
+
+  int child_status = 0;
+  waitpid(pid, &child_status, 0);
+  if(!WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0)
+    return case_result(); // crashed, e.g. out of memory
+
+  return deserialize(text);
+#endif
+}
+
+/** @brief Keeps the fastest time of each phase over repeated runs */
+void merge_minimum(case_result& best, case_result const& run)
+{
+  if(run.failed) { best.failed = true; return; }
+  for(std::size_t i = 0; i < best.phases.size() && i < run.phases.size(); i++)
+    best.phases[i].second = std::min(best.phases[i].second, run.phases[i].second);
+  for(std::size_t i = 0; i < best.memory.size() && i < run.memory.size(); i++)
+    best.memory[i].second = std::min(best.memory[i].second, run.memory[i].second);
+}
+
+//
+// ------------------------------------------------------------------------------------------------
+// JSON report
+// ------------------------------------------------------------------------------------------------
+//
+
+std::string json_string(std::string const& str)
+{
+  std::string result("\"");
+  for(std::size_t i = 0; i < str.size(); i++)
+  {
+    if(str[i] == '"' || str[i] == '\\') result += '\\';
+    result += str[i];
+  }
+  return result + "\"";
+}
+
+void write_measurements(std::ostream& stream, MeasurementsType const& values)
+{
+  stream << "{";
+  for(std::size_t i = 0; i < values.size(); i++)
+    stream << (i ? ", " : " ") << json_string(values[i].first) << ": " << values[i].second;
+  stream << " }";
+}
+
+bool write_report(std::string const& filename, std::vector<bench_case> const& cases,
+                  std::vector<case_result> const& results, options const& opt)
+{
+  std::ofstream file(filename.c_str());
+  if(!file) return false;
+
+  file << std::setprecision(6);
+  file << "{" << std::endl;
+  file << "  \"format\": \"viennamini_benchmark\"," << std::endl;
+  file << "  \"version\": 1," << std::endl;
+  file << "  \"repetitions\": " << opt.repetitions << "," << std::endl;
+  file << "  \"cases\": [" << std::endl;
+  for(std::size_t i = 0; i < cases.size(); i++)
+  {
+    case_result const& result = results[i];
+    file << "    {" << std::endl;
+    file << "      \"name\": "       << json_string(cases[i].name) << "," << std::endl;
+    file << "      \"source\": "     << json_string(cases[i].statefile.empty() ? std::string("synthetic") : cases[i].statefile) << "," << std::endl;
+    file << "      \"status\": "     << json_string(result.failed ? "failed" : (result.converged ? "converged" : "not converged")) << "," << std::endl;
+    file << "      \"cells\": "      << result.cells << "," << std::endl;
+    file << "      \"iterations\": " << result.iterations << "," << std::endl;
+    file << "      \"seconds\": ";
+    write_measurements(file, result.phases);
+    file << "," << std::endl;
+    file << "      \"memory_kb\": ";
+    write_measurements(file, result.memory);
+    file << std::endl;
+    file << "    }" << (i+1 < cases.size() ? "," : "") << std::endl;
+  }
+  file << "  ]" << std::endl;
+  file << "}" << std::endl;
+  return file.good();
+}
+
+/** @brief Minimal JSON reader for benchmark reports: flattens the document into
+    'path -> value' pairs, e.g. 'cases.0.seconds.assembly' -> '0.0123' */
+class json_flattener
+{
+public:
+  typedef std::map<std::string, std::string>  FlatType;
+
+  bool operator()(std::string const& text, FlatType& flat)
+  {
+    text_ = &text;
+    pos_  = 0;
+    flat_ = &flat;
+    return parse_value("") && (skip_whitespace(), pos_ == text.size());
+  }
+
+private:
+  void skip_whitespace()
+  {
+    while(pos_ < text_->size() && std::isspace(static_cast<unsigned char>((*text_)[pos_]))) pos_++;
+  }
+
+  bool expect(char c)
+  {
+    skip_whitespace();
+    if(pos_ >= text_->size() || (*text_)[pos_] != c) return false;
+    pos_++;
+    return true;
+  }
+
+  bool parse_string(std::string& value)
+  {
+    if(!expect('"')) return false;
+    value.clear();
+    while(pos_ < text_->size() && (*text_)[pos_] != '"')
+    {
+      if((*text_)[pos_] == '\\') pos_++;
+      if(pos_ < text_->size()) value += (*text_)[pos_++];
+    }
+    return expect('"');
+  }
+
+  static std::string join(std::string const& path, std::string const& key)
+  {
+    return path.empty() ? key : path + "." + key;
+  }
+
+  bool parse_value(std::string const& path)
+  {
+    skip_whitespace();
+    if(pos_ >= text_->size()) return false;
+
+    char c = (*text_)[pos_];
+    if(c == '{')
+    {
+      pos_++;
+      skip_whitespace();
+      if(pos_ < text_->size() && (*text_)[pos_] == '}') { pos_++; return true; }
+      do
+      {
+        std::string key;
+        if(!parse_string(key) || !expect(':') || !parse_value(join(path, key))) return false;
+      } while(expect(','));
+      return expect('}');
+    }
+    if(c == '[')
+    {
+      pos_++;
+      skip_whitespace();
+      if(pos_ < text_->size() && (*text_)[pos_] == ']') { pos_++; return true; }
+      std::size_t index = 0;
+      do
+      {
+        std::ostringstream key;
+        key << index++;
+        if(!parse_value(join(path, key.str()))) return false;
+      } while(expect(','));
+      return expect(']');
+    }
+    if(c == '"')
+    {
+      std::string value;
+      if(!parse_string(value)) return false;
+      (*flat_)[path] = value;
+      return true;
+    }
+
+    // number, true, false, null
+    std::size_t start = pos_;
+    while(pos_ < text_->size() && std::string(",}] \t\r\n").find((*text_)[pos_]) == std::string::npos) pos_++;
+    if(start == pos_) return false;
+    (*flat_)[path] = text_->substr(start, pos_ - start);
+    return true;
+  }
+
+  std::string const*  text_;
+  std::size_t         pos_;
+  FlatType*           flat_;
+};
+
+/** @brief Compares the results against a baseline report, returns the number of regressions */
+std::size_t compare(std::string const& filename, std::vector<bench_case> const& cases,
+                    std::vector<case_result> const& results, options const& opt)
+{
+  std::ifstream file(filename.c_str());
+  if(!file)
+  {
+    std::cout << "No baseline found at " << filename << " - skipping the comparison" << std::endl;
+    return 0;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+
+  json_flattener::FlatType flat;
+  if(!json_flattener()(buffer.str(), flat))
+  {
+    std::cerr << "Error: Could not parse baseline " << filename << std::endl;
+    return 0;
+  }
+
+  // map the case names of the baseline to their index paths
+  std::map<std::string, std::string> baseline_cases;
+  for(json_flattener::FlatType::const_iterator iter = flat.begin(); iter != flat.end(); iter++)
+  {
+    std::string const& key = iter->first;
+    if(key.compare(0, 6, "cases.") == 0 && key.size() > 5 && key.compare(key.size()-5, 5, ".name") == 0)
+      baseline_cases[iter->second] = key.substr(0, key.size()-5);
+  }
+
+  std::size_t regressions = 0;
+  std::cout << std::endl << "Comparison against " << filename << " (tolerance " << opt.tolerance * 100 << "%):" << std::endl;
+  for(std::size_t i = 0; i < cases.size(); i++)
+  {
+    std::map<std::string, std::string>::const_iterator base = baseline_cases.find(cases[i].name);
+    if(base == baseline_cases.end())
+    {
+      std::cout << "  " << cases[i].name << ": not in baseline" << std::endl;
+      continue;
+    }
+    if(results[i].failed) continue;
+
+    for(int kind = 0; kind < 2; kind++)
+    {
+      MeasurementsType const& values = (kind == 0) ? results[i].phases : results[i].memory;
+      std::string group = (kind == 0) ? ".seconds." : ".memory_kb.";
+
+      for(MeasurementsType::const_iterator iter = values.begin(); iter != values.end(); iter++)
+      {
+        json_flattener::FlatType::const_iterator ref = flat.find(base->second + group + iter->first);
+        if(ref == flat.end()) continue;
+
+        double reference = std::atof(ref->second.c_str());
+        if(reference <= 0 || (kind == 0 && std::max(reference, iter->second) < opt.min_time)) continue;
+
+        double ratio = iter->second / reference;
+        bool regression = ratio > 1.0 + opt.tolerance;
+        if(regression) regressions++;
+
+        std::cout << "  " << std::left << std::setw(24) << cases[i].name << std::setw(22) << iter->first
+                  << std::right << std::setw(12) << reference << " -> " << std::setw(12) << iter->second
+                  << (kind == 0 ? " s  " : " kB ") << std::fixed << std::setprecision(2) << std::setw(6) << ratio << "x"
+                  << (regression ? "  REGRESSION" : "") << std::endl;
+        std::cout.unsetf(std::ios_base::floatfield);
+        std::cout << std::setprecision(6);
+      }
+    }
+  }
+  return regressions;
+}
+
+//
+// ------------------------------------------------------------------------------------------------
+// Command line
+// ------------------------------------------------------------------------------------------------
+//
+
+void print_usage()
+{
+  std::cout << "usage: viennamini_benchmark [options] [<state.ini> ...]" << std::endl;
+  std::cout << "  -m, --materials <file>    material database (default: $VIENNAMINI_MATERIALS)" << std::endl;
+  std::cout << "  -s, --synthetic <nx>x<ny> add the nin2d geometry meshed with 2*nx*ny triangles" << std::endl;
+  std::cout << "  -r, --repetitions <n>     run each case n times and keep the fastest time of each phase (default: 1)" << std::endl;
+  std::cout << "  -o, --output <file>       JSON report (default: benchmark.json)" << std::endl;
+  std::cout << "  -b, --baseline <file>     compare against a previous report" << std::endl;
+  std::cout << "  -t, --tolerance <x>       relative slowdown considered a regression (default: 0.15)" << std::endl;
+  std::cout << "  -n, --min-time <seconds>  phases faster than this are not compared (default: 0.05)" << std::endl;
+  std::cout << "  -p, --profile             write a Chrome trace and folded stacks of each case to its work directory" << std::endl;
+  std::cout << "  -w, --workdir <dir>       directory for the vtk files and logs of the runs (default: benchmark_work)" << std::endl;
+}
+
+bool parse_grid(std::string const& spec, bench_case& bc)
+{
+  std::size_t pos = spec.find('x');
+  if(pos == std::string::npos) return false;
+  bc.nx = std::atoi(spec.substr(0, pos).c_str());
+  bc.ny = std::atoi(spec.substr(pos+1).c_str());
+  bc.name = "synthetic_" + spec;
+  return bc.nx >= 31 && bc.ny >= 1;  // the contacts need at least one column
+}
+
+bool parse_options(int argc, char** argv, options& opt, std::vector<bench_case>& cases)
+{
+  if(const char* materials = std::getenv("VIENNAMINI_MATERIALS"))
+    opt.materials = materials;
+
+  for(int i = 1; i < argc; i++)
+  {
+    std::string arg(argv[i]);
+    bool has_value = (i+1 < argc);
+
+    if((arg == "-h") || (arg == "--help")) return false;
+    else
+    if((arg == "-p") || (arg == "--profile"))                     opt.profile = true;
+    else
+    if(((arg == "-m") || (arg == "--materials")) && has_value)    opt.materials = argv[++i];
+    else
+    if(((arg == "-r") || (arg == "--repetitions")) && has_value)  opt.repetitions = std::max(1, std::atoi(argv[++i]));
+    else
+    if(((arg == "-o") || (arg == "--output")) && has_value)       opt.output = argv[++i];
+    else
+    if(((arg == "-b") || (arg == "--baseline")) && has_value)     opt.baseline = argv[++i];
+    else
+    if(((arg == "-t") || (arg == "--tolerance")) && has_value)    opt.tolerance = std::atof(argv[++i]);
+    else
+    if(((arg == "-w") || (arg == "--workdir")) && has_value)      opt.workdir = argv[++i];
+    else
+    if(((arg == "-n") || (arg == "--min-time")) && has_value)     opt.min_time = std::atof(argv[++i]);
+    else
+    if(((arg == "-s") || (arg == "--synthetic")) && has_value)
+    {
+      bench_case bc;
+      if(!parse_grid(argv[++i], bc))
+      {
+        std::cerr << "Error: Invalid synthetic grid " << argv[i] << ", expected <nx>x<ny> with nx >= 31" << std::endl;
+        return false;
+      }
+      cases.push_back(bc);
+    }
+    else
+    if(!arg.empty() && arg[0] == '-')
+    {
+      std::cerr << "Error: Unknown or incomplete option " << arg << std::endl;
+      return false;
+    }
+    else
+    {
+      bench_case bc;
+      bc.name      = basename_of(arg);
+      bc.statefile = arg;
+      cases.push_back(bc);
+    }
+  }
+
+  if(opt.materials.empty())
+  {
+    std::cerr << "Error: No material database given" << std::endl;
+    return false;
+  }
+  return !cases.empty();
+}
+
+int main(int argc, char** argv)
+{
+  options opt;
+  std::vector<bench_case> cases;
+  if(!parse_options(argc, argv, opt, cases))
+  {
+    print_usage();
+    return status_failed;
+  }
+
+  // runs change into their work directories, hence all paths are made absolute beforehand
+  //
+  opt.materials = absolute_path(opt.materials);
+  opt.workdir   = absolute_path(opt.workdir);
+  for(std::size_t i = 0; i < cases.size(); i++)
+    if(!cases[i].statefile.empty())
+      cases[i].statefile = absolute_path(cases[i].statefile);
+
+  int status = status_ok;
+  std::vector<case_result> results(cases.size());
+  for(std::size_t i = 0; i < cases.size(); i++)
+  {
+    for(int rep = 0; rep < opt.repetitions; rep++)
+    {
+      case_result run = run_isolated(cases[i], opt);
+      if(rep == 0) results[i] = run;
+      else         merge_minimum(results[i], run);
+    }
+
+    case_result const& result = results[i];
+    if(result.failed)
+    {
+      status = status_failed;
+      std::cout << "[failed] " << cases[i].name << std::endl;
+      continue;
+    }
+
+    std::cout << "[" << (result.converged ? "converged" : "not converged") << "] " << cases[i].name
+              << ": " << result.cells << " cells, " << result.iterations << " iterations" << std::endl;
+    for(MeasurementsType::const_iterator iter = result.phases.begin(); iter != result.phases.end(); iter++)
+      std::cout << "  " << std::left << std::setw(22) << iter->first << std::right << std::setw(12) << iter->second << " s" << std::endl;
+    if(!result.memory.empty())
+      std::cout << "  " << std::left << std::setw(22) << "peak memory" << std::right << std::setw(12) << result.memory.back().second << " kB" << std::endl;
+  }
+
+  if(!write_report(opt.output, cases, results, opt))
+  {
+    std::cerr << "Error: Could not write report " << opt.output << std::endl;
+    return status_failed;
+  }
+  std::cout << std::endl << "Report written to " << opt.output << std::endl;
+
+  if(!opt.baseline.empty() && compare(opt.baseline, cases, results, opt) > 0 && status == status_ok)
+    status = status_regression;
+
+  return status;
+}
@@ -20,6 +20,19 @@
 
 namespace viennamini {
 
+enum mobility_model_type
+{
+  mobility_constant,          // lattice mobility of the material
+  mobility_doping_dependent,  // Caughey-Thomas doping dependence
+  mobility_field_dependent    // doping dependence and high-field saturation
+};
+
+enum time_integration_type
+{
+  time_backward_euler,        // first order
+  time_bdf2                   // second order, variable step
+};
+
 struct config
 {
   typedef double                              NumericType;
@@ -42,6 +55,19 @@ struct config
   NumericType&  damping();
   IndexType&    initial_guess_smoothing_iterations();
 
+  mobility_model_type& mobility_model();
+
+  // relative change of the electric field of a cell, above which its
+  // field-dependent mobility is reevaluated between nonlinear iterations
+  NumericType&  mobility_field_tolerance();
+
+  // adaptive mesh refinement of stationary runs: number of refine-and-solve steps after the
+  // solve on the imported mesh, fraction of the cells refined per step, and the error
+  // indicator (in V) up to which cells are not refined
+  IndexType&    refinement_steps();
+  NumericType&  refinement_fraction();
+  NumericType&  refinement_tolerance();
+
   void assign_contact(std::size_t segment_index, NumericType value, NumericType workfunction);
 
   NumericType& contact_value(std::size_t segment_index);
@@ -50,6 +76,23 @@ struct config
 
   bool& drift_diffusion_state();
 
+  // net recombination sources of the continuity equations
+  bool& recombination_srh_state();
+  bool& recombination_auger_state();
+
+  // transient simulation: starting from the stationary solution, contacts with a switch
+  // value are set to it at t=0 and the device is integrated up to the end time
+  bool&         transient_state();
+  time_integration_type& time_integration();
+  NumericType&  end_time();
+  NumericType&  initial_time_step();
+  NumericType&  time_step_tolerance();   // relative local error per time step
+
+  void assign_contact_switch(std::size_t segment_index, NumericType value);
+  bool has_contact_switch(std::size_t segment_index) const;
+  NumericType& switched_contact_value(std::size_t segment_index);
+  void clear_contact_switches();
+
 private:
   IndexType         nonlinear_iterations_;
   IndexType         linear_iterations_;
@@ -61,6 +104,19 @@ private:
   SegmentValuesType segment_contact_values_;
   SegmentValuesType segment_contact_workfunctions_;
   bool              model_drift_diffusion_state_;
+  bool              model_recombination_srh_state_;
+  bool              model_recombination_auger_state_;
+  bool              transient_state_;
+  time_integration_type time_integration_;
+  NumericType       end_time_;
+  NumericType       initial_time_step_;
+  NumericType       time_step_tolerance_;
+  SegmentValuesType segment_switched_contact_values_;
+  mobility_model_type mobility_model_;
+  NumericType       mobility_field_tolerance_;
+  IndexType         refinement_steps_;
+  NumericType       refinement_fraction_;
+  NumericType       refinement_tolerance_;
 };
 
 
@@ -34,6 +34,7 @@ struct device
   typedef std::vector<std::size_t>                        IndicesType;
   typedef std::map<std::size_t, NumericType>              IndexValuesType;
   typedef std::map<std::size_t, std::size_t>              IndexMapType;
+  typedef std::map<std::size_t, doping_profile const*>    IndexProfilesType;
   typedef typename SegmentationType::segment_handle_type  SegmentType;
 
   typedef MeshType              mesh_type;
@@ -100,6 +101,12 @@ struct device
 //    segment_acceptors_[segment_index] = NA;
 //  }
 
+  /**
+      @brief Replaces the constant doping of a semiconductor segment by profiles, NULL keeps the constant.
+      The profiles are not copied and have to outlive the simulations of the device
+  */
+  void assign_doping_profiles(std::size_t segment_index, doping_profile const* ND, doping_profile const* NA);
+
 IndexKeysType& segment_names();
 IndexKeysType& segment_materials();
 IndicesType&   contact_segments();
@@ -109,6 +116,9 @@ IndicesType&   semiconductor_segments();
 NumericType& donator (std::size_t segment_index);
 NumericType& acceptor(std::size_t segment_index);
 
+doping_profile const* donator_profile (std::size_t segment_index) const;
+doping_profile const* acceptor_profile(std::size_t segment_index) const;
+
 
 MeshType&          mesh();
 SegmentationType&  segments();
@@ -143,6 +153,8 @@ private:
   IndicesType                 semiconductor_segments_;
   IndexValuesType             segment_donators_;
   IndexValuesType             segment_acceptors_;
+  IndexProfilesType           segment_donator_profiles_;
+  IndexProfilesType           segment_acceptor_profiles_;
 };
 
 } // viennamini
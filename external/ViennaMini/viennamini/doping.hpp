@@ -0,0 +1,497 @@
+#ifndef VIENNAMINI_DOPING_HPP
+#define VIENNAMINI_DOPING_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/** @file doping.hpp
+    @brief Spatially varying doping profiles.
+
+    By default, each semiconductor segment has a constant donor and acceptor concentration.
+    A doping profile replaces such a constant by a function of the position, e.g. a Gaussian
+    or an error function implant, or data interpolated from a table exported by another tool.
+    Profiles are evaluated at the cell centroids, in the coordinates of the (scaled) mesh.
+    The values are cached per cell ID and reused as long as neither the mesh (compared by its
+    fingerprint) nor the doping of the segments changes. The cache may be kept by the caller
+    across simulators, e.g. for repeated runs of the same device.
+*/
+
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+// ViennaGrid includes:
+#include "viennagrid/algorithm/centroid.hpp"
+
+// ViennaMini includes:
+#include "viennamini/fwd.h"
+#include "viennamini/point_index.hpp"
+#include "viennamini/mesh_fingerprint.hpp"
+
+namespace viennamini
+{
+  /**
+      @brief Interface of a doping concentration in m^-3 as a function of the position.
+      Profiles are evaluated concurrently and must not modify their state in operator()
+  */
+  class doping_profile
+  {
+    public:
+      doping_profile() : serial_(next_serial()) {}
+      doping_profile(doping_profile const&) : serial_(next_serial()) {}
+      virtual ~doping_profile() {}
+
+      doping_profile& operator=(doping_profile const&) { renew_serial(); return *this; }
+
+      /** @brief Returns the concentration at the point x, which has 'dimension' coordinates */
+      virtual double operator()(double const* x, std::size_t dimension) const = 0;
+
+      /**
+          @brief Unique per profile and renewed by each modification, so that cached evaluations can tell profiles apart
+          even if one is later constructed at the address of another. Profiles are constructed and modified on one thread
+      */
+      std::size_t serial() const { return serial_; }
+
+    protected:
+      void renew_serial() { serial_ = next_serial(); }
+
+    private:
+      static std::size_t next_serial()
+      {
+        static std::size_t counter = 0;
+        return ++counter;
+      }
+
+      std::size_t serial_;
+  };
+
+  /**
+      @brief The same concentration everywhere, e.g. the background doping of a sum of profiles
+  */
+  class constant_doping : public doping_profile
+  {
+    public:
+      constant_doping(double value) : value_(value) {}
+
+      double operator()(double const*, std::size_t) const { return value_; }
+
+    private:
+      double value_;
+  };
+
+  /**
+      @brief The sum of several profiles, e.g. implants on top of a background doping. The profiles are not copied,
+      modifying one of them afterwards requires doping_cache::invalidate()
+  */
+  class doping_sum : public doping_profile
+  {
+    public:
+      void add(doping_profile const& profile)
+      {
+        profiles_.push_back(&profile);
+        renew_serial();
+      }
+
+      double operator()(double const* x, std::size_t dimension) const
+      {
+        double result = 0;
+        for(std::size_t i = 0; i < profiles_.size(); i++)
+          result += (*profiles_[i])(x, dimension);
+        return result;
+      }
+
+    private:
+      std::vector<doping_profile const*> profiles_;
+  };
+
+  /**
+      @brief The geometry of an implant: the depth of a point below a surface point along the implant direction,
+      and an optional mask opening along a lateral direction, whose edges are smeared out by a lateral straggle
+  */
+  class implant_geometry
+  {
+    public:
+      /** @brief The surface passes through 'origin', the direction points into the substrate and needs not be normalized */
+      implant_geometry(std::vector<double> const& origin, std::vector<double> const& direction) : masked_(false), lower_(0), upper_(0), lateral_straggle_(0)
+      {
+        double length = 0;
+        for(std::size_t d = 0; d < 3; d++)
+        {
+          origin_[d]    = (d < origin.size())    ? origin[d]    : 0;
+          direction_[d] = (d < direction.size()) ? direction[d] : 0;
+          lateral_[d]   = 0;
+          length       += direction_[d] * direction_[d];
+        }
+        length = std::sqrt(length);
+        for(std::size_t d = 0; d < 3; d++)
+          direction_[d] = (length > 0) ? direction_[d] / length : 0;
+      }
+
+      /**
+          @brief Restricts the implant to the opening [lower, upper] of a mask, measured from the origin along 'lateral'.
+          A vanishing straggle gives sharp edges
+      */
+      void set_mask(std::vector<double> const& lateral, double lower, double upper, double lateral_straggle)
+      {
+        double length = 0;
+        for(std::size_t d = 0; d < 3; d++)
+        {
+          lateral_[d] = (d < lateral.size()) ? lateral[d] : 0;
+          length     += lateral_[d] * lateral_[d];
+        }
+        length = std::sqrt(length);
+        for(std::size_t d = 0; d < 3; d++)
+          lateral_[d] = (length > 0) ? lateral_[d] / length : 0;
+
+        masked_           = true;
+        lower_            = lower;
+        upper_            = upper;
+        lateral_straggle_ = lateral_straggle;
+      }
+
+      double depth(double const* x, std::size_t dimension) const { return project(x, dimension, direction_); }
+
+      /** @brief The fraction of the dose which reaches the lateral position of x, one without a mask */
+      double lateral_factor(double const* x, std::size_t dimension) const
+      {
+        if(!masked_) return 1;
+
+        double t = project(x, dimension, lateral_);
+        if(lateral_straggle_ <= 0)
+          return (t >= lower_ && t <= upper_) ? 1 : 0;
+
+        double scale = 1.0 / (std::sqrt(2.0) * lateral_straggle_);
+        return 0.5 * (erfc((lower_ - t) * scale) - erfc((upper_ - t) * scale));
+      }
+
+    private:
+      double project(double const* x, std::size_t dimension, double const* axis) const
+      {
+        double result = 0;
+        for(std::size_t d = 0; d < dimension && d < 3; d++)
+          result += (x[d] - origin_[d]) * axis[d];
+        return result;
+      }
+
+      double origin_[3];
+      double direction_[3];   // normalized
+      double lateral_[3];     // normalized
+      bool   masked_;
+      double lower_;
+      double upper_;
+      double lateral_straggle_;
+  };
+
+  /**
+      @brief As-implanted profile N = peak exp(-(depth - Rp)^2 / (2 dRp^2)), with the projected range Rp and the straggle dRp
+  */
+  class gaussian_doping : public doping_profile
+  {
+    public:
+      gaussian_doping(double peak, double projected_range, double straggle, implant_geometry const& geometry) :
+        peak_(peak), projected_range_(projected_range), straggle_(straggle), geometry_(geometry) {}
+
+      double operator()(double const* x, std::size_t dimension) const
+      {
+        double distance = (geometry_.depth(x, dimension) - projected_range_) / straggle_;
+        return peak_ * std::exp(-0.5 * distance * distance) * geometry_.lateral_factor(x, dimension);
+      }
+
+    private:
+      double           peak_;
+      double           projected_range_;
+      double           straggle_;
+      implant_geometry geometry_;
+  };
+
+  /**
+      @brief Constant source diffusion profile N = surface erfc(depth / L), with the diffusion length L = 2 sqrt(D t).
+      Points above the surface take the surface concentration
+  */
+  class erfc_doping : public doping_profile
+  {
+    public:
+      erfc_doping(double surface, double diffusion_length, implant_geometry const& geometry) :
+        surface_(surface), diffusion_length_(diffusion_length), geometry_(geometry) {}
+
+      double operator()(double const* x, std::size_t dimension) const
+      {
+        double depth = std::max(0.0, geometry_.depth(x, dimension));
+        return surface_ * erfc(depth / diffusion_length_) * geometry_.lateral_factor(x, dimension);
+      }
+
+    private:
+      double           surface_;
+      double           diffusion_length_;
+      implant_geometry geometry_;
+  };
+
+  /**
+      @brief Doping given at scattered points, e.g. the vertices of the mesh of a process simulation.
+      Evaluates the inverse distance weighted mean of the dimension+1 nearest points, found via a bucket grid
+  */
+  class tabulated_doping : public doping_profile
+  {
+    public:
+      tabulated_doping() : dimension_(0) {}
+
+      tabulated_doping(tabulated_doping const& other) : doping_profile(other),
+        dimension_(other.dimension_), points_(other.points_), values_(other.values_)
+      {
+        build_index();
+      }
+
+      tabulated_doping& operator=(tabulated_doping const& other)
+      {
+        doping_profile::operator=(other);
+        dimension_ = other.dimension_;
+        points_    = other.points_;
+        values_    = other.values_;
+        build_index();
+        return *this;
+      }
+
+      /** @brief Sets the table, the coordinates of point i start at points[i*dimension] */
+      void assign(std::size_t dimension, std::vector<double> const& points, std::vector<double> const& values)
+      {
+        dimension_ = dimension;
+        points_    = points;
+        values_    = values;
+        build_index();
+        renew_serial();
+      }
+
+      bool        empty()     const { return values_.empty(); }
+      std::size_t size()      const { return values_.size(); }
+      std::size_t dimension() const { return dimension_; }
+
+      double operator()(double const* x, std::size_t dimension) const
+      {
+        if(values_.empty()) return 0;
+
+        double point[3] = { 0, 0, 0 };
+        for(std::size_t d = 0; d < dimension && d < 3; d++)
+          point[d] = x[d];
+
+        std::size_t ids[4];
+        double      squared_distances[4];
+        std::size_t found = index_.nearest(point, dimension_ + 1, ids, squared_distances);
+
+        double weight_sum = 0;
+        double result     = 0;
+        for(std::size_t i = 0; i < found; i++)
+        {
+          if(squared_distances[i] <= 0) return values_[ids[i]];
+          double weight = 1.0 / squared_distances[i];
+          weight_sum += weight;
+          result     += weight * values_[ids[i]];
+        }
+        return result / weight_sum;
+      }
+
+    private:
+      void build_index()
+      {
+        std::vector<std::size_t> ids(values_.size());
+        for(std::size_t i = 0; i < ids.size(); i++)
+          ids[i] = i;
+        index_.build(points_, dimension_, ids);
+      }
+
+      std::size_t                 dimension_;
+      std::vector<double>         points_;
+      std::vector<double>         values_;
+      detail::nearest_point_index index_;
+  };
+
+  /**
+      @brief Reads a doping table with one point per line, i.e. 'dimension' coordinates followed by the concentration in m^-3.
+      Empty lines and lines starting with '#' are skipped. The coordinates are multiplied by 'scaling', e.g. the mesh scaling.
+      Returns false if the file can't be read or a line can't be parsed
+  */
+  inline bool read_doping_table(std::string const& filename, std::size_t dimension, double scaling, tabulated_doping& table)
+  {
+    std::ifstream file(filename.c_str());
+    if(!file || dimension < 1 || dimension > 3) return false;
+
+    std::vector<double> points;
+    std::vector<double> values;
+    std::string line;
+    while(std::getline(file, line))
+    {
+      std::size_t first = line.find_first_not_of(" \t\r");
+      if(first == std::string::npos || line[first] == '#') continue;
+
+      std::istringstream stream(line);
+      double coordinates[3];
+      double value;
+      for(std::size_t d = 0; d < dimension; d++)
+        stream >> coordinates[d];
+      stream >> value;
+      if(stream.fail()) return false;
+
+      for(std::size_t d = 0; d < dimension; d++)
+        points.push_back(coordinates[d] * scaling);
+      values.push_back(value);
+    }
+
+    table.assign(dimension, points, values);
+    return true;
+  }
+
+  /**
+      @brief Donor and acceptor concentrations per cell ID of the semiconductor segments of a device and of the contacts attached to them.
+      A contact takes the doping of its semiconductor at its own cells. Segments without a profile have their constant doping.
+      The cache is keyed on the mesh fingerprint and the doping of the segments, not on a simulator or device instance,
+      so that it can be kept by the caller across simulators for the same mesh
+  */
+  class doping_cache
+  {
+    public:
+      typedef std::map<std::size_t, std::size_t>   IndexMapType;
+
+      doping_cache() {}
+
+      /**
+          @brief Evaluates the doping, unless the cached values belong to the same mesh and doping of the segments.
+          Returns true if the doping has been evaluated
+      */
+      template<typename DeviceT>
+      bool update(DeviceT& device, IndexMapType const& contact_semiconductor_interfaces)
+      {
+        typedef typename DeviceT::indices_type                                                      IndicesType;
+        typedef typename viennagrid::result_of::point<typename DeviceT::mesh_type>::type            PointType;
+
+        std::size_t const dimension = static_cast<std::size_t>(PointType::dim);
+
+        // the cells of each segment, with the semiconductor segment whose doping they take
+        std::vector<source> sources;
+        IndicesType& semiconductor_segments = device.semiconductor_segments();
+        for(typename IndicesType::iterator iter = semiconductor_segments.begin(); iter != semiconductor_segments.end(); iter++)
+          sources.push_back(make_source(device, *iter, *iter));
+        for(typename IndexMapType::const_iterator iter = contact_semiconductor_interfaces.begin(); iter != contact_semiconductor_interfaces.end(); iter++)
+          sources.push_back(make_source(device, iter->first, iter->second));
+
+        std::vector<double> centroids;
+        std::size_t id_count = detail::cell_centroids(device.mesh(), centroids);
+        mesh_fingerprint mesh = detail::fingerprint_of(device.mesh(), centroids);
+        if(mesh == mesh_ && sources == sources_)
+          return false;
+
+        mesh_    = mesh;
+        sources_ = sources;
+        donators_.assign(id_count, 0);
+        acceptors_.assign(id_count, 0);
+
+        std::vector<std::size_t> cell_ids;
+        std::vector<std::size_t> cell_sources;
+        for(std::size_t i = 0; i < sources_.size(); i++)
+          collect(device, i, cell_ids, cell_sources);
+
+        // the profiles are evaluated in parallel, the cells of one segment take the same profiles
+        long num_cells = static_cast<long>(cell_ids.size());
+#ifdef VIENNAMINI_WITH_OPENMP
+        #pragma omp parallel for
+#endif
+        for(long i = 0; i < num_cells; i++)
+        {
+          source const& src = sources_[cell_sources[i]];
+          double const* x = &centroids[cell_ids[i] * dimension];
+          donators_[cell_ids[i]]  = src.donator_profile  ? (*src.donator_profile)(x, dimension)  : src.donator;
+          acceptors_[cell_ids[i]] = src.acceptor_profile ? (*src.acceptor_profile)(x, dimension) : src.acceptor;
+        }
+        return true;
+      }
+
+      /** @brief Forces the evaluation by the next update(), e.g. after a profile of a doping_sum has been modified */
+      void invalidate() { mesh_ = mesh_fingerprint(); }
+
+      double donator (std::size_t cell_id) const { return donators_[cell_id]; }
+      double acceptor(std::size_t cell_id) const { return acceptors_[cell_id]; }
+
+      std::vector<double> const& donators()  const { return donators_; }
+      std::vector<double> const& acceptors() const { return acceptors_; }
+
+    private:
+      /** @brief The doping of the cells of a segment, profiles are identified by their serials since their addresses may be reused */
+      struct source
+      {
+        bool operator==(source const& other) const
+        {
+          return segment == other.segment && semiconductor == other.semiconductor && cell_count == other.cell_count &&
+                 donator == other.donator && acceptor == other.acceptor &&
+                 donator_serial == other.donator_serial && acceptor_serial == other.acceptor_serial;
+        }
+
+        std::size_t            segment;
+        std::size_t            semiconductor;
+        std::size_t            cell_count;
+        double                 donator;
+        double                 acceptor;
+        doping_profile const * donator_profile;
+        doping_profile const * acceptor_profile;
+        std::size_t            donator_serial;
+        std::size_t            acceptor_serial;
+      };
+
+      template<typename DeviceT>
+      static source make_source(DeviceT& device, std::size_t segment_index, std::size_t semiconductor_segment)
+      {
+        typedef typename viennagrid::result_of::cell_tag<typename DeviceT::mesh_type>::type                     CellTagType;
+        typedef typename viennagrid::result_of::const_element_range<typename DeviceT::segment_type, CellTagType>::type CellRangeType;
+
+        CellRangeType cells(device.segment(segment_index));
+
+        source src;
+        src.segment          = segment_index;
+        src.semiconductor    = semiconductor_segment;
+        src.cell_count       = cells.size();
+        src.donator          = device.donator(semiconductor_segment);
+        src.acceptor         = device.acceptor(semiconductor_segment);
+        src.donator_profile  = device.donator_profile(semiconductor_segment);
+        src.acceptor_profile = device.acceptor_profile(semiconductor_segment);
+        src.donator_serial   = src.donator_profile  ? src.donator_profile->serial()  : 0;
+        src.acceptor_serial  = src.acceptor_profile ? src.acceptor_profile->serial() : 0;
+        return src;
+      }
+
+      template<typename DeviceT>
+      void collect(DeviceT& device, std::size_t source_index, std::vector<std::size_t>& cell_ids, std::vector<std::size_t>& cell_sources) const
+      {
+        typedef typename viennagrid::result_of::cell_tag<typename DeviceT::mesh_type>::type                     CellTagType;
+        typedef typename viennagrid::result_of::const_element_range<typename DeviceT::segment_type, CellTagType>::type CellRangeType;
+        typedef typename viennagrid::result_of::iterator<CellRangeType>::type                                   CellIteratorType;
+
+        CellRangeType cells(device.segment(sources_[source_index].segment));
+        for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        {
+          cell_ids.push_back(static_cast<std::size_t>(cit->id().get()));
+          cell_sources.push_back(source_index);
+        }
+      }
+
+      mesh_fingerprint          mesh_;
+      std::vector<source>       sources_;
+
+      std::vector<double>       donators_;    // indexed by cell ID
+      std::vector<double>       acceptors_;   // indexed by cell ID
+  };
+
+} // viennamini
+
+#endif
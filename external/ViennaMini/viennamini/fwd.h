@@ -123,6 +123,8 @@ namespace viennamini
   template<typename MeshT, typename SegmentationT, typename StorageT>
   class device;
 
+  class doping_profile;
+
   typedef ::viennadata::storage<>                                                                   StorageType;
   typedef ::vmat::Library<vmat::tag::pugixml>::type                                                 MatLibPugixmlType;
 
@@ -0,0 +1,294 @@
+#ifndef VIENNAMINI_INITIAL_GUESS_HPP
+#define VIENNAMINI_INITIAL_GUESS_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/** @file initial_guess.hpp
+    @brief Initial guesses from earlier solutions (solution continuation).
+
+    By default, the simulator starts from the built-in potential and the doping, smoothed
+    a number of times. An initial guess provider replaces this cold start, e.g. by the
+    converged solution of a previous run on the same mesh, or by a solution interpolated from
+    a different mesh.
+*/
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+// ViennaFVM includes:
+#include "viennafvm/forwards.h"
+
+// ViennaGrid includes:
+#include "viennagrid/algorithm/centroid.hpp"
+
+// ViennaMini includes:
+#include "viennamini/fwd.h"
+#include "viennamini/point_index.hpp"
+#include "viennamini/mesh_fingerprint.hpp"
+
+namespace viennamini
+{
+  /**
+      @brief Potential, electron and hole density of a solution per cell ID, together with the cell centroids
+      and the fingerprint of the mesh. Quantities which are disabled in a cell (e.g. the carriers in an oxide)
+      are flagged as such
+  */
+  struct solution_snapshot
+  {
+    enum { potential = 0, electron_density = 1, hole_density = 2, quantity_count = 3 };
+
+    solution_snapshot() : dimension(0) {}
+
+    bool        empty()      const { return values[potential].empty(); }
+    std::size_t cell_count() const { return values[potential].size(); }
+
+    std::size_t         dimension;
+    std::vector<double> values[quantity_count];    // indexed by cell ID
+    std::vector<bool>   enabled[quantity_count];   // indexed by cell ID
+    std::vector<double> centroids;                 // 'dimension' coordinates per cell ID
+    mesh_fingerprint    mesh;
+  };
+
+  /**
+      @brief Stores the current iterates of potential and carrier densities of a device,
+      e.g. right after a converged run
+  */
+  template<typename DeviceT>
+  void capture_solution(DeviceT& device, long potential_id, long electron_id, long hole_id, solution_snapshot& snapshot)
+  {
+    typedef typename DeviceT::mesh_type                                                           MeshType;
+    typedef typename DeviceT::storage_type                                                        StorageType;
+    typedef typename viennagrid::result_of::cell_tag<MeshType>::type                              CellTagType;
+    typedef typename viennagrid::result_of::cell<MeshType>::type                                  CellType;
+    typedef typename viennagrid::result_of::point<MeshType>::type                                 PointType;
+    typedef typename viennagrid::result_of::const_element_range<MeshType, CellTagType>::type      CellRangeType;
+    typedef typename viennagrid::result_of::iterator<CellRangeType>::type                         CellIteratorType;
+
+    typedef typename viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, double, CellType>::type  IterateAccessorType;
+    typedef typename viennadata::result_of::accessor<StorageType, viennafvm::disable_quantity_key, bool, CellType>::type   DisabledAccessorType;
+
+    long ids[solution_snapshot::quantity_count] = { potential_id, electron_id, hole_id };
+    IterateAccessorType  iterate[solution_snapshot::quantity_count];
+    DisabledAccessorType disabled[solution_snapshot::quantity_count];
+    for(std::size_t q = 0; q < solution_snapshot::quantity_count; q++)
+    {
+      iterate[q]  = viennadata::make_accessor(device.storage(), viennafvm::current_iterate_key(ids[q]));
+      disabled[q] = viennadata::make_accessor(device.storage(), viennafvm::disable_quantity_key(ids[q]));
+    }
+
+    snapshot.dimension = static_cast<std::size_t>(PointType::dim);
+    std::size_t id_count = detail::cell_centroids(device.mesh(), snapshot.centroids);
+    snapshot.mesh = detail::fingerprint_of(device.mesh(), snapshot.centroids);
+    for(std::size_t q = 0; q < solution_snapshot::quantity_count; q++)
+    {
+      snapshot.values[q].assign(id_count, 0);
+      snapshot.enabled[q].assign(id_count, false);
+    }
+
+    CellRangeType cells(device.mesh());
+    for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+    {
+      std::size_t id = static_cast<std::size_t>(cit->id().get());
+      for(std::size_t q = 0; q < solution_snapshot::quantity_count; q++)
+      {
+        snapshot.enabled[q][id] = !disabled[q](*cit);
+        if(snapshot.enabled[q][id])
+          snapshot.values[q][id] = iterate[q](*cit);
+      }
+    }
+  }
+
+  /**
+      @brief Interface of the initial guesses of the simulator
+  */
+  template<typename DeviceT>
+  class initial_guess_provider
+  {
+    public:
+      virtual ~initial_guess_provider() {}
+
+      /**
+          @brief Writes the initial guesses to the current iterates of the enabled cells of all three quantities.
+          Returns false, without touching the iterates, if there is no guess for this device. The simulator then
+          falls back to the smoothed doping based guess
+      */
+      virtual bool operator()(DeviceT& device, long potential_id, long electron_id, long hole_id) = 0;
+  };
+
+  namespace detail
+  {
+    /**
+        @brief Writes a guess to the current iterates of the enabled cells. The functor maps a cell and
+        a quantity index of solution_snapshot to the value, and is only called if the guess is complete,
+        i.e. 'available' holds for all enabled cells
+    */
+    template<typename DeviceT, typename GuessT>
+    bool assign_guess(DeviceT& device, long potential_id, long electron_id, long hole_id, GuessT const& guess)
+    {
+      typedef typename DeviceT::mesh_type                                                           MeshType;
+      typedef typename DeviceT::storage_type                                                        StorageType;
+      typedef typename viennagrid::result_of::cell_tag<MeshType>::type                              CellTagType;
+      typedef typename viennagrid::result_of::cell<MeshType>::type                                  CellType;
+      typedef typename viennagrid::result_of::const_element_range<MeshType, CellTagType>::type      CellRangeType;
+      typedef typename viennagrid::result_of::iterator<CellRangeType>::type                         CellIteratorType;
+
+      typedef typename viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, double, CellType>::type  IterateAccessorType;
+      typedef typename viennadata::result_of::accessor<StorageType, viennafvm::disable_quantity_key, bool, CellType>::type   DisabledAccessorType;
+
+      long ids[solution_snapshot::quantity_count] = { potential_id, electron_id, hole_id };
+      IterateAccessorType  iterate[solution_snapshot::quantity_count];
+      DisabledAccessorType disabled[solution_snapshot::quantity_count];
+      for(std::size_t q = 0; q < solution_snapshot::quantity_count; q++)
+      {
+        iterate[q]  = viennadata::make_accessor(device.storage(), viennafvm::current_iterate_key(ids[q]));
+        disabled[q] = viennadata::make_accessor(device.storage(), viennafvm::disable_quantity_key(ids[q]));
+      }
+
+      CellRangeType cells(device.mesh());
+      for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        for(std::size_t q = 0; q < solution_snapshot::quantity_count; q++)
+          if(!disabled[q](*cit) && !guess.available(*cit, q))
+            return false;
+
+      for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        for(std::size_t q = 0; q < solution_snapshot::quantity_count; q++)
+          if(!disabled[q](*cit))
+            iterate[q](*cit) = guess(*cit, q);
+      return true;
+    }
+
+    /**
+        @brief True if the snapshot has been taken on the mesh of the device, i.e. the mesh fingerprints match.
+        A snapshot without a fingerprint matches no mesh
+    */
+    template<typename DeviceT>
+    bool same_mesh(DeviceT& device, solution_snapshot const& snapshot)
+    {
+      return snapshot.mesh == viennamini::make_fingerprint(device.mesh());
+    }
+
+    /** @brief Cell-wise access to a snapshot of the same mesh */
+    struct snapshot_guess
+    {
+      snapshot_guess(solution_snapshot const& snapshot) : snapshot_(snapshot) {}
+
+      template<typename CellT>
+      bool available(CellT const& cell, std::size_t q) const
+      {
+        std::size_t id = static_cast<std::size_t>(cell.id().get());
+        return id < snapshot_.cell_count() && snapshot_.enabled[q][id];
+      }
+
+      template<typename CellT>
+      double operator()(CellT const& cell, std::size_t q) const
+      {
+        return snapshot_.values[q][static_cast<std::size_t>(cell.id().get())];
+      }
+
+      solution_snapshot const& snapshot_;
+    };
+  }
+
+  /**
+      @brief The converged solution of a previous run on the same mesh, e.g. before a small parameter change.
+      The new boundary values take effect via the Dirichlet cells
+  */
+  template<typename DeviceT>
+  class previous_solution_guess : public initial_guess_provider<DeviceT>
+  {
+    public:
+      previous_solution_guess(solution_snapshot const& snapshot) : snapshot_(snapshot) {}
+
+      bool operator()(DeviceT& device, long potential_id, long electron_id, long hole_id)
+      {
+        if(!detail::same_mesh(device, snapshot_)) return false;
+        return detail::assign_guess(device, potential_id, electron_id, hole_id, detail::snapshot_guess(snapshot_));
+      }
+
+    private:
+      solution_snapshot snapshot_;
+  };
+
+  /**
+      @brief A solution on a different mesh of the same device, e.g. a coarser one. Each cell takes the value of the
+      source cell with the nearest centroid among the cells where the quantity is enabled, which is the piecewise
+      constant interpolant of the finite volume solution
+  */
+  template<typename DeviceT>
+  class interpolated_solution_guess : public initial_guess_provider<DeviceT>
+  {
+      typedef typename DeviceT::mesh_type                                   MeshType;
+      typedef typename viennagrid::result_of::point<MeshType>::type         PointType;
+
+    public:
+      interpolated_solution_guess(solution_snapshot const& snapshot) : snapshot_(snapshot)
+      {
+        build_indices();
+      }
+
+      // the indices refer to the centroids of the own snapshot, hence a copy builds its own
+      interpolated_solution_guess(interpolated_solution_guess const& other) :
+        initial_guess_provider<DeviceT>(other), snapshot_(other.snapshot_)
+      {
+        build_indices();
+      }
+
+      interpolated_solution_guess& operator=(interpolated_solution_guess const& other)
+      {
+        snapshot_ = other.snapshot_;
+        build_indices();
+        return *this;
+      }
+
+      bool operator()(DeviceT& device, long potential_id, long electron_id, long hole_id)
+      {
+        if(snapshot_.dimension != static_cast<std::size_t>(PointType::dim)) return false;
+        return detail::assign_guess(device, potential_id, electron_id, hole_id, *this);
+      }
+
+      template<typename CellT>
+      bool available(CellT const&, std::size_t q) const { return !index_[q].empty(); }
+
+      template<typename CellT>
+      double operator()(CellT const& cell, std::size_t q) const
+      {
+        PointType centroid = viennagrid::centroid(cell);
+        double x[3] = { 0, 0, 0 };
+        for(std::size_t d = 0; d < snapshot_.dimension; d++)
+          x[d] = centroid[d];
+        return snapshot_.values[q][index_[q].nearest(x)];
+      }
+
+    private:
+      void build_indices()
+      {
+        for(std::size_t q = 0; q < solution_snapshot::quantity_count; q++)
+        {
+          std::vector<std::size_t> ids;
+          for(std::size_t id = 0; id < snapshot_.cell_count(); id++)
+            if(snapshot_.enabled[q][id])
+              ids.push_back(id);
+          index_[q].build(snapshot_.centroids, snapshot_.dimension, ids);
+        }
+      }
+
+      solution_snapshot           snapshot_;
+      detail::nearest_point_index index_[solution_snapshot::quantity_count];
+  };
+
+} // viennamini
+
+#endif
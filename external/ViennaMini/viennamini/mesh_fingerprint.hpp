@@ -0,0 +1,136 @@
+#ifndef VIENNAMINI_MESH_FINGERPRINT_HPP
+#define VIENNAMINI_MESH_FINGERPRINT_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/** @file mesh_fingerprint.hpp
+    @brief Identifies a mesh independently of its address.
+
+    Data kept across simulator runs (solution snapshots, the doping per cell) is only valid for
+    the mesh it has been computed on. A mesh may be rebuilt at the same address or moved in place,
+    e.g. by viennagrid::scale, so the data is tagged with a fingerprint of the mesh geometry instead.
+*/
+
+#include <algorithm>
+#include <vector>
+
+// Boost includes:
+#include <boost/cstdint.hpp>
+
+// ViennaGrid includes:
+#include "viennagrid/algorithm/centroid.hpp"
+
+namespace viennamini
+{
+  /**
+      @brief Identifies a mesh by its numbers of cells and vertices and a hash of the cell centroids in the
+      order of the cell IDs. A default constructed fingerprint matches no mesh
+  */
+  struct mesh_fingerprint
+  {
+    mesh_fingerprint() : cell_count(0), vertex_count(0), centroid_hash(0) {}
+
+    bool empty() const { return cell_count == 0; }
+
+    bool operator==(mesh_fingerprint const& other) const
+    {
+      return !empty() && cell_count == other.cell_count && vertex_count == other.vertex_count
+          && centroid_hash == other.centroid_hash;
+    }
+    bool operator!=(mesh_fingerprint const& other) const { return !(*this == other); }
+
+    boost::uint64_t cell_count;
+    boost::uint64_t vertex_count;
+    boost::uint64_t centroid_hash;
+  };
+
+  namespace detail
+  {
+    /** @brief FNV-1a hash of the bit patterns of the centroid coordinates, 'dimension' coordinates per cell ID */
+    inline boost::uint64_t centroid_hash(std::vector<double> const& centroids)
+    {
+      boost::uint64_t const prime = (static_cast<boost::uint64_t>(1) << 40) + 0x1b3;
+      boost::uint64_t       hash  = (static_cast<boost::uint64_t>(0xcbf29ce4) << 32) + 0x84222325;
+      for(std::size_t i = 0; i < centroids.size(); i++)
+      {
+        double coordinate = centroids[i] + 0.0;   // -0.0 and 0.0 hash alike
+        unsigned char const* bytes = reinterpret_cast<unsigned char const*>(&coordinate);
+        for(std::size_t b = 0; b < sizeof(double); b++)
+        {
+          hash ^= bytes[b];
+          hash *= prime;
+        }
+      }
+      return hash;
+    }
+
+    /** @brief The cell centroids of a mesh, 'dimension' coordinates per cell ID, and the number of cell IDs */
+    template<typename MeshT>
+    std::size_t cell_centroids(MeshT const& mesh, std::vector<double>& centroids)
+    {
+      typedef typename viennagrid::result_of::cell_tag<MeshT>::type                              CellTagType;
+      typedef typename viennagrid::result_of::point<MeshT>::type                                 PointType;
+      typedef typename viennagrid::result_of::const_element_range<MeshT, CellTagType>::type      CellRangeType;
+      typedef typename viennagrid::result_of::iterator<CellRangeType>::type                      CellIteratorType;
+
+      std::size_t const dimension = static_cast<std::size_t>(PointType::dim);
+
+      CellRangeType cells(mesh);
+      std::size_t id_count = 0;
+      for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        id_count = std::max(id_count, static_cast<std::size_t>(cit->id().get()) + 1);
+
+      centroids.assign(id_count * dimension, 0);
+      for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+      {
+        std::size_t id = static_cast<std::size_t>(cit->id().get());
+        PointType centroid = viennagrid::centroid(*cit);
+        for(std::size_t d = 0; d < dimension; d++)
+          centroids[id * dimension + d] = centroid[d];
+      }
+      return id_count;
+    }
+
+    /** @brief The fingerprint of a mesh with the given cell centroids, see cell_centroids() */
+    template<typename MeshT>
+    mesh_fingerprint fingerprint_of(MeshT const& mesh, std::vector<double> const& centroids)
+    {
+      typedef typename viennagrid::result_of::cell_tag<MeshT>::type                              CellTagType;
+      typedef typename viennagrid::result_of::const_element_range<MeshT, CellTagType>::type      CellRangeType;
+      typedef typename viennagrid::result_of::const_vertex_range<MeshT>::type                    VertexRangeType;
+
+      CellRangeType   cells(mesh);
+      VertexRangeType vertices(mesh);
+
+      mesh_fingerprint result;
+      result.cell_count    = cells.size();
+      result.vertex_count  = vertices.size();
+      result.centroid_hash = centroid_hash(centroids);
+      return result;
+    }
+  }
+
+  /** @brief The fingerprint of a mesh */
+  template<typename MeshT>
+  mesh_fingerprint make_fingerprint(MeshT const& mesh)
+  {
+    std::vector<double> centroids;
+    detail::cell_centroids(mesh, centroids);
+    return detail::fingerprint_of(mesh, centroids);
+  }
+
+} // viennamini
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef VIENNAMINI_MODELS_MATERIAL_PARAMETERS_HPP
+#define VIENNAMINI_MODELS_MATERIAL_PARAMETERS_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+#include <string>
+
+namespace viennamini
+{
+  namespace detail
+  {
+    /**
+        @brief Returns a parameter of a material scaled to SI units, or the default if the library does not hold it
+    */
+    template<typename MatlibT>
+    double material_value(MatlibT& matlib, std::string const& material, std::string const& parameter,
+                          double scaling, double default_value)
+    {
+      if(!matlib.hasParameter(material, parameter)) return default_value;
+      return matlib.getParameterValue(material, parameter) * scaling;
+    }
+  }
+
+} // viennamini
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef VIENNAMINI_MODELS_MOBILITY_HPP
+#define VIENNAMINI_MODELS_MOBILITY_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// ViennaFVM includes:
+#include "viennafvm/forwards.h"
+#include "viennafvm/coefficient_updater.hpp"
+#include "viennafvm/profiler.hpp"
+
+// ViennaGrid includes:
+#include "viennagrid/algorithm/centroid.hpp"
+#include "viennagrid/algorithm/csr_adjacency.hpp"
+#include "viennagrid/algorithm/norm.hpp"
+
+// ViennaMini includes:
+#include "viennamini/fwd.h"
+#include "viennamini/config.hpp"
+#include "viennamini/models/material_parameters.hpp"
+
+namespace viennamini
+{
+  /**
+      @brief Caughey-Thomas parameters of one carrier type in one material, in SI units.
+      The defaults switch the doping and the field dependence off
+  */
+  struct mobility_parameters
+  {
+    explicit mobility_parameters(double lattice_mobility = 0) :
+      lattice(lattice_mobility), minimum(lattice_mobility), reference_doping(1.0), alpha(1.0),
+      saturation_velocity(std::numeric_limits<double>::infinity()), beta(1.0) {}
+
+    double lattice;              // m^2/Vs
+    double minimum;              // m^2/Vs
+    double reference_doping;     // m^-3
+    double alpha;
+    double saturation_velocity;  // m/s
+    double beta;
+  };
+
+  /**
+      @brief Low-field mobility for the total doping concentration N_D + N_A
+  */
+  inline double caughey_thomas_doping(mobility_parameters const& par, double total_doping)
+  {
+    return par.minimum + (par.lattice - par.minimum) / (1.0 + std::pow(total_doping / par.reference_doping, par.alpha));
+  }
+
+  /**
+      @brief Saturates a low-field mobility for the magnitude of the electric field
+  */
+  inline double caughey_thomas_field(mobility_parameters const& par, double low_field_mobility, double field)
+  {
+    double x = low_field_mobility * field / par.saturation_velocity;
+    if(par.beta == 1.0) return low_field_mobility / (1.0 + x);
+    if(par.beta == 2.0) return low_field_mobility / std::sqrt(1.0 + x*x);
+    return low_field_mobility / std::pow(1.0 + std::pow(x, par.beta), 1.0 / par.beta);
+  }
+
+  /**
+      @brief Retrieves the mobility parameters of a carrier ('electron' or 'hole') from the material library.
+      The library holds cm based units. Without a lattice mobility, the given default is used,
+      missing model parameters disable the respective dependence
+  */
+  template<typename MatlibT>
+  mobility_parameters make_mobility_parameters(MatlibT& matlib, std::string const& material,
+                                               std::string const& carrier, double default_lattice_mobility)
+  {
+    mobility_parameters par(detail::material_value(matlib, material, carrier+"_mobility", 1.0e-4, default_lattice_mobility));
+    par.minimum             = detail::material_value(matlib, material, carrier+"_mobility_min",        1.0e-4, par.lattice);
+    par.reference_doping    = detail::material_value(matlib, material, carrier+"_mobility_nref",       1.0e+6, par.reference_doping);
+    par.alpha               = detail::material_value(matlib, material, carrier+"_mobility_alpha",      1.0,    par.alpha);
+    par.saturation_velocity = detail::material_value(matlib, material, carrier+"_saturation_velocity", 1.0e-2, par.saturation_velocity);
+    par.beta                = detail::material_value(matlib, material, carrier+"_mobility_beta",       1.0,    par.beta);
+    return par;
+  }
+
+  /**
+      @brief Evaluates the mobility models of all semiconductor cells into the storage
+      read by the mu_n/mu_p cell quantities of the continuity equations.
+
+      setup() evaluates the doping dependence once. For the field-dependent model, update()
+      is called by the PDE solver before each nonlinear iteration: the field of a cell is estimated
+      as the largest potential difference per distance to its neighbours, and the mobilities are only
+      reevaluated for cells whose field changed by more than the tolerance since their last evaluation.
+      The neighbourhood is compiled from the CSR adjacency of the mesh by setup(), so an update is a pass over flat arrays.
+  */
+  template<typename DeviceT>
+  class mobility_model : public viennafvm::coefficient_updater
+  {
+    public:
+      typedef typename DeviceT::numeric_type                                                  NumericType;
+      typedef typename DeviceT::indices_type                                                  IndicesType;
+      typedef typename DeviceT::mesh_type                                                     MeshType;
+      typedef typename DeviceT::storage_type                                                  StorageType;
+      typedef typename DeviceT::segment_type                                                  SegmentType;
+
+      typedef typename viennagrid::result_of::cell_tag<MeshType>::type                        CellTagType;
+      typedef typename viennagrid::result_of::cell<MeshType>::type                            CellType;
+      typedef typename viennagrid::result_of::point<MeshType>::type                           PointType;
+
+      typedef typename viennagrid::result_of::const_element_range<SegmentType, CellTagType>::type   CellRangeType;
+      typedef typename viennagrid::result_of::iterator<CellRangeType>::type                         CellIteratorType;
+      typedef typename viennagrid::result_of::const_element_range<MeshType, CellTagType>::type      MeshCellRangeType;
+      typedef typename viennagrid::result_of::iterator<MeshCellRangeType>::type                     MeshCellIteratorType;
+
+      typedef typename viennadata::result_of::accessor<StorageType, mobility_electrons_key, NumericType, CellType>::type  ElectronMobilityAccessorType;
+      typedef typename viennadata::result_of::accessor<StorageType, mobility_holes_key, NumericType, CellType>::type      HoleMobilityAccessorType;
+      typedef typename viennadata::result_of::accessor<StorageType, donator_doping_key, NumericType, CellType>::type      DonatorAccessorType;
+      typedef typename viennadata::result_of::accessor<StorageType, acceptor_doping_key, NumericType, CellType>::type     AcceptorAccessorType;
+      typedef typename viennadata::result_of::accessor<StorageType, viennafvm::current_iterate_key, NumericType, CellType>::type  PotentialAccessorType;
+
+      mobility_model() : device_(NULL), potential_id_(0), field_dependent_(false), tolerance_(0.05), cells_updated_(0) {}
+
+      /**
+          @brief Compiles the semiconductor cells and their neighbourhood and writes
+          the low-field mobilities to the storage. Requires the doping to be set
+      */
+      template<typename MatlibT>
+      void setup(DeviceT& device, MatlibT& matlib, viennamini::config& config, long potential_id)
+      {
+        device_          = &device;
+        potential_id_    = potential_id;
+        field_dependent_ = (config.mobility_model() == mobility_field_dependent);
+        tolerance_       = config.mobility_field_tolerance();
+
+        cells_.clear();
+        material_.clear();
+        parameters_n_.clear();
+        parameters_p_.clear();
+        low_field_n_.clear();
+        low_field_p_.clear();
+
+        ElectronMobilityAccessorType mu_n = viennadata::make_accessor(device.storage(), mobility_electrons_key());
+        HoleMobilityAccessorType     mu_p = viennadata::make_accessor(device.storage(), mobility_holes_key());
+        DonatorAccessorType          ND   = viennadata::make_accessor(device.storage(), donator_doping_key());
+        AcceptorAccessorType         NA   = viennadata::make_accessor(device.storage(), acceptor_doping_key());
+
+        IndicesType& semiconductor_segments = device.semiconductor_segments();
+        for(typename IndicesType::iterator iter = semiconductor_segments.begin();
+            iter != semiconductor_segments.end(); iter++)
+        {
+          std::string const& material = device.segment_materials()[*iter];
+
+          // the former hard-coded values serve as defaults for materials without mobility data
+          mobility_parameters par_n = make_mobility_parameters(matlib, material, "electron", 0.1430);
+          mobility_parameters par_p = make_mobility_parameters(matlib, material, "hole",     0.046);
+          if(config.mobility_model() == mobility_constant)
+          {
+            par_n = mobility_parameters(par_n.lattice);
+            par_p = mobility_parameters(par_p.lattice);
+          }
+          parameters_n_.push_back(par_n);
+          parameters_p_.push_back(par_p);
+
+          CellRangeType cells(device.segment(*iter));
+          for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+          {
+            double total_doping = ND(*cit) + NA(*cit);
+
+            cells_.push_back(&(*cit));
+            material_.push_back(parameters_n_.size()-1);
+            low_field_n_.push_back(caughey_thomas_doping(par_n, total_doping));
+            low_field_p_.push_back(caughey_thomas_doping(par_p, total_doping));
+
+            mu_n(*cit) = low_field_n_.back();
+            mu_p(*cit) = low_field_p_.back();
+          }
+        }
+
+        field_.assign(cells_.size(), 0);
+        evaluated_field_.assign(cells_.size(), 0);
+        cells_updated_ = 0;
+
+        if(field_dependent_)
+          this->compile_neighbourhood();
+      }
+
+      /**
+          @brief Called by the PDE solver. Reevaluates the mobilities of the cells whose field has changed
+      */
+      void update(std::size_t /*nonlinear_iteration*/)
+      {
+        cells_updated_ = 0;
+        if(!field_dependent_ || !device_) return;
+
+        PotentialAccessorType        psi  = viennadata::make_accessor(device_->storage(), viennafvm::current_iterate_key(potential_id_));
+        ElectronMobilityAccessorType mu_n = viennadata::make_accessor(device_->storage(), mobility_electrons_key());
+        HoleMobilityAccessorType     mu_p = viennadata::make_accessor(device_->storage(), mobility_holes_key());
+
+        for(std::size_t i = 0; i < mesh_cells_.size(); i++)
+          potential_[i] = psi(*mesh_cells_[i]);
+
+        std::size_t const size = cells_.size();
+        for(std::size_t i = 0; i < size; i++)
+        {
+          double potential = potential_[cell_index_[i]];
+          double field     = 0;
+          for(std::size_t k = offsets_[i]; k < offsets_[i+1]; k++)
+            field = std::max(field, std::abs(potential_[neighbours_[k]] - potential) * inverse_distances_[k]);
+          field_[i] = field;
+        }
+
+        for(std::size_t i = 0; i < size; i++)
+        {
+          if(std::abs(field_[i] - evaluated_field_[i]) <= tolerance_ * evaluated_field_[i])
+            continue;
+
+          evaluated_field_[i] = field_[i];
+          mu_n(*cells_[i]) = caughey_thomas_field(parameters_n_[material_[i]], low_field_n_[i], field_[i]);
+          mu_p(*cells_[i]) = caughey_thomas_field(parameters_p_[material_[i]], low_field_p_[i], field_[i]);
+          cells_updated_++;
+        }
+        viennafvm::profiler::counter("mobility_cells_updated", static_cast<double>(cells_updated_));
+      }
+
+      /**
+          @brief Returns the number of cells whose mobilities have been reevaluated by the last update
+      */
+      std::size_t cells_updated() const { return cells_updated_; }
+
+    private:
+      /**
+          @brief Builds the CSR arrays of neighbour indices and inverse centroid distances
+          of the semiconductor cells from the cell adjacency of the whole mesh
+      */
+      void compile_neighbourhood()
+      {
+        typedef viennagrid::csr_adjacency::index_array_type   IndexArrayType;
+
+        MeshType const& mesh = device_->mesh();
+        viennagrid::csr_adjacency adjacency(mesh);
+
+        // the cells of the mesh in the order of the adjacency
+        mesh_cells_.clear();
+        std::vector<PointType> centroids;
+        MeshCellRangeType cells(mesh);
+        for(MeshCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        {
+          mesh_cells_.push_back(&(*cit));
+          centroids.push_back(viennagrid::centroid(*cit));
+        }
+
+        IndexArrayType const& cell_ids = adjacency.cell_ids();
+        IndexArrayType index_of_id(cell_ids.empty() ? 0 : *std::max_element(cell_ids.begin(), cell_ids.end()) + 1,
+                                   viennagrid::csr_adjacency::invalid_index());
+        for(std::size_t i = 0; i < cell_ids.size(); i++)
+          index_of_id[cell_ids[i]] = i;
+
+        IndexArrayType const& neighbour_offsets = adjacency.cell_neighbor_offsets();
+        IndexArrayType const& neighbours        = adjacency.neighbors();
+
+        cell_index_.resize(cells_.size());
+        offsets_.assign(1, 0);
+        neighbours_.clear();
+        inverse_distances_.clear();
+        for(std::size_t i = 0; i < cells_.size(); i++)
+        {
+          std::size_t index = index_of_id[cells_[i]->id().get()];
+          cell_index_[i] = index;
+
+          for(std::size_t k = neighbour_offsets[index]; k < neighbour_offsets[index+1]; k++)
+          {
+            neighbours_.push_back(neighbours[k]);
+            inverse_distances_.push_back(1.0 / viennagrid::norm(centroids[index] - centroids[neighbours[k]]));
+          }
+          offsets_.push_back(neighbours_.size());
+        }
+
+        potential_.resize(mesh_cells_.size());
+      }
+
+      DeviceT*                          device_;
+      long                              potential_id_;
+      bool                              field_dependent_;
+      NumericType                       tolerance_;
+      std::size_t                       cells_updated_;
+
+      // per material
+      std::vector<mobility_parameters>  parameters_n_;
+      std::vector<mobility_parameters>  parameters_p_;
+
+      // per semiconductor cell
+      std::vector<CellType const*>      cells_;
+      std::vector<std::size_t>          material_;
+      std::vector<double>               low_field_n_;
+      std::vector<double>               low_field_p_;
+      std::vector<double>               field_;
+      std::vector<double>               evaluated_field_;
+
+      // neighbourhood in CSR format, indices refer to the cells of the mesh
+      std::vector<CellType const*>      mesh_cells_;
+      std::vector<double>               potential_;
+      std::vector<std::size_t>          cell_index_;
+      std::vector<std::size_t>          offsets_;
+      std::vector<std::size_t>          neighbours_;
+      std::vector<double>               inverse_distances_;
+  };
+
+} // viennamini
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef VIENNAMINI_MODELS_RECOMBINATION_HPP
+#define VIENNAMINI_MODELS_RECOMBINATION_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+#include <string>
+#include <vector>
+
+// ViennaFVM includes:
+#include "viennafvm/forwards.h"
+#include "viennafvm/volume_kernel.hpp"
+
+// ViennaMini includes:
+#include "viennamini/fwd.h"
+#include "viennamini/config.hpp"
+#include "viennamini/models/material_parameters.hpp"
+
+namespace viennamini
+{
+  /**
+      @brief Recombination parameters of one material in SI units. The defaults are silicon values,
+      the SRH trap level is assumed at the intrinsic level
+  */
+  struct recombination_parameters
+  {
+    recombination_parameters() :
+      intrinsic_density(1.0e16), electron_lifetime(1.0e-7), hole_lifetime(1.0e-7),
+      electron_auger(2.8e-43), hole_auger(9.9e-44) {}
+
+    double intrinsic_density;   // m^-3
+    double electron_lifetime;   // s
+    double hole_lifetime;       // s
+    double electron_auger;      // m^6/s
+    double hole_auger;          // m^6/s
+  };
+
+  /**
+      @brief Shockley-Read-Hall net recombination rate and its derivatives with respect to n and p
+  */
+  inline double srh_recombination(recombination_parameters const& par, double n, double p, double& dn, double& dp)
+  {
+    double ni = par.intrinsic_density;
+    double excess      = n * p - ni * ni;
+    double denominator = par.hole_lifetime * (n + ni) + par.electron_lifetime * (p + ni);
+    double inverse     = 1.0 / denominator;
+
+    dn = (p - excess * inverse * par.hole_lifetime)     * inverse;
+    dp = (n - excess * inverse * par.electron_lifetime) * inverse;
+    return excess * inverse;
+  }
+
+  /**
+      @brief Auger net recombination rate and its derivatives with respect to n and p
+  */
+  inline double auger_recombination(recombination_parameters const& par, double n, double p, double& dn, double& dp)
+  {
+    double ni = par.intrinsic_density;
+    double excess      = n * p - ni * ni;
+    double coefficient = par.electron_auger * n + par.hole_auger * p;
+
+    dn = par.electron_auger * excess + coefficient * p;
+    dp = par.hole_auger     * excess + coefficient * n;
+    return coefficient * excess;
+  }
+
+  /**
+      @brief Retrieves the recombination parameters of a material from the material library,
+      which holds cm based units. Missing parameters keep the silicon defaults
+  */
+  template<typename MatlibT>
+  recombination_parameters make_recombination_parameters(MatlibT& matlib, std::string const& material)
+  {
+    recombination_parameters par;
+    par.intrinsic_density = detail::material_value(matlib, material, "intrinsic_concentration", 1.0e+6,  par.intrinsic_density);
+    par.electron_lifetime = detail::material_value(matlib, material, "electron_lifetime",       1.0,     par.electron_lifetime);
+    par.hole_lifetime     = detail::material_value(matlib, material, "hole_lifetime",           1.0,     par.hole_lifetime);
+    par.electron_auger    = detail::material_value(matlib, material, "electron_auger",          1.0e-12, par.electron_auger);
+    par.hole_auger        = detail::material_value(matlib, material, "hole_auger",              1.0e-12, par.hole_auger);
+    return par;
+  }
+
+  /**
+      @brief Net recombination rate R of the enabled mechanisms as a compiled source of both continuity equations.
+      With the current sign convention of the continuity equations, div(J_n/q) = R and -div(J_p/q) = R,
+      so the same kernel is attached to both. The parameters are looked up per cell via the material
+      of its semiconductor segment; cells outside of the semiconductors do not recombine.
+  */
+  class recombination_model : public viennafvm::volume_kernel
+  {
+    public:
+      recombination_model() : srh_(false), auger_(false), electron_index_(0), hole_index_(1) {}
+
+      /**
+          @brief Collects the parameters of all semiconductor segments. Returns true if any mechanism is enabled
+      */
+      template<typename DeviceT, typename MatlibT>
+      bool setup(DeviceT& device, MatlibT& matlib, viennamini::config& config, long electron_id, long hole_id)
+      {
+        typedef typename DeviceT::indices_type                                                        IndicesType;
+        typedef typename DeviceT::segment_type                                                        SegmentType;
+        typedef typename viennagrid::result_of::cell_tag<SegmentType>::type                           CellTagType;
+        typedef typename viennagrid::result_of::const_element_range<SegmentType, CellTagType>::type   CellRangeType;
+        typedef typename viennagrid::result_of::iterator<CellRangeType>::type                         CellIteratorType;
+
+        srh_   = config.recombination_srh_state();
+        auger_ = config.recombination_auger_state();
+
+        quantities_.clear();
+        quantities_.push_back(electron_id);
+        quantities_.push_back(hole_id);
+
+        parameters_.clear();
+        material_of_cell_.clear();
+        if(!this->enabled()) return false;
+
+        IndicesType& semiconductor_segments = device.semiconductor_segments();
+        for(typename IndicesType::iterator iter = semiconductor_segments.begin();
+            iter != semiconductor_segments.end(); iter++)
+        {
+          parameters_.push_back(make_recombination_parameters(matlib, device.segment_materials()[*iter]));
+
+          CellRangeType cells(device.segment(*iter));
+          for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+          {
+            std::size_t id = static_cast<std::size_t>(cit->id().get());
+            if(id >= material_of_cell_.size())
+              material_of_cell_.resize(id+1, no_material());
+            material_of_cell_[id] = parameters_.size()-1;
+          }
+        }
+        return true;
+      }
+
+      bool enabled() const { return srh_ || auger_; }
+
+      viennafvm::numeric_type eval(long cell_id, viennafvm::numeric_type const * values, viennafvm::numeric_type * derivatives) const
+      {
+        derivatives[electron_index_] = 0;
+        derivatives[hole_index_]     = 0;
+
+        std::size_t id = static_cast<std::size_t>(cell_id);
+        if(id >= material_of_cell_.size() || material_of_cell_[id] == no_material())
+          return 0;
+
+        recombination_parameters const& par = parameters_[material_of_cell_[id]];
+        double n = values[electron_index_];
+        double p = values[hole_index_];
+        double dn, dp;
+        double rate = 0;
+
+        if(srh_)
+        {
+          rate += srh_recombination(par, n, p, dn, dp);
+          derivatives[electron_index_] += dn;
+          derivatives[hole_index_]     += dp;
+        }
+        if(auger_)
+        {
+          rate += auger_recombination(par, n, p, dn, dp);
+          derivatives[electron_index_] += dn;
+          derivatives[hole_index_]     += dp;
+        }
+        return rate;
+      }
+
+    private:
+      static std::size_t no_material() { return static_cast<std::size_t>(-1); }
+
+      bool                                  srh_;
+      bool                                  auger_;
+      std::size_t                           electron_index_;
+      std::size_t                           hole_index_;
+
+      std::vector<recombination_parameters> parameters_;        // per semiconductor segment
+      std::vector<std::size_t>              material_of_cell_;  // indexed by cell ID
+  };
+
+} // viennamini
+
+#endif
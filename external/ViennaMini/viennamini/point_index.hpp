@@ -0,0 +1,202 @@
+#ifndef VIENNAMINI_POINT_INDEX_HPP
+#define VIENNAMINI_POINT_INDEX_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+namespace viennamini
+{
+  namespace detail
+  {
+    /**
+        @brief Nearest neighbour search on a set of points via a uniform grid of buckets,
+        which holds about two points per bucket
+    */
+    class nearest_point_index
+    {
+      public:
+        nearest_point_index() : dimension_(0) {}
+
+        /** @brief Indexes the points of the given IDs, the coordinates of ID i start at points[i*dimension] */
+        void build(std::vector<double> const& points, std::size_t dimension, std::vector<std::size_t> const& ids)
+        {
+          points_    = &points;
+          dimension_ = dimension;
+          buckets_.clear();
+          offsets_.clear();
+          if(ids.empty()) return;
+
+          for(std::size_t d = 0; d < 3; d++)
+          {
+            min_[d] = 0; size_[d] = 1; width_[d] = 1;
+          }
+          for(std::size_t d = 0; d < dimension_; d++)
+          {
+            min_[d] = std::numeric_limits<double>::max();
+            double max = -std::numeric_limits<double>::max();
+            for(std::size_t i = 0; i < ids.size(); i++)
+            {
+              min_[d] = std::min(min_[d], coordinate(ids[i], d));
+              max     = std::max(max,     coordinate(ids[i], d));
+            }
+            width_[d] = max - min_[d];
+          }
+
+          // cubic buckets of equal volume, the degenerate directions of the bounding box get a single bucket
+          double volume = 1;
+          std::size_t extended = 0;
+          for(std::size_t d = 0; d < dimension_; d++)
+            if(width_[d] > 0) { volume *= width_[d]; extended++; }
+          double edge = extended ? std::pow(volume * 2.0 / ids.size(), 1.0 / extended) : 1;
+          for(std::size_t d = 0; d < dimension_; d++)
+          {
+            size_[d]  = (width_[d] > 0) ? std::max<std::size_t>(1, static_cast<std::size_t>(width_[d] / edge)) : 1;
+            width_[d] = (width_[d] > 0) ? width_[d] / size_[d] : 1;
+          }
+
+          // counting sort of the points into the buckets
+          std::vector<std::size_t> bucket_of_point(ids.size());
+          offsets_.assign(size_[0] * size_[1] * size_[2] + 1, 0);
+          for(std::size_t i = 0; i < ids.size(); i++)
+          {
+            std::size_t cell[3];
+            bucket_cell(&points[ids[i] * dimension_], cell);
+            bucket_of_point[i] = bucket_index(cell);
+            offsets_[bucket_of_point[i] + 1]++;
+          }
+          for(std::size_t b = 1; b < offsets_.size(); b++)
+            offsets_[b] += offsets_[b-1];
+
+          buckets_.resize(ids.size());
+          std::vector<std::size_t> position(offsets_.begin(), offsets_.end() - 1);
+          for(std::size_t i = 0; i < ids.size(); i++)
+            buckets_[position[bucket_of_point[i]]++] = ids[i];
+        }
+
+        bool empty() const { return buckets_.empty(); }
+
+        /** @brief Returns the ID of the point closest to x. The index must not be empty */
+        std::size_t nearest(double const* x) const
+        {
+          std::size_t id       = buckets_.front();
+          double      distance = 0;
+          nearest(x, 1, &id, &distance);
+          return id;
+        }
+
+        /**
+            @brief Finds the 'count' points closest to x, sorted by distance. Writes their IDs and squared distances
+            and returns how many have been found, which is less than 'count' only for smaller indices
+        */
+        std::size_t nearest(double const* x, std::size_t count, std::size_t* ids, double* squared_distances) const
+        {
+          std::size_t found = 0;
+          if(buckets_.empty() || count == 0) return found;
+
+          std::size_t center[3];
+          bucket_cell(x, center);
+
+          double      min_width     = std::min(width_[0], std::min(dimension_ > 1 ? width_[1] : width_[0], dimension_ > 2 ? width_[2] : width_[0]));
+          std::size_t max_size      = std::max(size_[0], std::max(size_[1], size_[2]));
+
+          // search shells of buckets around the bucket of x, until no closer point can be found
+          for(std::size_t ring = 0; ring <= max_size; ring++)
+          {
+            if(ring > 0 && found == count)
+            {
+              double reach = (ring - 1) * min_width;
+              if(reach * reach > squared_distances[found-1]) break;
+            }
+
+            std::size_t lower[3], upper[3];
+            for(std::size_t d = 0; d < 3; d++)
+            {
+              lower[d] = (center[d] >= ring) ? center[d] - ring : 0;
+              upper[d] = std::min(size_[d] - 1, center[d] + ring);
+            }
+
+            std::size_t cell[3];
+            for(cell[2] = lower[2]; cell[2] <= upper[2]; cell[2]++)
+              for(cell[1] = lower[1]; cell[1] <= upper[1]; cell[1]++)
+                for(cell[0] = lower[0]; cell[0] <= upper[0]; cell[0]++)
+                {
+                  // only the shell of this ring, the interior has been searched before
+                  bool on_shell = (ring == 0);
+                  for(std::size_t d = 0; d < 3; d++)
+                    on_shell = on_shell || (cell[d] + ring == center[d]) || (cell[d] == center[d] + ring);
+                  if(!on_shell) continue;
+
+                  std::size_t b = bucket_index(cell);
+                  for(std::size_t i = offsets_[b]; i < offsets_[b+1]; i++)
+                  {
+                    double distance = squared_distance(buckets_[i], x);
+                    if(found == count && distance >= squared_distances[found-1])
+                      continue;
+
+                    // insertion into the sorted list of the closest points
+                    std::size_t j = (found < count) ? found++ : found-1;
+                    for(; j > 0 && squared_distances[j-1] > distance; j--)
+                    {
+                      squared_distances[j] = squared_distances[j-1];
+                      ids[j]               = ids[j-1];
+                    }
+                    squared_distances[j] = distance;
+                    ids[j]               = buckets_[i];
+                  }
+                }
+          }
+          return found;
+        }
+
+      private:
+        double coordinate(std::size_t id, std::size_t d) const { return (*points_)[id * dimension_ + d]; }
+
+        double squared_distance(std::size_t id, double const* x) const
+        {
+          double result = 0;
+          for(std::size_t d = 0; d < dimension_; d++)
+            result += (coordinate(id, d) - x[d]) * (coordinate(id, d) - x[d]);
+          return result;
+        }
+
+        void bucket_cell(double const* x, std::size_t* cell) const
+        {
+          for(std::size_t d = 0; d < 3; d++)
+          {
+            cell[d] = 0;
+            if(d < dimension_ && x[d] > min_[d])
+              cell[d] = std::min(size_[d] - 1, static_cast<std::size_t>((x[d] - min_[d]) / width_[d]));
+          }
+        }
+
+        std::size_t bucket_index(std::size_t const* cell) const { return (cell[2] * size_[1] + cell[1]) * size_[0] + cell[0]; }
+
+        std::vector<double> const* points_;
+        std::size_t                dimension_;
+        double                     min_[3];
+        double                     width_[3];     // of a bucket
+        std::size_t                size_[3];      // number of buckets
+        std::vector<std::size_t>   offsets_;      // into buckets_, per bucket
+        std::vector<std::size_t>   buckets_;      // point IDs, sorted by bucket
+    };
+  }
+
+} // viennamini
+
+#endif
@@ -0,0 +1,469 @@
+#ifndef VIENNAMINI_REFINEMENT_HPP
+#define VIENNAMINI_REFINEMENT_HPP
+
+/* =======================================================================
+   Copyright (c) 2011-2013, Institute for Microelectronics, TU Wien
+   http://www.iue.tuwien.ac.at
+                             -----------------
+                 ViennaMini - The Vienna Device Simulator
+                             -----------------
+
+   authors:    Karl Rupp                          rupp@iue.tuwien.ac.at
+               Josef Weinbub                   weinbub@iue.tuwien.ac.at
+               (add your name here)
+
+   license:    see file LICENSE in the ViennaFVM base directory
+======================================================================= */
+
+/** @file refinement.hpp
+    @brief Adaptive mesh refinement driven by error indicators of a converged solution.
+
+    An adaptive run solves on the imported mesh, computes an error indicator per cell from the solution,
+    refines the cells with the largest indicators, and solves again on the refined mesh, starting from the
+    interpolated previous solution (see interpolated_solution_guess). adaptive_run drives these steps. The indicator of a cell is the largest
+    jump of the reconstructed cell gradients across its facets, which vanishes where the solution is linear
+    and is largest at junctions and in inversion channels.
+*/
+
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+#include <string>
+
+// ViennaFVM includes:
+#include "viennafvm/profiler.hpp"
+#include "viennafvm/solver_monitor.hpp"
+
+// ViennaGrid includes:
+#include "viennagrid/algorithm/csr_adjacency.hpp"
+#include "viennagrid/algorithm/refine.hpp"
+
+// ViennaMini includes:
+#include "viennamini/fwd.h"
+#include "viennamini/config.hpp"
+#include "viennamini/physics.hpp"
+#include "viennamini/initial_guess.hpp"
+
+namespace viennamini
+{
+  namespace detail
+  {
+    /**
+        @brief Solves the symmetric positive semi-definite system a x = b of dimension 1 to 3 by Gaussian elimination,
+        a and b are overwritten. Returns false if the system is singular relative to its diagonal
+    */
+    inline bool solve_small_system(double a[3][3], double b[3], std::size_t dim)
+    {
+      double scale = 0;
+      for(std::size_t i = 0; i < dim; i++)
+        scale = std::max(scale, a[i][i]);
+      if(scale <= 0) return false;
+
+      for(std::size_t k = 0; k < dim; k++)
+      {
+        std::size_t pivot = k;
+        for(std::size_t i = k+1; i < dim; i++)
+          if(std::abs(a[i][k]) > std::abs(a[pivot][k]))
+            pivot = i;
+        if(std::abs(a[pivot][k]) < 1.0e-10 * scale)
+          return false;
+
+        std::swap(b[k], b[pivot]);
+        for(std::size_t j = 0; j < dim; j++)
+          std::swap(a[k][j], a[pivot][j]);
+
+        for(std::size_t i = k+1; i < dim; i++)
+        {
+          double factor = a[i][k] / a[k][k];
+          for(std::size_t j = k; j < dim; j++)
+            a[i][j] -= factor * a[k][j];
+          b[i] -= factor * b[k];
+        }
+      }
+
+      for(std::size_t k = dim; k-- > 0; )
+      {
+        for(std::size_t j = k+1; j < dim; j++)
+          b[k] -= a[k][j] * b[j];
+        b[k] /= a[k][k];
+      }
+      return true;
+    }
+
+    /** @brief Marker for cells which do not take part in the error indicators */
+    inline std::size_t no_group() { return static_cast<std::size_t>(-1); }
+
+    /**
+        @brief Groups the cells by the material of their segment, indexed by cell ID. Gradients are only
+        reconstructed within a group, as the potential gradient jumps at material interfaces by the ratio
+        of the permittivities. Contacts form no group, as their values are boundary conditions
+    */
+    template<typename DeviceT>
+    void material_groups(DeviceT& device, std::vector<std::size_t>& groups)
+    {
+      typedef typename DeviceT::segment_type                                                        SegmentType;
+      typedef typename DeviceT::segmentation_type                                                   SegmentationType;
+      typedef typename DeviceT::indices_type                                                        IndicesType;
+      typedef typename viennagrid::result_of::cell_tag<SegmentType>::type                           CellTagType;
+      typedef typename viennagrid::result_of::const_element_range<SegmentType, CellTagType>::type   CellRangeType;
+      typedef typename viennagrid::result_of::iterator<CellRangeType>::type                         CellIteratorType;
+
+      IndicesType& contacts = device.contact_segments();
+      std::map<std::string, std::size_t> group_of_material;
+
+      groups.clear();
+      for(typename SegmentationType::iterator sit = device.segments().begin(); sit != device.segments().end(); ++sit)
+      {
+        std::size_t si = static_cast<std::size_t>(sit->id());
+        if(std::find(contacts.begin(), contacts.end(), si) != contacts.end())
+          continue;
+
+        std::string const& material = device.segment_materials()[si];
+        std::size_t group = group_of_material.insert(std::make_pair(material, group_of_material.size())).first->second;
+
+        CellRangeType cells(*sit);
+        for(CellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        {
+          std::size_t id = static_cast<std::size_t>(cit->id().get());
+          if(id >= groups.size())
+            groups.resize(id+1, no_group());
+          groups[id] = group;
+        }
+      }
+    }
+  }
+
+  /**
+      @brief Computes the error indicators of a solution per cell ID, in volts.
+
+      The potential and, scaled by the thermal voltage, the logarithms of the carrier densities are reconstructed
+      as linear functions in each cell by a least squares fit to the values of the neighbour cells. Across each
+      facet, the difference of the reconstructed gradients along the line between the cell centroids estimates
+      twice the deviation of the solution from a linear function, and half of it is the contribution to both
+      cells. The indicator of a cell is the largest contribution over its facets and the three quantities.
+      The snapshot has to be taken on the mesh of the device; returns false otherwise
+  */
+  template<typename DeviceT>
+  bool refinement_indicators(DeviceT& device, solution_snapshot const& snapshot, double thermal_voltage,
+                             std::vector<double>& indicators)
+  {
+    typedef typename DeviceT::mesh_type                                   MeshType;
+    typedef typename viennagrid::result_of::point<MeshType>::type         PointType;
+    typedef viennagrid::csr_adjacency::index_array_type                   IndexArrayType;
+
+    if(!detail::same_mesh(device, snapshot) || snapshot.dimension != static_cast<std::size_t>(PointType::dim))
+      return false;
+
+    const std::size_t dim = snapshot.dimension;
+
+    std::vector<std::size_t> groups;
+    detail::material_groups(device, groups);
+
+    viennagrid::csr_adjacency adjacency(device.mesh());
+    IndexArrayType const& cell_ids          = adjacency.cell_ids();
+    IndexArrayType const& neighbour_offsets = adjacency.cell_neighbor_offsets();
+    IndexArrayType const& neighbours        = adjacency.neighbors();
+    const std::size_t cell_count = cell_ids.size();
+
+    indicators.assign(snapshot.cell_count(), 0);
+
+    std::vector<double> values(cell_count);
+    std::vector<double> gradients(cell_count * 3);
+    std::vector<bool>   valid(cell_count);
+    for(std::size_t q = 0; q < solution_snapshot::quantity_count; q++)
+    {
+      // carrier densities vary exponentially, their logarithms like the potential
+      for(std::size_t i = 0; i < cell_count; i++)
+      {
+        double value = snapshot.values[q][cell_ids[i]];
+        values[i] = (q == solution_snapshot::potential) ? value : thermal_voltage * std::log(std::max(value, 1.0));
+      }
+
+      for(std::size_t i = 0; i < cell_count; i++)
+      {
+        std::size_t id = cell_ids[i];
+        valid[i] = false;
+        if(groups.size() <= id || groups[id] == detail::no_group() || !snapshot.enabled[q][id])
+          continue;
+
+        double a[3][3] = { {0, 0, 0}, {0, 0, 0}, {0, 0, 0} };
+        double b[3]    = { 0, 0, 0 };
+        for(std::size_t k = neighbour_offsets[i]; k < neighbour_offsets[i+1]; k++)
+        {
+          std::size_t j  = neighbours[k];
+          std::size_t jd = cell_ids[j];
+          if(groups.size() <= jd || groups[jd] != groups[id] || !snapshot.enabled[q][jd])
+            continue;
+
+          double d[3];
+          for(std::size_t r = 0; r < dim; r++)
+            d[r] = snapshot.centroids[jd * dim + r] - snapshot.centroids[id * dim + r];
+          for(std::size_t r = 0; r < dim; r++)
+          {
+            for(std::size_t c = 0; c < dim; c++)
+              a[r][c] += d[r] * d[c];
+            b[r] += d[r] * (values[j] - values[i]);
+          }
+        }
+
+        // cells with too few neighbours in their group, e.g. in the corners of a segment, have no gradient
+        if(!detail::solve_small_system(a, b, dim))
+          continue;
+        for(std::size_t r = 0; r < dim; r++)
+          gradients[i * 3 + r] = b[r];
+        valid[i] = true;
+      }
+
+      for(std::size_t i = 0; i < cell_count; i++)
+      {
+        if(!valid[i]) continue;
+        std::size_t id = cell_ids[i];
+        for(std::size_t k = neighbour_offsets[i]; k < neighbour_offsets[i+1]; k++)
+        {
+          std::size_t j  = neighbours[k];
+          std::size_t jd = cell_ids[j];
+          if(j < i || !valid[j] || groups[jd] != groups[id])   // each facet once
+            continue;
+
+          double jump = 0;
+          for(std::size_t r = 0; r < dim; r++)
+            jump += (gradients[j * 3 + r] - gradients[i * 3 + r]) * (snapshot.centroids[jd * dim + r] - snapshot.centroids[id * dim + r]);
+          jump = 0.5 * std::abs(jump);
+
+          indicators[id] = std::max(indicators[id], jump);
+          indicators[jd] = std::max(indicators[jd], jump);
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+      @brief Marks the given fraction of all cells with the largest indicators for refinement, leaving out cells whose
+      indicator does not exceed the tolerance. The marks are indexed by cell ID. Returns the number of marked cells
+  */
+  inline std::size_t mark_for_refinement(std::vector<double> const& indicators, double fraction, double tolerance,
+                                         std::vector<bool>& marks)
+  {
+    marks.assign(indicators.size(), false);
+
+    std::vector<double> candidates;
+    for(std::size_t id = 0; id < indicators.size(); id++)
+      if(indicators[id] > tolerance)
+        candidates.push_back(indicators[id]);
+
+    std::size_t count = std::min(candidates.size(),
+                                 static_cast<std::size_t>(std::ceil(std::max(0.0, fraction) * indicators.size())));
+    if(count == 0) return 0;
+
+    std::nth_element(candidates.begin(), candidates.begin() + (count-1), candidates.end(), std::greater<double>());
+    double threshold = candidates[count-1];
+
+    std::size_t marked = 0;
+    for(std::size_t id = 0; id < indicators.size() && marked < count; id++)
+      if(indicators[id] > tolerance && indicators[id] >= threshold)
+      {
+        marks[id] = true;
+        marked++;
+      }
+    return marked;
+  }
+
+  /**
+      @brief Refines the marked cells of the mesh and segmentation of a device into a new mesh and segmentation.
+      All edges of a marked cell are bisected, and so is the longest edge of every cell with a bisected edge,
+      which keeps the angles of the refined cells bounded. Neighbour cells are split along the bisected edges,
+      so the refined mesh is conforming, and its segments carry the IDs of the original ones
+  */
+  template<typename DeviceT>
+  void refine_marked(DeviceT& device, std::vector<bool> const& marks,
+                     typename DeviceT::mesh_type& mesh_out, typename DeviceT::segmentation_type& segments_out)
+  {
+    typedef typename DeviceT::mesh_type                                   MeshType;
+    typedef typename viennagrid::result_of::cell_tag<MeshType>::type      CellTagType;
+    typedef typename viennagrid::result_of::cell<MeshType>::type          CellType;
+    typedef typename viennagrid::result_of::line<MeshType>::type          EdgeType;
+
+    std::deque<bool> cell_flags(viennagrid::id_upper_bound<CellType>(device.mesh()).get(), false);
+    for(std::size_t id = 0; id < std::min(marks.size(), cell_flags.size()); id++)
+      cell_flags[id] = marks[id];
+
+    std::deque<bool> edge_flags(viennagrid::id_upper_bound<EdgeType>(device.mesh()).get(), false);
+    viennagrid::cell_refinement_to_edge_refinement<CellTagType>(device.mesh(),
+                                                                viennagrid::make_accessor<CellType>(cell_flags),
+                                                                viennagrid::make_accessor<EdgeType>(edge_flags));
+    viennagrid::ensure_longest_edge_refinement<CellTagType>(device.mesh(), viennagrid::make_accessor<EdgeType>(edge_flags));
+
+    viennagrid::refine<CellTagType>(device.mesh(), device.segments(), mesh_out, segments_out,
+                                    viennagrid::make_accessor<EdgeType>(edge_flags));
+  }
+
+  /**
+      @brief Assigns the segment setup of a device (names, materials, roles and doping) to a device on a refined mesh
+      with the same segment IDs. Doping profiles are shared, not copied
+  */
+  template<typename DeviceT>
+  void copy_device_setup(DeviceT& source, DeviceT& target)
+  {
+    typedef typename DeviceT::indexkeys_type    IndexKeysType;
+    typedef typename DeviceT::indices_type      IndicesType;
+
+    for(typename IndexKeysType::iterator iter = source.segment_names().begin(); iter != source.segment_names().end(); iter++)
+      target.assign_name(iter->first, iter->second);
+    for(typename IndexKeysType::iterator iter = source.segment_materials().begin(); iter != source.segment_materials().end(); iter++)
+      target.assign_material(iter->first, iter->second);
+
+    for(typename IndicesType::iterator iter = source.contact_segments().begin(); iter != source.contact_segments().end(); iter++)
+      target.assign_contact(*iter);
+    for(typename IndicesType::iterator iter = source.oxide_segments().begin(); iter != source.oxide_segments().end(); iter++)
+      target.assign_oxide(*iter);
+    for(typename IndicesType::iterator iter = source.semiconductor_segments().begin(); iter != source.semiconductor_segments().end(); iter++)
+    {
+      target.assign_semiconductor(*iter, source.donator(*iter), source.acceptor(*iter));
+      if(source.donator_profile(*iter) || source.acceptor_profile(*iter))
+        target.assign_doping_profiles(*iter, source.donator_profile(*iter), source.acceptor_profile(*iter));
+    }
+  }
+
+  /**
+      @brief A device on a refinement of the mesh of another device, which owns its mesh, segmentation and storage.
+      The source device is only needed during construction
+  */
+  template<typename DeviceT>
+  class refined_device
+  {
+      typedef typename DeviceT::mesh_type           MeshType;
+      typedef typename DeviceT::segmentation_type   SegmentationType;
+      typedef typename DeviceT::storage_type        StorageType;
+
+    public:
+      refined_device(DeviceT& source, std::vector<bool> const& marks) : segments_(mesh_), device_(mesh_, segments_, storage_)
+      {
+        refine_marked(source, marks, mesh_, segments_);
+        copy_device_setup(source, device_);
+      }
+
+      DeviceT& device() { return device_; }
+
+    private:
+      refined_device(refined_device const&);
+      refined_device& operator=(refined_device const&);
+
+      MeshType          mesh_;
+      SegmentationType  segments_;
+      StorageType       storage_;
+      DeviceT           device_;
+  };
+
+  /**
+      @brief The adaptive refinement steps after the solve of a device, as configured by config::refinement_steps(),
+      refinement_fraction() and refinement_tolerance(). Each step refines the cells with the largest indicators of
+      the last solution and solves again, starting from the interpolated solution. The steps stop early if a solve
+      does not converge or is cancelled, or if no cell is marked. Transient runs are not refined.
+      A refined level is released once the next one has taken over its solution
+  */
+  template<typename DeviceT, typename SimulatorT>
+  class adaptive_run
+  {
+      typedef typename SimulatorT::MatlibType   MatlibType;
+
+      /** @brief A refinement of the device of the previous solve, with a simulator which starts from the previous solution */
+      struct level
+      {
+        level(DeviceT& device, std::vector<bool> const& marks, solution_snapshot const& solution,
+              MatlibType& matlib, viennamini::config& config) :
+          refined(device, marks), guess(solution), sim(refined.device(), matlib, config)
+        {
+          sim.set_initial_guess_provider(&guess);
+        }
+
+        refined_device<DeviceT>               refined;
+        interpolated_solution_guess<DeviceT>  guess;
+        SimulatorT                            sim;
+      };
+
+    public:
+      /** @brief The simulator has to be run on the device before operator() */
+      adaptive_run(DeviceT& device, SimulatorT& sim, MatlibType& matlib, viennamini::config& config) :
+        device_(device), sim_(sim), matlib_(matlib), config_(config), monitor_(NULL), steps_(0) {}
+
+      /** @brief Attaches a monitor to the simulators of the refined levels, e.g. the one of the initial solve */
+      void set_monitor(viennafvm::solver_monitor* monitor) { monitor_ = monitor; }
+
+      /** @brief Performs the refinement steps, returns the number of solves on refined meshes */
+      std::size_t operator()()
+      {
+        if(config_.transient_state()) return steps_;
+
+        for(int step = 1; step <= config_.refinement_steps() && simulator().converged() && !simulator().cancelled(); step++)
+        {
+          std::auto_ptr<level> next;
+          {
+            viennafvm::profiler::scope profile("refinement");
+
+            solution_snapshot   solution;
+            std::vector<double> indicators;
+            std::vector<bool>   marks;
+            simulator().capture_solution(solution);
+            refinement_indicators(device(), solution, get_thermal_potential(config_.temperature()), indicators);
+            std::size_t marked = mark_for_refinement(indicators, config_.refinement_fraction(), config_.refinement_tolerance(), marks);
+
+            std::cout << "* refinement step " << step << ": " << marked << " of " << indicators.size() << " cells marked, largest indicator "
+                      << (indicators.empty() ? 0.0 : *std::max_element(indicators.begin(), indicators.end())) << " V" << std::endl;
+            if(marked == 0) break;
+
+            next.reset(new level(device(), marks, solution, matlib_, config_));
+            next->sim.set_monitor(monitor_);
+          }
+          next->sim();
+
+          level_ = next;
+          steps_++;
+        }
+        return steps_;
+      }
+
+      /** @brief The number of solves on refined meshes */
+      std::size_t steps() const { return steps_; }
+
+      /** @brief The device of the last solve, the initial one if no refinement step has been performed */
+      DeviceT&    device()    { return level_.get() ? level_->refined.device() : device_; }
+
+      /** @brief The simulator of the last solve */
+      SimulatorT& simulator() { return level_.get() ? level_->sim : sim_; }
+
+      /**
+          @brief Writes the solution of the last solve, interpolated by the nearest cell centroids, to the current iterates
+          of the initial device, e.g. to show it on the imported mesh. Returns false if there is no refined solution
+      */
+      bool interpolate_to_initial_device()
+      {
+        if(!level_.get()) return false;
+
+        solution_snapshot solution;
+        level_->sim.capture_solution(solution);
+        interpolated_solution_guess<DeviceT> guess(solution);
+        return guess(device_, sim_.quantity_potential().id(), sim_.quantity_electron_density().id(), sim_.quantity_hole_density().id());
+      }
+
+    private:
+      adaptive_run(adaptive_run const&);
+      adaptive_run& operator=(adaptive_run const&);
+
+      DeviceT                   & device_;
+      SimulatorT                & sim_;
+      MatlibType                & matlib_;
+      viennamini::config        & config_;
+      viennafvm::solver_monitor * monitor_;
+      std::auto_ptr<level>        level_;
+      std::size_t                 steps_;
+  };
+
+} // viennamini
+
+#endif
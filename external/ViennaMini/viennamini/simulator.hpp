@@ -32,6 +32,8 @@
 #include "viennafvm/io/vtk_writer.hpp"
 #include "viennafvm/boundary.hpp"
 #include "viennafvm/pde_solver.hpp"
+#include "viennafvm/transient_solver.hpp"
+#include "viennafvm/profiler.hpp"
 #include "viennafvm/initial_guess.hpp"
 #ifdef VIENNACL_WITH_OPENCL
 #include "viennafvm/viennacl_support.hpp"
@@ -41,7 +43,7 @@
 #include "viennagrid/config/default_configs.hpp"
 #include "viennagrid/io/netgen_reader.hpp"
 #include "viennagrid/io/vtk_writer.hpp"
-#include "viennagrid/algorithm/interface.hpp"
+#include "viennagrid/algorithm/segment_interface_map.hpp"
 #include "viennagrid/algorithm/voronoi.hpp"
 #include "viennagrid/algorithm/scale.hpp"
 
@@ -65,9 +67,28 @@
 #include "viennamini/config.hpp"
 #include "viennamini/device.hpp"
 #include "viennamini/result_accessor.hpp"
+#include "viennamini/initial_guess.hpp"
+#include "viennamini/doping.hpp"
+#include "viennamini/refinement.hpp"
+#include "viennamini/models/mobility.hpp"
+#include "viennamini/models/recombination.hpp"
 
 namespace viennamini
 {
+    /**
+        @brief Wall clock times of the phases of the last simulator run, in seconds
+    */
+    struct simulator_timings
+    {
+        simulator_timings() : interface_detection(0), prepare(0), diagnostics(0), solve(0) {}
+
+        double                      interface_detection;
+        double                      prepare;
+        double                      diagnostics;    // writing the doping and initial guess vtk files
+        double                      solve;
+        viennafvm::solver_timings   solver;         // breakdown of 'solve'
+    };
+
     template<typename DeviceT, typename MatlibT>
     class simulator
     {
@@ -94,6 +115,7 @@ namespace viennamini
 
         typedef viennafvm::linsolv::viennacl                                                    LinerSolverType;
         typedef viennafvm::pde_solver<>                                                         PDESolverType;
+        typedef viennafvm::transient_solver<>                                                   TransientSolverType;
         typedef viennafvm::linear_pde_system<>                                                  PDESystemType;
         typedef viennafvm::boundary_key                                                         BoundaryKeyType;
         typedef viennafvm::current_iterate_key                                                  IterateKeyType;
@@ -101,6 +123,10 @@ namespace viennamini
 
         typedef boost::numeric::ublas::vector<NumericType>                                      VectorType;
         typedef std::map<std::size_t, std::size_t>                                              IndexMapType;
+        typedef std::map<std::size_t, NumericType>                                              SegmentValuesType;
+        typedef viennagrid::segment_interface_map<SegmentationType>                             InterfaceMapType;
+        typedef viennamini::initial_guess_provider<DeviceT>                                     InitialGuessProviderType;
+        typedef viennamini::doping_cache                                                        DopingCacheType;
 
 
         /**
@@ -142,7 +168,8 @@ namespace viennamini
             @brief Method identifies for a given segment under test whether it
             shares an interface with a reference contact segment
         */
-        int find_adjacent_segment(SegmentType & current_contact_segment,
+        int find_adjacent_segment(InterfaceMapType const & interfaces,
+                                  std::size_t contact_segment_index,
                                   IndicesType & segments_under_test);
 
 
@@ -151,7 +178,7 @@ namespace viennamini
             1. assign dirichlet boundary conditions
             2. disable obsolete quantities
             3. assign initial guesses
-            4. smooth initial guesses
+            4. smooth initial guesses, unless a provider has taken over the initial guesses
         */
         void prepare();
 
@@ -165,6 +192,12 @@ namespace viennamini
         */
         bool isContactSemiconductorInterface(std::size_t contact_segment_index);
 
+        /**
+            @brief Sets the potential of a contact to the contact value plus its workfunction and,
+            for contacts to semiconductors, the built-in potential of the doping at each contact cell
+        */
+        void assign_contact_potential(std::size_t contact_segment, NumericType contact_value);
+
         void add_drift_diffusion();
 
         /**
@@ -173,6 +206,12 @@ namespace viennamini
         */
         void run();
 
+        /**
+            @brief Switches the contacts and integrates the drift-diffusion system in time,
+            starting from the stationary solution
+        */
+        void run_transient();
+
     public:
         FunctionSymbolType quantity_potential()        const;
         FunctionSymbolType quantity_electron_density() const;
@@ -180,6 +219,60 @@ namespace viennamini
 
         VectorType const& result();
 
+        /**
+            @brief Attaches an observer to the PDE solver, which receives progress
+            reports and may cancel the simulation between linear solves
+        */
+        void set_monitor(viennafvm::solver_monitor* monitor);
+
+        /**
+            @brief Attaches an observer which receives each accepted step of a transient run
+        */
+        void set_transient_observer(viennafvm::transient_observer* observer);
+
+        /**
+            @brief Attaches a provider of initial guesses, e.g. the solution of a previous run.
+            If it provides a guess, the doping based initial guesses are not smoothed
+        */
+        void set_initial_guess_provider(InitialGuessProviderType* provider);
+
+        /**
+            @brief Uses the given doping cache instead of the simulator's own one, e.g. one kept by the caller
+            across simulators for the same device. NULL reverts to the own cache
+        */
+        void set_doping_cache(DopingCacheType* cache);
+
+        /**
+            @brief Stores the current solution, e.g. for the initial guess of a later run
+        */
+        void capture_solution(solution_snapshot& snapshot);
+
+        /**
+            @brief Returns the step statistics of the last transient run
+        */
+        viennafvm::transient_statistics const& transient_statistics() const;
+
+        /**
+            @brief Returns true if the last run has been cancelled by the monitor
+        */
+        bool cancelled() const;
+
+        /**
+            @brief Returns true if the last run reached the nonlinear break tolerance,
+            for transient runs in each step up to the end time
+        */
+        bool converged() const;
+
+        /**
+            @brief Returns the number of nonlinear iterations of the last run
+        */
+        std::size_t required_nonlinear_iterations() const;
+
+        /**
+            @brief Returns the phase timings of the last run
+        */
+        simulator_timings const& timings() const;
+
     private:
         DeviceType            & device_;
         MatlibType            & matlib_;
@@ -188,10 +281,19 @@ namespace viennamini
         PDESystemType           pde_system_;
         PDESolverType           pde_solver_;
         LinerSolverType         linear_solver_;
+        TransientSolverType     transient_solver_;
 
         IndexMapType contactSemiconductorInterfaces_;
         IndexMapType contactOxideInterfaces_;
 
+        bool              transient_completed_;
+
+        InitialGuessProviderType* initial_guess_provider_;
+
+        // the doping per cell, kept for later runs on the same mesh and doping
+        DopingCacheType           own_doping_;
+        DopingCacheType*          doping_;
+
         viennamini::permittivity_key       eps_key_;
         viennamini::builtin_potential_key  builtin_key_;
         viennamini::donator_doping_key     ND_key_;
@@ -205,7 +307,12 @@ namespace viennamini
         QuantityType  mu_n_;
         QuantityType  mu_p_;
 
+        viennamini::mobility_model<DeviceT> mobility_;
+        viennamini::recombination_model     recombination_;
+
         int notfound_;
+
+        simulator_timings timings_;
     };
 }
 
@@ -26,19 +26,32 @@
  *
  */
 
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+
 #include <vtkSmartPointer.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkStructuredGrid.h>
 #include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
 #include <vtkAssignAttribute.h>
 #include <vtkPointData.h>
 #include <vtkCellData.h>
 #include <vtkTetra.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
 
 #include "common.hpp"
 #include "device.hpp"
 #include "multiview.h"
 #include "quantity.h"
+#include "result_sequence.hpp"
 
 #include "boost/lexical_cast.hpp"
 
@@ -147,6 +160,41 @@ struct viennagrid_domain {};
 //    }
 //}
 
+/**
+ * @brief Writes the values of the given elements straight into the contiguous buffer of a VTK array.
+ * If the attribute container already holds a scalar double array of this name and size, its buffer is
+ * overwritten in place, so render views sharing the array see the new values without further copies.
+ * Otherwise, a new array is allocated and replaces the old one in a single pointer swap.
+ */
+template<typename ElementRangeT, typename AccessorT>
+inline void copy(ElementRangeT& elements, AccessorT& accessor, std::string const& name, vtkDataSetAttributes* attributes)
+{
+  typedef typename viennagrid::result_of::iterator<ElementRangeT>::type   ElementIterator;
+
+  vtkIdType size = static_cast<vtkIdType>(elements.size());
+
+  vtkSmartPointer<vtkDoubleArray> render_data = vtkDoubleArray::SafeDownCast(attributes->GetArray(name.c_str()));
+  bool reuse = render_data && (render_data->GetNumberOfComponents() == 1) && (render_data->GetNumberOfTuples() == size);
+  if(!reuse)
+  {
+    render_data = vtkSmartPointer<vtkDoubleArray>::New();
+    render_data->SetName(name.c_str());
+    render_data->SetNumberOfValues(size);
+  }
+
+  double* buffer = render_data->GetPointer(0);
+  for(ElementIterator it = elements.begin(); it != elements.end(); it++)
+  {
+    *buffer++ = accessor(*it);
+  }
+  render_data->Modified();
+
+  // AddArray replaces a previous array with the same name
+  //
+  if(!reuse)
+    attributes->AddArray(render_data);
+}
+
 template<typename DeviceT>
 inline void copy(DeviceT& device, Quantity const& quantity, MultiView* multiview)
 {
@@ -160,9 +208,7 @@ inline void copy(DeviceT& device, Quantity const& quantity, MultiView* multiview
   typedef typename viennagrid::result_of::element<DomainType, CellTag>::type                          CellType;
   typedef typename viennagrid::result_of::element<SegmentType, viennagrid::vertex_tag>::type          VertexType;
   typedef typename viennagrid::result_of::element_range<SegmentType, viennagrid::vertex_tag>::type    VertexRange;
-  typedef typename viennagrid::result_of::iterator<VertexRange>::type                                 VertexIterator;
   typedef typename viennagrid::result_of::element_range<SegmentType, CellTag>::type                   CellRange;
-  typedef typename viennagrid::result_of::iterator<CellRange>::type                                   CellIterator;
 
   MultiView::MultiGrid   multigrid = multiview->getGrid();
   SegmentationType     & segments  = device.getSegmentation();
@@ -177,22 +223,8 @@ inline void copy(DeviceT& device, Quantity const& quantity, MultiView* multiview
     for(SegmentationIteratorType sit = segments.begin(); sit != segments.end(); sit++)
     {
       VertexRange vertices = viennagrid::elements<VertexType>(*sit);
-      vtkSmartPointer<vtkDoubleArray> render_data = vtkSmartPointer<vtkDoubleArray>::New();
-      render_data->SetName(quantity.name.c_str());
-      render_data->SetNumberOfValues(vertices.size());
-
-      std::size_t i = 0;
-      for(VertexIterator vit = vertices.begin(); vit != vertices.end(); vit++)
-      {
-        render_data->SetValue(i++, accessor(*vit));
-      }
-
       vtkPointSet* generic_segment = vtkPointSet::SafeDownCast(multigrid->GetBlock(si));
-
-      if(generic_segment->GetPointData()->HasArray(quantity.name.c_str()))
-          generic_segment->GetPointData()->RemoveArray(quantity.name.c_str());
-      generic_segment->GetPointData()->AddArray(render_data);
-
+      viennamos::copy(vertices, accessor, quantity.name, generic_segment->GetPointData());
       si++;
     }
   }
@@ -206,33 +238,216 @@ inline void copy(DeviceT& device, Quantity const& quantity, MultiView* multiview
     for(SegmentationIteratorType sit = segments.begin(); sit != segments.end(); sit++)
     {
       CellRange cells = viennagrid::elements<CellType>(*sit);
-      vtkSmartPointer<vtkDoubleArray> render_data = vtkSmartPointer<vtkDoubleArray>::New();
-      render_data->SetName(quantity.name.c_str());
-      render_data->SetNumberOfValues(cells.size());
+      vtkPointSet* generic_segment = vtkPointSet::SafeDownCast(multigrid->GetBlock(si));
+      viennamos::copy(cells, accessor, quantity.name, generic_segment->GetCellData());
+      si++;
+    }
+  }
 
-      std::size_t i = 0;
+  // let the render views know that only this array has changed
+  //
+  multiview->quantityModified(quantity.name);
+}
+
+/**
+ * @brief Extracts the per-segment values of a scalar quantity into a result sequence frame,
+ * using the same segment-local ordering as the render arrays
+ */
+template<typename DeviceT>
+inline void copy(DeviceT& device, Quantity const& quantity, ResultSequence::Frame& frame)
+{
+  typedef typename DeviceT::CellComplex                   DomainType;
+  typedef typename DeviceT::Segmentation                  SegmentationType;
+  typedef typename DeviceT::QuantityComplex               QuantityComplexType;
+  typedef typename SegmentationType::iterator             SegmentationIteratorType;
+  typedef typename SegmentationType::segment_handle_type  SegmentType;
+
+  typedef typename viennagrid::result_of::cell_tag<DomainType>::type                                  CellTag;
+  typedef typename viennagrid::result_of::element<DomainType, CellTag>::type                          CellType;
+  typedef typename viennagrid::result_of::element<SegmentType, viennagrid::vertex_tag>::type          VertexType;
+  typedef typename viennagrid::result_of::element_range<SegmentType, viennagrid::vertex_tag>::type    VertexRange;
+  typedef typename viennagrid::result_of::iterator<VertexRange>::type                                 VertexIterator;
+  typedef typename viennagrid::result_of::element_range<SegmentType, CellTag>::type                   CellRange;
+  typedef typename viennagrid::result_of::iterator<CellRange>::type                                   CellIterator;
+
+  SegmentationType & segments = device.getSegmentation();
+
+  frame.clear();
+  frame.resize(segments.size());
+
+  if((quantity.cell_level == VERTEX) && (quantity.tensor_level == SCALAR))
+  {
+    typedef typename viennadata::result_of::accessor<QuantityComplexType, Quantity, double, VertexType>::type TargetAccessorType;
+    TargetAccessorType accessor = viennadata::make_accessor(device.getQuantityComplex(), quantity);
+
+    std::size_t si = 0;
+    for(SegmentationIteratorType sit = segments.begin(); sit != segments.end(); sit++, si++)
+    {
+      VertexRange vertices = viennagrid::elements<VertexType>(*sit);
+      frame[si].reserve(vertices.size());
+      for(VertexIterator vit = vertices.begin(); vit != vertices.end(); vit++)
+        frame[si].push_back(accessor(*vit));
+    }
+  }
+  else
+  if((quantity.cell_level == CELL) && (quantity.tensor_level == SCALAR))
+  {
+    typedef typename viennadata::result_of::accessor<QuantityComplexType, Quantity, double, CellType>::type TargetAccessorType;
+    TargetAccessorType accessor = viennadata::make_accessor(device.getQuantityComplex(), quantity);
+
+    std::size_t si = 0;
+    for(SegmentationIteratorType sit = segments.begin(); sit != segments.end(); sit++, si++)
+    {
+      CellRange cells = viennagrid::elements<CellType>(*sit);
+      frame[si].reserve(cells.size());
       for(CellIterator cit = cells.begin(); cit != cells.end(); cit++)
-      {
-        render_data->SetValue(i++, accessor(*cit));
-      }
+        frame[si].push_back(accessor(*cit));
+    }
+  }
+}
 
-      vtkPointSet* generic_segment = vtkPointSet::SafeDownCast(multigrid->GetBlock(si));
+/**
+ * @brief Transfers a result sequence frame of a scalar quantity to the render arrays of the central multi-block datastructure
+ */
+inline void copy(ResultSequence::Frame const& frame, Quantity const& quantity, MultiView* multiview)
+{
+  MultiView::MultiGrid multigrid = multiview->getGrid();
 
-      if(generic_segment->GetCellData()->HasArray(quantity.name.c_str()))
-          generic_segment->GetCellData()->RemoveArray(quantity.name.c_str());
-      generic_segment->GetCellData()->AddArray(render_data);
+  for(std::size_t si = 0; (si < frame.size()) && (si < multigrid->GetNumberOfBlocks()); si++)
+  {
+    vtkPointSet* generic_segment = vtkPointSet::SafeDownCast(multigrid->GetBlock(si));
 
-      si++;
+    vtkDataSetAttributes* attributes;
+    if(quantity.cell_level == VERTEX)     attributes = generic_segment->GetPointData();
+    else
+    if(quantity.cell_level == CELL)       attributes = generic_segment->GetCellData();
+    else return;
+
+    ResultSequence::Values const& values = frame[si];
+    vtkIdType size = static_cast<vtkIdType>(values.size());
+
+    vtkSmartPointer<vtkDoubleArray> render_data = vtkDoubleArray::SafeDownCast(attributes->GetArray(quantity.name.c_str()));
+    bool reuse = render_data && (render_data->GetNumberOfComponents() == 1) && (render_data->GetNumberOfTuples() == size);
+    if(!reuse)
+    {
+      render_data = vtkSmartPointer<vtkDoubleArray>::New();
+      render_data->SetName(quantity.name.c_str());
+      render_data->SetNumberOfValues(size);
     }
+    if(size > 0)
+      std::copy(values.begin(), values.end(), render_data->GetPointer(0));
+    render_data->Modified();
+
+    if(!reuse)
+      attributes->AddArray(render_data);
   }
+
+  multiview->quantityModified(quantity.name);
 }
 
+namespace detail {
+
+/**
+ * @brief Fills the preallocated point coordinates and cell connectivity of one segment's vtk grid.
+ * The jobs of different segments run concurrently: they only read the device and
+ * write to buffers which are owned by their own segment.
+ */
+template<typename DeviceT, typename SegmentT>
+class SegmentGeometryJob : public QRunnable
+{
+public:
+  SegmentGeometryJob(DeviceT& device, SegmentT& segment, int cell_size,
+                     double* coords, vtkIdType* connectivity) :
+    device(device), segment(segment), cell_size(cell_size),
+    coords(coords), connectivity(connectivity)
+  {
+    this->setAutoDelete(false);
+  }
+
+  virtual void run()
+  {
+    typedef typename DeviceT::CellComplex                     DomainType;
+
+    typedef typename viennagrid::result_of::cell_tag<DomainType>::type                                  CellTag;
+    typedef typename viennagrid::result_of::element<DomainType, CellTag>::type                          CellType;
+    typedef typename viennagrid::result_of::element<SegmentT, viennagrid::vertex_tag>::type             VertexType;
+    typedef typename viennagrid::result_of::element_range<SegmentT, viennagrid::vertex_tag>::type       VertexRange;
+    typedef typename viennagrid::result_of::iterator<VertexRange>::type                                 VertexIterator;
+    typedef typename viennagrid::result_of::point<DomainType>::type                                     PointType;
+    typedef typename viennagrid::result_of::default_point_accessor<DomainType>::type                    PointAccessorType;
+    typedef typename viennagrid::result_of::element_range<SegmentT, CellTag>::type                      CellRange;
+    typedef typename viennagrid::result_of::iterator<CellRange>::type                                   CellIterator;
+    typedef typename viennagrid::result_of::element_range<CellType, VertexType>::type                   VertexOnCellRange;
+    typedef typename viennagrid::result_of::iterator<VertexOnCellRange>::type                           VertexOnCellIterator;
+
+    static const int DIMG = PointType::dim;
+
+    PointAccessorType pnt_acc = viennagrid::default_point_accessor(device.getCellComplex());
+
+    // maps vertex IDs to the point index within this segment's grid, sorted by the IDs.
+    // vertices on interfaces belong to several segments, hence each job has its own map,
+    // sized by the segment rather than by the whole mesh
+    //
+    std::vector<IndexPair> local_index;
+
+    // transfer the segment's geometry information,
+    // the z-component stays 0.0 in the 2d case
+    //
+    VertexRange vertices = viennagrid::elements<VertexType>(segment);
+    local_index.reserve(vertices.size());
+    vtkIdType i = 0;
+    for (VertexIterator vit = vertices.begin(); vit != vertices.end(); ++vit)
+    {
+      double* point = coords + 3*i;
+      for(int dim = 0; dim < DIMG; dim++) // that should be automatically unrolled by the compiler as dimg is static ..
+          point[dim] = pnt_acc(*vit)[dim];
+      for(int dim = DIMG; dim < 3; dim++)
+          point[dim] = 0.0;
+      local_index.push_back(IndexPair(vit->id().get(), i++));
+    }
+    std::sort(local_index.begin(), local_index.end());
+
+    // transfer the segment's topology information in the vtk cell array layout:
+    // the number of points of a cell, followed by the point indices
+    //
+    CellRange cells = viennagrid::elements<CellType>(segment);
+    vtkIdType* entry = connectivity;
+    for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
+    {
+      *entry++ = cell_size;
+
+      VertexOnCellRange vertices_on_cell = viennagrid::elements<VertexType>(*cit);
+      for (VertexOnCellIterator vocit = vertices_on_cell.begin(); vocit != vertices_on_cell.end(); ++vocit)
+      {
+          *entry++ = std::lower_bound(local_index.begin(), local_index.end(),
+                                      IndexPair(vocit->id().get(), 0))->second;
+      }
+    }
+  }
+
+private:
+  typedef std::pair<std::size_t, vtkIdType>   IndexPair;    // vertex ID, point index
+
+  DeviceT&      device;
+  SegmentT&     segment;
+  int           cell_size;
+  double*       coords;
+  vtkIdType*    connectivity;
+};
+
+} // end detail
+
+/**
+ * @brief Sets up the central multi-block datastructure with one unstructured vtk grid per segment.
+ * All vtk arrays are created and preallocated to their exact size up front, the segments are then
+ * filled concurrently by a thread pool. Creating the vtk objects and assembling the multi-block
+ * remains with the calling thread.
+ */
 template<typename DeviceT>
 inline void copy(DeviceT& device, MultiView* multiview, tag::viennagrid_domain, int VTK_CELL_TYPE)
 {
   typedef typename DeviceT::CellComplex                     DomainType;
   typedef typename DeviceT::Segmentation                    SegmentationType;
-  typedef typename DeviceT::QuantityComplex                 QuantityComplexType;
   typedef typename SegmentationType::iterator               SegmentationIteratorType;
   typedef typename SegmentationType::segment_handle_type    SegmentType;
 
@@ -240,15 +455,9 @@ inline void copy(DeviceT& device, MultiView* multiview, tag::viennagrid_domain,
   typedef typename viennagrid::result_of::element<DomainType, CellTag>::type                          CellType;
   typedef typename viennagrid::result_of::element<SegmentType, viennagrid::vertex_tag>::type          VertexType;
   typedef typename viennagrid::result_of::element_range<SegmentType, viennagrid::vertex_tag>::type    VertexRange;
-  typedef typename viennagrid::result_of::iterator<VertexRange>::type                                 VertexIterator;
-  typedef typename viennagrid::result_of::point<DomainType>::type                                     PointType;
-  typedef typename viennagrid::result_of::default_point_accessor<DomainType>::type                    PointAccessorType;
   typedef typename viennagrid::result_of::element_range<SegmentType, CellTag>::type                   CellRange;
-  typedef typename viennagrid::result_of::iterator<CellRange>::type                                   CellIterator;
-  typedef typename viennagrid::result_of::element_range<CellType, VertexType>::type                   VertexOnCellRange;
-  typedef typename viennagrid::result_of::iterator<VertexOnCellRange>::type                           VertexOnCellIterator;
 
-  static const int DIMG = PointType::dim;
+  typedef detail::SegmentGeometryJob<DeviceT, SegmentType>                                            JobType;
 
   // TODO retrieve this info from viennagrid
   //
@@ -264,76 +473,69 @@ inline void copy(DeviceT& device, MultiView* multiview, tag::viennagrid_domain,
   else
   if(VTK_CELL_TYPE == VTK_HEXAHEDRON)
       cell_size = 8;
-
-  std::vector<vtkIdType>  temp_array(cell_size);
+  else return;
 
   SegmentationType & segments = device.getSegmentation();
 
-  PointAccessorType pnt_acc = viennagrid::default_point_accessor(device.getCellComplex());
-
-  multiview->resetGrid();
-  MultiView::MultiGrid multigrid = multiview->getGrid();
-
-  vtkUnstructuredGrid*    usg;
-  vtkPoints*              points;
+  // for each segment, we shall setup an unstructured vtk grid with exactly sized arrays
+  //
+  std::vector< vtkSmartPointer<vtkUnstructuredGrid> >  grids;
+  std::vector< vtkSmartPointer<vtkCellArray> >         cell_arrays;
+  std::vector< vtkSmartPointer<vtkIdTypeArray> >       connectivities;
+  std::vector< vtkIdType >                             cell_counts;
+  std::vector< JobType* >                              jobs;
 
-  std::size_t si = 0;
   for(SegmentationIteratorType sit = segments.begin();
       sit != segments.end(); sit++)
   {
-    // for each segment, we shall setup an unstructured vtk grid
-    // and add it as a new block to the general, central multi-block datastructure
-    //
-    usg = vtkUnstructuredGrid::New();
-
-    // transfer the segment's geometry information
-    //
-    points = vtkPoints::New();
     VertexRange vertices = viennagrid::elements<VertexType>(*sit);
-    std::map<std::size_t,std::size_t>   indexMap;
-    int i = 0;
-    double array[3];
-    array[0] = 0.0;
-    array[1] = 0.0;
-    array[2] = 0.0; // important for 2d case: the z-component has to be 0.0, to be sure ..
+    CellRange   cells    = viennagrid::elements<CellType>(*sit);
+    vtkIdType   vertex_count = static_cast<vtkIdType>(vertices.size());
+    vtkIdType   cell_count   = static_cast<vtkIdType>(cells.size());
 
-    for (VertexIterator vit = vertices.begin(); vit != vertices.end(); ++vit)
-    {
-      for(int dim = 0; dim < DIMG; dim++) // that should be automatically unrolled by the compiler as dimg is static ..
-          array[dim] = pnt_acc(*vit)[dim];
-      points->InsertNextPoint(array);
-      indexMap[vit->id().get()] = i++;
-      //indexMap[i++] = points->InsertNextPoint(array);
-    }
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataTypeToDouble();
+    points->SetNumberOfPoints(vertex_count);
+
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(cell_count * (cell_size+1));
+
+    vtkSmartPointer<vtkUnstructuredGrid> usg = vtkSmartPointer<vtkUnstructuredGrid>::New();
     usg->SetPoints(points);
-    points->Delete();
 
-    // transfer the segment's topology information
-    //
-    CellRange cells = viennagrid::elements<CellType>(*sit);
+    grids.push_back(usg);
+    cell_arrays.push_back(vtkSmartPointer<vtkCellArray>::New());
+    connectivities.push_back(connectivity);
+    cell_counts.push_back(cell_count);
 
-    for (CellIterator cit = cells.begin(); cit != cells.end(); ++cit)
-    {
-      vtkIdType cell_index = 0;
+    double*    coords      = vertex_count > 0 ? vtkDoubleArray::SafeDownCast(points->GetData())->GetPointer(0) : NULL;
+    vtkIdType* connections = cell_count   > 0 ? connectivity->GetPointer(0) : NULL;
+    jobs.push_back(new JobType(device, *sit, cell_size, coords, connections));
+  }
 
-      for (VertexOnCellIterator vocit = viennagrid::elements<VertexType>(*cit).begin(); // TODO make this 'unroll'able' ..
-           vocit != viennagrid::elements<VertexType>(*cit).end();
-           ++vocit)
-      {
-          temp_array[cell_index++] = indexMap.at(vocit->id().get());
-      }
-      usg->InsertNextCell (VTK_CELL_TYPE , cell_size, &temp_array[0] );
-    }
+  // fill the segments concurrently. a local pool, as the global one
+  // may be busy with unrelated work which we must not wait for
+  //
+  QThreadPool pool;
+  pool.setMaxThreadCount(std::max(1, std::min(QThread::idealThreadCount(), static_cast<int>(jobs.size()))));
+  for(std::size_t i = 0; i < jobs.size(); i++)
+    pool.start(jobs[i]);
+  pool.waitForDone();
 
-    // now, as the grid representing the segment has been set up,
-    // add it as a new block to the central multi-block datastructure
-    //
-    multigrid->SetBlock(si++, usg);
+  for(std::size_t i = 0; i < jobs.size(); i++)
+    delete jobs[i];
 
-    // we don't need the usg anymore,
-    // delete everything, we'll start from scratch with the next segment ..
-    //
-    usg->Delete();
+  // now, as the grids representing the segments have been set up,
+  // add them as new blocks to the central multi-block datastructure
+  //
+  multiview->resetGrid();
+  MultiView::MultiGrid multigrid = multiview->getGrid();
+
+  for(std::size_t si = 0; si < grids.size(); si++)
+  {
+    cell_arrays[si]->SetCells(cell_counts[si], connectivities[si]);
+    grids[si]->SetCells(VTK_CELL_TYPE, cell_arrays[si]);
+    multigrid->SetBlock(si, grids[si]);
   }
 
   multiview->multigridModified();
@@ -0,0 +1,125 @@
+#ifndef LOG_BUFFER_HPP
+#define LOG_BUFFER_HPP
+
+/*
+ *
+ * Copyright (c) 2013, Institute for Microelectronics, TU Wien.
+ *
+ * This file is part of ViennaMOS     http://viennamos.sourceforge.net/
+ *
+ * Contact: Josef Weinbub             weinbub@iue.tuwien.ac.at
+ *
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <fstream>
+
+#include <QString>
+#include <QStringList>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "spsc_queue.hpp"
+
+namespace viennamos {
+
+/**
+ * @brief Line buffer between log producing threads and the GUI.
+ * Producers append lines to a single producer ring buffer, the GUI collects them in batches at its own pace.
+ * Since std::cout and std::cerr are rerouted process wide, any thread may end up as a producer
+ * (e.g. the worker and the GUI thread at the same time), hence the producers are serialized by a mutex.
+ * The consumer side stays lock-free.
+ * If the GUI falls behind and the ring buffer is full, lines are dropped from the GUI output and only counted.
+ * An optional file sink receives every line directly from the producer, hence the full log is never lost.
+ */
+class LogBuffer
+{
+public:
+    static const int CAPACITY = 4096; // lines
+
+    LogBuffer() : dropped(0) {}
+
+    /// Producer side: appends a single line (without the trailing newline), may be called from any thread
+    void write(std::string const& line)
+    {
+        QString entry = QString::fromStdString(line);
+
+        QMutexLocker lock(&producer_mutex); // the ring buffer admits one producer at a time
+        if(file_sink.is_open())
+            file_sink << line << '\n';
+        if(!lines.push(entry))
+            dropped.fetchAndAddOrdered(1);
+    }
+
+    /// Consumer side: moves all pending lines to 'result', returns false if there are none
+    bool take(QStringList& result)
+    {
+        int skipped = dropped.fetchAndStoreOrdered(0);
+
+        QString line;
+        bool available = false;
+        while(lines.pop(line))
+        {
+            result.append(line);
+            available = true;
+        }
+        if(skipped > 0)
+        {
+            result.append(QString("[... %1 lines not shown, the log output is too fast for the GUI ...]").arg(skipped));
+            available = true;
+        }
+        return available;
+    }
+
+    /// Attaches a file sink, an already attached sink is replaced. Returns false if the file can't be opened
+    bool open_file(QString const& filename)
+    {
+        QMutexLocker lock(&producer_mutex);
+        if(file_sink.is_open()) file_sink.close();
+        file_sink.clear();
+        file_sink.open(filename.toLocal8Bit().constData(), std::ios::out | std::ios::app);
+        if(!file_sink.is_open()) return false;
+        file_name = filename;
+        return true;
+    }
+
+    void close_file()
+    {
+        QMutexLocker lock(&producer_mutex);
+        if(file_sink.is_open()) file_sink.close();
+        file_name = QString();
+    }
+
+    /// The file the log is written to, empty if there is no file sink
+    QString get_file() const { return file_name; }
+
+private:
+    LogBuffer(LogBuffer const&);
+    LogBuffer& operator=(LogBuffer const&);
+
+    SPSCQueue<QString, CAPACITY>    lines;
+    QAtomicInt                      dropped;
+    QMutex                          producer_mutex; // guards the producer side of 'lines' and the file sink
+    std::ofstream                   file_sink;
+    QString                         file_name;
+};
+
+} // viennamos
+
+#endif // LOG_BUFFER_HPP
@@ -77,6 +77,7 @@ private slots:
     void on_actionExit_triggered();
     void apply_module_end(QString const& module);
     void apply_module_end_error(QString const& module);
+    void apply_module_warning(QString const& module, QString const& message);
     void apply_module_begin(QString const& module);
     void change_mesh_visualization(QString id);
     void on_actionActive_Modules_triggered();
@@ -119,6 +120,8 @@ private:
     void repopulate_quantity_selection(QuantitySet const& quantityset);
     double get_current_module_timer_seconds();
     void delay(int mseconds);
+    bool get_vcr_selection(QString& module, Quantity& quantity);
+    std::size_t& get_vcr_index(QString const& module, Quantity& quantity);
     void addNewView();
     QDockWidget* createNewViewDock();
 
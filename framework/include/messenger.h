@@ -27,6 +27,7 @@
  */
 
 #include <QPlainTextEdit>
+#include <QTimer>
 
 #include <iostream>
 #include <streambuf>
@@ -34,6 +35,7 @@
 #include <vector>
 
 #include "qdebugstream.h"
+#include "log_buffer.hpp"
 
 #include "boost/shared_ptr.hpp"
 
@@ -42,14 +44,27 @@ class Messenger : public QPlainTextEdit
     Q_OBJECT
 
 public:
+    static const int FLUSH_INTERVAL = 100;    // ms
+    static const int MAX_LINES      = 10000;  // lines kept in the widget
+
     explicit Messenger(QWidget *parent = 0);
     ~Messenger();
     void append(QString const& msg);
+    viennamos::LogBuffer& getLogBuffer();
     void claimStream(std::ostream & os);
     void claimDefaultStreams();
     void releaseStreams();
     QPlainTextEdit* getPlainTextEditWidget();
 
+public slots:
+    void flush();
+
+protected:
+    virtual void contextMenuEvent(QContextMenuEvent* event);
+
+private slots:
+    void selectLogFile();
+    void closeLogFile();
 
 private:
     typedef boost::shared_ptr<QDebugStream> DebugStreamsPtr;
@@ -57,6 +72,9 @@ private:
 
     DebugStreams    debug_streams;
     std::map<std::ostream*, bool>    stream_unifier;
+
+    viennamos::LogBuffer    log_buffer;
+    QTimer*                 flush_timer;
 };
 
 #endif // MESSENGER_H
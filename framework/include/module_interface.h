@@ -53,12 +53,14 @@ public:
     virtual bool            is_ready                ()                                                  = 0;
     virtual void            update                  ()                                                  = 0;
     virtual void            reset                   ()                                                  = 0;
-    virtual std::size_t     quantity_sequence_size  (std::string quankey)                               = 0;
+    virtual std::size_t     quantity_sequence_size  (Quantity& quan)                                    = 0;
     virtual void execute    () = 0;
+    virtual void cancel     ();
 
     void setup(DataBase* central_db,         MultiView* central_multiview,
                Messenger* central_messenger, MaterialManager* central_material_manager);
     QWidget*                    get_widget();
+    void                        report_progress(int percent, QString const& text);
     void                        register_module_widget(QWidget* widget);
 
     //Quantity::TupleContainer&   getQuantityTuples();
@@ -108,6 +110,7 @@ private slots:
     void on_pushButtonSave_clicked();
     void on_pushButtonLoad_clicked();
     void pre_execute();
+    void pre_cancel();
     void post_execute();
     void report_error();
 
@@ -122,6 +125,7 @@ signals:
     void module_end       (QString const& name);
     //void module_end       (QString const& name, Quantity::TupleContainer const& quantity_tuples, int default_quantity);
     void module_end_error (QString const& name);
+    void module_warning   (QString const& name, QString const& message);
     void render_log       (bool state);
     void state_loaded     (QSettings& settings);
     void state_saved      (QSettings& settings);
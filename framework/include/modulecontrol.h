@@ -42,12 +42,14 @@ public:
     explicit ModuleControl(QWidget *parent = 0);
     ~ModuleControl();
     QPushButton* getButtonRun();
+    QPushButton* getButtonStop();
     QPushButton* getButtonSave();
     QPushButton* getButtonLoad();
     void addModuleParameterWidget(QWidget *widget);
     QWidget * getWidget();
     void deactivate();
     void activate();
+    void setProgress(int percent, QString const& text);
 
 private:
     Ui::ModuleControl *ui;
@@ -102,6 +102,8 @@ public:
     void            show_current_grid();
     void            show_current_grid_segments();
     void            multigridModified();
+    void            quantityModified(std::string const& name);
+    void            refresh(Render3D* render);
 
 public slots:
     void            resetCurrentView();
@@ -136,6 +138,8 @@ private:
     DockIndexMap                            dock_index_map;
     Tables                                  tables;
     MultiGrid                               multigrid;
+    Render3D::Version                       topology_version;
+    Render3D::ArrayVersions                 array_versions;
     std::size_t                             table_index;
     const char* dock_key;
 };
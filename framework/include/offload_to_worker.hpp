@@ -12,12 +12,14 @@ void offload(Worker* worker, Messenger* messenger, const char* signal_finished,
     QThread* thread = new QThread;
     worker->moveToThread(thread);
 
+    // the worker's output is collected by the messenger's log buffer, which
+    // is flushed in batches. a queued signal per line would flood the GUI
+    //
+    worker->setLogBuffer(messenger->getLogBuffer());
+
     // signals/slot communication between threads need to use the
     // queuedconnection mechanism! otherwise, it's unstable
     //
-    QObject::connect(worker, SIGNAL(message(QString const&)),
-                     messenger->getPlainTextEditWidget(), SLOT(appendPlainText(QString const&)),
-                     Qt::QueuedConnection);
     QObject::connect(worker, signal_finished,
                      module, slot_onfinish,
                      Qt::QueuedConnection);
@@ -27,6 +27,7 @@
  */
 
 #include <vector>
+#include <map>
 
 #include <QVTKWidget.h>
 #include <QObject>
@@ -97,6 +98,8 @@ public:
     typedef std::vector<Mapper>                 Mappers;
     typedef vtkSmartPointer<vtkActor>           Actor;
     typedef std::vector<Actor>                  Actors;
+    typedef unsigned long                       Version;
+    typedef std::map<std::string, Version>      ArrayVersions;
 
     explicit Render3D(vtkSmartPointer<vtkMultiBlockDataSet> domain, QWidget *parent = 0);
     ~Render3D();
@@ -104,6 +107,7 @@ public:
     void  reset_grid();
     void  reset_renderer();
     void  update_render_domain();
+    void  refresh(Version topology_version, ArrayVersions const& array_versions);
     void  print_current_statistics();
     void  update_render();
     void  color_current_quantity();
@@ -184,6 +188,7 @@ private:
     }
 
     void resetCameraParameters();
+    void link_array(std::string const& name);
 
     vtkSmartPointer<vtkMultiBlockDataSet>                local_domain;
     vtkSmartPointer<vtkMultiBlockDataSet>                central_domain;
@@ -213,6 +218,9 @@ private:
     int  current_quantity_cell_lvl;
     std::string current_quantity_key;
 
+    Version       rendered_topology_version;
+    ArrayVersions rendered_array_versions;
+
     int state;
 
     static const int UNSET      = -1;
@@ -0,0 +1,282 @@
+#ifndef RESULT_SEQUENCE_HPP
+#define RESULT_SEQUENCE_HPP
+
+/*
+ *
+ * Copyright (c) 2013, Institute for Microelectronics, TU Wien.
+ *
+ * This file is part of ViennaMOS     http://viennamos.sourceforge.net/
+ *
+ * Contact: Josef Weinbub             weinbub@iue.tuwien.ac.at
+ *
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <list>
+#include <vector>
+#include <cstring>
+
+#include <QByteArray>
+#include <QString>
+#include <QTemporaryFile>
+
+namespace viennamos {
+
+/**
+ * @brief Stores a sequence of results (e.g. the steps of a bias sweep or a transient run) per quantity,
+ * the quantities are identified by their handle.
+ * A step holds one array of values per segment. The most recently used steps are kept in memory,
+ * up to the given memory limit. Older steps are compressed and spilled to a temporary chunk file,
+ * and they are decompressed again lazily when they are accessed.
+ * The store does not report errors itself: failures of the chunk file are recorded, see has_error(),
+ * and it is up to the owner to present them.
+ */
+class ResultSequence
+{
+public:
+    typedef std::size_t             Key;     // the quantity handle
+    typedef std::vector<double>     Values;  // the values of one segment
+    typedef std::vector<Values>     Frame;   // the values of all segments of one step
+
+    static const std::size_t DEFAULT_MEMORY_LIMIT = 256 * 1024 * 1024; // bytes
+
+    explicit ResultSequence(std::size_t limit = DEFAULT_MEMORY_LIMIT) :
+        memory_limit(limit), memory_usage(0) {}
+
+    /// Appends a step to the sequence of the quantity, returns the index of the new step
+    std::size_t append(Key key, Frame const& frame)
+    {
+        Steps& steps = sequences[key];
+        steps.push_back(Entry());
+        Entry& entry = steps.back();
+        entry.frame = frame;
+        entry.bytes = bytes(frame);
+        entry.lru_position = lru.insert(lru.end(), Position(key, steps.size()-1));
+        memory_usage += entry.bytes;
+
+        this->spill(&entry);
+        return steps.size()-1;
+    }
+
+    /// Number of steps stored for the quantity
+    std::size_t size(Key key) const
+    {
+        Sequences::const_iterator iter = sequences.find(key);
+        if(iter == sequences.end()) return 0;
+        return iter->second.size();
+    }
+
+    /// Access a step, spilled steps are loaded from the chunk file.
+    /// Returns NULL for an unknown quantity or step, or if a spilled step can't be read back, see has_error().
+    /// The pointer stays valid until the next call to append() or at()
+    Frame const* at(Key key, std::size_t step)
+    {
+        Sequences::iterator iter = sequences.find(key);
+        if(iter == sequences.end() || step >= iter->second.size()) return NULL;
+
+        Entry& entry = iter->second[step];
+        if(entry.resident)
+        {
+            lru.splice(lru.end(), lru, entry.lru_position);
+        }
+        else
+        {
+            if(!this->load(entry)) return NULL;
+            entry.lru_position = lru.insert(lru.end(), Position(key, step));
+            this->spill(&entry);
+        }
+        return &entry.frame;
+    }
+
+    /// Removes all steps of all quantities and discards the chunk file
+    void clear()
+    {
+        sequences.clear();
+        lru.clear();
+        memory_usage = 0;
+        if(chunk_file.isOpen())
+        {
+            chunk_file.resize(0);
+            chunk_file.close();
+        }
+    }
+
+    void        set_memory_limit(std::size_t limit) { memory_limit = limit; this->spill(NULL); }
+    std::size_t get_memory_limit() const            { return memory_limit; }
+    std::size_t get_memory_usage() const            { return memory_usage; }
+
+    /// True if a chunk file operation failed since the last call to take_error()
+    bool    has_error() const { return !error_message.isEmpty(); }
+    /// Returns the description of the last failure and resets the error state
+    QString take_error()      { QString message = error_message; error_message.clear(); return message; }
+
+private:
+    typedef std::pair<Key, std::size_t>         Position;   // quantity handle and step
+    typedef std::list<Position>                 LRUList;    // resident steps, least recently used first
+
+    struct Entry
+    {
+        Entry() : resident(true), bytes(0), offset(-1), compressed_size(0) {}
+
+        Frame               frame;
+        bool                resident;
+        std::size_t         bytes;
+        LRUList::iterator   lru_position;      // valid while resident
+        qint64              offset;            // position in the chunk file, -1 if not yet written
+        qint64              compressed_size;
+    };
+    typedef std::vector<Entry>                  Steps;
+    typedef std::map<Key, Steps>                Sequences;
+
+    static std::size_t bytes(Frame const& frame)
+    {
+        std::size_t size = 0;
+        for(Frame::const_iterator iter = frame.begin(); iter != frame.end(); iter++)
+            size += iter->size() * sizeof(double);
+        return size;
+    }
+
+    /// Evicts the least recently used resident steps until the memory limit is met, 'keep' is never evicted
+    void spill(Entry* keep)
+    {
+        LRUList::iterator candidate = lru.begin();
+        while(memory_usage > memory_limit && candidate != lru.end())
+        {
+            Entry& victim = sequences[candidate->first][candidate->second];
+            if(&victim == keep)
+            {
+                ++candidate;
+                continue;
+            }
+            if(!this->write(victim)) return;
+
+            Frame().swap(victim.frame);
+            victim.resident = false;
+            memory_usage -= victim.bytes;
+            candidate = lru.erase(candidate);
+        }
+    }
+
+    /// Records a failure of the chunk file, further steps are kept in memory
+    void fail(QString const& message)
+    {
+        error_message = message;
+        memory_limit = std::size_t(-1);
+    }
+
+    /// Compresses a step and appends it to the chunk file. Steps are immutable, hence a step is written at most once
+    bool write(Entry& entry)
+    {
+        if(entry.offset >= 0) return true;
+
+        if(!chunk_file.isOpen() && !chunk_file.open())
+        {
+            this->fail(QString("Could not open the result sequence chunk file - keeping all results in memory"));
+            return false;
+        }
+
+        // layout: number of segments, then for each segment the number of values followed by the values
+        QByteArray raw;
+        quint64 segments = entry.frame.size();
+        raw.append(reinterpret_cast<const char*>(&segments), sizeof(segments));
+        for(Frame::const_iterator iter = entry.frame.begin(); iter != entry.frame.end(); iter++)
+        {
+            quint64 values = iter->size();
+            raw.append(reinterpret_cast<const char*>(&values), sizeof(values));
+            if(values > 0)
+                raw.append(reinterpret_cast<const char*>(&(*iter)[0]), values * sizeof(double));
+        }
+        QByteArray compressed = qCompress(raw, 1); // fast compression, spilling must not stall the GUI
+
+        entry.offset = chunk_file.size();
+        entry.compressed_size = compressed.size();
+        chunk_file.seek(entry.offset);
+        if(chunk_file.write(compressed) != compressed.size())
+        {
+            entry.offset = -1;
+            this->fail(QString("Could not write to the result sequence chunk file - keeping all results in memory"));
+            return false;
+        }
+        return true;
+    }
+
+    /// Reads and decompresses a spilled step. The chunk is validated against the recorded sizes before
+    /// it is parsed, a short read or a corrupt chunk leaves the step unloaded and returns false
+    bool load(Entry& entry)
+    {
+        QByteArray raw;
+        if(chunk_file.seek(entry.offset))
+        {
+            QByteArray compressed = chunk_file.read(entry.compressed_size);
+            if(compressed.size() == entry.compressed_size)
+                raw = qUncompress(compressed);
+        }
+
+        // walk the counts of the chunk, each of them has to fit into the data that is left
+        const std::size_t count_size = sizeof(quint64);
+        const std::size_t raw_size   = static_cast<std::size_t>(raw.size());
+        quint64 segments = 0;
+        std::size_t parsed = count_size;
+        bool valid = (raw_size >= count_size);
+        if(valid)
+            std::memcpy(&segments, raw.constData(), count_size);
+        for(quint64 si = 0; valid && si < segments; si++)
+        {
+            valid = (raw_size - parsed >= count_size);
+            if(!valid) break;
+            quint64 values;
+            std::memcpy(&values, raw.constData() + parsed, count_size);
+            parsed += count_size;
+            valid = (values <= (raw_size - parsed) / sizeof(double));
+            if(valid) parsed += values * sizeof(double);
+        }
+        if(!valid || parsed != raw_size || parsed != count_size * (segments + 1) + entry.bytes)
+        {
+            error_message = QString("Could not read a result step back from the result sequence chunk file");
+            return false;
+        }
+
+        const char* pos = raw.constData() + count_size;
+        entry.frame.resize(segments);
+        for(Frame::iterator iter = entry.frame.begin(); iter != entry.frame.end(); iter++)
+        {
+            quint64 values;
+            std::memcpy(&values, pos, sizeof(values));
+            pos += sizeof(values);
+            iter->resize(values);
+            if(values > 0)
+                std::memcpy(&(*iter)[0], pos, values * sizeof(double));
+            pos += values * sizeof(double);
+        }
+
+        entry.resident = true;
+        memory_usage += entry.bytes;
+        return true;
+    }
+
+    Sequences       sequences;
+    LRUList         lru;
+    std::size_t     memory_limit;
+    std::size_t     memory_usage;
+    QString         error_message;
+    QTemporaryFile  chunk_file;
+};
+
+} // viennamos
+
+#endif // RESULT_SEQUENCE_HPP
@@ -0,0 +1,94 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+/*
+ *
+ * Copyright (c) 2013, Institute for Microelectronics, TU Wien.
+ *
+ * This file is part of ViennaMOS     http://viennamos.sourceforge.net/
+ *
+ * Contact: Josef Weinbub             weinbub@iue.tuwien.ac.at
+ *
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstddef>
+
+#include <QAtomicInt>
+
+namespace viennamos {
+
+/**
+ * @brief Bounded lock-free queue for exactly one producer thread (e.g. a worker)
+ * and one consumer thread (e.g. the GUI polling with a timer).
+ * Neither side ever blocks: push() fails if the queue is full and pop() fails if it is empty.
+ * One slot is kept free to tell a full from an empty queue, hence at most Capacity-1 elements are queued.
+ */
+template<typename T, int Capacity>
+class SPSCQueue
+{
+public:
+    SPSCQueue() : head(0), tail(0) {}
+
+    /// Producer side: returns false if the queue is full, the element is dropped then
+    bool push(T const& value)
+    {
+        int pos  = head.fetchAndAddAcquire(0);
+        int next = (pos + 1) % Capacity;
+        if(next == tail.fetchAndAddAcquire(0)) return false;
+
+        buffer[pos] = value;
+        head.fetchAndStoreRelease(next); // publish the element
+        return true;
+    }
+
+    /// Consumer side: returns false if the queue is empty
+    bool pop(T& value)
+    {
+        int pos = tail.fetchAndAddAcquire(0);
+        if(pos == head.fetchAndAddAcquire(0)) return false;
+
+        value = buffer[pos];
+        tail.fetchAndStoreRelease((pos + 1) % Capacity); // hand the slot back to the producer
+        return true;
+    }
+
+    /// Consumer side: drops all queued elements
+    void clear()
+    {
+        tail.fetchAndStoreRelease(head.fetchAndAddAcquire(0));
+    }
+
+    bool empty() const
+    {
+        return const_cast<QAtomicInt&>(head).fetchAndAddAcquire(0) == const_cast<QAtomicInt&>(tail).fetchAndAddAcquire(0);
+    }
+
+    static int capacity() { return Capacity - 1; }
+
+private:
+    SPSCQueue(SPSCQueue const&);
+    SPSCQueue& operator=(SPSCQueue const&);
+
+    T           buffer[Capacity];
+    QAtomicInt  head;   // next slot to write, owned by the producer
+    QAtomicInt  tail;   // next slot to read, owned by the consumer
+};
+
+} // viennamos
+
+#endif // SPSC_QUEUE_HPP
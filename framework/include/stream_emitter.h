@@ -30,27 +30,32 @@
 #include <streambuf>
 #include <string>
 
-#include <QObject>
+#include <QMutex>
 
-class StreamEmitter : public QObject, public std::basic_streambuf<char>
-{
-    Q_OBJECT
+#include "log_buffer.hpp"
 
+/**
+ * @brief Redirects a stream (e.g. std::cout of a worker) line by line into a log buffer,
+ * which is collected by the Messenger in batches.
+ * The stream stays rerouted for the whole process, hence any thread may write to it;
+ * the partial line is guarded by a mutex.
+ */
+class StreamEmitter : public std::basic_streambuf<char>
+{
 public:
-    StreamEmitter(std::ostream &stream);
+    StreamEmitter(std::ostream &stream, viennamos::LogBuffer& log);
     ~StreamEmitter();
 
 protected:
     virtual int_type overflow(int_type v);
     virtual std::streamsize xsputn(const char *p, std::streamsize n);
 
-signals:
-    void message(QString const& msg);
-
 private:
-    std::ostream   &m_stream;
-    std::streambuf *m_old_buf;
-    std::string     m_string;
+    std::ostream         &m_stream;
+    std::streambuf       *m_old_buf;
+    std::string           m_string;
+    QMutex                m_mutex;
+    viennamos::LogBuffer &m_log;
 };
 
 #endif // STREAMEMITTER_H
@@ -235,6 +235,8 @@ void MainWindow::loadActiveModules(QList<QString>& modules)
                          this, SLOT(apply_module_begin(QString)));
         QObject::connect(avail_modules[module], SIGNAL(module_end_error(QString)),
                          this, SLOT(apply_module_end_error(QString)));
+        QObject::connect(avail_modules[module], SIGNAL(module_warning(QString,QString)),
+                         this, SLOT(apply_module_warning(QString,QString)));
     }
 
     foreach(QString module, ready_modules) {
@@ -377,6 +379,18 @@ void MainWindow::apply_module_end_error(QString const& module)
     output->append("# ------------------------------------------------------------------------------------------");
 }
 
+/**
+ * @brief Slot: Is called if a module reports a problem which does not abort it,
+ * e.g. a failure of its result storage
+ * @param module The name key string of the module
+ * @param message The description of the problem
+ */
+void MainWindow::apply_module_warning(QString const& module, QString const& message)
+{
+    output->append("# [WARNING] \""+module+"\": "+message);
+    QMessageBox::warning(this, QString("Warning"), message);
+}
+
 
 //void MainWindow::update_current_results()
 //{
@@ -569,12 +583,11 @@ void MainWindow::change_quantity_visualization(int idx)
 
     // forward the quantity id to the module's renderer
     // the module will render the quantity accordingly
-    // by default, we show the first result of a sequence
-    // that's why we pass a '0' here to the plugin's render method
-    avail_modules[module]->render(quantity, 0);
-
-    // set the current index of the current module's quantity to 0
-    //module_quan_index[module][id] = 0;
+    // by default, we show the latest result of a sequence
+    std::size_t size = avail_modules[module]->quantity_sequence_size(quantity);
+    std::size_t step = (size > 0) ? size-1 : 0;
+    module_quan_index[module][QString::number(qulonglong(quantity.handle))] = step;
+    avail_modules[module]->render(quantity, step);
 
   }
 }
@@ -632,137 +645,110 @@ void MainWindow::showChartEditor()
         multi_view->getCurrentChartEditor()->show();
 }
 
-void MainWindow::show_first()
+bool MainWindow::get_vcr_selection(QString& module, Quantity& quantity)
 {
-//    if(active_modules->count() == 0)   return;
-
-//    // get the currently selected active module ..
-//    //
-//    QListWidgetItem* item = active_modules->currentItem();
-//    QString module = item->text();
+    if(active_modules->count() == 0)   return false;
 
-//    // get the currently selected quantity from the combobox ..
-//    //
-//    QString quantity = comboBoxFieldViz->currentText();
+    // get the currently selected active module ..
+    //
+    QListWidgetItem* item = active_modules->currentItem();
+    if(!item) return false;
+    module = item->text();
 
-//    if(quantity == key::solid_color)        return;
-//    else
-//    {
-//        // reset the module's quantity index
-//        //
-//        module_quan_index[module][quantity] = 0;
+    // get the currently selected quantity from the combobox ..
+    // the first two entries are the solid and the segment coloring
+    //
+    int idx = comboBoxFieldViz->currentIndex();
+    if(idx < 2) return false;
+    quantity = comboBoxFieldViz->itemData(idx).value<Quantity>();
 
-//        // forward the quantity id to the module's renderer
-//        // the module will render the quantity accordingly
-//        avail_modules[module]->render(quantity.toStdString(), module_quan_index[module][quantity]);
-//    }
+    return avail_modules[module]->quantity_sequence_size(quantity) > 0;
 }
 
-void MainWindow::show_back()
+std::size_t& MainWindow::get_vcr_index(QString const& module, Quantity& quantity)
 {
-//    if(active_modules->count() == 0)   return;
+    // the quantity handle distinguishes vertex and cell quantities with the same name
+    std::size_t& index = module_quan_index[module][QString::number(qulonglong(quantity.handle))];
 
-//    // get the currently selected active module ..
-//    //
-//    QListWidgetItem* item = active_modules->currentItem();
-//    QString module = item->text();
+    // the sequence may have been reset in the meantime, e.g., a new mesh has been loaded
+    std::size_t size = avail_modules[module]->quantity_sequence_size(quantity);
+    if(index >= size) index = size-1;
+    return index;
+}
 
-//    // get the currently selected quantity from the combobox ..
-//    //
-//    QString quantity = comboBoxFieldViz->currentText();
+void MainWindow::show_first()
+{
+    QString  module;
+    Quantity quantity;
+    if(!get_vcr_selection(module, quantity)) return;
 
-//    if(quantity == key::solid_color)        return;
-//    else
-//    {
-//        // decrement the current index - set 0
-//        //
-//        if(module_quan_index[module][quantity] != 0)
-//            module_quan_index[module][quantity]--;
+    // reset the module's quantity index
+    //
+    std::size_t& index = get_vcr_index(module, quantity);
+    index = 0;
 
-//        // forward the quantity id to the module's renderer
-//        // the module will render the quantity accordingly
-//        avail_modules[module]->render(quantity.toStdString(), module_quan_index[module][quantity]);
-//    }
+    // forward the quantity to the module's renderer
+    // the module will render the quantity accordingly
+    avail_modules[module]->render(quantity, index);
 }
 
-void MainWindow::show_play()
+void MainWindow::show_back()
 {
-//    if(active_modules->count() == 0)   return;
-
-//    // get the currently selected active module ..
-//    //
-//    QListWidgetItem* item = active_modules->currentItem();
-//    QString module = item->text();
+    QString  module;
+    Quantity quantity;
+    if(!get_vcr_selection(module, quantity)) return;
 
-//    // get the currently selected quantity from the combobox ..
-//    //
-//    QString quantity = comboBoxFieldViz->currentText();
+    // decrement the current index - watch for the lower bound
+    //
+    std::size_t& index = get_vcr_index(module, quantity);
+    if(index != 0) index--;
 
-//    if(quantity == key::solid_color)        return;
-//    else
-//    {
-//        std::size_t maxi = avail_modules[module]->quantity_sequence_size(quantity.toStdString());
-//        for(std::size_t i = module_quan_index[module][quantity]; i < maxi; i++)
-//        {
-//            module_quan_index[module][quantity] = i;
-//            avail_modules[module]->render(quantity.toStdString(), module_quan_index[module][quantity]);
-//            if(i < (maxi-1)) delay(spinBoxVCRDelay->value()); // in milliseconds
-//        }
-//    }
+    avail_modules[module]->render(quantity, index);
 }
 
-void MainWindow::show_forward()
+void MainWindow::show_play()
 {
-//    if(active_modules->count() == 0)   return;
+    QString  module;
+    Quantity quantity;
+    if(!get_vcr_selection(module, quantity)) return;
 
-//    // get the currently selected active module ..
-//    //
-//    QListWidgetItem* item = active_modules->currentItem();
-//    QString module = item->text();
+    std::size_t  maxi  = avail_modules[module]->quantity_sequence_size(quantity);
+    std::size_t& index = get_vcr_index(module, quantity);
+    for(std::size_t i = index; i < maxi; i++)
+    {
+        index = i;
+        avail_modules[module]->render(quantity, index);
+        if(i < (maxi-1)) delay(spinBoxVCRDelay->value()); // in milliseconds
+    }
+}
 
-//    // get the currently selected quantity from the combobox ..
-//    //
-//    QString quantity = comboBoxFieldViz->currentText();
+void MainWindow::show_forward()
+{
+    QString  module;
+    Quantity quantity;
+    if(!get_vcr_selection(module, quantity)) return;
 
-//    if(quantity == key::solid_color)        return;
-//    else
-//    {
-//        // increment the current index - watch for the upper bound
-//        //
-//        if(module_quan_index[module][quantity] != (avail_modules[module]->quantity_sequence_size(quantity.toStdString())-1))
-//            module_quan_index[module][quantity]++;
+    // increment the current index - watch for the upper bound
+    //
+    std::size_t& index = get_vcr_index(module, quantity);
+    if(index != (avail_modules[module]->quantity_sequence_size(quantity)-1))
+        index++;
 
-//        // forward the quantity id to the module's renderer
-//        // the module will render the quantity accordingly
-//        avail_modules[module]->render(quantity.toStdString(), module_quan_index[module][quantity]);
-//    }
+    avail_modules[module]->render(quantity, index);
 }
 
 void MainWindow::show_last()
 {
-//    if(active_modules->count() == 0)   return;
-
-//    // get the currently selected active module ..
-//    //
-//    QListWidgetItem* item = active_modules->currentItem();
-//    QString module = item->text();
-
-//    // get the currently selected quantity from the combobox ..
-//    //
-//    QString quantity = comboBoxFieldViz->currentText();
-
-//    if(quantity == key::solid_color)        return;
-//    else
-//    {
-//        // set the current index to the last frame
-//        //
-//        module_quan_index[module][quantity] = avail_modules[module]->quantity_sequence_size(quantity.toStdString())-1;
+    QString  module;
+    Quantity quantity;
+    if(!get_vcr_selection(module, quantity)) return;
 
+    // set the current index to the last frame
+    //
+    std::size_t& index = get_vcr_index(module, quantity);
+    index = avail_modules[module]->quantity_sequence_size(quantity)-1;
 
-//        // forward the quantity id to the module's renderer
-//        // the module will render the quantity accordingly
-//        avail_modules[module]->render(quantity.toStdString(), module_quan_index[module][quantity]);
-//    }
+    avail_modules[module]->render(quantity, index);
 }
 
 void MainWindow::delay(int mseconds)
@@ -26,6 +26,12 @@
 #include "messenger.h"
 
 #include <QDebug>
+#include <QMenu>
+#include <QAction>
+#include <QDir>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QContextMenuEvent>
 
 Messenger::Messenger(QWidget *parent) :
     QPlainTextEdit(parent)
@@ -33,6 +39,17 @@ Messenger::Messenger(QWidget *parent) :
     setReadOnly(true);
     setStyleSheet("background-color: lightgray");
     setBackgroundVisible(true);
+
+    // retaining the complete output of long runs slows down the widget,
+    // the full log can be written to a file instead (see the context menu)
+    setMaximumBlockCount(MAX_LINES);
+
+    // output of worker threads is collected in the log buffer and
+    // appended in batches, instead of one update per line
+    flush_timer = new QTimer(this);
+    flush_timer->setInterval(FLUSH_INTERVAL);
+    QObject::connect(flush_timer, SIGNAL(timeout()), this, SLOT(flush()));
+    flush_timer->start();
 }
 
 Messenger::~Messenger()
@@ -41,9 +58,49 @@ Messenger::~Messenger()
 
 void Messenger::append(QString const& msg)
 {
+    // keep the order: pending worker output comes first
+    this->flush();
     appendPlainText(msg);
 }
 
+viennamos::LogBuffer& Messenger::getLogBuffer()
+{
+    return log_buffer;
+}
+
+void Messenger::flush()
+{
+    QStringList lines;
+    if(log_buffer.take(lines))
+        appendPlainText(lines.join("\n"));
+}
+
+void Messenger::contextMenuEvent(QContextMenuEvent* event)
+{
+    QMenu* menu = createStandardContextMenu();
+    menu->addSeparator();
+    if(log_buffer.get_file().isEmpty())
+        menu->addAction(tr("Write Log to File ..."), this, SLOT(selectLogFile()));
+    else
+        menu->addAction(tr("Stop Writing Log to ")+log_buffer.get_file(), this, SLOT(closeLogFile()));
+    menu->exec(event->globalPos());
+    delete menu;
+}
+
+void Messenger::selectLogFile()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Write Log to File"), QDir::currentPath(), tr("Log Files (*.log *.txt)"));
+    if(filename == QString("")) return; // if the cancel button has been clicked ..
+
+    if(!log_buffer.open_file(filename))
+        QMessageBox::critical(this, QString("Error"), QString("Could not open the log file ")+filename);
+}
+
+void Messenger::closeLogFile()
+{
+    log_buffer.close_file();
+}
+
 QPlainTextEdit* Messenger::getPlainTextEditWidget()
 {
     return this;
@@ -14,6 +14,9 @@ ModuleInterface::ModuleInterface(ModuleInterface* child) : child(child)
     QObject::connect(module_control_widget->getButtonRun(),   SIGNAL(clicked()),
                      this, SLOT(pre_execute()));
 
+    QObject::connect(module_control_widget->getButtonStop(),  SIGNAL(clicked()),
+                     this, SLOT(pre_cancel()));
+
     QObject::connect(this, SIGNAL(base_data_ready()),
                      child, SLOT(preprocess()));
 
@@ -52,6 +55,22 @@ void ModuleInterface::pre_execute()
     child->execute();
 }
 
+/**
+ * @brief Asks the running module to stop. The module finishes via the 'abort' signal
+ * once it has actually stopped
+ */
+void ModuleInterface::pre_cancel()
+{
+    child->cancel();
+}
+
+/**
+ * @brief Default implementation: modules which run to completion can't be cancelled
+ */
+void ModuleInterface::cancel()
+{
+}
+
 void ModuleInterface::post_execute()
 {
     emit module_end(child->name());
@@ -69,6 +88,11 @@ QWidget* ModuleInterface::get_widget()
     return module_control_widget;
 }
 
+void ModuleInterface::report_progress(int percent, QString const& text)
+{
+    module_control_widget->setProgress(percent, text);
+}
+
 void ModuleInterface::register_module_widget(QWidget* widget)
 {
     module_control_widget->addModuleParameterWidget(widget);
@@ -58,6 +58,11 @@ QPushButton* ModuleControl::getButtonRun()
     return ui->pushButtonRun;
 }
 
+QPushButton* ModuleControl::getButtonStop()
+{
+    return ui->pushButtonStop;
+}
+
 QPushButton* ModuleControl::getButtonSave()
 {
     return ui->pushButtonSave;
@@ -71,6 +76,7 @@ QPushButton* ModuleControl::getButtonLoad()
 void ModuleControl::deactivate()
 {
     ui->pushButtonRun->setEnabled(false);
+    ui->pushButtonStop->setEnabled(true);
     ui->pushButtonSave->setEnabled(false);
     ui->pushButtonLoad->setEnabled(false);
     if(current_widget) current_widget->setEnabled(false);
@@ -79,7 +85,17 @@ void ModuleControl::deactivate()
 void ModuleControl::activate()
 {
     ui->pushButtonRun->setEnabled(true);
+    ui->pushButtonStop->setEnabled(false);
     ui->pushButtonSave->setEnabled(true);
     ui->pushButtonLoad->setEnabled(true);
     if(current_widget) current_widget->setEnabled(true);
 }
+
+/**
+ * @brief Shows the progress of the running module, e.g., reported by an offloaded worker
+ */
+void ModuleControl::setProgress(int percent, QString const& text)
+{
+    ui->progressBar->setValue(percent);
+    ui->progressBar->setFormat(text.isEmpty() ? QString("%p%") : text + QString(" - %p%"));
+}
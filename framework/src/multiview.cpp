@@ -41,6 +41,7 @@ MultiView::MultiView(QWidget *parent) :
 
     // create the central datastructures
     multigrid = MultiGrid::New();
+    topology_version = 1;
 
     current_index = 0;
     view_counter  = 0;
@@ -159,7 +160,7 @@ void MultiView::addRender3D()
 
     QWidget*     widget = new QWidget;
     Render3D*    view   = new Render3D(multigrid, dock);
-    view->update_render_domain();
+    this->refresh(view);
     QHBoxLayout* layout = new QHBoxLayout;
     layout->setContentsMargins(3, 3, 3, 3); // leave room for the border!
     layout->addWidget(view);
@@ -362,6 +363,14 @@ void MultiView::setCurrentLogScale(bool state)
 
 void MultiView::update()
 {
+    // let the render views pick up modified quantities, topology changes
+    // have already been forwarded via multigridModified()
+    for(Render3DMap::iterator iter = render_map.begin();
+        iter != render_map.end(); iter++)
+    {
+        this->refresh(iter->second);
+    }
+
     emit chartUpdated();
 }
 
@@ -465,9 +474,24 @@ void MultiView::show_current_grid_segments()
 
 void MultiView::multigridModified()
 {
+  // the topology changed: all previous quantity arrays are gone
+  // and each render view has to set up its mappers and actors from scratch
+  topology_version++;
+  array_versions.clear();
+
   for(Render3DMap::iterator iter = render_map.begin();
       iter != render_map.end(); iter++)
     {
-      iter->second->update_render_domain();
+      this->refresh(iter->second);
     }
 }
+
+void MultiView::quantityModified(std::string const& name)
+{
+  array_versions[name]++;
+}
+
+void MultiView::refresh(Render3D* render)
+{
+  render->refresh(topology_version, array_versions);
+}
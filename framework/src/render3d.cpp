@@ -43,6 +43,7 @@ Render3D::Render3D(vtkSmartPointer<vtkMultiBlockDataSet> domain, QWidget *parent
 
   this->resize(400, 400);
 
+  rendered_topology_version = 0; // nothing rendered yet, any topology version triggers a full setup
   use_log = false; // by default, use linear scaling
   state = SOLID; // by default, we color the mesh solid
 
@@ -180,14 +181,22 @@ void Render3D::update_render_domain()
 {
     this->reset_grid();
 
-    // make sure that we work on a local copy in this render view
-    // so we don't have some 'crosstalk'.
-    // this crosstalk manifests due to the fact that during coloring vertex/cell data,
-    // we have to set an 'active' array. this is a vtk thing. The problem is now,
-    // when we work on a 'shared' grid, that one renderer sets a different active grid
-    // as another renderer -> hence 'crosstalk'
+    // share the points, cells and quantity arrays of the central domain instead of
+    // copying them. each segment is a shallow copy, i.e. the arrays are referenced,
+    // but the point/cell attribute containers are owned by this render view.
+    // hence, arrays added here (segment index) do not appear in other views.
+    // the colored array is selected per mapper via SelectColorArray, so no 'active'
+    // array is set on the data and there is no 'crosstalk' between render views.
     //
-    local_domain->DeepCopy(central_domain);
+    local_domain->SetNumberOfBlocks(central_domain->GetNumberOfBlocks());
+    for(unsigned int si = 0; si < central_domain->GetNumberOfBlocks(); si++)
+    {
+        vtkDataObject* central_segment = central_domain->GetBlock(si);
+        vtkSmartPointer<vtkDataObject> local_segment;
+        local_segment.TakeReference(central_segment->NewInstance());
+        local_segment->ShallowCopy(central_segment);
+        local_domain->SetBlock(si, local_segment);
+    }
 
     for(unsigned int si = 0; si < local_domain->GetNumberOfBlocks(); si++)
     {
@@ -206,7 +215,7 @@ void Render3D::update_render_domain()
 
         // color the segments by assigning the segment ID as cell quantity
         //
-        vtkIntArray* segment_array = vtkIntArray::New();
+        vtkSmartPointer<vtkIntArray> segment_array = vtkSmartPointer<vtkIntArray>::New();
         segment_array->SetName(key::segment_index.toStdString().c_str());
         segment_array->SetNumberOfValues(segment->GetNumberOfCells());
         for(int ci = 0; ci < segment->GetNumberOfCells(); ci++)
@@ -224,6 +233,60 @@ void Render3D::update_render_domain()
     emit grid_updated();
 }
 
+void Render3D::refresh(Version topology_version, ArrayVersions const& array_versions)
+{
+    // the topology changed, e.g., a new mesh has been loaded,
+    // so the mappers and actors have to be set up from scratch
+    //
+    if(topology_version != rendered_topology_version)
+    {
+        this->update_render_domain();
+        rendered_topology_version = topology_version;
+        rendered_array_versions   = array_versions;
+        return;
+    }
+
+    // otherwise, only hand over the quantity arrays which have been modified
+    // since the last refresh. the points, cells, mappers and actors are kept as they are
+    //
+    bool current_quantity_modified = false;
+    for(ArrayVersions::const_iterator iter = array_versions.begin(); iter != array_versions.end(); iter++)
+    {
+        ArrayVersions::const_iterator rendered = rendered_array_versions.find(iter->first);
+        if((rendered != rendered_array_versions.end()) && (rendered->second == iter->second))
+            continue;
+
+        this->link_array(iter->first);
+        rendered_array_versions[iter->first] = iter->second;
+
+        if(iter->first == current_quantity_key)
+            current_quantity_modified = true;
+    }
+
+    // re-color only if the array currently shown has changed (the value range may differ)
+    //
+    if(current_quantity_modified && (state == QUANTITY))
+        this->update_render();
+}
+
+void Render3D::link_array(std::string const& name)
+{
+    for(unsigned int si = 0; (si < local_domain->GetNumberOfBlocks()) && (si < central_domain->GetNumberOfBlocks()); si++)
+    {
+        vtkDataSet* central_segment = vtkDataSet::SafeDownCast(central_domain->GetBlock(si));
+        vtkDataSet* local_segment   = vtkDataSet::SafeDownCast(local_domain->GetBlock(si));
+        if(!central_segment || !local_segment) continue;
+
+        // AddArray replaces a previous array with the same name,
+        // the array itself is shared with the central domain
+        //
+        if(vtkDataArray* point_array = central_segment->GetPointData()->GetArray(name.c_str()))
+            local_segment->GetPointData()->AddArray(point_array);
+        if(vtkDataArray* cell_array = central_segment->GetCellData()->GetArray(name.c_str()))
+            local_segment->GetCellData()->AddArray(cell_array);
+    }
+}
+
 void Render3D::print_current_statistics()
 {
     for(unsigned int si = 0; si < local_domain->GetNumberOfBlocks(); si++)
@@ -286,9 +349,7 @@ void Render3D::color_quantity_vertex()
 
         if(generic_segment->GetPointData()->HasArray(current_quantity_key.c_str()))
         {
-            generic_segment->GetPointData()->SetActiveScalars(current_quantity_key.c_str());
-
-            double* range = generic_segment->GetPointData()->GetScalars()->GetRange();
+            double* range = generic_segment->GetPointData()->GetArray(current_quantity_key.c_str())->GetRange();
 
             if(si == 0)
             {
@@ -328,7 +389,7 @@ void Render3D::color_quantity_vertex()
     {
         Mapper map = *iter;
         map->ScalarVisibilityOn();
-        map->SetScalarModeToUsePointData();
+        map->SetScalarModeToUsePointFieldData();
         map->SetColorModeToMapScalars();
         map->SelectColorArray(current_quantity_key.c_str());
         map->UseLookupTableScalarRangeOff();
@@ -353,9 +414,7 @@ void Render3D::color_quantity_cell()
 
         if(generic_segment->GetCellData()->HasArray(current_quantity_key.c_str()))
         {
-            generic_segment->GetCellData()->SetActiveScalars(current_quantity_key.c_str());
-
-            double* range = generic_segment->GetCellData()->GetScalars()->GetRange();
+            double* range = generic_segment->GetCellData()->GetArray(current_quantity_key.c_str())->GetRange();
             if(si == 0)
             {
                 domain_quantity_range[0] = range[0];
@@ -394,7 +453,7 @@ void Render3D::color_quantity_cell()
     {
         Mapper map = *iter;
         map->ScalarVisibilityOn();
-        map->SetScalarModeToUseCellData();
+        map->SetScalarModeToUseCellFieldData();
         map->SetColorModeToMapScalars();
         map->SelectColorArray(current_quantity_key.c_str());
         map->UseLookupTableScalarRangeOff();
@@ -25,10 +25,10 @@
 
 #include "stream_emitter.h"
 
-#include <QDebug>
+#include <QMutexLocker>
 
-StreamEmitter::StreamEmitter(std::ostream &stream)
-    : QObject(NULL), m_stream(stream)
+StreamEmitter::StreamEmitter(std::ostream &stream, viennamos::LogBuffer& log)
+    : m_stream(stream), m_log(log)
 {
     m_old_buf = stream.rdbuf();
     stream.rdbuf(this);
@@ -37,15 +37,21 @@ StreamEmitter::StreamEmitter(std::ostream &stream)
 
 StreamEmitter::~StreamEmitter()
 {
+    // output anything that is left
+    QMutexLocker lock(&m_mutex);
+    if (!m_string.empty())
+        m_log.write(m_string);
+
     m_stream.rdbuf(m_old_buf);
 }
 
 
 StreamEmitter::int_type StreamEmitter::overflow(StreamEmitter::int_type v)
 {
+    QMutexLocker lock(&m_mutex);
     if (v == '\n')
     {
-        emit message(QString::fromStdString(m_string));
+        m_log.write(m_string);
         m_string.erase(m_string.begin(), m_string.end());
     }
     else
@@ -56,20 +62,17 @@ StreamEmitter::int_type StreamEmitter::overflow(StreamEmitter::int_type v)
 
 std::streamsize StreamEmitter::xsputn(const char *p, std::streamsize n)
 {
+    QMutexLocker lock(&m_mutex);
     m_string.append(p, p + n);
 
-    std::size_t pos = 0;
+    std::size_t start = 0;
+    std::size_t pos   = m_string.find('\n');
     while (pos != std::string::npos)
     {
-        pos = m_string.find('\n');
-        if (pos != std::string::npos)
-        {
-            std::string tmp(m_string.begin(), m_string.begin() + pos);
-
-            emit message(QString::fromStdString(tmp));
-            m_string.erase(m_string.begin(), m_string.begin() + pos + 1);
-        }
+        m_log.write(m_string.substr(start, pos - start));
+        start = pos + 1;
+        pos   = m_string.find('\n', start);
     }
+    m_string.erase(0, start);
     return n;
 }
-
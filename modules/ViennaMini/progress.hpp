@@ -0,0 +1,171 @@
+#ifndef PROGRESS_HPP
+#define PROGRESS_HPP
+
+#include <cmath>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "spsc_queue.hpp"
+#include "result_sequence.hpp"
+
+#include "viennafvm/solver_monitor.hpp"
+
+/**
+ * @brief A structured progress report of the ViennaMini worker
+ */
+struct ProgressEvent
+{
+    enum Phase { SETUP, ASSEMBLY, LINEAR_SOLVE, UPDATE, TRANSFER, FINISHED, CANCELLED };
+
+    ProgressEvent() : phase(SETUP), iteration(0), iterations(0), pde_index(0),
+                      update_norm(0), elapsed(0), eta(-1) {}
+
+    Phase       phase;
+    std::size_t iteration;      // nonlinear iteration
+    std::size_t iterations;     // maximum number of nonlinear iterations
+    std::size_t pde_index;
+    double      update_norm;    // latest update norm of the observed quantity
+    double      elapsed;        // seconds since the start of the solver
+    double      eta;            // estimated remaining seconds, negative if unknown
+};
+
+/**
+ * @brief The results of one accepted step of a transient run, one frame per quantity handle
+ */
+struct StepResult
+{
+    StepResult() : step(0), time(0) {}
+
+    std::size_t step;
+    double      time;       // simulated time in seconds
+    std::map<viennamos::ResultSequence::Key, viennamos::ResultSequence::Frame> frames;
+};
+
+/**
+ * @brief Progress and cancellation channel between the ViennaMini worker thread and the GUI.
+ * The worker pushes events into a lock-free queue, the GUI polls it at a fixed rate.
+ * The cancel flag is set by the GUI and checked by the PDE solver before each linear solve.
+ * The accepted steps of transient runs are handed over in a separate queue, which never drops entries.
+ */
+class ViennaMiniProgress : public viennafvm::solver_monitor
+{
+public:
+    typedef viennamos::SPSCQueue<ProgressEvent, 1024>   Queue;
+
+    ViennaMiniProgress() : cancel_flag(0), aborted_flag(0) { this->reset(); }
+
+    /// GUI thread: prepares a new run, must not be called while a worker is running
+    void reset()
+    {
+        queue.clear();
+        {
+            QMutexLocker lock(&steps_mutex);
+            steps.clear();
+        }
+        cancel_flag.fetchAndStoreRelease(0);
+        aborted_flag.fetchAndStoreRelease(0);
+        last = ProgressEvent();
+        previous_norm = -1;
+    }
+
+    /// GUI thread: asks the running worker to stop
+    void cancel() { cancel_flag.fetchAndStoreRelease(1); }
+
+    /// Both threads: polled by the PDE solver between linear solves
+    virtual bool cancelled() const { return const_cast<QAtomicInt&>(cancel_flag).fetchAndAddAcquire(0) != 0; }
+
+    /// GUI thread: true if the last run has been stopped before it finished.
+    /// Unlike the queued events, this state is never dropped
+    bool aborted() const { return const_cast<QAtomicInt&>(aborted_flag).fetchAndAddAcquire(0) != 0; }
+
+    /// Worker thread: reports a phase outside of the PDE solver
+    void post(ProgressEvent::Phase phase)
+    {
+        last.phase = phase;
+        queue.push(last);
+    }
+
+    /// Worker thread: called by the PDE solver
+    virtual void notify(viennafvm::solver_progress const& progress)
+    {
+        last.iteration  = progress.nonlinear_iteration;
+        last.iterations = progress.nonlinear_iterations;
+        last.pde_index  = progress.pde_index;
+        last.elapsed    = progress.elapsed;
+
+        switch(progress.phase)
+        {
+        case viennafvm::phase_assembly:     last.phase = ProgressEvent::ASSEMBLY;     break;
+        case viennafvm::phase_linear_solve: last.phase = ProgressEvent::LINEAR_SOLVE; break;
+        case viennafvm::phase_update:       last.phase = ProgressEvent::UPDATE;       break;
+        case viennafvm::phase_finished:     last.phase = ProgressEvent::FINISHED;     break;
+        case viennafvm::phase_cancelled:    last.phase = ProgressEvent::CANCELLED;    break;
+        }
+        if(last.phase == ProgressEvent::CANCELLED)
+            aborted_flag.fetchAndStoreRelease(1);
+
+        if((progress.phase == viennafvm::phase_update) && (progress.pde_index == progress.break_pde))
+        {
+            last.update_norm = progress.update_norm;
+            last.eta = estimate_remaining(progress);
+            previous_norm = progress.update_norm;
+        }
+        queue.push(last); // if the GUI lags behind, intermediate events are dropped
+    }
+
+    /// GUI thread: fetches the next queued event
+    bool poll(ProgressEvent& event) { return queue.pop(event); }
+
+    /// Worker thread: hands the results of an accepted time step over to the GUI
+    void post_step(StepResult& result)
+    {
+        QMutexLocker lock(&steps_mutex);
+        steps.push_back(StepResult());
+        steps.back().step = result.step;
+        steps.back().time = result.time;
+        steps.back().frames.swap(result.frames);
+    }
+
+    /// GUI thread: takes all steps posted since the last call, oldest first
+    void take_steps(std::vector<StepResult>& result)
+    {
+        result.clear();
+        QMutexLocker lock(&steps_mutex);
+        result.swap(steps);
+    }
+
+private:
+    /// Extrapolates the linear convergence rate of the observed update norm to the break tolerance
+    double estimate_remaining(viennafvm::solver_progress const& progress)
+    {
+        std::size_t done = progress.nonlinear_iteration + 1;
+        double remaining = static_cast<double>(progress.nonlinear_iterations - done);
+
+        double rate = (previous_norm > 0) ? progress.update_norm / previous_norm : 1.0;
+        if((rate > 0) && (rate < 1) && (progress.update_norm > progress.nonlinear_breaktol))
+            remaining = std::min(remaining, std::ceil(std::log(progress.nonlinear_breaktol / progress.update_norm) / std::log(rate)));
+        else
+        if(progress.update_norm <= progress.nonlinear_breaktol)
+            remaining = 0;
+
+        return remaining * progress.elapsed / static_cast<double>(done);
+    }
+
+    Queue           queue;
+    QAtomicInt      cancel_flag;
+    QAtomicInt      aborted_flag;
+
+    QMutex                  steps_mutex;
+    std::vector<StepResult> steps;
+
+    // worker-side state
+    ProgressEvent   last;
+    double          previous_norm;
+};
+
+#endif // PROGRESS_HPP
@@ -450,6 +450,27 @@ void ViennaMiniForm::saveState(QSettings& settings)
     settings.setValue("nonlinsolve_iter", device_parameters.config().nonlinear_iterations());
     settings.setValue("nonlinsolve_tol", device_parameters.config().nonlinear_breaktol());
     settings.setValue("nonlinsolve_damping", device_parameters.config().damping());
+    if(device_parameters.config().mobility_model() == viennamini::mobility_doping_dependent)
+        settings.setValue("mobility_model", "doping");
+    else
+    if(device_parameters.config().mobility_model() == viennamini::mobility_field_dependent)
+        settings.setValue("mobility_model", "field");
+    else
+        settings.setValue("mobility_model", "constant");
+    settings.setValue("mobility_field_tol", device_parameters.config().mobility_field_tolerance());
+    settings.setValue("refinement_steps", device_parameters.config().refinement_steps());
+    settings.setValue("refinement_fraction", device_parameters.config().refinement_fraction());
+    settings.setValue("refinement_tol", device_parameters.config().refinement_tolerance());
+    settings.setValue("recombination_srh", device_parameters.config().recombination_srh_state());
+    settings.setValue("recombination_auger", device_parameters.config().recombination_auger_state());
+    settings.setValue("transient", device_parameters.config().transient_state());
+    if(device_parameters.config().time_integration() == viennamini::time_backward_euler)
+        settings.setValue("time_integration", "euler");
+    else
+        settings.setValue("time_integration", "bdf2");
+    settings.setValue("end_time", device_parameters.config().end_time());
+    settings.setValue("time_step", device_parameters.config().initial_time_step());
+    settings.setValue("time_tol", device_parameters.config().time_step_tolerance());
     settings.endGroup();
 
     settings.beginGroup("device");
@@ -500,6 +521,35 @@ void ViennaMiniForm::loadState(QSettings& settings)
     device_parameters.config().nonlinear_iterations() = settings.value("nonlinsolve_iter").toInt();
     device_parameters.config().nonlinear_breaktol() = settings.value("nonlinsolve_tol").toDouble();
     device_parameters.config().damping() = settings.value("nonlinsolve_damping").toDouble();
+    QString mobility_model = settings.value("mobility_model", "constant").toString().toLower();
+    if(mobility_model == "doping")
+        device_parameters.config().mobility_model() = viennamini::mobility_doping_dependent;
+    else
+    if(mobility_model == "field")
+        device_parameters.config().mobility_model() = viennamini::mobility_field_dependent;
+    else
+        device_parameters.config().mobility_model() = viennamini::mobility_constant;
+    device_parameters.config().mobility_field_tolerance() =
+        settings.value("mobility_field_tol", device_parameters.config().mobility_field_tolerance()).toDouble();
+    device_parameters.config().refinement_steps() =
+        settings.value("refinement_steps", device_parameters.config().refinement_steps()).toInt();
+    device_parameters.config().refinement_fraction() =
+        settings.value("refinement_fraction", device_parameters.config().refinement_fraction()).toDouble();
+    device_parameters.config().refinement_tolerance() =
+        settings.value("refinement_tol", device_parameters.config().refinement_tolerance()).toDouble();
+    device_parameters.config().recombination_srh_state() = settings.value("recombination_srh", false).toBool();
+    device_parameters.config().recombination_auger_state() = settings.value("recombination_auger", false).toBool();
+    device_parameters.config().transient_state() = settings.value("transient", false).toBool();
+    if(settings.value("time_integration", "bdf2").toString().toLower() == "euler")
+        device_parameters.config().time_integration() = viennamini::time_backward_euler;
+    else
+        device_parameters.config().time_integration() = viennamini::time_bdf2;
+    device_parameters.config().end_time() =
+        settings.value("end_time", device_parameters.config().end_time()).toDouble();
+    device_parameters.config().initial_time_step() =
+        settings.value("time_step", device_parameters.config().initial_time_step()).toDouble();
+    device_parameters.config().time_step_tolerance() =
+        settings.value("time_tol", device_parameters.config().time_step_tolerance()).toDouble();
     settings.endGroup();
 
     // now, we update the UI too!
@@ -33,6 +33,7 @@
 
 #include "viennagrid/io/netgen_reader.hpp"
 #include "viennagrid/algorithm/scale.hpp"
+#include "viennafvm/profiler.hpp"
 
 #include "viennaminimodule.h"
 
@@ -43,7 +44,7 @@
  * @brief The module's c'tor registers the module's UI widget and registers
  * output quantities
  */
-ViennaMiniModule::ViennaMiniModule() : ModuleInterface(this)
+ViennaMiniModule::ViennaMiniModule() : ModuleInterface(this), streamed_steps(0)
 {
     // setup a new UI widget and register it with this module
     //
@@ -55,6 +56,20 @@ ViennaMiniModule::ViennaMiniModule() : ModuleInterface(this)
     QObject::connect(widget, SIGNAL(meshFileEntered(QString const&)), this, SLOT(loadMeshFile(QString const&)));
     QObject::connect(this, SIGNAL(materialsAvailable(MaterialManager::Library&)), widget, SLOT(setMaterialLibrary(MaterialManager::Library&)));
 
+    // the worker reports its progress via a lock-free queue, which is polled
+    // at a fixed rate, independent of how fast the worker produces events
+    //
+    progress_timer = new QTimer(this);
+    progress_timer->setInterval(100); // ms
+    QObject::connect(progress_timer, SIGNAL(timeout()), this, SLOT(pollProgress()));
+
+    // the instrumentation of mesh loading, simulation and result transfer is
+    // switched on by pointing VIENNAMOS_PROFILE to an output base name
+    //
+    profile_basename = QString(qgetenv("VIENNAMOS_PROFILE"));
+    if(!profile_basename.isEmpty())
+        viennafvm::profiler::enable();
+
 
     // create output quantities of this module
     //
@@ -123,8 +138,19 @@ void ViennaMiniModule::render(Quantity& quan, int step)
     // if current is actually a render view, and not a, for instance, chart view
     if(render)
     {
-        // make sure that the 'domain' is up-to-date
-        render->update_render_domain();
+        // load the requested step of the result sequence into the central render arrays,
+        // steps which have been spilled to disk are decompressed on the fly
+        if((step >= 0) && (std::size_t(step) < results.size(quan.handle)))
+        {
+            viennamos::ResultSequence::Frame const* frame = results.at(quan.handle, step);
+            if(frame)
+                viennamos::copy(*frame, quan, multiview);
+            this->reportResultErrors();
+        }
+
+        // make sure that the 'domain' is up-to-date. this only rebuilds the view
+        // if the topology has changed, otherwise only modified arrays are exchanged
+        multiview->refresh(render);
 
         if((quan == pot_quan_vertex) || (quan == pot_quan_cell))
           multiview->setCurrentLogScale(false);
@@ -138,29 +164,13 @@ void ViennaMiniModule::render(Quantity& quan, int step)
 }
 
 /**
- * @brief Function returns the size of the sequence of a given quantity
- * this function is currently out of order, need to revisit the approach of handling
- * a sequence of quantities .. this is also coupled with the VCR function of ViennaMOS
+ * @brief Function returns the number of results stored for a given quantity,
+ * each stationary simulation run appends one result to the sequence,
+ * transient runs append one result per accepted time step
  */
-std::size_t ViennaMiniModule::quantity_sequence_size(std::string quankey)
+std::size_t ViennaMiniModule::quantity_sequence_size(Quantity& quan)
 {
-//    if(device_id == Device22u::ID())
-//    {
-//        Device22u* device = database->value<Device22u*>(Device22u::ID());
-//        typedef Device22u::Quantities    QuantitiesT;
-//        QuantitiesT& quantities = device->quantities();
-//        QuantitiesT::iterator it = quantities.find(quankey);
-//        return (it->data_sequence).size();
-//    }
-//    else if(device_id == Device33u::ID())
-//    {
-//        Device33u* device = database->value<Device33u*>(Device33u::ID());
-//        typedef Device33u::Quantities    QuantitiesT;
-//        QuantitiesT& quantities = device->quantities();
-//        QuantitiesT::iterator it = quantities.find(quankey);
-//        return (it->data_sequence).size();
-//    }
-//        else return 0;
+    return results.size(quan.handle);
 }
 
 /**
@@ -184,7 +194,9 @@ void ViennaMiniModule::update()
  */
 void ViennaMiniModule::reset()
 {
-
+    results.clear();
+    previous_solution = viennamini::solution_snapshot();
+    doping_cache.invalidate();
 }
 
 /**
@@ -194,12 +206,19 @@ void ViennaMiniModule::execute()
 {
     DeviceParameters& parameters = widget->getParameters();
 
+    progress.reset();
+    streamed_steps = 0;
+    this->report_progress(0, QString("Setup"));
+    progress_timer->start();
+
     if((device_id == viennamos::Device2u::ID()) && (has<viennamos::Device2u>()))
     {
         viennamos::Device2u& device = access<viennamos::Device2u>();
         ViennaMiniWorker* worker = new ViennaMiniWorker(&device, material_manager->getLibrary(), parameters,
                                                         pot_quan_vertex, n_quan_vertex, p_quan_vertex,
-                                                        pot_quan_cell, n_quan_cell, p_quan_cell);
+                                                        pot_quan_cell, n_quan_cell, p_quan_cell, progress);
+        worker->setPreviousSolution(previous_solution);
+        worker->setDopingCache(doping_cache);
         viennamos::offload(worker, messenger, SIGNAL(finished()), this, SLOT(transferResult()));
     }
     else
@@ -208,11 +227,71 @@ void ViennaMiniModule::execute()
         viennamos::Device3u& device = access<viennamos::Device3u>();
         ViennaMiniWorker* worker = new ViennaMiniWorker(&device, material_manager->getLibrary(), parameters,
                                                         pot_quan_vertex, n_quan_vertex, p_quan_vertex,
-                                                        pot_quan_cell, n_quan_cell, p_quan_cell);
+                                                        pot_quan_cell, n_quan_cell, p_quan_cell, progress);
+        worker->setPreviousSolution(previous_solution);
+        worker->setDopingCache(doping_cache);
         viennamos::offload(worker, messenger, SIGNAL(finished()), this, SLOT(transferResult()));
     }
 }
 
+/**
+ * @brief Function is executed when the 'Stop' button is pressed. The worker
+ * stops cooperatively before its next linear solve
+ */
+void ViennaMiniModule::cancel()
+{
+    progress.cancel();
+}
+
+/**
+ * @brief Function drains the progress queue of the worker and shows
+ * the most recent state in the module control widget
+ */
+void ViennaMiniModule::pollProgress()
+{
+    this->storeSteps();
+
+    ProgressEvent event;
+    bool updated = false;
+    while(progress.poll(event)) updated = true;
+    if(!updated) return;
+
+    QString text;
+    switch(event.phase)
+    {
+    case ProgressEvent::SETUP:        text = "Setup";        break;
+    case ProgressEvent::ASSEMBLY:     text = "Assembly";     break;
+    case ProgressEvent::LINEAR_SOLVE: text = "Linear solve"; break;
+    case ProgressEvent::UPDATE:       text = "Update";       break;
+    case ProgressEvent::TRANSFER:     text = "Transfer";     break;
+    case ProgressEvent::FINISHED:     text = "Finished";     break;
+    case ProgressEvent::CANCELLED:    text = "Cancelled";    break;
+    }
+
+    int percent = 0;
+    if((event.phase == ProgressEvent::TRANSFER) || (event.phase == ProgressEvent::FINISHED))
+        percent = 100;
+    else
+    if(event.phase != ProgressEvent::SETUP)
+    {
+        text += " | iteration " + QString::number(event.iteration+1) + "/" + QString::number(event.iterations)
+              + " | update norm " + QString::number(event.update_norm, 'e', 2);
+
+        if((event.eta >= 0) && (event.elapsed + event.eta > 0))
+        {
+            percent = int(100.0 * event.elapsed / (event.elapsed + event.eta));
+            text += " | ETA " + QString::number(event.eta, 'f', 1) + " s";
+        }
+        else
+        if(event.iterations > 0)
+            percent = int(100.0 * event.iteration / event.iterations);
+
+        if(streamed_steps > 0)
+            text += " | time step " + QString::number(streamed_steps+1);
+    }
+    this->report_progress(percent, text);
+}
+
 /**
  * @brief Function is called after the offloaded worker is finished and takes
  * care of copying the output data to the framework
@@ -220,30 +299,109 @@ void ViennaMiniModule::execute()
  */
 void ViennaMiniModule::transferResult()
 {
-  if((device_id == viennamos::Device2u::ID()) && (has<viennamos::Device2u>()))
+  progress_timer->stop();
+  this->pollProgress();
+
+  // the run has been stopped by the user, there is no result to transfer
+  //
+  if(progress.aborted())
+  {
+    this->writeProfile();
+    emit abort();
+    return;
+  }
+
+  // transient runs have already stored each time step, including the final one
+  //
+  if((streamed_steps == 0) && (device_id == viennamos::Device2u::ID()) && (has<viennamos::Device2u>()))
   {
     viennamos::Device2u& device = access<viennamos::Device2u>();
-    viennamos::copy(device, pot_quan_vertex, multiview);
-    viennamos::copy(device, n_quan_vertex,   multiview);
-    viennamos::copy(device, p_quan_vertex,   multiview);
-    viennamos::copy(device, pot_quan_cell,   multiview);
-    viennamos::copy(device, n_quan_cell,     multiview);
-    viennamos::copy(device, p_quan_cell,     multiview);
+    this->storeResult(device, pot_quan_vertex);
+    this->storeResult(device, n_quan_vertex);
+    this->storeResult(device, p_quan_vertex);
+    this->storeResult(device, pot_quan_cell);
+    this->storeResult(device, n_quan_cell);
+    this->storeResult(device, p_quan_cell);
   }
   else
-  if((device_id == viennamos::Device3u::ID()) && (has<viennamos::Device3u>()))
+  if((streamed_steps == 0) && (device_id == viennamos::Device3u::ID()) && (has<viennamos::Device3u>()))
   {
     viennamos::Device3u& device = access<viennamos::Device3u>();
-    viennamos::copy(device, pot_quan_vertex, multiview);
-    viennamos::copy(device, n_quan_vertex,   multiview);
-    viennamos::copy(device, p_quan_vertex,   multiview);
-    viennamos::copy(device, pot_quan_cell,   multiview);
-    viennamos::copy(device, n_quan_cell,     multiview);
-    viennamos::copy(device, p_quan_cell,     multiview);
+    this->storeResult(device, pot_quan_vertex);
+    this->storeResult(device, n_quan_vertex);
+    this->storeResult(device, p_quan_vertex);
+    this->storeResult(device, pot_quan_cell);
+    this->storeResult(device, n_quan_cell);
+    this->storeResult(device, p_quan_cell);
   }
+  this->writeProfile();
   emit finished();
 }
 
+/**
+ * @brief Function exports the events recorded since the previous export, i.e., the last
+ * run including a preceding mesh load, if profiling has been requested via VIENNAMOS_PROFILE
+ */
+void ViennaMiniModule::writeProfile()
+{
+  if(profile_basename.isEmpty()) return;
+
+  if(!viennafvm::profiler::write_files(profile_basename.toStdString()))
+    QMessageBox::critical(0, QString("Error"), QString("Could not write the profile to ") + profile_basename + QString(".json"));
+  viennafvm::profiler::clear();
+}
+
+/**
+ * @brief Function appends the current result of a quantity to the result sequence
+ * and shows it as the latest step in the render arrays
+ */
+template<typename DeviceT>
+void ViennaMiniModule::storeResult(DeviceT& device, Quantity& quan)
+{
+  viennafvm::profiler::scope profile("framework_copy");
+  viennamos::ResultSequence::Frame frame;
+  viennamos::copy(device, quan, frame);
+  viennamos::copy(frame, quan, multiview);
+  results.append(quan.handle, frame);
+  this->reportResultErrors();
+}
+
+/**
+ * @brief Function appends the time steps streamed by the worker to the result sequence
+ * and shows the most recent one in the render arrays
+ */
+void ViennaMiniModule::storeSteps()
+{
+  std::vector<StepResult> steps;
+  progress.take_steps(steps);
+  if(steps.empty()) return;
+
+  viennafvm::profiler::scope profile("framework_copy");
+  Quantity* quantities[] = { &pot_quan_vertex, &n_quan_vertex, &p_quan_vertex,
+                             &pot_quan_cell,   &n_quan_cell,   &p_quan_cell };
+  std::size_t const num_quantities = sizeof(quantities) / sizeof(quantities[0]);
+
+  for(std::size_t i = 0; i < steps.size(); i++)
+  {
+    for(std::size_t q = 0; q < num_quantities; q++)
+      results.append(quantities[q]->handle, steps[i].frames[quantities[q]->handle]);
+  }
+  for(std::size_t q = 0; q < num_quantities; q++)
+    viennamos::copy(steps.back().frames[quantities[q]->handle], *quantities[q], multiview);
+
+  streamed_steps += steps.size();
+  this->reportResultErrors();
+}
+
+/**
+ * @brief Function forwards failures of the result sequence storage to the main window
+ */
+void ViennaMiniModule::reportResultErrors()
+{
+  if(results.has_error())
+    emit module_warning(this->name(), results.take_error());
+}
+
 
 /**
  * @brief Function reads an input mesh into the framework's central device database
@@ -264,10 +422,17 @@ void ViennaMiniModule::loadMeshFile(QString const& filename)
             try {
                 if(has<viennamos::Device2u>()) remove<viennamos::Device2u>();
                 viennamos::Device2u& device = make<viennamos::Device2u>();
-                viennagrid::io::netgen_reader  reader;
-                reader(device.getCellComplex(), device.getSegmentation(), filename.toStdString());
-                viennagrid::scale(device.getCellComplex(), widget->getScaling());
-                viennamos::copy(device, multiview);
+                {
+                    viennafvm::profiler::scope profile("mesh_read");
+                    viennagrid::io::netgen_reader  reader;
+                    reader(device.getCellComplex(), device.getSegmentation(), filename.toStdString());
+                    viennagrid::scale(device.getCellComplex(), widget->getScaling());
+                }
+                {
+                    viennafvm::profiler::scope profile("framework_copy");
+                    viennamos::copy(device, multiview);
+                }
+                results.clear(); // the previous results do not match the new mesh
                 device_id = viennamos::Device2u::ID();
 //                device_segments = device.getSegmentation().size();
 
@@ -289,10 +454,17 @@ void ViennaMiniModule::loadMeshFile(QString const& filename)
             try {
                 if(has<viennamos::Device3u>()) remove<viennamos::Device3u>();
                 viennamos::Device3u& device = make<viennamos::Device3u>();
-                viennagrid::io::netgen_reader  reader;
-                reader(device.getCellComplex(), device.getSegmentation(), filename.toStdString());
-                viennagrid::scale(device.getCellComplex(), widget->getScaling());
-                viennamos::copy(device, multiview);
+                {
+                    viennafvm::profiler::scope profile("mesh_read");
+                    viennagrid::io::netgen_reader  reader;
+                    reader(device.getCellComplex(), device.getSegmentation(), filename.toStdString());
+                    viennagrid::scale(device.getCellComplex(), widget->getScaling());
+                }
+                {
+                    viennafvm::profiler::scope profile("framework_copy");
+                    viennamos::copy(device, multiview);
+                }
+                results.clear(); // the previous results do not match the new mesh
                 device_id = viennamos::Device3u::ID();
 //                device_segments = device.getSegmentation().size();
                 std::vector<int> segment_indices;
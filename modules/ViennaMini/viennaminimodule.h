@@ -27,9 +27,12 @@
  */
 
 
+#include <QTimer>
+
 // ViennaMOS includes
 //
 #include "module_interface.h"
+#include "result_sequence.hpp"
 
 // Local includes
 //
@@ -50,8 +53,9 @@ public:
     virtual bool            is_ready            ();
     virtual void            update              ();
     virtual void            reset               ();
-    virtual std::size_t     quantity_sequence_size  (std::string quankey);
+    virtual std::size_t     quantity_sequence_size  (Quantity& quan);
     virtual void            execute             ();
+    virtual void            cancel              ();
     virtual void            preprocess          ();
 
 signals:
@@ -59,11 +63,19 @@ signals:
 
 private slots:
     void loadMeshFile(QString const& filename);
+    void pollProgress();
 
 public slots:
     void transferResult();
 
 private:
+    template<typename DeviceT>
+    void storeResult(DeviceT& device, Quantity& quan);
+    void storeSteps();
+    void reportResultErrors();
+
+    void writeProfile();
+
     ViennaMiniForm*     widget;
     QString             meshfile;
     int                 device_id;
@@ -76,6 +88,20 @@ private:
     Quantity n_quan_cell;
     Quantity p_quan_cell;
 
+    viennamos::ResultSequence results;
+    std::size_t               streamed_steps;   // time steps stored during the current run
+
+    ViennaMiniProgress  progress;
+    QTimer*             progress_timer;
+
+    // the converged solution of the last stationary run, written by the worker. runs don't overlap
+    viennamini::solution_snapshot  previous_solution;
+
+    // the doping per cell of the last run, reused while the mesh and the doping are unchanged
+    viennamini::doping_cache       doping_cache;
+
+    QString             profile_basename;   // $VIENNAMOS_PROFILE, traces each run if set
+
 };
 
 #endif // VIENNAMINIMODULE_H
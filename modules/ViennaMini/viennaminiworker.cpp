@@ -1,25 +1,31 @@
 
 #include <vector>
 
+#include "boost/scoped_ptr.hpp"
+
 #include "viennaminiworker.h"
 #include "stream_emitter.h"
 
 ViennaMiniWorker::ViennaMiniWorker(viennamos::Device2u* vmos_device, MaterialManager::Library& matlib, DeviceParameters& parameters,
                                    Quantity& target_pot_quan_vertex, Quantity& target_n_quan_vertex, Quantity& target_p_quan_vertex,
-                                   Quantity& target_pot_quan_cell, Quantity& target_n_quan_cell, Quantity& target_p_quan_cell)
+                                   Quantity& target_pot_quan_cell, Quantity& target_n_quan_cell, Quantity& target_p_quan_cell,
+                                   ViennaMiniProgress& progress)
     : vmos_device2u_(vmos_device), matlib_(matlib), parameters_(parameters),
       target_pot_quan_vertex_(target_pot_quan_vertex), target_n_quan_vertex_(target_n_quan_vertex), target_p_quan_vertex_(target_p_quan_vertex),
-      target_pot_quan_cell_(target_pot_quan_cell), target_n_quan_cell_(target_n_quan_cell), target_p_quan_cell_(target_p_quan_cell)
+      target_pot_quan_cell_(target_pot_quan_cell), target_n_quan_cell_(target_n_quan_cell), target_p_quan_cell_(target_p_quan_cell),
+      progress_(progress), log_(NULL), previous_solution_(NULL), doping_cache_(NULL)
 {
     vmos_device3u_ = NULL;
 }
 
 ViennaMiniWorker::ViennaMiniWorker(viennamos::Device3u* vmos_device, MaterialManager::Library& matlib, DeviceParameters& parameters,
                                    Quantity& target_pot_quan_vertex, Quantity& target_n_quan_vertex, Quantity& target_p_quan_vertex,
-                                   Quantity& target_pot_quan_cell, Quantity& target_n_quan_cell, Quantity& target_p_quan_cell)
+                                   Quantity& target_pot_quan_cell, Quantity& target_n_quan_cell, Quantity& target_p_quan_cell,
+                                   ViennaMiniProgress& progress)
     : vmos_device3u_(vmos_device), matlib_(matlib), parameters_(parameters),
       target_pot_quan_vertex_(target_pot_quan_vertex), target_n_quan_vertex_(target_n_quan_vertex), target_p_quan_vertex_(target_p_quan_vertex),
-      target_pot_quan_cell_(target_pot_quan_cell), target_n_quan_cell_(target_n_quan_cell), target_p_quan_cell_(target_p_quan_cell)
+      target_pot_quan_cell_(target_pot_quan_cell), target_n_quan_cell_(target_n_quan_cell), target_p_quan_cell_(target_p_quan_cell),
+      progress_(progress), log_(NULL), previous_solution_(NULL), doping_cache_(NULL)
 {
     vmos_device2u_ = NULL;
 }
@@ -34,10 +40,13 @@ void ViennaMiniWorker::process()
     //
     // Reroute streams
     //
-    StreamEmitter msg_cout(std::cout);
-    StreamEmitter msg_cerr(std::cerr);
-    connect(&msg_cout, SIGNAL(message(QString const&)), this, SLOT(forward_message(QString const&)));
-    connect(&msg_cerr, SIGNAL(message(QString const&)), this, SLOT(forward_message(QString const&)));
+    boost::scoped_ptr<StreamEmitter> msg_cout;
+    boost::scoped_ptr<StreamEmitter> msg_cerr;
+    if(log_)
+    {
+        msg_cout.reset(new StreamEmitter(std::cout, *log_));
+        msg_cerr.reset(new StreamEmitter(std::cerr, *log_));
+    }
 
     //
     // process a 22u domain
@@ -50,7 +59,17 @@ void ViennaMiniWorker::process()
     emit finished();
 }
 
-void ViennaMiniWorker::forward_message(QString const& msg)
+void ViennaMiniWorker::setLogBuffer(viennamos::LogBuffer& log)
+{
+    log_ = &log;
+}
+
+void ViennaMiniWorker::setPreviousSolution(viennamini::solution_snapshot& snapshot)
+{
+    previous_solution_ = &snapshot;
+}
+
+void ViennaMiniWorker::setDopingCache(viennamini::doping_cache& cache)
 {
-    emit message(msg);
+    doping_cache_ = &cache;
 }
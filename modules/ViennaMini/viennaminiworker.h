@@ -4,6 +4,7 @@
 #include <QObject>
 
 #include "deviceparameters.hpp"
+#include "progress.hpp"
 
 #include "copy.hpp"
 #include "common.hpp"
@@ -14,9 +15,9 @@
 #include "viennamini/simulator.hpp"
 
 #include "viennagrid/algorithm/quantity_transfer.hpp"
-#include "viennautils/average.hpp"
 
 #include "utils.hpp"
+#include "log_buffer.hpp"
 
 class ViennaMiniWorker : public QObject
 {
@@ -28,16 +29,61 @@ public:
 
   ViennaMiniWorker(viennamos::Device2u* vmos_device, MaterialManager::Library& matlib, DeviceParameters& parameters,
                    Quantity& target_pot_quan_vertex, Quantity& target_n_quan_vertex, Quantity& target_p_quan_vertex,
-                   Quantity& target_pot_quan_cell, Quantity& target_n_quan_cell, Quantity& target_p_quan_cell);
+                   Quantity& target_pot_quan_cell, Quantity& target_n_quan_cell, Quantity& target_p_quan_cell,
+                   ViennaMiniProgress& progress);
   ViennaMiniWorker(viennamos::Device3u* vmos_device, MaterialManager::Library& matlib, DeviceParameters& parameters,
                    Quantity& target_pot_quan_vertex, Quantity& target_n_quan_vertex, Quantity& target_p_quan_vertex,
-                   Quantity& target_pot_quan_cell, Quantity& target_n_quan_cell, Quantity& target_p_quan_cell);
+                   Quantity& target_pot_quan_cell, Quantity& target_n_quan_cell, Quantity& target_p_quan_cell,
+                   ViennaMiniProgress& progress);
   ~ViennaMiniWorker();
 
+  void setLogBuffer(viennamos::LogBuffer& log);
+
+  /**
+   * @brief Sets the converged solution of the previous run. A run on the same mesh starts from it
+   * instead of the doping based initial guess, and a converged stationary run replaces it
+   */
+  void setPreviousSolution(viennamini::solution_snapshot& snapshot);
+
+  /**
+   * @brief Sets the doping cache of the module, so that re-runs on the same mesh and doping
+   * don't evaluate the doping again
+   */
+  void setDopingCache(viennamini::doping_cache& cache);
+
 public slots:
   void process();
 
 private:
+  /**
+   * @brief Receives the accepted steps of a transient run, transfers them to the ViennaMOS device
+   * and hands the resulting frames over to the GUI
+   */
+  template<typename DeviceT, typename VMiniDeviceT, typename SimulatorT>
+  class StepStreamer : public viennafvm::transient_observer
+  {
+  public:
+    StepStreamer(ViennaMiniWorker& worker, DeviceT& device, VMiniDeviceT& vmini_device, SimulatorT& simulator) :
+      worker_(worker), device_(device), vmini_device_(vmini_device), simulator_(simulator) {}
+
+    void accepted(std::size_t step, viennafvm::numeric_type time, viennafvm::numeric_type)
+    {
+      worker_.transfer(device_, vmini_device_, simulator_);
+
+      StepResult result;
+      result.step = step;
+      result.time = time;
+      worker_.extract(device_, result);
+      worker_.progress_.post_step(result);
+    }
+
+  private:
+    ViennaMiniWorker  & worker_;
+    DeviceT           & device_;
+    VMiniDeviceT      & vmini_device_;
+    SimulatorT        & simulator_;
+  };
+
   template<typename DeviceT>
   void process_impl(DeviceT& device)
   {
@@ -47,8 +93,11 @@ private:
     typedef viennamini::device<Domain, Segmentation, QuanComplex>   VMiniDevice;
     typedef typename MaterialManager::Library                       MatLib;
 
+    progress_.post(ProgressEvent::SETUP);
+
     VMiniDevice vmini_device(device.getCellComplex(), device.getSegmentation(), device.getQuantityComplex());
     viennamini::config & config = parameters_.config();
+    config.clear_contact_switches();
 
     for(typename DeviceParameters::iterator siter = parameters_.begin();
         siter != parameters_.end(); siter++)
@@ -61,7 +110,16 @@ private:
         if(segpara.isContact)
         {
             vmini_device.assign_contact(si);
-            config.assign_contact(si, segpara.contact, segpara.workfunction);
+
+            // transient runs start from the stationary solution at the lower end of the range
+            // and switch the contact to the upper end at t=0
+            if(config.transient_state() && segpara.isContactRange)
+            {
+                config.assign_contact(si, segpara.contactFrom, segpara.workfunction);
+                config.assign_contact_switch(si, segpara.contactTo);
+            }
+            else
+                config.assign_contact(si, segpara.contact, segpara.workfunction);
         }
         else
         if(segpara.isOxide)
@@ -80,25 +138,102 @@ private:
     // create a ViennaMini simulator object
     //
     typedef viennamini::simulator<VMiniDevice, MatLib>     Simulator;
-    typedef typename Simulator::VectorType                 ResultVector;
     Simulator simulator(vmini_device, matlib_, config);
+    simulator.set_monitor(&progress_);
+
+    // a re-run on the same mesh, e.g. after a small change of a contact potential,
+    // continues from the previous solution. the provider declines on other meshes
+    //
+    viennamini::solution_snapshot empty_snapshot;
+    viennamini::previous_solution_guess<VMiniDevice> previous_guess(previous_solution_ ? *previous_solution_ : empty_snapshot);
+    simulator.set_initial_guess_provider(&previous_guess);
+    simulator.set_doping_cache(doping_cache_);
+
+    // each accepted time step is streamed to the GUI while the run continues
+    //
+    StepStreamer<DeviceT, VMiniDevice, Simulator> streamer(*this, device, vmini_device, simulator);
+    if(config.transient_state())
+      simulator.set_transient_observer(&streamer);
 
     // run the simulation
     //
     simulator();
 
+    // adaptive refinement of a stationary run, as configured. the levels are solved on
+    // refined copies of the mesh, ViennaMOS keeps the imported one
+    //
+    viennamini::adaptive_run<VMiniDevice, Simulator> adaptive(vmini_device, simulator, matlib_, config);
+    adaptive.set_monitor(&progress_);
+    adaptive();
+
+    // a cancelled run leaves an incomplete iterate, don't hand it to ViennaMOS
+    //
+    if(adaptive.simulator().cancelled()) return;
+
+    // the solution of the finest level is shown on the imported mesh, sampled at its cell centroids
+    //
+    bool refined = adaptive.interpolate_to_initial_device();
+
+    if(previous_solution_ && adaptive.simulator().converged() && !config.transient_state())
+      simulator.capture_solution(*previous_solution_);
+
+    progress_.post(ProgressEvent::TRANSFER);
+    if(refined)
+    {
+      typedef typename viennagrid::result_of::cell_tag<Domain>::type                                                 CellTag;
+      typedef typename viennagrid::result_of::element<Domain, CellTag>::type                                         CellType;
+      typedef typename viennadata::result_of::accessor<QuanComplex, viennafvm::current_iterate_key, double, CellType>::type IterateAccessor;
+
+      IterateAccessor pot_acc = viennadata::make_accessor(vmini_device.storage(), viennafvm::current_iterate_key(simulator.quantity_potential().id()));
+      IterateAccessor n_acc   = viennadata::make_accessor(vmini_device.storage(), viennafvm::current_iterate_key(simulator.quantity_electron_density().id()));
+      IterateAccessor p_acc   = viennadata::make_accessor(vmini_device.storage(), viennafvm::current_iterate_key(simulator.quantity_hole_density().id()));
+      this->transfer(device, pot_acc, n_acc, p_acc);
+    }
+    else
+      this->transfer(device, vmini_device, simulator);
+
     //simulator.write_result();
 
+    progress_.post(ProgressEvent::FINISHED);
+  }
+
+  /**
+   * @brief Transfers the current ViennaMini solution to the vertex and cell quantities of the ViennaMOS device
+   */
+  template<typename DeviceT, typename VMiniDeviceT, typename SimulatorT>
+  void transfer(DeviceT& device, VMiniDeviceT& vmini_device, SimulatorT& simulator)
+  {
+    typedef typename DeviceT::CellComplex                           Domain;
+    typedef typename DeviceT::QuantityComplex                       QuanComplex;
+    typedef typename SimulatorT::VectorType                         ResultVector;
 
     typedef typename viennagrid::result_of::cell_tag<Domain>::type                          CellTag;
     typedef typename viennagrid::result_of::element<Domain, CellTag>::type                  CellType;
-    typedef typename viennagrid::result_of::element<Domain, viennagrid::vertex_tag>::type   VertexType;
     typedef viennamini::result_accessor<CellType, QuanComplex, ResultVector>                ResultAccessor;
 
     ResultAccessor source_pot_acc(vmini_device.storage(), simulator.result(), simulator.quantity_potential().id());
     ResultAccessor source_n_acc  (vmini_device.storage(), simulator.result(), simulator.quantity_electron_density().id());
     ResultAccessor source_p_acc  (vmini_device.storage(), simulator.result(), simulator.quantity_hole_density().id());
 
+    this->transfer(device, source_pot_acc, source_n_acc, source_p_acc);
+  }
+
+  /**
+   * @brief Transfers cell values of the potential and the carrier densities, read by the given accessors,
+   * to the vertex and cell quantities of the ViennaMOS device
+   */
+  template<typename DeviceT, typename SourceAccessorT>
+  void transfer(DeviceT& device, SourceAccessorT& source_pot_acc, SourceAccessorT& source_n_acc, SourceAccessorT& source_p_acc)
+  {
+    typedef typename DeviceT::CellComplex                           Domain;
+    typedef typename DeviceT::QuantityComplex                       QuanComplex;
+
+    viennafvm::profiler::scope transfer_scope("framework_copy");
+
+    typedef typename viennagrid::result_of::cell_tag<Domain>::type                          CellTag;
+    typedef typename viennagrid::result_of::element<Domain, CellTag>::type                  CellType;
+    typedef typename viennagrid::result_of::element<Domain, viennagrid::vertex_tag>::type   VertexType;
+
     typedef typename viennadata::result_of::accessor<QuanComplex, Quantity, double, VertexType>::type TargetVertexAccessor;
     TargetVertexAccessor target_pot_vertex_acc = viennadata::make_accessor(device.getQuantityComplex(), target_pot_quan_vertex_);
     TargetVertexAccessor target_n_vertex_acc   = viennadata::make_accessor(device.getQuantityComplex(), target_n_quan_vertex_);
@@ -110,22 +245,25 @@ private:
     QuantityTransferSetter p_setter   (target_p_vertex_acc);
 
     // transfer the cell-based ViennaMini results to the vertex-based ViennaMOS
-    // device using the ViennaMOS quantity accessor
+    // device using the ViennaMOS quantity accessor. the averaging weights are
+    // computed once and applied to all three quantities in a single sweep. the
+    // vertex values match the former per-quantity averaging up to rounding
     //
-    viennagrid::quantity_transfer<CellType, VertexType>(device.getCellComplex(),
-                                        source_pot_acc, pot_setter,
-                                        viennautils::arithmetic_averaging(),
-                                        any_filter(), any_filter());
+    typedef viennagrid::quantity_transfer_weights<Domain, CellType, VertexType>  TransferWeights;
+    TransferWeights transfer_weights(device.getCellComplex(), viennagrid::arithmetic_averaging_tag(), any_filter(), any_filter());
+
+    std::size_t const num_fields = 3;
+    std::vector<double> cell_values;
+    transfer_weights.gather(source_pot_acc, 0, num_fields, cell_values);
+    transfer_weights.gather(source_n_acc,   1, num_fields, cell_values);
+    transfer_weights.gather(source_p_acc,   2, num_fields, cell_values);
 
-    viennagrid::quantity_transfer<CellType, VertexType>(device.getCellComplex(),
-                                        source_n_acc, n_setter,
-                                        viennautils::arithmetic_averaging(),
-                                        any_filter(), any_filter());
+    std::vector<double> vertex_values;
+    transfer_weights.apply(cell_values, num_fields, vertex_values);
 
-    viennagrid::quantity_transfer<CellType, VertexType>(device.getCellComplex(),
-                                        source_p_acc, p_setter,
-                                        viennautils::arithmetic_averaging(),
-                                        any_filter(), any_filter());
+    transfer_weights.scatter(vertex_values, 0, num_fields, pot_setter);
+    transfer_weights.scatter(vertex_values, 1, num_fields, n_setter);
+    transfer_weights.scatter(vertex_values, 2, num_fields, p_setter);
 
     typedef typename viennadata::result_of::accessor<QuanComplex, Quantity, double, CellType>::type TargetCellAccessor;
     TargetCellAccessor target_pot_cell_acc = viennadata::make_accessor(device.getQuantityComplex(), target_pot_quan_cell_);
@@ -138,15 +276,25 @@ private:
     viennamos::copy(device, source_pot_acc, target_pot_cell_acc);
     viennamos::copy(device, source_n_acc,   target_n_cell_acc);
     viennamos::copy(device, source_p_acc,   target_p_cell_acc);
-
   }
 
-private slots:
-  void forward_message(QString const& msg);
+  /**
+   * @brief Extracts the frames of all six ViennaMOS quantities
+   */
+  template<typename DeviceT>
+  void extract(DeviceT& device, StepResult& result)
+  {
+    viennafvm::profiler::scope profile("framework_copy");
+    viennamos::copy(device, target_pot_quan_vertex_, result.frames[target_pot_quan_vertex_.handle]);
+    viennamos::copy(device, target_n_quan_vertex_,   result.frames[target_n_quan_vertex_.handle]);
+    viennamos::copy(device, target_p_quan_vertex_,   result.frames[target_p_quan_vertex_.handle]);
+    viennamos::copy(device, target_pot_quan_cell_,   result.frames[target_pot_quan_cell_.handle]);
+    viennamos::copy(device, target_n_quan_cell_,     result.frames[target_n_quan_cell_.handle]);
+    viennamos::copy(device, target_p_quan_cell_,     result.frames[target_p_quan_cell_.handle]);
+  }
 
 signals:
   void finished();
-  void message(QString const& msg);
 
 private:
   viennamos::Device2u*            vmos_device2u_;
@@ -159,6 +307,10 @@ private:
   Quantity                      & target_pot_quan_cell_;
   Quantity                      & target_n_quan_cell_;
   Quantity                      & target_p_quan_cell_;
+  ViennaMiniProgress            & progress_;
+  viennamos::LogBuffer          * log_;
+  viennamini::solution_snapshot * previous_solution_;
+  viennamini::doping_cache      * doping_cache_;
 
 };
 